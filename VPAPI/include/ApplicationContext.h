@@ -40,6 +40,7 @@
 #define APPLICATIONCONTEXT_H_
 
 #include <QFileSystemWatcher>
+#include <QMutex>
 #include <QOpenGLFramebufferObject>
 #include <QQueue>
 #include <QTime>
@@ -81,13 +82,15 @@ public:
     bool extractModelNameFromFileName(const std::string &path, std::string &modelName) const;
     vpvl2::ITexture *uploadTextureOpaque(const vpvl2::uint8 *data, vpvl2::vsize size, const std::string &key, int flags, ModelContext *context);
     vpvl2::ITexture *uploadTextureOpaque(const std::string &path, int flags, ModelContext *context);
+    bool decodeTextureOpaque(const vpvl2::uint8 *data, vpvl2::vsize size, bool flipVertically, vpvl2::Vector3 &textureSize, vpvl2::Array<vpvl2::uint8> &pixels) const;
     FunctionResolver *sharedFunctionResolverInstance() const;
 #ifdef QT_OPENGL_ES_2
     vpvl2::gl::BaseSurface::Format defaultTextureFormat() const;
 #endif
 
-    vpvl2::ITexture *uploadTextureQt(const QImage &image, const std::string &key, int flags, ModelContext *context);
+    vpvl2::ITexture *uploadTextureQt(const QImage &image, const std::string &key, ModelContext *context);
     void uploadEnqueuedModelProxies(ProjectProxy *projectProxy, QList<ModelProxyPair> &succeededModelProxies, QList<ModelProxyPair> &failedModelProxies);
+    bool hasEnqueuedModelProxies() const;
     void uploadEnqueuedEffects(ProjectProxy *projectProxy, QList<ModelProxy *> &succeededEffects, QList<ModelProxy *> &failedEffects);
     QList<ModelProxy *> deleteEnqueuedModelProxies(ProjectProxy *projectProxy);
     void deleteAllModelProxies(ProjectProxy *projectProxy);
@@ -104,6 +107,8 @@ signals:
     void fileDidChange(const QString &filePath);
 
 private:
+    struct UploadingModelContext;
+    UploadingModelContext *findUploadingModelContext(ModelProxy *modelProxy);
     void addTextureWatch(const vpvl2::IModel *modelRef, const ModelContext &context);
     void removeTextureWatch(const vpvl2::IModel *modelRef);
     void deleteModelProxy(ModelProxy *modelProxy, ProjectProxy *projectProxyRef);
@@ -112,7 +117,10 @@ private:
     QHash<const vpvl2::IModel *, BaseApplicationContext::ModelContext::TextureRefCacheMap> m_textureCacheRefs;
     QHash<const QString, vpvl2::ITexture *> m_filePath2TextureRefs;
     QHash<const QString, vpvl2::IEffect *> m_filePath2EffectRefs;
+    /* enqueued on the GUI thread and uploaded on the render thread */
+    mutable QMutex m_uploadingModelsMutex;
     QQueue<ModelProxyPair> m_uploadingModels;
+    QHash<const ModelProxy *, UploadingModelContext *> m_uploadingModelContexts;
     QQueue<ModelProxy *> m_uploadingEffects;
     QQueue<ModelProxy *> m_deletingModels;
     mutable QTime m_elapsedTime;
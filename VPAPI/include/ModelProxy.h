@@ -241,6 +241,7 @@ public:
     QList<RigidBodyRefObject *> allRigidBodyRefs() const;
     QList<JointRefObject *> allJointRefs() const;
     QList<IKConstraintRefObject *> allIKConstraintRefs() const;
+    int countMaterializedObjects(ObjectType type) const;
 
 signals:
     void parentBindingModelChanged();
@@ -314,6 +315,8 @@ public slots:
     Q_INVOKABLE JointRefObject *resolveJointRef(const vpvl2::IJoint *value) const;
     Q_INVOKABLE JointRefObject *findJointByName(const QString &name) const;
     Q_INVOKABLE JointRefObject *findJointByUuid(const QUuid &uuid) const;
+    Q_INVOKABLE int countObjects(ObjectType type) const;
+    Q_INVOKABLE QObject *findObjectAt(ObjectType type, int index) const;
 
     Q_INVOKABLE VertexRefObject *createVertex();
     Q_INVOKABLE MaterialRefObject *createMaterial();
@@ -339,10 +342,6 @@ private slots:
 private:
     void initializeAllBones(const vpvl2::Array<vpvl2::ILabel *> &labelRefs);
     void initializeAllMorphs(const vpvl2::Array<vpvl2::ILabel *> &labelRefs, bool all);
-    void initializeAllVertices();
-    void initializeAllMaterials();
-    void initializeAllRigidBodies();
-    void initializeAllJoints();
     void initializeAllIKConstraints();
     void saveTransformState();
     void clearTransformState();
@@ -357,31 +356,28 @@ private:
     const QUrl m_faviconUrl;
     QHash<const vpvl2::IBone *, BoneRefObject *> m_bone2Refs;
     QHash<const vpvl2::IMorph *, MorphRefObject *> m_morph2Refs;
-    QHash<const vpvl2::IMaterial *, MaterialRefObject *> m_material2Refs;
-    QHash<const vpvl2::IVertex *, VertexRefObject *> m_vertex2Refs;
-    QHash<const vpvl2::IRigidBody *, RigidBodyRefObject *> m_rigidBody2Refs;
-    QHash<const vpvl2::IJoint *, JointRefObject *> m_joint2Refs;
+    /* vertices, materials, rigid bodies and joints are materialized on demand by resolve*Ref */
+    mutable QHash<const vpvl2::IMaterial *, MaterialRefObject *> m_material2Refs;
+    mutable QHash<const vpvl2::IVertex *, VertexRefObject *> m_vertex2Refs;
+    mutable QHash<const vpvl2::IRigidBody *, RigidBodyRefObject *> m_rigidBody2Refs;
+    mutable QHash<const vpvl2::IJoint *, JointRefObject *> m_joint2Refs;
     QHash<const vpvl2::IBone::IKConstraint *, IKConstraintRefObject *> m_constraint2Refs;
     QHash<const QString, BoneRefObject *> m_name2BoneRefs;
     QHash<const QUuid, BoneRefObject *> m_uuid2BoneRefs;
     QHash<const QString, MorphRefObject *> m_name2MorphRefs;
     QHash<const QUuid, MorphRefObject *> m_uuid2MorphRefs;
-    QHash<const QString, MaterialRefObject *> m_name2MaterialRefs;
-    QHash<const QUuid, MaterialRefObject *> m_uuid2MaterialRefs;
-    QHash<const QUuid, VertexRefObject *> m_uuid2VertexRefs;
-    QHash<const QString, RigidBodyRefObject *> m_name2RigidBodyRefs;
-    QHash<const QUuid, RigidBodyRefObject *> m_uuid2RigidBodyRefs;
-    QHash<const QString, JointRefObject *> m_name2JointRefs;
-    QHash<const QUuid, JointRefObject *> m_uuid2JointRefs;
+    mutable QHash<const QString, MaterialRefObject *> m_name2MaterialRefs;
+    mutable QHash<const QUuid, MaterialRefObject *> m_uuid2MaterialRefs;
+    mutable QHash<const QUuid, VertexRefObject *> m_uuid2VertexRefs;
+    mutable QHash<const QString, RigidBodyRefObject *> m_name2RigidBodyRefs;
+    mutable QHash<const QUuid, RigidBodyRefObject *> m_uuid2RigidBodyRefs;
+    mutable QHash<const QString, JointRefObject *> m_name2JointRefs;
+    mutable QHash<const QUuid, JointRefObject *> m_uuid2JointRefs;
     QHash<const QUuid, IKConstraintRefObject *> m_uuid2ConstraintRefs;
     QList<LabelRefObject *> m_allLabels;
     QList<BoneRefObject *> m_allBones;
     QList<BoneRefObject *> m_targetBoneRefs;
     QList<MorphRefObject *> m_allMorphs;
-    QList<MaterialRefObject *> m_allMaterials;
-    QList<VertexRefObject *> m_allVertices;
-    QList<RigidBodyRefObject *> m_allRigidBodies;
-    QList<JointRefObject *> m_allJoints;
     QList<IKConstraintRefObject *> m_allIKConstraints;
     QList<ModelProxy *> m_bindingModels;
     QUndoStack *m_undoStackRef;
@@ -171,6 +171,7 @@ public:
     ModelProxy *resolveModelProxy(const vpvl2::IModel *value) const;
     MotionProxy *resolveMotionProxy(const vpvl2::IMotion *value) const;
     ModelProxy *internalLoadModel(const QUrl &fileUrl, const QUuid &uuid);
+    ModelProxy *internalLoadModel(vpvl2::IModel *model, const QUrl &fileUrl, const QUuid &uuid, const QString &errorString);
     void internalDeleteAllMotions(bool fromDestructor);
     void deleteMotion(MotionProxy *value, bool fromDestructor);
     QVariant globalSetting(const QString &key, const QVariant &defaultValue = QVariant()) const;
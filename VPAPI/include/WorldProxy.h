@@ -89,6 +89,7 @@ public:
     void setDebugDrawer(btIDebugDraw *value);
     void debugDraw();
     void setPlaying(bool value);
+    void setOfflineRendering(bool value);
 
     SimulationType simulationType() const;
     void setSimulationType(SimulationType value);
@@ -126,6 +127,7 @@ private:
     qreal m_lastTimeIndex;
     bool m_enableDebug;
     bool m_playing;
+    bool m_offlineRendering;
 };
 
 #endif // WORLDPROXY_H
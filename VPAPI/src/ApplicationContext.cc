@@ -149,6 +149,17 @@ QOpenGLFramebufferObjectFormat ApplicationContext::framebufferObjectFormat(int s
     return format;
 }
 
+/* keeps the directory of ModelContext alive while textures of the model are decoded across frames */
+struct ApplicationContext::UploadingModelContext {
+    UploadingModelContext(ApplicationContext *applicationContextRef, const QString &path, bool flipVertically)
+        : directory(path),
+          context(applicationContextRef, 0, &directory, flipVertically)
+    {
+    }
+    const String directory;
+    ModelContext context;
+};
+
 ApplicationContext::ApplicationContext(const ProjectProxy *proxy, const StringMap *stringMap, bool isCoreProfile)
     : QObject(0),
       BaseApplicationContext(proxy->projectInstanceRef(), proxy->encodingInstanceRef(), stringMap),
@@ -161,6 +172,8 @@ ApplicationContext::ApplicationContext(const ProjectProxy *proxy, const StringMa
 
 ApplicationContext::~ApplicationContext()
 {
+    qDeleteAll(m_uploadingModelContexts);
+    m_uploadingModelContexts.clear();
 }
 
 void *ApplicationContext::findProcedureAddress(const void **candidatesPtr) const
@@ -218,10 +231,10 @@ bool ApplicationContext::mapFile(const std::string &path, MapBuffer *buffer) con
         buffer->address = file->map(0, size);
         ok = buffer->address != 0;
 #else
-        const QByteArray &bytes = file->readAll();
-        size = bytes.size();
+        /* read into the buffer directly to avoid holding an intermediate copy of the file */
+        size = file->size();
         buffer->address = new uint8_t[size];
-        memcpy(buffer->address, bytes.constData(), size);
+        ok = file->read(reinterpret_cast<char *>(buffer->address), size) == qint64(size);
 #endif
         buffer->size = size;
         buffer->opaque = reinterpret_cast<intptr_t>(file.take());
@@ -272,24 +285,46 @@ bool ApplicationContext::extractModelNameFromFileName(const std::string &path, s
 
 ITexture *ApplicationContext::uploadTextureOpaque(const uint8 *data, vsize size, const std::string &key, int flags, ModelContext *context)
 {
+    ITexture *texturePtr = 0;
+    if (context->findTexture(key, texturePtr)) {
+        return texturePtr;
+    }
+    const std::string &sharedKey = context->sharedTextureKey(data, size, flags);
+    if ((texturePtr = context->findSharedTexture(sharedKey, key)) != 0) {
+        return texturePtr;
+    }
     QImage image;
     image.loadFromData(data, size);
-    ITexture *texturePtr = uploadTextureQt(image, key, flags, context);
-    if (!texturePtr) {
-        texturePtr = context->createTextureFromMemory(data, size, key, flags);
+    if ((texturePtr = uploadTextureQt(image, key, context)) != 0) {
+        return context->storeSharedTexture(sharedKey, key, flags, texturePtr);
     }
-    return texturePtr;
+    return context->createTextureFromMemory(data, size, key, flags);
 }
 
 ITexture *ApplicationContext::uploadTextureOpaque(const std::string &path, int flags, ModelContext *context)
 {
+    /* decode from the mapped file to share the same content with other models */
+    MapBuffer buffer(this);
+    if (mapFile(path, &buffer) && buffer.size > 0) {
+        return uploadTextureOpaque(buffer.address, buffer.size, path, flags, context);
+    }
+    return context->createTextureFromFile(path, flags);
+}
+
+bool ApplicationContext::decodeTextureOpaque(const uint8 *data, vsize size, bool flipVertically, Vector3 &textureSize, Array<uint8> &pixels) const
+{
+    /* same pixels as uploadTextureQt uploads, QImage can be decoded on worker threads */
     QImage image;
-    image.load(QString::fromStdString(path));
-    ITexture *texturePtr = uploadTextureQt(image, path, flags, context);
-    if (!texturePtr) {
-        texturePtr = context->createTextureFromFile(path, flags);
+    if (image.loadFromData(data, size)) {
+        const QImage &normalizedImage = image.convertToFormat(QImage::Format_ARGB32).rgbSwapped();
+        const QImage &orientedImage = flipVertically ? normalizedImage.mirrored() : normalizedImage;
+        const int nbytes = orientedImage.byteCount();
+        pixels.resize(nbytes);
+        memcpy(&pixels[0], orientedImage.constBits(), nbytes);
+        textureSize.setValue(orientedImage.width(), orientedImage.height(), 1);
+        return true;
     }
-    return texturePtr;
+    return false;
 }
 
 IApplicationContext::FunctionResolver *ApplicationContext::sharedFunctionResolverInstance() const
@@ -305,7 +340,7 @@ gl::BaseSurface::Format ApplicationContext::defaultTextureFormat() const
 }
 #endif
 
-ITexture *ApplicationContext::uploadTextureQt(const QImage &image, const std::string &key, int flags, ModelContext *context)
+ITexture *ApplicationContext::uploadTextureQt(const QImage &image, const std::string &key, ModelContext *context)
 {
     /* use Qt's pluggable image loader (jpg/png is loaded with libjpeg/libpng) */
     ITexture *texturePtr = 0;
@@ -314,7 +349,6 @@ ITexture *ApplicationContext::uploadTextureQt(const QImage &image, const std::st
         const QImage &normalizedImage = image.convertToFormat(QImage::Format_ARGB32).rgbSwapped();
         texturePtr = uploadTexture((context->flipVertically() ? normalizedImage.mirrored() : normalizedImage).constBits(), defaultTextureFormat(), size);
         VPVL2_VLOG(2, "Created a texture: texture=" << texturePtr);
-        context->storeTexture(key, flags, texturePtr);
     }
     else {
         VPVL2_LOG(WARNING, "Cannot load an image texture with QImage: " << key);
@@ -325,15 +359,36 @@ ITexture *ApplicationContext::uploadTextureQt(const QImage &image, const std::st
 void ApplicationContext::uploadEnqueuedModelProxies(ProjectProxy *projectProxy, QList<ModelProxyPair> &succeededModelProxies, QList<ModelProxyPair> &failedModelProxies)
 {
     XMLProject *projectRef = projectProxy->projectInstanceRef();
+    QQueue<ModelProxyPair> uploadingModels, decodingModels;
     succeededModelProxies.clear();
     failedModelProxies.clear();
-    while (!m_uploadingModels.isEmpty()) {
-        const ModelProxyPair &pair = m_uploadingModels.dequeue();
+    {
+        /* takes the queue not to block enqueueUploadingModel while uploading */
+        QMutexLocker locker(&m_uploadingModelsMutex); Q_UNUSED(locker);
+        uploadingModels.swap(m_uploadingModels);
+    }
+    while (!uploadingModels.isEmpty()) {
+        const ModelProxyPair pair = uploadingModels.dequeue();
         ModelProxy *modelProxy = pair.first;
         const QFileInfo fileInfo(modelProxy->fileUrl().toLocalFile());
-        const String dir(fileInfo.absoluteDir().absolutePath());
-        ModelContext context(this, 0, &dir, modelProxy->data()->type() == IModel::kAssetModel);
         IModel *modelRef = modelProxy->data();
+        UploadingModelContext *uploadingContext = 0;
+        {
+            QMutexLocker locker(&m_uploadingModelsMutex); Q_UNUSED(locker);
+            uploadingContext = findUploadingModelContext(modelProxy);
+        }
+        /* uploads textures decoded by now and retries at the next frame instead of waiting for the rest */
+        if (uploadingContext->context.uploadDecodedTextures() > 0) {
+            decodingModels.enqueue(pair);
+            continue;
+        }
+        QScopedPointer<UploadingModelContext> uploadingContextPtr;
+        {
+            QMutexLocker locker(&m_uploadingModelsMutex); Q_UNUSED(locker);
+            uploadingContextPtr.reset(m_uploadingModelContexts.take(modelProxy));
+        }
+        const String &dir = uploadingContextPtr->directory;
+        ModelContext &context = uploadingContextPtr->context;
         IRenderEngineSmartPtr engine(projectRef->createRenderEngine(this, modelRef, Scene::kEffectCapable));
         engine->setUpdateOptions(IRenderEngine::kParallelUpdate);
         IEffect *effectRef = 0;
@@ -359,6 +414,32 @@ void ApplicationContext::uploadEnqueuedModelProxies(ProjectProxy *projectProxy,
             failedModelProxies.append(pair);
         }
     }
+    /* models still decoding are uploaded before ones enqueued while uploading */
+    QMutexLocker locker(&m_uploadingModelsMutex); Q_UNUSED(locker);
+    while (!m_uploadingModels.isEmpty()) {
+        decodingModels.enqueue(m_uploadingModels.dequeue());
+    }
+    m_uploadingModels.swap(decodingModels);
+}
+
+ApplicationContext::UploadingModelContext *ApplicationContext::findUploadingModelContext(ModelProxy *modelProxy)
+{
+    /* m_uploadingModelsMutex must be locked by the caller */
+    UploadingModelContext *uploadingContext = m_uploadingModelContexts.value(modelProxy);
+    if (!uploadingContext) {
+        const QFileInfo fileInfo(modelProxy->fileUrl().toLocalFile());
+        const IModel *modelRef = modelProxy->data();
+        uploadingContext = new UploadingModelContext(this, fileInfo.absoluteDir().absolutePath(), modelRef->type() == IModel::kAssetModel);
+        uploadingContext->context.decodeTextures(modelRef);
+        m_uploadingModelContexts.insert(modelProxy, uploadingContext);
+    }
+    return uploadingContext;
+}
+
+bool ApplicationContext::hasEnqueuedModelProxies() const
+{
+    QMutexLocker locker(&m_uploadingModelsMutex); Q_UNUSED(locker);
+    return !m_uploadingModels.isEmpty();
 }
 
 void ApplicationContext::uploadEnqueuedEffects(ProjectProxy *projectProxy, QList<ModelProxy *> &succeededEffects, QList<ModelProxy *> &failedEffects)
@@ -416,6 +497,9 @@ void ApplicationContext::deleteAllModelProxies(ProjectProxy *projectProxy)
 
 void ApplicationContext::enqueueUploadingModel(ModelProxy *model, bool isProject)
 {
+    /* starts decoding textures now so that they are decoded while the rest of the project is loaded */
+    QMutexLocker locker(&m_uploadingModelsMutex); Q_UNUSED(locker);
+    findUploadingModelContext(model);
     m_uploadingModels.enqueue(ModelProxyPair(model, isProject));
 }
 
@@ -524,6 +608,18 @@ void ApplicationContext::removeTextureWatch(const IModel *modelRef)
 void ApplicationContext::deleteModelProxy(ModelProxy *modelProxy, ProjectProxy *projectProxyRef)
 {
     IModel *modelRef = modelProxy->data();
+    /* the model may be deleted while its textures are still decoded */
+    UploadingModelContext *uploadingContext = 0;
+    {
+        QMutexLocker locker(&m_uploadingModelsMutex); Q_UNUSED(locker);
+        uploadingContext = m_uploadingModelContexts.take(modelProxy);
+        for (int i = m_uploadingModels.size() - 1; i >= 0; i--) {
+            if (m_uploadingModels.at(i).first == modelProxy) {
+                m_uploadingModels.removeAt(i);
+            }
+        }
+    }
+    delete uploadingContext;
     /* Failed loading effect will have null IRenderEngine instance case  */
     XMLProject *projectRef = projectProxyRef->projectInstanceRef();
     if (IRenderEngine *engine = projectRef->findRenderEngine(modelRef)) {
@@ -60,6 +60,47 @@ using namespace vpvl2;
 using namespace vpvl2::extensions;
 using namespace vpvl2::extensions::qt;
 
+namespace {
+
+/* removed elements keep their parent model but lose their index */
+template<typename T>
+static inline bool isResolvable(const T *value, const IModel *modelRef)
+{
+    return value && value->parentModelRef() == modelRef && value->index() >= 0;
+}
+
+/* exposes an element list to QML without creating RefObjects until each index is accessed */
+template<typename TObject, typename TRefObject, IModel::ObjectType kType,
+         TObject *(IModel::*FindRefAt)(int) const,
+         TRefObject *(ModelProxy::*ResolveRef)(const TObject *) const>
+struct LazyRefObjectList {
+    static int count(QQmlListProperty<TRefObject> *property) {
+        const ModelProxy *modelProxy = static_cast<const ModelProxy *>(property->data);
+        return modelProxy->data()->count(kType);
+    }
+    static TRefObject *at(QQmlListProperty<TRefObject> *property, int index) {
+        const ModelProxy *modelProxy = static_cast<const ModelProxy *>(property->data);
+        if (const TObject *value = (modelProxy->data()->*FindRefAt)(index)) {
+            return (modelProxy->*ResolveRef)(value);
+        }
+        return 0;
+    }
+    static QQmlListProperty<TRefObject> create(ModelProxy *modelProxy) {
+        return QQmlListProperty<TRefObject>(modelProxy, modelProxy, &count, &at);
+    }
+};
+
+typedef LazyRefObjectList<IVertex, VertexRefObject, IModel::kVertex,
+                          &IModel::findVertexRefAt, &ModelProxy::resolveVertexRef> LazyVertexList;
+typedef LazyRefObjectList<IMaterial, MaterialRefObject, IModel::kMaterial,
+                          &IModel::findMaterialRefAt, &ModelProxy::resolveMaterialRef> LazyMaterialList;
+typedef LazyRefObjectList<IRigidBody, RigidBodyRefObject, IModel::kRigidBody,
+                          &IModel::findRigidBodyRefAt, &ModelProxy::resolveRigidBodyRef> LazyRigidBodyList;
+typedef LazyRefObjectList<IJoint, JointRefObject, IModel::kJoint,
+                          &IModel::findJointRefAt, &ModelProxy::resolveJointRef> LazyJointList;
+
+}
+
 ModelProxy::ModelProxy(ProjectProxy *project,
                        IModel *model,
                        const QUuid &uuid,
@@ -109,14 +150,14 @@ ModelProxy::~ModelProxy()
     m_allMorphs.clear();
     qDeleteAll(m_allLabels);
     m_allLabels.clear();
-    qDeleteAll(m_allMaterials);
-    m_allMaterials.clear();
-    qDeleteAll(m_allVertices);
-    m_allVertices.clear();
-    qDeleteAll(m_allRigidBodies);
-    m_allRigidBodies.clear();
-    qDeleteAll(m_allJoints);
-    m_allJoints.clear();
+    qDeleteAll(m_material2Refs);
+    m_material2Refs.clear();
+    qDeleteAll(m_vertex2Refs);
+    m_vertex2Refs.clear();
+    qDeleteAll(m_rigidBody2Refs);
+    m_rigidBody2Refs.clear();
+    qDeleteAll(m_joint2Refs);
+    m_joint2Refs.clear();
     m_parentProjectRef = 0;
     m_undoStackRef = 0;
     m_childMotionRef = 0;
@@ -181,12 +222,12 @@ QJsonValue ModelProxy::toJson() const
     v.insert("translation", Util::toJson(translation()));
     v.insert("orientation", Util::toJson(orientation()));
     QJsonArray vertices;
-    foreach (VertexRefObject *vertex, m_allVertices) {
+    foreach (VertexRefObject *vertex, allVertexRefs()) {
         vertices.append(vertex->toJson());
     }
     v.insert("vertices", vertices);
     QJsonArray materials;
-    foreach (MaterialRefObject *material, m_allMaterials) {
+    foreach (MaterialRefObject *material, allMaterialRefs()) {
         materials.append(material->toJson());
     }
     v.insert("materials", materials);
@@ -206,12 +247,12 @@ QJsonValue ModelProxy::toJson() const
     }
     v.insert("morphs", morphs);
     QJsonArray rigidBodies;
-    foreach (RigidBodyRefObject *body, m_allRigidBodies) {
+    foreach (RigidBodyRefObject *body, allRigidBodyRefs()) {
         rigidBodies.append(body->toJson());
     }
     v.insert("rigidBodies", rigidBodies);
     QJsonArray joints;
-    foreach (JointRefObject *joint, m_allJoints) {
+    foreach (JointRefObject *joint, allJointRefs()) {
         joints.append(joint->toJson());
     }
     v.insert("joints", joints);
@@ -226,12 +267,6 @@ void ModelProxy::initialize(bool all)
     initializeAllBones(labelRefs);
     initializeAllMorphs(labelRefs, all);
     qSort(m_allLabels.begin(), m_allLabels.end(), Util::LessThan());
-    if (all) {
-        initializeAllJoints();
-        initializeAllMaterials();
-        initializeAllRigidBodies();
-        initializeAllVertices();
-    }
     setDirty(false);
 }
 
@@ -535,11 +570,21 @@ QList<QObject *> ModelProxy::findMorphsByCategory(int type) const
 
 MaterialRefObject *ModelProxy::resolveMaterialRef(const vpvl2::IMaterial *value) const
 {
-    return m_material2Refs.value(value);
+    MaterialRefObject *material = m_material2Refs.value(value);
+    if (!material && isResolvable(value, m_model.data())) {
+        material = new MaterialRefObject(const_cast<ModelProxy *>(this), const_cast<IMaterial *>(value), QUuid::createUuid());
+        connect(material, &MaterialRefObject::texturePathDidChange, this, &ModelProxy::texturePathDidChange);
+        m_material2Refs.insert(value, material);
+        m_name2MaterialRefs.insert(material->name(), material);
+        m_uuid2MaterialRefs.insert(material->uuid(), material);
+    }
+    return material;
 }
 
 MaterialRefObject *ModelProxy::findMaterialByName(const QString &name) const
 {
+    /* names are registered on materialization, so resolve all materials before lookup */
+    allMaterialRefs();
     return m_name2MaterialRefs.value(name);
 }
 
@@ -550,7 +595,13 @@ MaterialRefObject *ModelProxy::findMaterialByUuid(const QUuid &uuid) const
 
 VertexRefObject *ModelProxy::resolveVertexRef(const vpvl2::IVertex *value) const
 {
-    return m_vertex2Refs.value(value);
+    VertexRefObject *vertex = m_vertex2Refs.value(value);
+    if (!vertex && isResolvable(value, m_model.data())) {
+        vertex = new VertexRefObject(const_cast<ModelProxy *>(this), const_cast<IVertex *>(value), QUuid::createUuid());
+        m_vertex2Refs.insert(value, vertex);
+        m_uuid2VertexRefs.insert(vertex->uuid(), vertex);
+    }
+    return vertex;
 }
 
 VertexRefObject *ModelProxy::findVertexByUuid(const QUuid &uuid) const
@@ -560,11 +611,19 @@ VertexRefObject *ModelProxy::findVertexByUuid(const QUuid &uuid) const
 
 RigidBodyRefObject *ModelProxy::resolveRigidBodyRef(const vpvl2::IRigidBody *value) const
 {
-    return m_rigidBody2Refs.value(value);
+    RigidBodyRefObject *body = m_rigidBody2Refs.value(value);
+    if (!body && isResolvable(value, m_model.data())) {
+        body = new RigidBodyRefObject(const_cast<ModelProxy *>(this), const_cast<IRigidBody *>(value), QUuid::createUuid());
+        m_rigidBody2Refs.insert(value, body);
+        m_name2RigidBodyRefs.insert(body->name(), body);
+        m_uuid2RigidBodyRefs.insert(body->uuid(), body);
+    }
+    return body;
 }
 
 RigidBodyRefObject *ModelProxy::findRigidBodyByName(const QString &name) const
 {
+    allRigidBodyRefs();
     return m_name2RigidBodyRefs.value(name);
 }
 
@@ -575,11 +634,19 @@ RigidBodyRefObject *ModelProxy::findRigidBodyByUuid(const QUuid &uuid) const
 
 JointRefObject *ModelProxy::resolveJointRef(const vpvl2::IJoint *value) const
 {
-    return m_joint2Refs.value(value);
+    JointRefObject *joint = m_joint2Refs.value(value);
+    if (!joint && isResolvable(value, m_model.data())) {
+        joint = new JointRefObject(const_cast<ModelProxy *>(this), const_cast<IJoint *>(value), QUuid::createUuid());
+        m_joint2Refs.insert(value, joint);
+        m_name2JointRefs.insert(joint->name(), joint);
+        m_uuid2JointRefs.insert(joint->uuid(), joint);
+    }
+    return joint;
 }
 
 JointRefObject *ModelProxy::findJointByName(const QString &name) const
 {
+    allJointRefs();
     return m_name2JointRefs.value(name);
 }
 
@@ -588,13 +655,60 @@ JointRefObject *ModelProxy::findJointByUuid(const QUuid &uuid) const
     return m_uuid2JointRefs.value(uuid);
 }
 
+int ModelProxy::countObjects(ObjectType type) const
+{
+    Q_ASSERT(m_model);
+    switch (type) {
+    case Vertex:
+        return m_model->count(IModel::kVertex);
+    case Material:
+        return m_model->count(IModel::kMaterial);
+    case Bone:
+        return m_model->count(IModel::kBone);
+    case Morph:
+        return m_model->count(IModel::kMorph);
+    case Label:
+        return m_allLabels.size();
+    case RigidBody:
+        return m_model->count(IModel::kRigidBody);
+    case Joint:
+        return m_model->count(IModel::kJoint);
+    case SoftBody:
+        return m_model->count(IModel::kSoftBody);
+    default:
+        return 0;
+    }
+}
+
+QObject *ModelProxy::findObjectAt(ObjectType type, int index) const
+{
+    Q_ASSERT(m_model);
+    switch (type) {
+    case Vertex:
+        return resolveVertexRef(m_model->findVertexRefAt(index));
+    case Material:
+        return resolveMaterialRef(m_model->findMaterialRefAt(index));
+    case Bone:
+        return resolveBoneRef(m_model->findBoneRefAt(index));
+    case Morph:
+        return resolveMorphRef(m_model->findMorphRefAt(index));
+    case Label:
+        return m_allLabels.value(index);
+    case RigidBody:
+        return resolveRigidBodyRef(m_model->findRigidBodyRefAt(index));
+    case Joint:
+        return resolveJointRef(m_model->findJointRefAt(index));
+    case SoftBody:
+    default:
+        return 0;
+    }
+}
+
 VertexRefObject *ModelProxy::createVertex()
 {
     Q_ASSERT(m_model);
     QScopedPointer<IVertex> vertex(m_model->createVertex());
     QScopedPointer<VertexRefObject> vertexRef(new VertexRefObject(this, vertex.data(), QUuid::createUuid()));
-    initializeAllVertices();
-    m_allVertices.append(vertexRef.data());
     m_uuid2VertexRefs.insert(vertexRef->uuid(), vertexRef.data());
     m_vertex2Refs.insert(vertex.data(), vertexRef.data());
     m_model->addVertex(vertex.take());
@@ -607,8 +721,6 @@ MaterialRefObject *ModelProxy::createMaterial()
     Q_ASSERT(m_model);
     QScopedPointer<IMaterial> material(m_model->createMaterial());
     QScopedPointer<MaterialRefObject> materialRef(new MaterialRefObject(this, material.data(), QUuid::createUuid()));
-    initializeAllMaterials();
-    m_allMaterials.append(materialRef.data());
     m_uuid2MaterialRefs.insert(materialRef->uuid(), materialRef.data());
     m_material2Refs.insert(material.data(), materialRef.data());
     m_model->addMaterial(material.take());
@@ -658,8 +770,6 @@ RigidBodyRefObject *ModelProxy::createRigidBody()
     Q_ASSERT(m_model);
     QScopedPointer<IRigidBody> body(m_model->createRigidBody());
     QScopedPointer<RigidBodyRefObject> bodyRef(new RigidBodyRefObject(this, body.data(), QUuid::createUuid()));
-    initializeAllRigidBodies();
-    m_allRigidBodies.append(bodyRef.data());
     m_uuid2RigidBodyRefs.insert(bodyRef->uuid(), bodyRef.data());
     m_rigidBody2Refs.insert(body.data(), bodyRef.data());
     m_model->addRigidBody(body.take());
@@ -672,8 +782,6 @@ JointRefObject *ModelProxy::createJoint()
     Q_ASSERT(m_model);
     QScopedPointer<IJoint> joint(m_model->createJoint());
     QScopedPointer<JointRefObject> jointRef(new JointRefObject(this, joint.data(), QUuid::createUuid()));
-    initializeAllJoints();
-    m_allJoints.append(jointRef.data());
     m_uuid2JointRefs.insert(jointRef->uuid(), jointRef.data());
     m_joint2Refs.insert(joint.data(), jointRef.data());
     m_model->addJoint(joint.take());
@@ -727,30 +835,31 @@ bool ModelProxy::removeVertex(VertexRefObject *value)
 {
     Q_ASSERT(m_model);
     Q_ASSERT(value);
-    initializeAllVertices();
+    if (m_vertex2Refs.value(value->data()) != value) {
+        return false;
+    }
     m_model->removeVertex(value->data());
     m_vertex2Refs.remove(value->data());
     m_uuid2VertexRefs.remove(value->uuid());
-    if (m_allVertices.removeOne(value)) {
-        emit allVerticesChanged();
-        return true;
-    }
-    return false;
+    emit allVerticesChanged();
+    return true;
 }
 
 bool ModelProxy::removeMaterial(MaterialRefObject *value)
 {
     Q_ASSERT(m_model);
     Q_ASSERT(value);
-    initializeAllMaterials();
+    if (m_material2Refs.value(value->data()) != value) {
+        return false;
+    }
     m_model->removeMaterial(value->data());
     m_material2Refs.remove(value->data());
     m_uuid2MaterialRefs.remove(value->uuid());
-    if (m_allMaterials.removeOne(value)) {
-        emit allMaterialsChanged();
-        return true;
+    if (m_name2MaterialRefs.value(value->name()) == value) {
+        m_name2MaterialRefs.remove(value->name());
     }
-    return false;
+    emit allMaterialsChanged();
+    return true;
 }
 
 bool ModelProxy::removeBone(BoneRefObject *value)
@@ -797,30 +906,34 @@ bool ModelProxy::removeRigidBody(RigidBodyRefObject *value)
 {
     Q_ASSERT(m_model);
     Q_ASSERT(value);
-    initializeAllRigidBodies();
+    if (m_rigidBody2Refs.value(value->data()) != value) {
+        return false;
+    }
     m_model->removeRigidBody(value->data());
     m_rigidBody2Refs.remove(value->data());
     m_uuid2RigidBodyRefs.remove(value->uuid());
-    if (m_allRigidBodies.removeOne(value)) {
-        emit allRigidBodiesChanged();
-        return true;
+    if (m_name2RigidBodyRefs.value(value->name()) == value) {
+        m_name2RigidBodyRefs.remove(value->name());
     }
-    return false;
+    emit allRigidBodiesChanged();
+    return true;
 }
 
 bool ModelProxy::removeJoint(JointRefObject *value)
 {
     Q_ASSERT(m_model);
     Q_ASSERT(value);
-    initializeAllJoints();
+    if (m_joint2Refs.value(value->data()) != value) {
+        return false;
+    }
     m_model->removeJoint(value->data());
     m_joint2Refs.remove(value->data());
     m_uuid2JointRefs.remove(value->uuid());
-    if (m_allJoints.removeOne(value)) {
-        emit allJointsChanged();
-        return true;
+    if (m_name2JointRefs.value(value->name()) == value) {
+        m_name2JointRefs.remove(value->name());
     }
-    return false;
+    emit allJointsChanged();
+    return true;
 }
 
 bool ModelProxy::removeObject(QObject *value)
@@ -1057,26 +1170,22 @@ QQmlListProperty<MorphRefObject> ModelProxy::allMorphs()
 
 QQmlListProperty<MaterialRefObject> ModelProxy::allMaterials()
 {
-    initializeAllMaterials();
-    return QQmlListProperty<MaterialRefObject>(this, m_allMaterials);
+    return LazyMaterialList::create(this);
 }
 
 QQmlListProperty<VertexRefObject> ModelProxy::allVertices()
 {
-    initializeAllVertices();
-    return QQmlListProperty<VertexRefObject>(this, m_allVertices);
+    return LazyVertexList::create(this);
 }
 
 QQmlListProperty<RigidBodyRefObject> ModelProxy::allRigidBodies()
 {
-    initializeAllRigidBodies();
-    return QQmlListProperty<RigidBodyRefObject>(this, m_allRigidBodies);
+    return LazyRigidBodyList::create(this);
 }
 
 QQmlListProperty<JointRefObject> ModelProxy::allJoints()
 {
-    initializeAllJoints();
-    return QQmlListProperty<JointRefObject>(this, m_allJoints);
+    return LazyJointList::create(this);
 }
 
 QQmlListProperty<IKConstraintRefObject> ModelProxy::allIKConstraints()
@@ -1335,22 +1444,58 @@ QList<MorphRefObject *> ModelProxy::allMorphRefs() const
 
 QList<MaterialRefObject *> ModelProxy::allMaterialRefs() const
 {
-    return m_allMaterials;
+    Q_ASSERT(m_model);
+    Array<IMaterial *> materialRefs;
+    m_model->getMaterialRefs(materialRefs);
+    const int nmaterials = materialRefs.count();
+    QList<MaterialRefObject *> materials;
+    materials.reserve(nmaterials);
+    for (int i = 0; i < nmaterials; i++) {
+        materials.append(resolveMaterialRef(materialRefs[i]));
+    }
+    return materials;
 }
 
 QList<VertexRefObject *> ModelProxy::allVertexRefs() const
 {
-    return m_allVertices;
+    Q_ASSERT(m_model);
+    Array<IVertex *> vertexRefs;
+    m_model->getVertexRefs(vertexRefs);
+    const int nvertices = vertexRefs.count();
+    QList<VertexRefObject *> vertices;
+    vertices.reserve(nvertices);
+    for (int i = 0; i < nvertices; i++) {
+        vertices.append(resolveVertexRef(vertexRefs[i]));
+    }
+    return vertices;
 }
 
 QList<RigidBodyRefObject *> ModelProxy::allRigidBodyRefs() const
 {
-    return m_allRigidBodies;
+    Q_ASSERT(m_model);
+    Array<IRigidBody *> bodyRefs;
+    m_model->getRigidBodyRefs(bodyRefs);
+    const int nbodies = bodyRefs.count();
+    QList<RigidBodyRefObject *> bodies;
+    bodies.reserve(nbodies);
+    for (int i = 0; i < nbodies; i++) {
+        bodies.append(resolveRigidBodyRef(bodyRefs[i]));
+    }
+    return bodies;
 }
 
 QList<JointRefObject *> ModelProxy::allJointRefs() const
 {
-    return m_allJoints;
+    Q_ASSERT(m_model);
+    Array<IJoint *> jointRefs;
+    m_model->getJointRefs(jointRefs);
+    const int njoints = jointRefs.count();
+    QList<JointRefObject *> joints;
+    joints.reserve(njoints);
+    for (int i = 0; i < njoints; i++) {
+        joints.append(resolveJointRef(jointRefs[i]));
+    }
+    return joints;
 }
 
 QList<IKConstraintRefObject *> ModelProxy::allIKConstraintRefs() const
@@ -1358,6 +1503,29 @@ QList<IKConstraintRefObject *> ModelProxy::allIKConstraintRefs() const
     return m_allIKConstraints;
 }
 
+int ModelProxy::countMaterializedObjects(ObjectType type) const
+{
+    switch (type) {
+    case Vertex:
+        return m_vertex2Refs.size();
+    case Material:
+        return m_material2Refs.size();
+    case Bone:
+        return m_bone2Refs.size();
+    case Morph:
+        return m_morph2Refs.size();
+    case Label:
+        return m_allLabels.size();
+    case RigidBody:
+        return m_rigidBody2Refs.size();
+    case Joint:
+        return m_joint2Refs.size();
+    case SoftBody:
+    default:
+        return 0;
+    }
+}
+
 void ModelProxy::resetLanguage()
 {
     /* force updating language property */
@@ -1443,78 +1611,6 @@ void ModelProxy::initializeAllMorphs(const Array<ILabel *> &labelRefs, bool all)
     }
 }
 
-void ModelProxy::initializeAllVertices()
-{
-    if (m_allVertices.isEmpty()) {
-        Array<IVertex *> vertexRefs;
-        m_model->getVertexRefs(vertexRefs);
-        const int nvertices = vertexRefs.count();
-        for (int i = 0; i < nvertices; i++) {
-            IVertex *vertexRef = vertexRefs[i];
-            VertexRefObject *vertex = new VertexRefObject(this, vertexRef, QUuid::createUuid());
-            m_allVertices.append(vertex);
-            m_vertex2Refs.insert(vertexRef, vertex);
-            m_uuid2VertexRefs.insert(vertex->uuid(), vertex);
-        }
-        qSort(m_allVertices.begin(), m_allVertices.end(), Util::LessThan());
-    }
-}
-
-void ModelProxy::initializeAllMaterials()
-{
-    if (m_allMaterials.isEmpty()) {
-        Array<IMaterial *> materialRefs;
-        m_model->getMaterialRefs(materialRefs);
-        const int nmaterials = materialRefs.count();
-        for (int i = 0; i < nmaterials; i++) {
-            IMaterial *materialRef = materialRefs[i];
-            MaterialRefObject *material = new MaterialRefObject(this, materialRef, QUuid::createUuid());
-            connect(material, &MaterialRefObject::texturePathDidChange, this, &ModelProxy::texturePathDidChange);
-            m_allMaterials.append(material);
-            m_material2Refs.insert(materialRef, material);
-            m_name2MaterialRefs.insert(material->name(), material);
-            m_uuid2MaterialRefs.insert(material->uuid(), material);
-        }
-        qSort(m_allMaterials.begin(), m_allMaterials.end(), Util::LessThan());
-    }
-}
-
-void ModelProxy::initializeAllRigidBodies()
-{
-    if (m_allRigidBodies.isEmpty()) {
-        Array<IRigidBody *> rigidBodyRefs;
-        m_model->getRigidBodyRefs(rigidBodyRefs);
-        const int nbodies = rigidBodyRefs.count();
-        for (int i = 0; i < nbodies; i++) {
-            IRigidBody *rigidBodyRef = rigidBodyRefs[i];
-            RigidBodyRefObject *rigidBody = new RigidBodyRefObject(this, rigidBodyRef, QUuid::createUuid());
-            m_allRigidBodies.append(rigidBody);
-            m_rigidBody2Refs.insert(rigidBodyRef, rigidBody);
-            m_name2RigidBodyRefs.insert(rigidBody->name(), rigidBody);
-            m_uuid2RigidBodyRefs.insert(rigidBody->uuid(), rigidBody);
-        }
-        qSort(m_allRigidBodies.begin(), m_allRigidBodies.end(), Util::LessThan());
-    }
-}
-
-void ModelProxy::initializeAllJoints()
-{
-    if (m_allJoints.isEmpty()) {
-        Array<IJoint *> jointRefs;
-        m_model->getJointRefs(jointRefs);
-        const int njoints = jointRefs.count();
-        for (int i = 0; i < njoints; i++) {
-            IJoint *jointRef = jointRefs[i];
-            JointRefObject *joint = new JointRefObject(this, jointRef, QUuid::createUuid());
-            m_allJoints.append(joint);
-            m_joint2Refs.insert(jointRef, joint);
-            m_name2JointRefs.insert(joint->name(), joint);
-            m_uuid2JointRefs.insert(joint->uuid(), joint);
-        }
-        qSort(m_allJoints.begin(), m_allJoints.end(), Util::LessThan());
-    }
-}
-
 void ModelProxy::initializeAllIKConstraints()
 {
     if (m_allIKConstraints.isEmpty()) {
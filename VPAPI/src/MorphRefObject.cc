@@ -423,7 +423,7 @@ QString ChildMaterialMorphRefObject::name() const
     if (materials.isEmpty()) {
         names << tr("(Empty)");
     }
-    else if (materials.size() == m_parentMorphRef->parentModel()->allMaterialRefs().size()) {
+    else if (materials.size() == m_parentMorphRef->parentModel()->data()->count(IModel::kMaterial)) {
         names << tr("(All)");
     }
     else {
@@ -59,6 +59,7 @@
 
 #include <vpvl2/vpvl2.h>
 #include <vpvl2/extensions/qt/String.h>
+#include <vpvl2/vmd/Motion.h>
 
 using namespace vpvl2;
 using namespace vpvl2::extensions::qt;
@@ -902,6 +903,11 @@ void MotionProxy::assignModel(ModelProxy *modelProxy, const Factory *factoryRef)
     loadBoneTrackBundle(motionRef, numBoneKeyframes, numEstimatedTotalKeyframes, numLoadedKeyframes);
     loadMorphTrackBundle(motionRef, numMorphKeyframes, numEstimatedTotalKeyframes, numLoadedKeyframes);
     emit motionDidLoad(numLoadedKeyframes, numEstimatedTotalKeyframes);
+    /* sort keyframes of the motion once after adding all of the first keyframes */
+    vmd::Motion *vmdMotionRef = motionRef->type() == IMotion::kVMDFormat ? static_cast<vmd::Motion *>(motionRef) : 0;
+    if (vmdMotionRef) {
+        vmdMotionRef->beginBatchEdit();
+    }
     QScopedPointer<IBoneKeyframe> boneKeyframe;
     foreach (const BoneRefObject *bone, modelProxy->allBoneRefs()) {
         if (!findBoneMotionTrack(bone)) {
@@ -926,6 +932,9 @@ void MotionProxy::assignModel(ModelProxy *modelProxy, const Factory *factoryRef)
             track->addKeyframe(track->convertMorphKeyframe(morphKeyframe.take()), false);
         }
     }
+    if (vmdMotionRef) {
+        vmdMotionRef->endBatchEdit();
+    }
     refresh();
 }
 
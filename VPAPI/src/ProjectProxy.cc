@@ -41,6 +41,7 @@
 #include <vpvl2/extensions/XMLProject.h>
 #include <vpvl2/extensions/qt/Encoding.h>
 #include <vpvl2/extensions/qt/String.h>
+#include <vpvl2/pmx/Model.h>
 
 #define GLM_FORCE_RADIANS
 #include <glm/glm.hpp>
@@ -78,33 +79,50 @@ using namespace vpvl2::extensions::qt;
 
 namespace {
 
-struct ProjectDelegate : public XMLProject::IDelegate {
-    ProjectDelegate(ProjectProxy *proxy)
-        : m_projectRef(proxy)
+/* maps a model or motion file to read it without copying into an intermediate buffer */
+class MappedFile : public pmx::Model::MappedData {
+public:
+    MappedFile(const QString &filename)
+        : m_file(filename),
+          m_address(0),
+          m_size(0)
     {
-        Q_ASSERT(m_projectRef);
-    }
-    ~ProjectDelegate() {
-        m_projectRef = 0;
-    }
-    std::string toStdFromString(const IString *value) const {
-        return Util::toQString(value).toStdString();
-    }
-    IString *toStringFromStd(const std::string &value) const {
-        return String::create(value);
     }
-    bool loadModel(const XMLProject::UUID &uuid, const StringMap &settings, IModel::Type /* type */, IModel *&model, IRenderEngine *&engine, int &priority) {
-        const std::string &uri = settings.value(XMLProject::kSettingURIKey, std::string());
-        if (ModelProxy *modelProxy = m_projectRef->internalLoadModel(QUrl::fromLocalFile(QString::fromStdString(uri)), QUuid(QString::fromStdString(uuid)))) {
-            m_projectRef->internalAddModel(modelProxy, settings.value("selected", std::string("false")) == "true", true);
-            priority = XMLProject::toIntFromString(settings.value(XMLProject::kSettingOrderKey, std::string("0")));;
-            /* upload render engine later */
-            model = modelProxy->data();
+    ~MappedFile() {
+        if (m_address && m_bytes.isNull()) {
+            m_file.unmap(m_address);
         }
-        engine = 0;
-        return model;
+        m_address = 0;
+        m_size = 0;
+    }
+
+    bool open() {
+        if (m_file.open(QFile::ReadOnly | QFile::Unbuffered)) {
+            m_size = m_file.size();
+            m_address = m_file.map(0, m_size);
+            if (!m_address) {
+                /* fallback to read whole file such as an empty file or unmappable file system */
+                m_bytes = m_file.readAll();
+                m_address = reinterpret_cast<uchar *>(m_bytes.data());
+                m_size = m_bytes.size();
+            }
+            return true;
+        }
+        return false;
     }
-    ProjectProxy *m_projectRef;
+    const uint8_t *address() const { return m_address; }
+    vsize size() const { return vsize(m_size); }
+    bool isPMX() const { return Factory::findModelType(m_address, vsize(m_size)) == IModel::kPMXModel; }
+    QString fileName() const { return m_file.fileName(); }
+    QString errorString() const { return m_file.errorString(); }
+
+private:
+    QFile m_file;
+    QByteArray m_bytes;
+    uchar *m_address;
+    qint64 m_size;
+
+    Q_DISABLE_COPY(MappedFile)
 };
 
 class ModelLoader : public QObject, public QRunnable {
@@ -124,16 +142,23 @@ public:
     }
 
     bool load(QScopedPointer<IModel> &model, QString &errorString) {
-        QFile file(m_fileUrl.toLocalFile());
+        QScopedPointer<MappedFile> file(new MappedFile(m_fileUrl.toLocalFile()));
         bool ok = false;
-        if (file.open(QFile::ReadOnly)) {
-            const QByteArray &bytes = file.readAll();
-            const uint8_t *ptr = reinterpret_cast<const uint8_t *>(bytes.constData());
-            model.reset(m_factoryRef->createModel(ptr, file.size(), ok));
+        if (file->open()) {
+            const QString fileName = file->fileName();
+            if (file->isPMX()) {
+                /* PMX indices are read from the mapping so the model keeps the mapped file */
+                pmx::Model *pmxModel = static_cast<pmx::Model *>(m_factoryRef->newModel(IModel::kPMXModel));
+                model.reset(pmxModel);
+                ok = pmxModel->loadMapped(file.take());
+            }
+            else {
+                model.reset(m_factoryRef->createModel(file->address(), file->size(), ok));
+            }
             if (ok) {
                 /* set filename of the model if the name of the model is null such as asset */
                 if (!model->name(IEncoding::kDefaultLanguage)) {
-                    const qt::String s(QFileInfo(file.fileName()).fileName());
+                    const qt::String s(QFileInfo(fileName).fileName());
                     model->setName(&s, IEncoding::kDefaultLanguage);
                 }
             }
@@ -143,7 +168,7 @@ public:
             }
         }
         else {
-            errorString = file.errorString();
+            errorString = file->errorString();
         }
         return ok;
     }
@@ -164,6 +189,150 @@ private:
     const bool m_skipConfirm;
 };
 
+/* parses model files of a project on the thread pool ahead of XMLProject::IDelegate::loadModel */
+class ModelPrefetcher {
+public:
+    ModelPrefetcher(const Factory *factoryRef)
+        : m_factoryRef(factoryRef),
+          m_numRunningTasks(0)
+    {
+        Q_ASSERT(m_factoryRef);
+    }
+    ~ModelPrefetcher() {
+        QMutexLocker locker(&m_mutex);
+        while (m_numRunningTasks > 0) {
+            m_condition.wait(&m_mutex);
+        }
+        foreach (const Result &result, m_results) {
+            delete result.model;
+        }
+        m_results.clear();
+    }
+
+    void enqueue(const QUuid &uuid, const QUrl &fileUrl) {
+        QMutexLocker locker(&m_mutex);
+        if (!m_results.contains(uuid) && fileUrl.isValid()) {
+            m_results.insert(uuid, Result());
+            m_numRunningTasks++;
+            QThreadPool::globalInstance()->start(new Task(this, uuid, fileUrl));
+        }
+    }
+    bool contains(const QUuid &uuid) const {
+        QMutexLocker locker(&m_mutex);
+        return m_results.contains(uuid);
+    }
+    IModel *take(const QUuid &uuid, QString &errorString) {
+        QMutexLocker locker(&m_mutex);
+        while (m_results.contains(uuid) && !m_results.value(uuid).done) {
+            m_condition.wait(&m_mutex);
+        }
+        const Result &result = m_results.take(uuid);
+        errorString = result.errorString;
+        return result.model;
+    }
+
+private:
+    struct Result {
+        Result()
+            : model(0),
+              done(false)
+        {
+        }
+        IModel *model;
+        QString errorString;
+        bool done;
+    };
+    class Task : public QRunnable {
+    public:
+        Task(ModelPrefetcher *prefetcher, const QUuid &uuid, const QUrl &fileUrl)
+            : m_prefetcherRef(prefetcher),
+              m_uuid(uuid),
+              m_fileUrl(fileUrl)
+        {
+        }
+        void run() {
+            ModelLoader loader(m_prefetcherRef->m_factoryRef, m_fileUrl, true, 0);
+            QScopedPointer<IModel> model;
+            QString errorString;
+            loader.load(model, errorString);
+            m_prefetcherRef->complete(m_uuid, model.take(), errorString);
+        }
+    private:
+        ModelPrefetcher *m_prefetcherRef;
+        const QUuid m_uuid;
+        const QUrl m_fileUrl;
+    };
+
+    void complete(const QUuid &uuid, IModel *model, const QString &errorString) {
+        QMutexLocker locker(&m_mutex);
+        Result &result = m_results[uuid];
+        result.model = model;
+        result.errorString = errorString;
+        result.done = true;
+        m_numRunningTasks--;
+        m_condition.wakeAll();
+    }
+
+    const Factory *m_factoryRef;
+    mutable QMutex m_mutex;
+    QWaitCondition m_condition;
+    QHash<QUuid, Result> m_results;
+    int m_numRunningTasks;
+
+    Q_DISABLE_COPY(ModelPrefetcher)
+};
+
+struct ProjectDelegate : public XMLProject::IDelegate {
+    ProjectDelegate(ProjectProxy *proxy)
+        : m_projectRef(proxy)
+    {
+        Q_ASSERT(m_projectRef);
+    }
+    ~ProjectDelegate() {
+        m_projectRef = 0;
+    }
+    std::string toStdFromString(const IString *value) const {
+        return Util::toQString(value).toStdString();
+    }
+    IString *toStringFromStd(const std::string &value) const {
+        return String::create(value);
+    }
+    void prefetchModels(const XMLProject::ModelRequestList &requests) {
+        m_prefetcher.reset(new ModelPrefetcher(m_projectRef->factoryInstanceRef()));
+        for (XMLProject::ModelRequestList::const_iterator it = requests.begin(); it != requests.end(); it++) {
+            const std::string &uri = it->settings.value(XMLProject::kSettingURIKey, std::string());
+            if (!uri.empty()) {
+                m_prefetcher->enqueue(QUuid(QString::fromStdString(it->uuid)), QUrl::fromLocalFile(QString::fromStdString(uri)));
+            }
+        }
+    }
+    bool loadModel(const XMLProject::UUID &uuid, const StringMap &settings, IModel::Type /* type */, IModel *&model, IRenderEngine *&engine, int &priority) {
+        const std::string &uri = settings.value(XMLProject::kSettingURIKey, std::string());
+        const QUrl &fileUrl = QUrl::fromLocalFile(QString::fromStdString(uri));
+        const QUuid modelUUID(QString::fromStdString(uuid));
+        ModelProxy *modelProxy = 0;
+        if (m_prefetcher && m_prefetcher->contains(modelUUID)) {
+            /* the model was parsed on the thread pool and only registering runs here */
+            QString errorString;
+            IModel *prefetchedModel = m_prefetcher->take(modelUUID, errorString);
+            modelProxy = m_projectRef->internalLoadModel(prefetchedModel, fileUrl, modelUUID, errorString);
+        }
+        else {
+            modelProxy = m_projectRef->internalLoadModel(fileUrl, modelUUID);
+        }
+        if (modelProxy) {
+            m_projectRef->internalAddModel(modelProxy, settings.value("selected", std::string("false")) == "true", true);
+            priority = XMLProject::toIntFromString(settings.value(XMLProject::kSettingOrderKey, std::string("0")));;
+            /* upload render engine later */
+            model = modelProxy->data();
+        }
+        engine = 0;
+        return model;
+    }
+    ProjectProxy *m_projectRef;
+    QScopedPointer<ModelPrefetcher> m_prefetcher;
+};
+
 class MotionLoader : public QObject, public QRunnable {
     Q_OBJECT
 
@@ -190,15 +359,13 @@ signals:
 
 private:
     void run() {
-        QFile file(m_fileUrl.toLocalFile());
+        MappedFile file(m_fileUrl.toLocalFile());
         QScopedPointer<IMotion> motion;
         QString errorString;
         bool ok = false;
-        if (file.open(QFile::ReadOnly)) {
-            const QByteArray &bytes = file.readAll();
-            const uint8_t *ptr = reinterpret_cast<const uint8_t *>(bytes.constData());
+        if (file.open()) {
             IModel *modelRef = m_parentModel ? m_parentModel->data() : 0;
-            motion.reset(m_factoryRef->createMotion(ptr, file.size(), modelRef, ok));
+            motion.reset(m_factoryRef->createMotion(file.address(), file.size(), modelRef, ok));
             if (!ok) {
                 errorString = QStringLiteral("errno=%1").arg(motion->error());
                 motion.reset();
@@ -359,7 +526,9 @@ bool ProjectProxy::save(const QUrl &fileUrl)
     }
     QTemporaryFile temp;
     if (temp.open()) {
-        saved = m_project->save(temp.fileName().toUtf8().constData());
+        const XMLProject::FormatType format = QFileInfo(fileUrl.toLocalFile()).suffix() == QStringLiteral("vpvb")
+                ? XMLProject::kBinaryFormat : XMLProject::kXMLFormat;
+        saved = m_project->save(temp.fileName().toUtf8().constData(), format);
         QSaveFile saveFile(fileUrl.toLocalFile());
         if (saveFile.open(QFile::WriteOnly | QFile::Unbuffered)) {
             saveFile.write(temp.readAll());
@@ -1196,7 +1365,16 @@ void ProjectProxy::internalLoadAsync()
 {
     disconnect(this, &ProjectProxy::enqueuedModelsDidDelete, this, &ProjectProxy::internalLoadAsync);
     createProjectInstance();
-    m_project->load(m_fileUrl.toLocalFile().toUtf8().constData());
+    QFile file(m_fileUrl.toLocalFile());
+    uchar *address = file.open(QFile::ReadOnly) ? file.map(0, file.size()) : 0;
+    if (address) {
+        /* the binary project is parsed in place from the mapped file */
+        m_project->load(address, file.size());
+        file.unmap(address);
+    }
+    else {
+        m_project->load(m_fileUrl.toLocalFile().toUtf8().constData());
+    }
     Array<IMotion *> motionRefs;
     m_project->getMotionRefs(motionRefs);
     const int nmotions = motionRefs.count();
@@ -1252,12 +1430,18 @@ ModelProxy *ProjectProxy::internalLoadModel(const QUrl &fileUrl, const QUuid &uu
     QScopedPointer<IModel> model;
     QString errorString;
     loader.load(model, errorString);
+    return internalLoadModel(model.take(), fileUrl, uuid, errorString);
+}
+
+ModelProxy *ProjectProxy::internalLoadModel(IModel *model, const QUrl &fileUrl, const QUuid &uuid, const QString &errorString)
+{
     ModelProxy *modelProxy = 0;
     if (model) {
-        modelProxy = createModelProxy(model.take(), uuid, fileUrl);
+        modelProxy = createModelProxy(model, uuid, fileUrl);
         emit modelDidLoad(modelProxy, true);
     }
     else {
+        setErrorString(errorString);
         emit modelDidFailLoading();
     }
     return modelProxy;
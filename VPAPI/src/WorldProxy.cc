@@ -89,8 +89,11 @@ WorldProxy::WorldProxy(ProjectProxy *parent)
       m_lastGravity(gravity()),
       m_lastTimeIndex(0.0),
       m_enableDebug(false),
-      m_playing(false)
+      m_playing(false),
+      m_offlineRendering(false)
 {
+    /* seeking and scrubbing are interactive too, so substeps are bounded until offline rendering starts */
+    m_sceneWorld->setSteppingPolicy(World::kInterpolateStepping);
 }
 
 WorldProxy::~WorldProxy()
@@ -140,6 +143,7 @@ void WorldProxy::leaveWorld(ModelProxy *value)
     Q_ASSERT(value);
     IModel *modelRef = value->data();
     modelRef->leaveWorld(m_sceneWorld->dynamicWorldRef());
+    m_sceneWorld->clearSnapshots();
 }
 
 void WorldProxy::resetProjectInstance(ProjectProxy *value)
@@ -156,9 +160,22 @@ void WorldProxy::stepSimulation(qreal timeIndex)
     SimulationType type = simulationType();
     if (type == EnableSimulationAnytime || (type == EnableSimulationPlayOnly && m_playing)) {
         int delta = qRound(timeIndex - m_lastTimeIndex);
+        /* restore the nearest earlier physics state on seeking instead of simulating from rest */
+        if (delta < 0 || delta > m_sceneWorld->snapshotInterval()) {
+            Scalar snapshotTimeIndex = 0, restoredTimeIndex = 0;
+            /* jumping forward restores only a snapshot ahead of the current state */
+            const bool restorable = delta < 0 || (m_sceneWorld->findSnapshot(timeIndex, snapshotTimeIndex)
+                                                  && snapshotTimeIndex > m_lastTimeIndex);
+            if (restorable && m_sceneWorld->restoreSnapshot(timeIndex, restoredTimeIndex)) {
+                delta = qRound(timeIndex - restoredTimeIndex);
+            }
+        }
         if (delta > 0) {
             m_sceneWorld->stepSimulation(delta, Scene::defaultFPS());
         }
+        if (m_playing) {
+            m_sceneWorld->captureSnapshot(timeIndex);
+        }
         m_lastTimeIndex = timeIndex;
     }
 }
@@ -167,6 +184,7 @@ void WorldProxy::rewind()
 {
     Q_ASSERT(m_sceneWorld);
     stepSimulation(0);
+    m_sceneWorld->clearSnapshots();
     XMLProject *project = m_parentProjectProxyRef->projectInstanceRef();
     Q_ASSERT(project);
     project->setWorldRef(0);
@@ -196,6 +214,14 @@ void WorldProxy::setPlaying(bool value)
     m_playing = value;
 }
 
+void WorldProxy::setOfflineRendering(bool value)
+{
+    Q_ASSERT(m_sceneWorld);
+    /* exported frames must not drop substeps regardless of the cost per frame */
+    m_offlineRendering = value;
+    m_sceneWorld->setSteppingPolicy(value ? World::kExactStepping : World::kInterpolateStepping);
+}
+
 WorldProxy::SimulationType WorldProxy::simulationType() const
 {
     return m_simulationType;
@@ -217,6 +243,7 @@ void WorldProxy::setSimulationType(SimulationType value)
             m_lastGravity = gravity();
         }
         applyAllModels(enabled);
+        m_sceneWorld->clearSnapshots();
         m_simulationType = value;
         simulationTypeChanged();
     }
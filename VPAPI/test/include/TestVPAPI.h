@@ -84,6 +84,8 @@ private slots:
     void model_addAndRemoveRigidBody();
     void model_addAndRemoveJoint_data();
     void model_addAndRemoveJoint();
+    void model_lazyResolveVertices_data();
+    void model_lazyResolveVertices();
     void model_translateTransform_data();
     void model_translateTransform();
     void model_rotateTransform_data();
@@ -608,6 +608,39 @@ void TestVPAPI::model_addAndRemoveJoint()
     delete joint;
 }
 
+void TestVPAPI::model_lazyResolveVertices_data()
+{
+    QTest::addColumn<IModel::Type>("modelType");
+    QTest::newRow("PMD") << IModel::kPMDModel;
+    QTest::newRow("PMX") << IModel::kPMXModel;
+}
+
+void TestVPAPI::model_lazyResolveVertices()
+{
+    QFETCH(IModel::Type, modelType);
+    ProjectProxy project;
+    project.initializeOnce();
+    QScopedPointer<IModel> model(project.factoryInstanceRef()->newModel(modelType));
+    for (int i = 0; i < 3; i++) {
+        model->addVertex(model->createVertex());
+    }
+    ModelProxy *modelProxy = project.createModelProxy(model.take(), QUuid::createUuid(), QUrl());
+    QCOMPARE(modelProxy->countObjects(ModelProxy::Vertex), 3);
+    QCOMPARE(modelProxy->countMaterializedObjects(ModelProxy::Vertex), 0);
+    VertexRefObject *vertex = qobject_cast<VertexRefObject *>(modelProxy->findObjectAt(ModelProxy::Vertex, 1));
+    QVERIFY(vertex);
+    QCOMPARE(modelProxy->countMaterializedObjects(ModelProxy::Vertex), 1);
+    QCOMPARE(modelProxy->findObjectAt(ModelProxy::Vertex, 1), static_cast<QObject *>(vertex));
+    QCOMPARE(modelProxy->resolveVertexRef(vertex->data()), vertex);
+    QCOMPARE(modelProxy->findVertexByUuid(vertex->uuid()), vertex);
+    QCOMPARE(modelProxy->countMaterializedObjects(ModelProxy::Vertex), 1);
+    QList<VertexRefObject *> vertices = modelProxy->allVertexRefs();
+    QCOMPARE(vertices.size(), 3);
+    QCOMPARE(vertices.at(1), vertex);
+    QCOMPARE(modelProxy->countMaterializedObjects(ModelProxy::Vertex), 3);
+    QCOMPARE(modelProxy->findObjectAt(ModelProxy::Vertex, 3), static_cast<QObject *>(0));
+}
+
 void TestVPAPI::model_translateTransform_data()
 {
     QTest::addColumn<IModel::Type>("modelType");
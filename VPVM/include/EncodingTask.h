@@ -39,11 +39,13 @@
 #ifndef ENCODINGTASK_H_
 #define ENCODINGTASK_H_
 
+#include <QAtomicInt>
 #include <QDir>
 #include <QObject>
 #include <QProcess>
 #include <QSize>
 
+class QOpenGLBuffer;
 class QOpenGLFramebufferObject;
 class QQuickWindow;
 class QTemporaryDir;
@@ -57,6 +59,8 @@ public:
     ~EncodingTask();
 
     bool isRunning() const;
+    bool isStreaming() const;
+    bool isReadyForNextFrame() const;
     void setSize(const QSize &value);
     void setTitle(const QString &value);
     void setInputImageFormat(const QString &value);
@@ -67,6 +71,8 @@ public:
     void reset();
     QOpenGLFramebufferObject *generateFramebufferObject(QQuickWindow *win);
     QString generateFilename(const qreal &timeIndex);
+    void writeFrame();
+    void finishFrames();
 
     void stop();
     void release();
@@ -78,6 +84,11 @@ public slots:
     void handleError(QProcess::ProcessError error);
     void launch();
 
+private slots:
+    void handleBytesWritten(qint64 bytes);
+    void writeFrameBytes(const QByteArray &bytes);
+    void closeWriteChannel();
+
 signals:
     void encodeDidBegin();
     void encodeDidProceed(quint64 proceed, quint64 estimated);
@@ -85,9 +96,13 @@ signals:
 
 private:
     void getArguments(QStringList &arguments);
+    void readPixelPackBuffer(QOpenGLBuffer *buffer);
+    void releasePixelPackBuffers();
 
     QScopedPointer<QProcess> m_process;
     QScopedPointer<QOpenGLFramebufferObject> m_fbo;
+    QScopedPointer<QOpenGLFramebufferObject> m_resolvedFbo;
+    QScopedPointer<QOpenGLBuffer> m_pixelPackBuffers[2];
     QScopedPointer<QTemporaryDir> m_workerDir;
     QProcess::ProcessState m_lastState;
     QDir m_workerDirPath;
@@ -101,6 +116,8 @@ private:
     QString m_outputFormat;
     QString m_pixelFormat;
     quint64 m_estimatedFrameCount;
+    quint64 m_numWrittenFrames;
+    QAtomicInt m_numPendingBytes;
 };
 
 #endif
@@ -213,7 +213,7 @@ ApplicationWindow {
     }
     FileDialog {
         id: loadProjectDialog
-        nameFilters: [ qsTr("Project File (*.xml)") ]
+        nameFilters: [ qsTr("Project File (*.xml)"), qsTr("Binary Project File (*.vpvb)") ]
         selectExisting: true
         onAccepted: {
             var fileUrlString = fileUrl.toString(),
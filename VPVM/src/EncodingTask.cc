@@ -39,6 +39,10 @@
 #include "EncodingTask.h"
 
 #include <QtCore>
+#include <QOpenGLBuffer>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions>
 #include <QQuickWindow>
 #include <vpvl2/vpvl2.h>
 
@@ -47,7 +51,8 @@ using namespace vpvl2;
 EncodingTask::EncodingTask(QObject *parent)
     : QObject(parent),
       m_lastState(QProcess::NotRunning),
-      m_estimatedFrameCount(0)
+      m_estimatedFrameCount(0),
+      m_numWrittenFrames(0)
 {
 }
 
@@ -61,6 +66,17 @@ bool EncodingTask::isRunning() const
     return m_process && m_process->state() == QProcess::Running;
 }
 
+bool EncodingTask::isStreaming() const
+{
+    return m_inputImageFormat == QStringLiteral("rawvideo");
+}
+
+bool EncodingTask::isReadyForNextFrame() const
+{
+    /* don't queue more than two frames if the encoder is slower than rendering */
+    return m_numPendingBytes.load() <= 2 * m_size.width() * m_size.height() * 4;
+}
+
 void EncodingTask::setSize(const QSize &value)
 {
     m_size = value;
@@ -105,7 +121,10 @@ void EncodingTask::reset()
     m_inputImageFormat = "bmp";
     m_outputFormat = "png";
     m_pixelFormat = "rgb24";
+    m_numWrittenFrames = 0;
+    m_numPendingBytes.store(0);
     m_fbo.reset();
+    releasePixelPackBuffers();
 }
 
 QOpenGLFramebufferObject *EncodingTask::generateFramebufferObject(QQuickWindow *win)
@@ -128,6 +147,54 @@ QString EncodingTask::generateFilename(const qreal &timeIndex)
     return path;
 }
 
+void EncodingTask::writeFrame()
+{
+    Q_ASSERT(m_fbo && isStreaming());
+    if (!isRunning()) {
+        return;
+    }
+    const int width = m_size.width(), height = m_size.height();
+    if (!m_resolvedFbo) {
+        m_resolvedFbo.reset(new QOpenGLFramebufferObject(m_size));
+        for (int i = 0; i < 2; i++) {
+            QOpenGLBuffer *buffer = new QOpenGLBuffer(QOpenGLBuffer::PixelPackBuffer);
+            buffer->setUsagePattern(QOpenGLBuffer::StreamRead);
+            buffer->create();
+            buffer->bind();
+            buffer->allocate(width * height * 4);
+            buffer->release();
+            m_pixelPackBuffers[i].reset(buffer);
+        }
+    }
+    /* resolve the multisampled framebuffer object to read pixels from it */
+    QOpenGLFramebufferObject::blitFramebuffer(m_resolvedFbo.data(), m_fbo.data());
+    QOpenGLBuffer *currentBuffer = m_pixelPackBuffers[m_numWrittenFrames % 2].data();
+    m_resolvedFbo->bind();
+    currentBuffer->bind();
+    QOpenGLContext::currentContext()->functions()->glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    currentBuffer->release();
+    m_resolvedFbo->release();
+    /* the previous frame is sent to the encoder while the current frame is being transferred */
+    if (m_numWrittenFrames > 0) {
+        readPixelPackBuffer(m_pixelPackBuffers[(m_numWrittenFrames - 1) % 2].data());
+    }
+    m_numWrittenFrames++;
+}
+
+void EncodingTask::finishFrames()
+{
+    Q_ASSERT(isStreaming());
+    if (isRunning()) {
+        if (m_numWrittenFrames > 0) {
+            readPixelPackBuffer(m_pixelPackBuffers[(m_numWrittenFrames - 1) % 2].data());
+        }
+        /* the encoder finishes by EOF of standard input after all of the queued frames are written */
+        QMetaObject::invokeMethod(this, "closeWriteChannel", Qt::QueuedConnection);
+        VPVL2_VLOG(1, "Wrote " << m_numWrittenFrames << " frames to the encoder");
+    }
+    releasePixelPackBuffers();
+}
+
 void EncodingTask::stop()
 {
     if (isRunning()) {
@@ -151,6 +218,7 @@ void EncodingTask::release()
     m_process.reset();
     m_workerDir.reset();
     m_fbo.reset();
+    releasePixelPackBuffers();
     m_estimatedFrameCount = 0;
 }
 
@@ -219,9 +287,14 @@ void EncodingTask::launch()
         m_process->setEnvironment(environments);
         connect(m_process.data(), &QProcess::started, this, &EncodingTask::handleStarted);
         connect(m_process.data(), &QProcess::readyRead, this, &EncodingTask::handleReadyRead);
+        connect(m_process.data(), &QProcess::bytesWritten, this, &EncodingTask::handleBytesWritten);
         connect(m_process.data(), &QProcess::stateChanged, this, &EncodingTask::handleStateChanged);
         connect(m_process.data(), SIGNAL(error(QProcess::ProcessError)), this, SLOT(handleError(QProcess::ProcessError)));
         m_process->start();
+        if (isStreaming()) {
+            /* frames cannot be written to standard input until the encoder has been started */
+            m_process->waitForStarted();
+        }
         VPVL2_VLOG(1, "executable=" << m_process->program().toStdString() << " arguments=" << arguments.join(" ").toStdString());
         VPVL2_VLOG(2, "Waiting for starting encoding task");
     }
@@ -241,14 +314,31 @@ void EncodingTask::getArguments(QStringList &arguments)
     arguments.append(QStringLiteral("%1").arg(30));
     arguments.append("-s");
     arguments.append(QStringLiteral("%1x%2").arg(m_size.width()).arg(m_size.height()));
-    arguments.append("-qscale");
-    arguments.append("1");
-    arguments.append("-vcodec");
-    arguments.append(m_inputImageFormat);
+    if (isStreaming()) {
+        /* raw frames read back from the framebuffer object are piped from standard input */
+        arguments.append("-f");
+        arguments.append("rawvideo");
+        arguments.append("-pix_fmt");
+        arguments.append("rgba");
+    }
+    else {
+        arguments.append("-qscale");
+        arguments.append("1");
+        arguments.append("-vcodec");
+        arguments.append(m_inputImageFormat);
+    }
     arguments.append("-metadata");
     arguments.append(QStringLiteral("title=\"%1\"").arg(m_title));
     arguments.append("-i");
-    arguments.append(m_workerDirPath.absoluteFilePath(QStringLiteral("%1-%09d.%2").arg(m_workerId).arg(m_inputImageFormat)));
+    if (isStreaming()) {
+        arguments.append("-");
+        /* rows read by glReadPixels are bottom-up */
+        arguments.append("-vf");
+        arguments.append("vflip");
+    }
+    else {
+        arguments.append(m_workerDirPath.absoluteFilePath(QStringLiteral("%1-%09d.%2").arg(m_workerId).arg(m_inputImageFormat)));
+    }
     arguments.append("-map");
     arguments.append("0");
     arguments.append("-c:v");
@@ -258,3 +348,46 @@ void EncodingTask::getArguments(QStringList &arguments)
     arguments.append("-y");
     arguments.append(m_outputPath);
 }
+
+void EncodingTask::handleBytesWritten(qint64 bytes)
+{
+    m_numPendingBytes.fetchAndAddOrdered(-int(bytes));
+}
+
+void EncodingTask::writeFrameBytes(const QByteArray &bytes)
+{
+    if (isRunning()) {
+        m_process->write(bytes);
+    }
+    else {
+        m_numPendingBytes.fetchAndAddOrdered(-bytes.size());
+    }
+}
+
+void EncodingTask::closeWriteChannel()
+{
+    if (isRunning()) {
+        m_process->closeWriteChannel();
+    }
+}
+
+void EncodingTask::readPixelPackBuffer(QOpenGLBuffer *buffer)
+{
+    const int size = buffer->size();
+    buffer->bind();
+    if (const char *pixels = static_cast<const char *>(buffer->map(QOpenGLBuffer::ReadOnly))) {
+        /* QProcess belongs to the thread of this object, not the render thread calling this */
+        const QByteArray bytes(pixels, size);
+        m_numPendingBytes.fetchAndAddOrdered(size);
+        QMetaObject::invokeMethod(this, "writeFrameBytes", Qt::QueuedConnection, Q_ARG(QByteArray, bytes));
+        buffer->unmap();
+    }
+    buffer->release();
+}
+
+void EncodingTask::releasePixelPackBuffers()
+{
+    m_pixelPackBuffers[0].reset();
+    m_pixelPackBuffers[1].reset();
+    m_resolvedFbo.reset();
+}
@@ -807,6 +807,12 @@ void RenderTarget::exportVideo(const QUrl &fileUrl, const QSize &size, const QSt
     encodingTaskRef->setInputImageFormat(frameImageType);
     encodingTaskRef->setOutputFormat(videoType);
     encodingTaskRef->setOutputPath(fileUrl.toLocalFile());
+    if (encodingTaskRef->isStreaming()) {
+        /* the encoder receives frames while playing so it must be launched first */
+        encodingTaskRef->setEstimatedFrameCount(qRound64(m_projectProxyRef->durationTimeIndex()));
+        encodingTaskRef->launch();
+    }
+    m_projectProxyRef->world()->setOfflineRendering(true);
     setPlaying(true);
     connect(window(), &QQuickWindow::frameSwapped, this, &RenderTarget::drawOffscreenForVideo, Qt::DirectConnection);
 }
@@ -819,6 +825,7 @@ void RenderTarget::cancelExportingVideo()
     if (m_encodingTask && m_encodingTask->isRunning()) {
         m_encodingTask->stop();
         setPlaying(false);
+        m_projectProxyRef->world()->setOfflineRendering(false);
         emit encodeDidCancel();
     }
 }
@@ -1082,20 +1089,37 @@ void RenderTarget::drawOffscreenForVideo()
     Q_ASSERT(window());
     Q_ASSERT(window()->thread() == thread());
     EncodingTask *encodingTaskRef = encodingTask();
+    if (encodingTaskRef->isStreaming() && !encodingTaskRef->isReadyForNextFrame()) {
+        /* retries at the next frame instead of waiting for the encoder on the render thread */
+        QMetaObject::invokeMethod(window(), "update", Qt::QueuedConnection);
+        return;
+    }
     QOpenGLFramebufferObject *fbo = encodingTaskRef->generateFramebufferObject(window());
     drawOffscreen(fbo);
     if (qFuzzyIsNull(m_projectProxyRef->differenceTimeIndex(m_currentTimeIndex))) {
-        encodingTaskRef->setEstimatedFrameCount(m_currentTimeIndex);
         setPlaying(false);
+        m_projectProxyRef->world()->setOfflineRendering(false);
         disconnect(window(), &QQuickWindow::frameSwapped, this, &RenderTarget::drawOffscreenForVideo);
-        connect(window(), &QQuickWindow::frameSwapped, this, &RenderTarget::launchEncodingTask);
+        if (encodingTaskRef->isStreaming()) {
+            encodingTaskRef->finishFrames();
+            m_exportSize = QSize();
+        }
+        else {
+            encodingTaskRef->setEstimatedFrameCount(m_currentTimeIndex);
+            connect(window(), &QQuickWindow::frameSwapped, this, &RenderTarget::launchEncodingTask);
+        }
     }
     else {
         const qreal &currentTimeIndex = m_currentTimeIndex;
         const QString &path = encodingTaskRef->generateFilename(currentTimeIndex);
         setCurrentTimeIndex(currentTimeIndex + 1);
         m_projectProxyRef->update(Scene::kUpdateAll);
-        fbo->toImage().save(path);
+        if (encodingTaskRef->isStreaming()) {
+            encodingTaskRef->writeFrame();
+        }
+        else {
+            fbo->toImage().save(path);
+        }
         emit videoFrameDidSave(currentTimeIndex, m_projectProxyRef->durationTimeIndex());
     }
 }
@@ -1146,7 +1170,8 @@ void RenderTarget::launchEncodingTask()
     Q_ASSERT(window());
     Q_ASSERT(window()->thread() == thread());
     disconnect(window(), &QQuickWindow::frameSwapped, this, &RenderTarget::launchEncodingTask);
-    encodingTask()->launch();
+    /* QProcess must be created on the thread of EncodingTask, not on the render thread */
+    QMetaObject::invokeMethod(encodingTask(), "launch", Qt::QueuedConnection);
     m_exportSize = QSize();
 }
 
@@ -1283,7 +1308,9 @@ void RenderTarget::enqueueDeletingModel(ModelProxy *model)
 void RenderTarget::commitUploadingModels()
 {
     Q_ASSERT(window());
-    connect(window(), &QQuickWindow::beforeRendering, this, &RenderTarget::performUploadingEnqueuedModels, Qt::DirectConnection);
+    /* the connection may still remain while textures of models enqueued before are decoded */
+    connect(window(), &QQuickWindow::beforeRendering, this, &RenderTarget::performUploadingEnqueuedModels,
+            static_cast<Qt::ConnectionType>(Qt::DirectConnection | Qt::UniqueConnection));
 }
 
 void RenderTarget::commitUploadingEffects()
@@ -1307,10 +1334,14 @@ void RenderTarget::performUploadingEnqueuedModels()
     Q_ASSERT(m_applicationContext);
     Q_ASSERT(window());
     Q_ASSERT(window()->thread() == thread());
-    disconnect(window(), &QQuickWindow::beforeRendering, this, &RenderTarget::performUploadingEnqueuedModels);
     gl::pushAnnotationGroup(Q_FUNC_INFO, m_applicationContext.data());
     QList<ApplicationContext::ModelProxyPair> succeededModelProxies, failedModelProxies;
     m_applicationContext->uploadEnqueuedModelProxies(m_projectProxyRef, succeededModelProxies, failedModelProxies);
+    /* models whose textures are still decoded on worker threads are uploaded at the next frames */
+    const bool hasEnqueuedModels = m_applicationContext->hasEnqueuedModelProxies();
+    if (!hasEnqueuedModels) {
+        disconnect(window(), &QQuickWindow::beforeRendering, this, &RenderTarget::performUploadingEnqueuedModels);
+    }
     if (!m_modelDrawer) {
         m_modelDrawer.reset(new SkeletonDrawer());
         connect(m_projectProxyRef, &ProjectProxy::currentTimeIndexChanged, m_modelDrawer.data(), &SkeletonDrawer::markDirty);
@@ -1337,7 +1368,12 @@ void RenderTarget::performUploadingEnqueuedModels()
         VPVL2_VLOG(1, "The model " << modelProxy->uuid().toString().toStdString() << " a.k.a " << modelProxy->name().toStdString() << " is not uploaded " << (pair.second ? " from the project." : "."));
         emit uploadingModelDidFail(modelProxy, pair.second);
     }
-    emit enqueuedModelsDidUpload();
+    if (hasEnqueuedModels) {
+        QMetaObject::invokeMethod(window(), "update", Qt::QueuedConnection);
+    }
+    else {
+        emit enqueuedModelsDidUpload();
+    }
     gl::popAnnotationGroup(m_applicationContext.data());
 }
 
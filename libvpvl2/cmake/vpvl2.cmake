@@ -641,6 +641,19 @@ function(vpvl2_add_egl_renderer)
   endif()
 endfunction()
 
+function(vpvl2_add_batch_renderer)
+  if(VPVL2_LINK_EGL)
+    find_path(EGL_INCLUDE_DIR NAMES EGL/egl.h PATHS $ENV{QTSDK_TOOLCHAIN}/include/QtANGLE)
+    find_library(EGL_LIBRARY NAMES EGL libEGL PATHS $ENV{QTSDK_TOOLCHAIN}/lib)
+    set(vpvl2_batch_sources "render/batch/main.cc")
+    set(VPVL2_EXECUTABLE vpvl2_batch)
+    add_executable(${VPVL2_EXECUTABLE} ${vpvl2_batch_sources})
+    target_link_libraries(${VPVL2_EXECUTABLE} ${EGL_LIBRARY})
+    include_directories(${EGL_INCLUDE_DIR})
+    vpvl2_create_executable(${VPVL2_EXECUTABLE})
+  endif()
+endfunction()
+
 function(vpvl2_create_library project_name library_type extra_sources extra_public_headers extra_private_headers)
   file(GLOB sources_core "${CMAKE_CURRENT_SOURCE_DIR}/src/core/*.cc")
   file(GLOB sources_base "${CMAKE_CURRENT_SOURCE_DIR}/src/core/base/*.cc")
@@ -93,6 +93,17 @@ public:
     struct DynamicVertexBuffer : Buffer {
         virtual void setupBindPose(void *address) const = 0;
         virtual void update(void *address) const = 0;
+        /**
+         * Writes morphed vertices only at indices into the buffer filled by update(void *) before.
+         */
+        virtual void update(void *address, const Array<int> &indices) const = 0;
+        /**
+         * Copies indices of vertices changed by morphs at the last update of the model.
+         *
+         * serial is incremented at every update so skipped updates can be detected by the caller.
+         * Returns false if the model doesn't track them and all vertices should be written.
+         */
+        virtual bool getMorphTouchedVertexIndices(Array<int> &indices, int &serial) const = 0;
         virtual void performTransform(void *address, const Vector3 &cameraPosition) const = 0;
         virtual void computeAabb(const void *address, Array<Vector3> &values) const = 0;
         virtual void setParallelUpdateEnable(bool value) = 0;
@@ -1035,6 +1046,16 @@ public:
      */
     virtual void removeVertex(IVertex *value) = 0;
 
+    /**
+     * ボーンやモーフの追加、削除、名前の変更またはモデル名の変更のたびに変わる値を返します.
+     *
+     * 名前から解決したボーンやモーフの参照を保持する場合にこの値が変わったら参照を解決し直す必要があります。
+     *
+     * @brief structureRevision
+     * @return
+     */
+    virtual int structureRevision() const = 0;
+
     virtual IProgressReporter *progressReporterRef() const = 0;
 
     virtual void setProgressReporterRef(IProgressReporter *value) = 0;
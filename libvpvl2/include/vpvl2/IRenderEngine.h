@@ -55,7 +55,8 @@ class VPVL2_API IRenderEngine
 public:
     enum UpdateOptionFlags {
         kNone = 0,
-        kParallelUpdate = 1
+        kParallelUpdate = 1,
+        kLegacyVertexUpload = 2
     };
 
     virtual ~IRenderEngine() {}
@@ -128,6 +129,46 @@ public:
      */
     virtual void update() = 0;
 
+    /**
+     * IRenderEngine#update を CPU スキニングとそれ以外に分割して実行するための準備を行います.
+     *
+     * グラフィック API のコンテキストを持つスレッドで呼び出す必要があります。
+     * false を返した場合は分割できないため、代わりに IRenderEngine#update を呼び出す必要があります。
+     * true を返した場合は IRenderEngine#performUpdate と IRenderEngine#endUpdate を順に呼び出す必要があります。
+     *
+     * @brief beginUpdate
+     * @return
+     */
+    virtual bool beginUpdate() = 0;
+
+    /**
+     * IRenderEngine#beginUpdate で確保したバッファに対して CPU スキニングを行います.
+     *
+     * グラフィック API を呼び出さないため、複数のレンダリングエンジンに対して別スレッドから並列に呼び出すことができます。
+     *
+     * @brief performUpdate
+     */
+    virtual void performUpdate() = 0;
+
+    /**
+     * IRenderEngine#beginUpdate で開始した更新を完了します.
+     *
+     * グラフィック API のコンテキストを持つスレッドで呼び出す必要があります。
+     *
+     * @brief endUpdate
+     */
+    virtual void endUpdate() = 0;
+
+    /**
+     * 頂点バッファを更新せずにエフェクトのシーンパラメータ (TIME や ELAPSEDTIME など) のみを更新します.
+     *
+     * Scene が変化のないモデルの IRenderEngine#update を省略する場合に代わりに呼び出されます。
+     * エフェクトを持たないレンダリングエンジンでは何もしません (デフォルトの実装も何もしません)。
+     *
+     * @brief updateSceneParameters
+     */
+    virtual void updateSceneParameters() {}
+
     /**
      * IRenderEngine#update におけるオプションを設定します.
      *
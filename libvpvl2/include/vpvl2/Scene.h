@@ -68,6 +68,7 @@ public:
         kOpenCLAccelerationType1,
         kVertexShaderAccelerationType1,
         kOpenCLAccelerationType2,
+        kCPUAccelerationType1,
         kMaxAccelerationType
     };
     enum RenderEngineTypeFlags {
@@ -84,6 +85,14 @@ public:
         kForceUpdateAllMorphs = 0x20,
         kMaxUpdateTypeFlags   = 0x40
     };
+    struct UpdateStatistics {
+        /* models updated and skipped by the last update(kUpdateModels) */
+        int numUpdatedModels;
+        int numSkippedModels;
+        /* accumulated since the scene is created */
+        uint64 totalUpdatedModels;
+        uint64 totalSkippedModels;
+    };
     struct Deleter {
         void operator()(IModel *model) const {
             Scene::deleteModelUnlessReferred(model);
@@ -597,6 +606,78 @@ public:
      */
     void setWorldRef(btDiscreteDynamicsWorld *worldRef) VPVL2_DECL_NOEXCEPT;
 
+    /**
+     * update(kUpdateModels) でモデルを並列に更新するかを返します.
+     *
+     * @brief isParallelUpdateEnabled
+     * @return
+     */
+    bool isParallelUpdateEnabled() const VPVL2_DECL_NOEXCEPT;
+
+    /**
+     * update(kUpdateModels) でモデルを並列に更新するかを設定します.
+     *
+     * 親モデルまたは親ボーンが設定されているモデルは親モデルの更新後に更新されます。
+     * 依存関係のないモデル同士が並列に更新されるため、結果は並列に更新しない場合と同じになります。
+     * update(kUpdateRenderEngines) でも IRenderEngine#beginUpdate に対応するレンダリングエンジンの
+     * CPU スキニングが並列に行われます。物理演算のステップ実行は並列化されません。
+     * IModel や IRenderEngine の実装がスレッドセーフである必要があるため、初期値は false です。
+     *
+     * @brief setParallelUpdateEnable
+     * @param value
+     */
+    void setParallelUpdateEnable(bool value) VPVL2_DECL_NOEXCEPT;
+
+    /**
+     * モデルが追加または削除されるたびに変わる値を返します.
+     *
+     * モデルやボーンの参照を保持する場合にこの値が変わったら参照を解決し直す必要があります。
+     * モデルの名前 (またはボーンやモーフの構成) の変更も Scene#update の呼び出し時に反映されます。
+     *
+     * @brief modelRevision
+     * @return
+     */
+    int modelRevision() const VPVL2_DECL_NOEXCEPT;
+
+    /**
+     * 名前からモデルへの対応が変わったことを通知し、 Scene#modelRevision の値を変更します.
+     *
+     * IApplicationContext#findEffectModelRef がファイル名などシーンの外にある名前でモデルを返す場合に使います。
+     *
+     * @brief invalidateModelRevision
+     */
+    void invalidateModelRevision() VPVL2_DECL_NOEXCEPT;
+
+    /**
+     * update(kUpdateModels) で変化のないモデルの更新を省略するかを返します.
+     *
+     * @brief isSkipUnchangedModelsEnabled
+     * @return
+     */
+    bool isSkipUnchangedModelsEnabled() const VPVL2_DECL_NOEXCEPT;
+
+    /**
+     * update(kUpdateModels) で変化のないモデルの更新を省略するかを設定します.
+     *
+     * ボーンのローカル変形、モーフの重み、材質、モデルの位置や不透明度、カメラの位置、物理演算で動く剛体の位置が
+     * 前回更新した時から変化していないモデルは IModel#performUpdate と IRenderEngine#update を呼び出さず、
+     * エフェクトのパラメータを更新するために IRenderEngine#updateSceneParameters のみを呼び出します。
+     * 親モデルが更新された場合は子モデルも更新されます。kResetMotionState または kForceUpdateAllMorphs が
+     * 指定された場合は全てのモデルを更新します。頂点を直接編集する場合は無効にしてください。初期値は false です。
+     *
+     * @brief setSkipUnchangedModelsEnable
+     * @param value
+     */
+    void setSkipUnchangedModelsEnable(bool value) VPVL2_DECL_NOEXCEPT;
+
+    /**
+     * update(kUpdateModels) で更新したモデルと省略したモデルの数を返します.
+     *
+     * @brief getUpdateStatistics
+     * @param value
+     */
+    void getUpdateStatistics(UpdateStatistics &value) const VPVL2_DECL_NOEXCEPT;
+
 private:
     VPVL2_DISABLE_COPY_AND_ASSIGN(Scene)
     struct PrivateContext;
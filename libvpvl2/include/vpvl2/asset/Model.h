@@ -173,6 +173,7 @@ public:
     void removeMorph(IMorph *value);
     void removeRigidBody(IRigidBody *value);
     void removeVertex(IVertex *value);
+    int structureRevision() const;
     IProgressReporter *progressReporterRef() const;
     void setProgressReporterRef(IProgressReporter *value);
 
@@ -214,6 +215,7 @@ private:
     Quaternion m_rotation;
     Scalar m_opacity;
     Scalar m_scaleFactor;
+    int m_structureRevision;
     bool m_visible;
 };
 
@@ -0,0 +1,101 @@
+/**
+
+ Copyright (c) 2010-2014  hkrn
+
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or
+ without modification, are permitted provided that the following
+ conditions are met:
+
+ - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following
+   disclaimer in the documentation and/or other materials provided
+   with the distribution.
+ - Neither the name of the MMDAI project team nor the names of
+   its contributors may be used to endorse or promote products
+   derived from this software without specific prior written
+   permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+#ifndef VPVL2_CPU_PMXACCELERATOR_H_
+#define VPVL2_CPU_PMXACCELERATOR_H_
+
+#include "vpvl2/IModel.h"
+
+namespace vpvl2
+{
+namespace VPVL2_VERSION_NS
+{
+
+class Scene;
+
+namespace cpu
+{
+
+class VPVL2_API PMXAccelerator VPVL2_DECL_FINAL
+{
+public:
+    /* per-frame stream layout without static attributes */
+    struct StreamUnit {
+        Vector3 position;
+        Vector3 normal;
+        Vector3 edge;
+    };
+    /* attributes only changed by UV morphs and vertex edits */
+    struct AttributeUnit {
+        Vector4 uva1;
+        Vector4 uva2;
+        Vector4 uva3;
+        Vector4 uva4;
+    };
+
+    static vsize streamStrideSize();
+    static vsize streamStrideOffset(IModel::Buffer::StrideType type);
+    static vsize attributeStrideSize();
+    static vsize attributeStrideOffset(IModel::Buffer::StrideType type);
+
+    PMXAccelerator(const Scene *sceneRef, IModel *modelRef);
+    ~PMXAccelerator();
+
+    bool isAvailable() const;
+    void upload();
+    void update(const IModel::DynamicVertexBuffer *dynamicBufferRef, void *address, Vector3 &aabbMin, Vector3 &aabbMax);
+    void updateStream(void *address, Vector3 &aabbMin, Vector3 &aabbMax);
+    void updateAttributes(void *address) const;
+    void updateAttributes(int offset, int nvertices, void *address) const;
+    bool checkAttributesChanged(const IModel::DynamicVertexBuffer *dynamicBufferRef);
+    const Array<int> &changedVertexIndices() const;
+    void release();
+    void setParallelUpdateEnable(bool value);
+
+private:
+    struct PrivateContext;
+    PrivateContext *m_context;
+
+    VPVL2_DISABLE_COPY_AND_ASSIGN(PMXAccelerator)
+};
+
+} /* namespace cpu */
+} /* namespace VPVL2_VERSION_NS */
+} /* namespace vpvl2 */
+
+#endif
@@ -51,6 +51,11 @@ namespace VPVL2_VERSION_NS
 namespace extensions
 {
 
+/**
+ * Archive indexes the central directory of a ZIP file once at open and inflates
+ * entries on demand. The archive is memory mapped so stored (not compressed) entries
+ * can be read without copying and several entries can be inflated in parallel.
+ */
 class VPVL2_API Archive VPVL2_DECL_FINAL
 {
 public:
@@ -64,6 +69,7 @@ public:
         kOpenCurrentFileError,
         kReadCurrentFileError,
         kCloseCurrentFileError,
+        kMapFileError,
         kMaxError
     };
 
@@ -78,6 +84,10 @@ public:
     Archive::ErrorType error() const;
     const EntryNames entryNames() const;
     const std::string *dataRef(const std::string &name) const;
+    const uint8 *mappedDataRef(const std::string &name, vsize &size);
+    bool readEntry(const std::string &name, std::string &bytes) const;
+    void releaseEntry(const std::string &name);
+    void releaseAllEntries();
 
 private:
     struct PrivateContext;
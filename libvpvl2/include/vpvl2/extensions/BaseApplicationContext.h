@@ -158,18 +158,33 @@ public:
         ITexture *createTextureFromFile(const std::string &path, int flags);
         ITexture *createTextureFromMemory(const uint8 *data, vsize size, const std::string &key, int flags);
         void storeTexture(const std::string &key, int flags, ITexture *textureRef);
+        std::string sharedTextureKey(const uint8 *data, vsize size, int flags) const;
+        ITexture *findSharedTexture(const std::string &sharedKey, const std::string &key);
+        ITexture *storeSharedTexture(const std::string &sharedKey, const std::string &key, int flags, ITexture *texturePtr);
         void getTextureRefCaches(TextureRefCacheMap &value) const;
         int countTextures() const;
         bool flipVertically() const;
         Archive *archiveRef() const;
         const IString *directoryRef() const;
+        void decodeTextures(const IModel *modelRef);
+        int uploadDecodedTextures();
+        ITexture *uploadDecodedTexture(const std::string &key, int flags);
     private:
+        struct DecodedImage;
+        struct TextureDecoder;
+        void addDecodeTarget(const IString *name, int flags);
+        ITexture *uploadDecodedImage(DecodedImage *image, int flags);
+        void setTextureParameters(int flags, ITexture *texture);
+        void registerTexture(const std::string &key, ITexture *textureRef);
         const IString *m_directoryRef;
         Archive *m_archiveRef;
         BaseApplicationContext *m_applicationContextRef;
         TextureRefCacheMap m_textureRefCache;
+        TextureDecoder *m_textureDecoder;
         float m_maxAnisotropyValue;
         bool m_flipVertically;
+
+        VPVL2_DISABLE_COPY_AND_ASSIGN(ModelContext)
     };
 
     static bool initializeOnce(const char *argv0, const char *logdir, int vlog);
@@ -313,6 +328,8 @@ protected:
 
     virtual ITexture *uploadTextureOpaque(const uint8 *data, vsize size, const std::string &key, int flags, ModelContext *context);
     virtual ITexture *uploadTextureOpaque(const std::string &path, int flags, ModelContext *context);
+    /* called on worker threads by ModelContext#decodeTextures, must decode as same as uploadTextureOpaque does */
+    virtual bool decodeTextureOpaque(const uint8 *data, vsize size, bool flipVertically, Vector3 &textureSize, Array<uint8> &pixels) const;
     virtual ITexture *handleNullTextureObject() const;
     virtual gl::BaseSurface::Format defaultTextureFormat() const;
 
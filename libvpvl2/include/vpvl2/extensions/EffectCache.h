@@ -0,0 +1,132 @@
+/**
+
+ Copyright (c) 2010-2014  hkrn
+
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or
+ without modification, are permitted provided that the following
+ conditions are met:
+
+ - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following
+   disclaimer in the documentation and/or other materials provided
+   with the distribution.
+ - Neither the name of the MMDAI project team nor the names of
+   its contributors may be used to endorse or promote products
+   derived from this software without specific prior written
+   permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+#ifndef VPVL2_EXTENSIONS_EFFECTCACHE_H_
+#define VPVL2_EXTENSIONS_EFFECTCACHE_H_
+
+#include <vpvl2/Common.h>
+#include <vpvl2/extensions/StringMap.h>
+
+/* STL */
+#include <string>
+
+namespace vpvl2
+{
+namespace VPVL2_VERSION_NS
+{
+namespace extensions
+{
+
+/**
+ * Process-wide on-disk store of translated shader sources and linked program binaries.
+ *
+ * Each entry is a file in the cache directory holding the full key, the entry type, a
+ * format value and a checksum of the payload. Entries not matching them are treated as
+ * misses and removed, so callers always fall back to compile from the source. Program
+ * binaries are only valid for the driver that made them, so callers must also reject
+ * an entry the driver refuses to load. The cache is disabled until the directory is set.
+ * All functions are thread safe.
+ */
+class VPVL2_API EffectCache VPVL2_DECL_FINAL
+{
+public:
+    enum EntryType {
+        /* GLSL translated from an effect, format is the shader type */
+        kTranslatedSource,
+        /* linked program, format is the binary format returned by the driver */
+        kProgramBinary,
+        kMaxEntryType
+    };
+    struct Statistics {
+        int numSourceHits;
+        int numSourceMisses;
+        int numProgramBinaryHits;
+        int numProgramBinaryMisses;
+        /* entries found but rejected by the header check or the driver */
+        int numRejects;
+        int numStores;
+    };
+
+    /**
+     * Makes a key from everything changing the compiled result.
+     *
+     * backend should identify the compiler and the target, for example the shader
+     * language version or the driver version for program binaries.
+     */
+    static std::string makeKey(const std::string &backend,
+                               const std::string &source,
+                               const StringMap &includeBuffers,
+                               const StringList &defines);
+
+    /**
+     * Reads the payload of the entry and returns true if it exists and is valid.
+     */
+    static bool find(const std::string &key, EntryType type, uint32 &format, Array<uint8> &bytes);
+
+    /**
+     * Writes the entry replacing existing one. Returns false if the cache is disabled
+     * or the entry cannot be written.
+     */
+    static bool store(const std::string &key, EntryType type, uint32 format, const uint8 *data, vsize size);
+
+    /**
+     * Removes the entry found but unusable (e.g. a program binary the driver refused).
+     */
+    static void reject(const std::string &key, EntryType type);
+
+    static void getStatistics(Statistics &value);
+    static void resetStatistics();
+
+    /**
+     * Empty string (default) disables the cache. The directory must exist.
+     */
+    static std::string directory();
+    static void setDirectory(const std::string &value);
+    static bool isEnabled();
+
+private:
+    VPVL2_MAKE_STATIC_CLASS(EffectCache)
+};
+
+} /* namespace extensions */
+} /* namespace VPVL2_VERSION_NS */
+using namespace VPVL2_VERSION_NS;
+
+} /* namespace vpvl2 */
+
+#endif /* VPVL2_EXTENSIONS_EFFECTCACHE_H_ */
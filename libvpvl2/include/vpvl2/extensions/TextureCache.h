@@ -0,0 +1,133 @@
+/**
+
+ Copyright (c) 2010-2014  hkrn
+
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or
+ without modification, are permitted provided that the following
+ conditions are met:
+
+ - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following
+   disclaimer in the documentation and/or other materials provided
+   with the distribution.
+ - Neither the name of the MMDAI project team nor the names of
+   its contributors may be used to endorse or promote products
+   derived from this software without specific prior written
+   permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+#ifndef VPVL2_EXTENSIONS_TEXTURECACHE_H_
+#define VPVL2_EXTENSIONS_TEXTURECACHE_H_
+
+#include <vpvl2/Common.h>
+
+/* STL */
+#include <string>
+
+namespace vpvl2
+{
+namespace VPVL2_VERSION_NS
+{
+
+class ITexture;
+
+namespace extensions
+{
+
+/**
+ * Process-wide store of uploaded textures keyed by their content.
+ *
+ * Each acquired texture is a reference to the shared texture and releases the reference
+ * when deleted, so render engines can delete textures as usual. Textures no longer
+ * referenced are kept until the cached bytes exceed the memory budget and then evicted
+ * in least recently used order. All functions are thread safe but must be called while
+ * an OpenGL context shared with the cached textures is current.
+ */
+class VPVL2_API TextureCache VPVL2_DECL_FINAL
+{
+public:
+    struct Statistics {
+        /* number of distinct textures alive in the cache */
+        int numEntries;
+        /* number of texture references handed out and not deleted yet */
+        int numReferences;
+        int numHits;
+        int numMisses;
+        int numEvictions;
+        /* estimated bytes of all textures including mipmaps */
+        vsize usedBytes;
+        /* part of usedBytes that no texture references (evictable) */
+        vsize unreferencedBytes;
+        vsize budgetBytes;
+    };
+
+    /**
+     * Returns IApplicationContext::TextureTypeFlags changing the uploaded texture or its parameters.
+     */
+    static int uploadFlags(int flags);
+
+    /**
+     * Makes a key from the encoded image and the parameters changing the uploaded texture.
+     *
+     * All flags returned by uploadFlags are a part of the key.
+     */
+    static std::string makeKey(const uint8 *data, vsize size, int flags, bool flipVertically);
+
+    /**
+     * Returns a new reference of the texture for the key or null if not cached.
+     */
+    static ITexture *acquire(const std::string &key);
+
+    /**
+     * Takes ownership of the texture and returns a new reference of it.
+     *
+     * If the key is already cached, the texture is deleted and a reference of cached
+     * one is returned. Texture parameters must be set before storing since references
+     * ignore ITexture::setParameter to keep the shared texture same for all of them.
+     */
+    static ITexture *store(const std::string &key, ITexture *texturePtr);
+
+    /**
+     * Deletes all textures no longer referenced.
+     */
+    static void purge();
+    static void getStatistics(Statistics &value);
+    static void resetStatistics();
+
+    /**
+     * Default is 256MB.
+     */
+    static vsize memoryBudget();
+    static void setMemoryBudget(vsize value);
+
+private:
+    VPVL2_MAKE_STATIC_CLASS(TextureCache)
+};
+
+} /* namespace extensions */
+} /* namespace VPVL2_VERSION_NS */
+using namespace VPVL2_VERSION_NS;
+
+} /* namespace vpvl2 */
+
+#endif /* VPVL2_EXTENSIONS_TEXTURECACHE_H_ */
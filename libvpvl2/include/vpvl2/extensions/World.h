@@ -56,7 +56,31 @@ namespace extensions
 
 class VPVL2_API World VPVL2_DECL_FINAL {
 public:
+    /**
+     * How stepSimulation catches up with the elapsed time.
+     *
+     * kExactStepping runs every fixed substep regardless of the cost (offline export),
+     * kDropStepping and kInterpolateStepping stop at maxSubSteps or the step time budget
+     * (live preview); the former discards the time left over and the latter keeps up to
+     * one fixed step of it to interpolate motion states.
+     */
+    enum SteppingPolicy {
+        kExactStepping,
+        kDropStepping,
+        kInterpolateStepping,
+        kMaxSteppingPolicy
+    };
+    struct StepStatistics {
+        int numSubSteps;
+        int numDroppedSubSteps;
+        int numOverlappingPairs;
+        Scalar elapsedTime;
+        Scalar collisionTime;
+        Scalar solverTime;
+    };
     static const int kDefaultMaxSubSteps;
+    static const Scalar kDefaultSnapshotInterval;
+    static const vsize kDefaultSnapshotMemoryBudget;
 
     World();
     ~World();
@@ -77,6 +101,29 @@ public:
     void setRandSeed(unsigned long value);
     bool isFloorEnabled() const;
     void setFloorEnabled(bool value);
+    SteppingPolicy steppingPolicy() const;
+    void setSteppingPolicy(SteppingPolicy value);
+    int maxSubSteps() const;
+    void setMaxSubSteps(int value);
+    Scalar stepTimeBudget() const;
+    void setStepTimeBudget(const Scalar &value);
+    void getStepStatistics(StepStatistics &value) const;
+
+    /**
+     * Snapshots hold transforms and velocities of every dynamic rigid body in the world.
+     * Seeking restores the nearest earlier snapshot and simulates only the frames after it
+     * instead of simulating from rest. The first snapshot is never evicted by the memory budget.
+     */
+    void captureSnapshot(const Scalar &timeIndex);
+    bool findSnapshot(const Scalar &timeIndex, Scalar &foundTimeIndex) const;
+    bool restoreSnapshot(const Scalar &timeIndex, Scalar &restoredTimeIndex);
+    void clearSnapshots();
+    int countSnapshots() const;
+    Scalar snapshotInterval() const;
+    void setSnapshotInterval(const Scalar &value);
+    vsize snapshotMemoryBudget() const;
+    void setSnapshotMemoryBudget(vsize value);
+    vsize snapshotMemoryUsage() const;
 
 private:
     struct PrivateContext;
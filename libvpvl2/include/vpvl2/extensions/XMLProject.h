@@ -64,7 +64,8 @@ namespace extensions
  *
  * @section DESCRIPTION
  *
- * Project class represents a project file (*.vpvx)
+ * Project class represents a project file (*.vpvx) and its binary form (*.vpvb)
+ * that stores motions as native VMD/MVD chunks.
  */
 
 class VPVL2_API XMLProject VPVL2_DECL_FINAL : public Scene
@@ -73,6 +74,24 @@ public:
     typedef std::string UUID;
     typedef std::vector<UUID> UUIDList;
     typedef std::map<XMLProject::UUID, StringMap> ModelSettings;
+    enum FormatType {
+        kXMLFormat,
+        kBinaryFormat,
+        kMaxFormatType
+    };
+
+    struct ModelRequest {
+        ModelRequest(const UUID &u, const StringMap &s, IModel::Type t)
+            : uuid(u),
+              settings(s),
+              type(t)
+        {
+        }
+        UUID uuid;
+        StringMap settings;
+        IModel::Type type;
+    };
+    typedef std::vector<ModelRequest> ModelRequestList;
 
     class IDelegate {
     public:
@@ -80,6 +99,11 @@ public:
         virtual std::string toStdFromString(const IString *value) const = 0;
         virtual IString *toStringFromStd(const std::string &value) const = 0;
         virtual bool loadModel(const UUID &uuid, const StringMap &settings, IModel::Type type, IModel *&model, IRenderEngine *&engine, int &priority) = 0;
+        /**
+         * Called with all models of the project before loadModel is called for each of them
+         * in the project order, so the delegate can start parsing them concurrently.
+         */
+        virtual void prefetchModels(const ModelRequestList & /* requests */) {}
     };
 
     static const UUID kNullUUID;
@@ -89,6 +113,7 @@ public:
     static const std::string kSettingOrderKey;
 
     static float32 formatVersion();
+    static bool isBinaryFormat(const uint8 *data, vsize size);
     static bool isReservedSettingKey(const std::string &key);
     static std::string toStringFromFloat32(float32 value);
     static std::string toStringFromVector3(const Vector3 &value);
@@ -106,6 +131,7 @@ public:
     bool load(const char *path);
     bool load(const uint8 *data, vsize size);
     bool save(const char *path);
+    bool save(const char *path, FormatType format);
     void clear();
 
     std::string version() const;
@@ -91,6 +91,10 @@ public:
     bool upload(void *userData);
     void release();
     void update();
+    bool beginUpdate();
+    void performUpdate();
+    void endUpdate();
+    void updateSceneParameters();
     void setUpdateOptions(int options);
     void renderModel(IEffect::Pass *overridePass);
     void renderEdge(IEffect::Pass *overridePass);
@@ -52,7 +52,9 @@ namespace vpvl2
 namespace VPVL2_VERSION_NS
 {
 
+class IBone;
 class IModel;
+class IMorph;
 class IApplicationContext;
 class IShadowMap;
 class IString;
@@ -284,15 +286,63 @@ public:
     void update(const IModel *self);
 
 private:
-    void setParameter(const IModel *model, IEffect::Parameter *parameterRef);
-    void setModelBoneMorphParameter(const IModel *model, const IEffect::Annotation *annotationRef, IEffect::Parameter *parameterRef);
-    void setAssetParameter(const IModel *model, const IEffect::Annotation *annotationRef, IEffect::Parameter *parameterRef);
-    void setModelParameter(const IModel *model, IEffect::Parameter *parameterRef);
-    void setNullParameter(IEffect::Parameter *parameterRef);
+    /* names of the annotations are resolved once to a handle and a value type */
+    struct Binding {
+        enum TargetType {
+            kSelfTarget,
+            kOffscreenOwnerTarget,
+            kNamedTarget
+        };
+        enum ValueType {
+            kNullValue,
+            kModelValue,
+            kBoneValue,
+            kMorphValue,
+            kAssetXValue,
+            kAssetYValue,
+            kAssetZValue,
+            kAssetXYZValue,
+            kAssetRxValue,
+            kAssetRyValue,
+            kAssetRzValue,
+            kAssetRxyzValue,
+            kAssetSiValue,
+            kAssetTrValue,
+            kNoValue
+        };
+        Binding(IEffect::Parameter *p, TargetType t)
+            : parameterRef(p),
+              modelRef(0),
+              boneRef(0),
+              morphRef(0),
+              modelRevision(0),
+              targetType(t),
+              valueType(kNullValue)
+        {
+        }
+        IEffect::Parameter *parameterRef;
+        const IModel *modelRef;
+        const IBone *boneRef;
+        const IMorph *morphRef;
+        int modelRevision;
+        TargetType targetType;
+        ValueType valueType;
+    };
+
+    void compileBindings(const IModel *self);
+    bool isBindingsChanged() const;
+    void bind(Binding &binding, const IModel *model) const;
+    void setParameter(const Binding &binding) const;
+    void setAssetParameter(const IModel *model, Binding::ValueType valueType, IEffect::Parameter *parameterRef) const;
+    void setModelParameter(const IModel *model, IEffect::Parameter *parameterRef) const;
+    void setNullParameter(IEffect::Parameter *parameterRef) const;
 
     const Scene *m_sceneRef;
     const IApplicationContext *m_applicationContextRef;
     Array<IEffect::Parameter *> m_parameterRefs;
+    Array<Binding> m_bindings;
+    int m_modelRevision;
+    bool m_compiled;
 
     VPVL2_DISABLE_COPY_AND_ASSIGN(ControlObjectSemantic)
 };
@@ -58,10 +58,16 @@ namespace VPVL2_VERSION_NS
 namespace cl {
 class PMXAccelerator;
 }
+namespace cpu {
+class PMXAccelerator;
+}
 namespace gl {
 class VertexBundle;
 class VertexBundleLayout;
 }
+namespace internal {
+class DynamicVertexUpdateTracker;
+}
 
 class Scene;
 
@@ -81,6 +87,10 @@ public:
     bool upload(void *userData);
     void release();
     void update();
+    bool beginUpdate();
+    void performUpdate();
+    void endUpdate();
+    void updateSceneParameters();
     void setUpdateOptions(int options);
     void renderModel(IEffect::Pass *overridePass);
     void renderEdge(IEffect::Pass *overridePass);
@@ -181,6 +191,7 @@ private:
                            void *userData);
     void setupOffscreenEffect(IEffect *effectRef, void *userData);
     void executeOneTechniqueAllPasses(const char *name, Array<IEffect::Pass *> &passes);
+    void uploadMorphedVertices();
     void labelVertexArray(const gl::VertexBundleLayout *layout, const char *name);
     void labelVertexBuffer(gl::GLenum key, const char *name);
     void annotateMaterial(const char *name, const IMaterial *material);
@@ -192,6 +203,7 @@ private:
 #ifdef VPVL2_ENABLE_OPENCL
     cl::PMXAccelerator::VertexBufferBridgeArray m_accelerationBuffers;
 #endif
+    cpu::PMXAccelerator *m_cpuAccelerator;
     IApplicationContext *m_applicationContextRef;
     TransformFeedbackProgram *m_transformFeedbackProgram;
     Scene *m_sceneRef;
@@ -199,6 +211,9 @@ private:
     IModel::StaticVertexBuffer *m_staticBuffer;
     IModel::DynamicVertexBuffer *m_dynamicBuffer;
     IModel::IndexBuffer *m_indexBuffer;
+    internal::DynamicVertexUpdateTracker *m_vertexUpdateTracker;
+    Array<uint8> m_morphedVertices;
+    void *m_mappedAddress;
     gl::VertexBundle *m_bundle;
     gl::VertexBundleLayout *m_layouts[kMaxVertexArrayObjectType];
     Array<MaterialContext> m_materialContexts;
@@ -207,6 +222,7 @@ private:
     PointerArray<PrivateEffectEngine> m_oseffects;
     IEffect *m_defaultEffectRef;
     gl::GLenum m_indexType;
+    int m_updateOptions;
     Vector3 m_aabbMin;
     Vector3 m_aabbMax;
     bool m_cullFaceState;
@@ -58,6 +58,8 @@ public:
     static const GLenum kGL_INFO_LOG_LENGTH = 0x8B84;
     static const GLenum kGL_FRAGMENT_SHADER = 0x8B30;
     static const GLenum kGL_VERTEX_SHADER = 0x8B31;
+    static const GLenum kGL_PROGRAM_BINARY_RETRIEVABLE_HINT = 0x8257;
+    static const GLenum kGL_PROGRAM_BINARY_LENGTH = 0x8741;
 
     ShaderProgram(const IApplicationContext::FunctionResolver *resolver)
         : createProgarm(reinterpret_cast<PFNGLCREATEPROGRAMPROC>(resolver->resolveSymbol("glCreateProgram"))),
@@ -84,9 +86,18 @@ public:
           uniformMatrix4fv(reinterpret_cast<PFNGLUNIFORMMATRIX3FVPROC>(resolver->resolveSymbol("glUniformMatrix4fv"))),
           activeTexture(reinterpret_cast<PFNGLACTIVETEXTUREPROC>(resolver->resolveSymbol("glActiveTexture"))),
           bindTexture(reinterpret_cast<PFNGLBINDTEXTUREPROC>(resolver->resolveSymbol("glBindTexture"))),
+          programParameteri(0),
+          getProgramBinary(0),
+          programBinary(0),
           m_program(0),
           m_linked(false)
     {
+        if (resolver->query(IApplicationContext::FunctionResolver::kQueryVersion) >= gl::makeVersion(4, 1) ||
+                resolver->hasExtension("ARB_get_program_binary")) {
+            programParameteri = reinterpret_cast<PFNGLPROGRAMPARAMETERIPROC>(resolver->resolveSymbol("glProgramParameteri"));
+            getProgramBinary = reinterpret_cast<PFNGLGETPROGRAMBINARYPROC>(resolver->resolveSymbol("glGetProgramBinary"));
+            programBinary = reinterpret_cast<PFNGLPROGRAMBINARYPROC>(resolver->resolveSymbol("glProgramBinary"));
+        }
     }
     virtual ~ShaderProgram() {
         if (m_program) {
@@ -127,6 +138,10 @@ public:
     }
     bool link() {
         GLint linked;
+        if (isProgramBinarySupported()) {
+            /* lets the driver keep the binary to be stored to the effect cache */
+            programParameteri(m_program, kGL_PROGRAM_BINARY_RETRIEVABLE_HINT, kGL_TRUE);
+        }
         linkProgram(m_program);
         getProgramiv(m_program, kGL_LINK_STATUS, &linked);
         if (!linked) {
@@ -143,6 +158,37 @@ public:
         m_linked = true;
         return true;
     }
+    bool loadBinary(GLenum format, const void *data, vsize size) {
+        GLint linked = 0;
+        if (isProgramBinarySupported() && data && size > 0) {
+            create();
+            programBinary(m_program, format, data, GLsizei(size));
+            getProgramiv(m_program, kGL_LINK_STATUS, &linked);
+            if (!linked) {
+                /* the driver was changed since the binary was retrieved, recreate to link from sources */
+                deleteProgram(m_program);
+                m_program = 0;
+            }
+        }
+        m_linked = linked != 0;
+        return m_linked;
+    }
+    bool getBinary(GLenum &format, Array<uint8> &bytes) const {
+        GLint size = 0;
+        bytes.clear();
+        if (isProgramBinarySupported() && m_linked) {
+            getProgramiv(m_program, kGL_PROGRAM_BINARY_LENGTH, &size);
+            if (size > 0) {
+                bytes.resize(size);
+                getProgramBinary(m_program, size, &size, &format, &bytes[0]);
+                bytes.resize(size);
+            }
+        }
+        return bytes.count() > 0;
+    }
+    bool isProgramBinarySupported() const {
+        return programParameteri && getProgramBinary && programBinary;
+    }
     virtual void bind() {
         useProgram(m_program);
     }
@@ -181,6 +227,9 @@ protected:
     typedef void (GLAPIENTRY * PFNGLUNIFORMMATRIX4FVPROC) (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
     typedef void (GLAPIENTRY * PFNGLACTIVETEXTUREPROC) (GLenum texture);
     typedef void (GLAPIENTRY * PFNGLBINDTEXTUREPROC) (GLenum target, GLuint texture);
+    typedef void (GLAPIENTRY * PFNGLPROGRAMPARAMETERIPROC) (GLuint program, GLenum pname, GLint value);
+    typedef void (GLAPIENTRY * PFNGLGETPROGRAMBINARYPROC) (GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+    typedef void (GLAPIENTRY * PFNGLPROGRAMBINARYPROC) (GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
     PFNGLCREATEPROGRAMPROC createProgarm;
     PFNGLCREATESHADERPROC createShader;
     PFNGLSHADERSOURCEPROC shaderSource;
@@ -205,6 +254,9 @@ protected:
     PFNGLUNIFORMMATRIX4FVPROC uniformMatrix4fv;
     PFNGLACTIVETEXTUREPROC activeTexture;
     PFNGLBINDTEXTUREPROC bindTexture;
+    PFNGLPROGRAMPARAMETERIPROC programParameteri;
+    PFNGLGETPROGRAMBINARYPROC getProgramBinary;
+    PFNGLPROGRAMBINARYPROC programBinary;
 
     GLuint m_program;
 
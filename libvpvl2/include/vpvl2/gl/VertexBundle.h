@@ -57,6 +57,13 @@ public:
     static const GLenum kGL_ELEMENT_ARRAY_BUFFER = 0x8893;
     static const GLenum kGL_WRITE_ONLY = 0x88B9;
     static const GLenum kGL_MAP_WRITE_BIT = 0x0002;
+    static const GLenum kGL_MAP_INVALIDATE_BUFFER_BIT = 0x0008;
+    static const GLenum kGL_MAP_UNSYNCHRONIZED_BIT = 0x0020;
+    static const GLenum kGL_MAP_PERSISTENT_BIT = 0x0040;
+    static const GLenum kGL_MAP_COHERENT_BIT = 0x0080;
+    static const GLenum kGL_SYNC_GPU_COMMANDS_COMPLETE = 0x9117;
+    static const GLenum kGL_SYNC_FLUSH_COMMANDS_BIT = 0x00000001;
+    static const GLenum kGL_TIMEOUT_EXPIRED = 0x911B;
     static const GLenum kGL_TRANSFORM_FEEDBACK_BUFFER = 0x8C8E;
     static const GLenum kGL_RASTERIZER_DISCARD = 0x8C89;
     static const GLenum kGL_INTERLEAVED_ATTRIBS = 0x8C8C;
@@ -68,6 +75,12 @@ public:
         kIndexBuffer,
         kMaxVertexBufferType
     };
+    enum UploadStrategy {
+        kMapBufferUpload,         /* maps whole buffer every time and lets the driver synchronize */
+        kOrphaningUpload,         /* orphans the storage and maps it without synchronization */
+        kPersistentMappingUpload, /* maps once (ARB_buffer_storage) and waits for the fence of the buffer */
+        kMaxUploadStrategy
+    };
 
     VertexBundle(const IApplicationContext::FunctionResolver *resolver)
         : genBuffers(reinterpret_cast<PFNGLGENBUFFERSPROC>(resolver->resolveSymbol("glGenBuffers"))),
@@ -88,13 +101,26 @@ public:
           mapBuffer(reinterpret_cast<PFNGLMAPBUFFERPROC>(resolver->resolveSymbol("glMapBuffer"))),
           unmapBuffer(reinterpret_cast<PFNGLUNMAPBUFFERPROC>(resolver->resolveSymbol("glUnmapBuffer"))),
           mapBufferRange(0),
+          bufferStorage(0),
+          fenceSync(0),
+          clientWaitSync(0),
+          deleteSync(0),
           m_indexBuffer(0),
           m_query(0)
     {
         if (resolver->hasExtension("ARB_map_buffer_range")) {
             mapBufferRange = reinterpret_cast<PFNGLMAPBUFFERRANGEPROC>(resolver->resolveSymbol("glMapBufferRange"));
         }
-        if (resolver->query(IApplicationContext::FunctionResolver::kQueryVersion) >= gl::makeVersion(3, 0)) {
+        const int version = resolver->query(IApplicationContext::FunctionResolver::kQueryVersion);
+        if (version >= gl::makeVersion(4, 4) || resolver->hasExtension("ARB_buffer_storage")) {
+            bufferStorage = reinterpret_cast<PFNGLBUFFERSTORAGEPROC>(resolver->resolveSymbol("glBufferStorage"));
+        }
+        if (version >= gl::makeVersion(3, 2) || resolver->hasExtension("ARB_sync")) {
+            fenceSync = reinterpret_cast<PFNGLFENCESYNCPROC>(resolver->resolveSymbol("glFenceSync"));
+            clientWaitSync = reinterpret_cast<PFNGLCLIENTWAITSYNCPROC>(resolver->resolveSymbol("glClientWaitSync"));
+            deleteSync = reinterpret_cast<PFNGLDELETESYNCPROC>(resolver->resolveSymbol("glDeleteSync"));
+        }
+        if (version >= gl::makeVersion(3, 0)) {
             bindBufferBase = reinterpret_cast<PFNGLBINDBUFFERBASEPROC>(resolver->resolveSymbol("glBindBufferBase"));
             transformFeedbackVaryings = reinterpret_cast<PFNGLTRANSFORMFEEDBACKVARYINGSPROC>(resolver->resolveSymbol("glTransformFeedbackVaryings"));
             getTransformFeedbackBarying = reinterpret_cast<PFNGLGETTRANSFORMFEEDBACKVARYINGPROC>(resolver->resolveSymbol("glGetTransformFeedbackVarying"));
@@ -110,6 +136,10 @@ public:
         }
     }
     ~VertexBundle() {
+        const int nstreams = m_streams.count();
+        for (int i = 0; i < nstreams; i++) {
+            releaseFence(*m_streams.value(i));
+        }
         const int numVertexBuffers = m_vertexBuffers.count();
         for (int i = 0; i < numVertexBuffers; i++) {
             const GLuint *value = m_vertexBuffers.value(i);
@@ -141,6 +171,11 @@ public:
     void release(Type value, GLuint key) {
         switch (value) {
         case kVertexBuffer: {
+            if (Stream *stream = m_streams[key]) {
+                /* deleting the buffer also unmaps the persistent mapping */
+                releaseFence(*stream);
+                m_streams.remove(key);
+            }
             if (const GLuint *buffer = m_vertexBuffers.find(key)) {
                 deleteBuffers(1, buffer);
                 m_vertexBuffers.remove(key);
@@ -249,6 +284,75 @@ public:
         unmapBuffer(target);
 #endif /* GL_CHROMIUM_map_sub */
     }
+    UploadStrategy detectUploadStrategy() const {
+#if defined(GL_CHROMIUM_map_sub) || defined(VPVL2_ENABLE_GLES2)
+        return kMapBufferUpload;
+#else
+        if (bufferStorage && fenceSync && mapBufferRange) {
+            return kPersistentMappingUpload;
+        }
+        else if (mapBufferRange) {
+            return kOrphaningUpload;
+        }
+        return kMapBufferUpload;
+#endif
+    }
+    /* creates a vertex buffer written every frame by mapStream/unmapStream */
+    void createStream(GLuint key, UploadStrategy strategy, vsize size) {
+        release(kVertexBuffer, key);
+        GLuint name;
+        genBuffers(1, &name);
+        bindBuffer(kGL_ARRAY_BUFFER, name);
+        Stream stream(strategy, size);
+        if (strategy == kPersistentMappingUpload) {
+            const GLbitfield flags = kGL_MAP_WRITE_BIT | kGL_MAP_PERSISTENT_BIT | kGL_MAP_COHERENT_BIT;
+            bufferStorage(kGL_ARRAY_BUFFER, size, 0, flags);
+            stream.address = mapBufferRange(kGL_ARRAY_BUFFER, 0, size, flags);
+        }
+        else {
+            bufferData(kGL_ARRAY_BUFFER, size, 0, kGL_STREAM_DRAW);
+        }
+        bindBuffer(kGL_ARRAY_BUFFER, 0);
+        m_vertexBuffers.insert(key, name);
+        m_streams.insert(key, stream);
+    }
+    void *mapStream(GLuint key) {
+        Stream *stream = m_streams[key];
+        if (!stream) {
+            return 0;
+        }
+        switch (stream->strategy) {
+        case kPersistentMappingUpload:
+            waitFence(*stream);
+            return stream->address;
+        case kOrphaningUpload:
+            bind(kVertexBuffer, key);
+            bufferData(kGL_ARRAY_BUFFER, stream->size, 0, kGL_STREAM_DRAW);
+            return mapBufferRange(kGL_ARRAY_BUFFER, 0, stream->size,
+                                  kGL_MAP_WRITE_BIT | kGL_MAP_INVALIDATE_BUFFER_BIT | kGL_MAP_UNSYNCHRONIZED_BIT);
+        case kMapBufferUpload:
+        case kMaxUploadStrategy:
+        default:
+            bind(kVertexBuffer, key);
+            return map(kVertexBuffer, 0, stream->size);
+        }
+    }
+    void unmapStream(GLuint key, void *address) {
+        if (const Stream *stream = m_streams.find(key)) {
+            if (stream->strategy != kPersistentMappingUpload) {
+                unmap(kVertexBuffer, address);
+                unbind(kVertexBuffer);
+            }
+        }
+    }
+    /* called after the last draw call reading the stream was issued */
+    void fenceStream(GLuint key) {
+        Stream *stream = m_streams[key];
+        if (stream && stream->strategy == kPersistentMappingUpload) {
+            releaseFence(*stream);
+            stream->fence = fenceSync(kGL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+    }
     GLuint findName(GLuint key) const {
         if (const GLuint *value = m_vertexBuffers.find(key)) {
             return *value;
@@ -266,6 +370,45 @@ public:
     }
 
 private:
+    typedef void *GLsync;
+    typedef uint64 GLuint64;
+    struct Stream {
+        Stream()
+            : address(0),
+              fence(0),
+              size(0),
+              strategy(kMapBufferUpload)
+        {
+        }
+        Stream(UploadStrategy strategy, vsize size)
+            : address(0),
+              fence(0),
+              size(size),
+              strategy(strategy)
+        {
+        }
+        void *address;
+        GLsync fence;
+        vsize size;
+        UploadStrategy strategy;
+    };
+    static const GLuint64 kFenceTimeout = 1000000; /* 1ms in nanoseconds */
+
+    void waitFence(Stream &stream) {
+        if (stream.fence) {
+            GLenum result = clientWaitSync(stream.fence, 0, 0);
+            while (result == kGL_TIMEOUT_EXPIRED) {
+                result = clientWaitSync(stream.fence, kGL_SYNC_FLUSH_COMMANDS_BIT, kFenceTimeout);
+            }
+            releaseFence(stream);
+        }
+    }
+    void releaseFence(Stream &stream) {
+        if (stream.fence) {
+            deleteSync(stream.fence);
+            stream.fence = 0;
+        }
+    }
     GLuint internalCreate(GLenum target, GLenum usage, const void *ptr, vsize size) {
         GLuint name;
         genBuffers(1, &name);
@@ -306,6 +449,10 @@ private:
     typedef GLvoid* (GLAPIENTRY * PFNGLMAPBUFFERPROC) (GLenum target, GLenum access);
     typedef GLboolean (GLAPIENTRY * PFNGLUNMAPBUFFERPROC) (GLenum target);
     typedef GLvoid * (GLAPIENTRY * PFNGLMAPBUFFERRANGEPROC) (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+    typedef void (GLAPIENTRY * PFNGLBUFFERSTORAGEPROC) (GLenum target, GLsizeiptr size, const GLvoid *data, GLbitfield flags);
+    typedef GLsync (GLAPIENTRY * PFNGLFENCESYNCPROC) (GLenum condition, GLbitfield flags);
+    typedef GLenum (GLAPIENTRY * PFNGLCLIENTWAITSYNCPROC) (GLsync sync, GLbitfield flags, GLuint64 timeout);
+    typedef void (GLAPIENTRY * PFNGLDELETESYNCPROC) (GLsync sync);
     PFNGLGENBUFFERSPROC genBuffers;
     PFNGLBINDBUFFERPROC bindBuffer;
     PFNGLBUFFERDATAPROC bufferData;
@@ -324,8 +471,13 @@ private:
     PFNGLMAPBUFFERPROC mapBuffer;
     PFNGLUNMAPBUFFERPROC unmapBuffer;
     PFNGLMAPBUFFERRANGEPROC mapBufferRange;
+    PFNGLBUFFERSTORAGEPROC bufferStorage;
+    PFNGLFENCESYNCPROC fenceSync;
+    PFNGLCLIENTWAITSYNCPROC clientWaitSync;
+    PFNGLDELETESYNCPROC deleteSync;
 
     Hash<HashInt, GLuint> m_vertexBuffers;
+    Hash<HashInt, Stream> m_streams;
     GLuint m_indexBuffer;
     GLuint m_query;
 #ifdef VPVL2_ENABLE_GLES2
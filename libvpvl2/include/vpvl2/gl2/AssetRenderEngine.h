@@ -98,6 +98,9 @@ public:
     bool upload(void *userData);
     void release();
     void update();
+    bool beginUpdate();
+    void performUpdate();
+    void endUpdate();
     void setUpdateOptions(int options);
     void renderModel(IEffect::Pass *overridePass);
     void renderEdge(IEffect::Pass *overridePass);
@@ -67,6 +67,15 @@ class BaseShaderProgram;
 class VPVL2_API PMXRenderEngine : public IRenderEngine
 {
 public:
+    struct RenderStatistics {
+        /* draws that would be issued if each material were drawn separately */
+        int numMaterialDraws;
+        int numDrawCalls;
+        int numUniformUpdates;
+        int numTextureBinds;
+        int numStateChanges;
+    };
+
     PMXRenderEngine(IApplicationContext *applicationContextRef,
                     Scene *scene,
                     cl::PMXAccelerator *accelerator,
@@ -77,6 +86,9 @@ public:
     bool upload(void *userData);
     void release();
     void update();
+    bool beginUpdate();
+    void performUpdate();
+    void endUpdate();
     void setUpdateOptions(int options);
     void renderModel(IEffect::Pass *overridePass);
     void renderEdge(IEffect::Pass *overridePass);
@@ -92,6 +104,11 @@ public:
     void setOverridePass(IEffect::Pass *pass);
     bool testVisible();
 
+    /**
+     * Returns GL calls issued by the render passes of the current (or the last rendered) frame.
+     */
+    void getRenderStatistics(RenderStatistics &value) const;
+
 private:
     typedef void (GLAPIENTRY * PFNGLCULLFACEPROC) (gl::GLenum mode);
     typedef void (GLAPIENTRY * PFNGLENABLEPROC) (gl::GLenum cap);
@@ -130,6 +147,7 @@ private:
     void unbindVertexBundle();
     void bindDynamicVertexAttributePointers();
     void bindEdgeVertexAttributePointers();
+    void bindStreamVertexAttributePointers(bool isEdge);
     void bindStaticVertexAttributePointers();
 
     cl::PMXAccelerator *m_accelerator;
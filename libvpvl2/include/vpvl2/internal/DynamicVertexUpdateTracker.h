@@ -0,0 +1,199 @@
+/**
+
+ Copyright (c) 2010-2014  hkrn
+
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or
+ without modification, are permitted provided that the following
+ conditions are met:
+
+ - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following
+   disclaimer in the documentation and/or other materials provided
+   with the distribution.
+ - Neither the name of the MMDAI project team nor the names of
+   its contributors may be used to endorse or promote products
+   derived from this software without specific prior written
+   permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#pragma once
+#ifndef VPVL2_INTERNAL_DYNAMICVERTEXUPDATETRACKER_H_
+#define VPVL2_INTERNAL_DYNAMICVERTEXUPDATETRACKER_H_
+
+#include <vpvl2/Common.h>
+#include <vpvl2/IModel.h>
+#include <vpvl2/internal/util.h>
+
+namespace vpvl2
+{
+namespace VPVL2_VERSION_NS
+{
+namespace internal
+{
+
+/**
+ * DynamicVertexUpdateTracker decides which vertices of rotated (double or triple buffered)
+ * dynamic vertex buffers have to be uploaded by a render engine.
+ *
+ * Morphed vertices are written into a CPU side copy of the buffer at every frame and only
+ * ranges touched since the target buffer was written last time are uploaded, so the state
+ * is owned by the engine instead of const IModel::DynamicVertexBuffer.
+ */
+class DynamicVertexUpdateTracker VPVL2_DECL_FINAL {
+public:
+    struct Range {
+        Range() : offset(0), size(0) {}
+        vsize offset;
+        vsize size;
+    };
+    static const int kMaxBufferedFrames = 3;
+    /* ranges separated by less than this gap are merged to reduce glBufferSubData calls */
+    static const int kMaxMergeVertexGap = 16;
+
+    explicit DynamicVertexUpdateTracker(int nbuffers)
+        : m_numBuffers(btClamped(nbuffers, 1, int(kMaxBufferedFrames))),
+          m_frameIndex(0),
+          m_lastNumVertices(-1),
+          m_lastSerial(-1),
+          m_numFullUpdates(0)
+    {
+    }
+    ~DynamicVertexUpdateTracker() {
+    }
+
+    /**
+     * Collects vertices to be written at this frame.
+     *
+     * Returns false if all vertices must be written into both the copy and the buffer, or true
+     * if only currentVertexIndices() should be written and ranges() should be uploaded.
+     */
+    bool collect(const IModel::DynamicVertexBuffer *buffer, int nvertices) {
+        int serial = 0;
+        const bool tracked = buffer->getMorphTouchedVertexIndices(m_currentIndices, serial);
+        if (!tracked || nvertices != m_lastNumVertices || serial < m_lastSerial || serial > m_lastSerial + 1) {
+            /* vertices are changed or updates are skipped so all buffers must be filled again */
+            for (int i = 0; i < kMaxBufferedFrames; i++) {
+                m_history[i].clear();
+            }
+            m_marks.resize(nvertices);
+            if (nvertices > 0) {
+                zerofill(&m_marks[0], nvertices);
+            }
+            m_numFullUpdates = m_numBuffers;
+            m_lastNumVertices = nvertices;
+        }
+        else if (serial == m_lastSerial) {
+            /* the model is not updated since the last frame */
+            m_currentIndices.clear();
+        }
+        m_lastSerial = serial;
+        removeOutOfBoundIndices(m_currentIndices, nvertices);
+        m_history[m_frameIndex].copy(m_currentIndices);
+        m_frameIndex = (m_frameIndex + 1) % m_numBuffers;
+        m_ranges.clear();
+        if (m_numFullUpdates > 0) {
+            m_numFullUpdates--;
+            return false;
+        }
+        /* the buffer to be written was last written m_numBuffers frames ago */
+        m_uploadIndices.clear();
+        for (int i = 0; i < m_numBuffers; i++) {
+            const Array<int> &indices = m_history[i];
+            const int nindices = indices.count();
+            for (int j = 0; j < nindices; j++) {
+                const int index = indices[j];
+                if (!m_marks[index]) {
+                    m_marks[index] = 1;
+                    m_uploadIndices.append(index);
+                }
+            }
+        }
+        const int nindices = m_uploadIndices.count();
+        for (int i = 0; i < nindices; i++) {
+            m_marks[m_uploadIndices[i]] = 0;
+        }
+        m_uploadIndices.sort(IndexLess());
+        return true;
+    }
+    /**
+     * Builds byte ranges to be uploaded from vertices collected by collect().
+     */
+    const Array<Range> &ranges(vsize strideSize) {
+        m_ranges.clear();
+        const int nindices = m_uploadIndices.count();
+        int i = 0;
+        while (i < nindices) {
+            const int first = m_uploadIndices[i];
+            int last = first;
+            while (++i < nindices && m_uploadIndices[i] - last <= kMaxMergeVertexGap) {
+                last = m_uploadIndices[i];
+            }
+            Range range;
+            range.offset = vsize(first) * strideSize;
+            range.size = vsize(last - first + 1) * strideSize;
+            m_ranges.append(range);
+        }
+        return m_ranges;
+    }
+    const Array<int> &currentVertexIndices() const {
+        return m_currentIndices;
+    }
+
+private:
+    struct IndexLess {
+        bool operator()(const int &left, const int &right) const {
+            return left < right;
+        }
+    };
+    static void removeOutOfBoundIndices(Array<int> &indices, int nvertices) {
+        int nindices = indices.count(), i = 0;
+        while (i < nindices) {
+            if (!checkBound(indices[i], 0, nvertices)) {
+                indices.removeAt(i);
+                nindices--;
+            }
+            else {
+                i++;
+            }
+        }
+    }
+
+    Array<int> m_history[kMaxBufferedFrames];
+    Array<int> m_currentIndices;
+    Array<int> m_uploadIndices;
+    Array<uint8> m_marks;
+    Array<Range> m_ranges;
+    const int m_numBuffers;
+    int m_frameIndex;
+    int m_lastNumVertices;
+    int m_lastSerial;
+    int m_numFullUpdates;
+
+    VPVL2_DISABLE_COPY_AND_ASSIGN(DynamicVertexUpdateTracker)
+};
+
+} /* namespace internal */
+} /* namespace VPVL2_VERSION_NS */
+} /* namespace vpvl2 */
+
+#endif
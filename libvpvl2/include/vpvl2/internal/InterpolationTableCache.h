@@ -0,0 +1,117 @@
+/**
+
+ Copyright (c) 2010-2014  hkrn
+
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or
+ without modification, are permitted provided that the following
+ conditions are met:
+
+ - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following
+   disclaimer in the documentation and/or other materials provided
+   with the distribution.
+ - Neither the name of the MMDAI project team nor the names of
+   its contributors may be used to endorse or promote products
+   derived from this software without specific prior written
+   permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+#ifndef VPVL2_INTERNAL_INTERPOLATIONTABLECACHE_H_
+#define VPVL2_INTERNAL_INTERPOLATIONTABLECACHE_H_
+
+#include "vpvl2/IKeyframe.h"
+
+namespace vpvl2
+{
+namespace VPVL2_VERSION_NS
+{
+namespace internal
+{
+
+/**
+ * Process-wide store of bezier interpolation tables.
+ *
+ * Tables are interned by their four control point bytes and table size, so keyframes
+ * sharing the same curve also share one immutable table. Tables are reference counted
+ * and freed when the last keyframe releases them. All functions are thread safe.
+ */
+class VPVL2_API InterpolationTableCache VPVL2_DECL_FINAL
+{
+public:
+    enum EvaluationMode {
+        kTableEvaluation,
+        kAnalyticEvaluation,
+        kMaxEvaluationMode
+    };
+    struct Statistics {
+        /* number of distinct tables currently alive */
+        int numTables;
+        /* number of keyframe slots referring to the tables above */
+        int numReferences;
+        /* bytes actually allocated for the tables */
+        vsize sharedBytes;
+        /* bytes that would be allocated if each keyframe owned its table */
+        vsize unsharedBytes;
+    };
+
+    /**
+     * Returns an interned table with (size + 1) elements for the parameter.
+     *
+     * Returns null when the current evaluation mode is kAnalyticEvaluation. Every
+     * non-null table must be passed to release() exactly once.
+     */
+    static const IKeyframe::SmoothPrecision *acquire(const QuadWord &parameter, int size);
+    static void release(const IKeyframe::SmoothPrecision *table);
+    static void getStatistics(Statistics &value);
+
+    /**
+     * Evaluation mode applies to tables acquired after the change, already acquired
+     * tables are kept as is. Default is kTableEvaluation.
+     */
+    static EvaluationMode evaluationMode();
+    static void setEvaluationMode(EvaluationMode value);
+
+    /**
+     * Solves the bezier curve of the parameter directly without a table.
+     */
+    static IKeyframe::SmoothPrecision evaluate(const QuadWord &parameter, const IKeyframe::SmoothPrecision &weight);
+    static inline IKeyframe::SmoothPrecision lookup(const IKeyframe::SmoothPrecision *table,
+                                                    const QuadWord &parameter,
+                                                    int size,
+                                                    const IKeyframe::SmoothPrecision &weight) {
+        if (table) {
+            const uint16 index = static_cast<int16>(weight * size);
+            return table[index] + (table[index + 1] - table[index]) * (weight * size - index);
+        }
+        return evaluate(parameter, weight);
+    }
+
+private:
+    VPVL2_MAKE_STATIC_CLASS(InterpolationTableCache)
+};
+
+} /* namespace internal */
+} /* namespace VPVL2_VERSION_NS */
+} /* namespace vpvl2 */
+
+#endif
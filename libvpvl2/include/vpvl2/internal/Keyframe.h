@@ -41,6 +41,7 @@
 #define VPVL2_INTERNAL_KEYFRAME_H_
 
 #include "vpvl2/IKeyframe.h"
+#include "vpvl2/internal/InterpolationTableCache.h"
 
 namespace vpvl2
 {
@@ -64,18 +65,20 @@ struct InterpolationPair VPVL2_DECL_FINAL {
 #pragma pack(pop)
 
 struct InterpolationTable VPVL2_DECL_FINAL {
-    typedef Array<IKeyframe::SmoothPrecision> Value;
-    Value table;
+    const IKeyframe::SmoothPrecision *table;
     QuadWord parameter;
     bool linear;
     int size;
     InterpolationTable()
-        : parameter(defaultParameter()),
+        : table(0),
+          parameter(defaultParameter()),
           linear(true),
           size(0)
     {
     }
     ~InterpolationTable() {
+        InterpolationTableCache::release(table);
+        table = 0;
         parameter = defaultParameter();
         linear = true;
         size = 0;
@@ -87,23 +90,22 @@ struct InterpolationTable VPVL2_DECL_FINAL {
         pair.second.y = uint8(parameter.w());
     }
     void build(const QuadWord &value, int s) {
+        InterpolationTableCache::release(table);
+        table = 0;
         if (!btFuzzyZero(value.x() - value.y()) || !btFuzzyZero(value.z() - value.w())) {
-            table.resize(s + 1);
-            const IKeyframe::SmoothPrecision &x1 = value.x() / 127.0f, &x2 = value.z() / 127.0f;
-            const IKeyframe::SmoothPrecision &y1 = value.y() / 127.0f, &y2 = value.w() / 127.0f;
-            IKeyframe::SmoothPrecision *ptr = &table[0];
-            build(x1, x2, y1, y2, s, ptr);
+            /* shared with other keyframes, null on analytic evaluation */
+            table = InterpolationTableCache::acquire(value, s);
             linear = false;
         }
         else {
-            table.clear();
             linear = true;
         }
         parameter = value;
         size = s;
     }
     void reset() {
-        table.clear();
+        InterpolationTableCache::release(table);
+        table = 0;
         linear = true;
         parameter = defaultParameter();
     }
@@ -152,6 +154,9 @@ struct InterpolationTable VPVL2_DECL_FINAL {
         }
         table[size] = 1;
     }
+
+private:
+    VPVL2_DISABLE_COPY_AND_ASSIGN(InterpolationTable)
 };
 
 } /* namespace internal */
@@ -0,0 +1,310 @@
+/**
+
+ Copyright (c) 2010-2014  hkrn
+
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or
+ without modification, are permitted provided that the following
+ conditions are met:
+
+ - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following
+   disclaimer in the documentation and/or other materials provided
+   with the distribution.
+ - Neither the name of the MMDAI project team nor the names of
+   its contributors may be used to endorse or promote products
+   derived from this software without specific prior written
+   permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+#ifndef VPVL2_INTERNAL_MATERIALDRAWLIST_H_
+#define VPVL2_INTERNAL_MATERIALDRAWLIST_H_
+
+#include <vpvl2/Common.h>
+#include <vpvl2/IMaterial.h>
+#include <vpvl2/IVertex.h>
+
+namespace vpvl2
+{
+namespace VPVL2_VERSION_NS
+{
+
+class ITexture;
+
+namespace internal
+{
+
+/**
+ * Per pass draw commands of the materials of a model.
+ *
+ * Each material state is cached as a plain uniform block so the render engine can compare
+ * it against the previously applied one instead of setting every uniform. Adjacent materials
+ * whose states are identical for a pass are merged into one command when merging is enabled,
+ * which requires index ranges of the materials to be contiguous (always true for PMD/PMX).
+ */
+class MaterialDrawList VPVL2_DECL_FINAL {
+public:
+    enum PassType {
+        kModelPass,
+        kEdgePass,
+        kShadowPass,
+        kZPlotPass,
+        kMaxPassType
+    };
+    struct State {
+        State()
+            : ambient(kZeroC),
+              diffuse(kZeroC),
+              specular(kZeroC),
+              mainTextureBlend(kZeroC),
+              sphereTextureBlend(kZeroC),
+              toonTextureBlend(kZeroC),
+              edgeColor(kZeroC),
+              shininess(0),
+              edgeSize(0),
+              mainTextureRef(0),
+              sphereTextureRef(0),
+              toonTextureRef(0),
+              sphereTextureRenderMode(IMaterial::kNone),
+              numIndices(0),
+              isCullingDisabled(false),
+              isShadowMapEnabled(false),
+              isEdgeEnabled(false),
+              isCastingShadowEnabled(false),
+              isCastingShadowMapEnabled(false)
+        {
+        }
+        /* returns true if both states can be drawn with the same uniforms in the pass */
+        bool isSameAs(const State &other, PassType type) const {
+            switch (type) {
+            case kModelPass:
+                return ambient == other.ambient && diffuse == other.diffuse && specular == other.specular
+                        && mainTextureBlend == other.mainTextureBlend
+                        && sphereTextureBlend == other.sphereTextureBlend
+                        && toonTextureBlend == other.toonTextureBlend
+                        && shininess == other.shininess
+                        && mainTextureRef == other.mainTextureRef
+                        && sphereTextureRef == other.sphereTextureRef
+                        && toonTextureRef == other.toonTextureRef
+                        && sphereTextureRenderMode == other.sphereTextureRenderMode
+                        && isCullingDisabled == other.isCullingDisabled
+                        && isShadowMapEnabled == other.isShadowMapEnabled;
+            case kEdgePass:
+                return edgeColor == other.edgeColor && edgeSize == other.edgeSize;
+            case kShadowPass:
+            case kZPlotPass:
+                return true;
+            case kMaxPassType:
+            default:
+                return false;
+            }
+        }
+        bool isDrawable(PassType type) const {
+            switch (type) {
+            case kModelPass:
+                return true;
+            case kEdgePass:
+                return isEdgeEnabled;
+            case kShadowPass:
+                return isCastingShadowEnabled;
+            case kZPlotPass:
+                return isCastingShadowMapEnabled;
+            case kMaxPassType:
+            default:
+                return false;
+            }
+        }
+        bool equals(const State &other) const {
+            return isSameAs(other, kModelPass) && isSameAs(other, kEdgePass)
+                    && numIndices == other.numIndices
+                    && isEdgeEnabled == other.isEdgeEnabled
+                    && isCastingShadowEnabled == other.isCastingShadowEnabled
+                    && isCastingShadowMapEnabled == other.isCastingShadowMapEnabled;
+        }
+        Color ambient;
+        Color diffuse;
+        Color specular;
+        Color mainTextureBlend;
+        Color sphereTextureBlend;
+        Color toonTextureBlend;
+        Color edgeColor;
+        Scalar shininess;
+        IVertex::EdgeSizePrecision edgeSize;
+        const ITexture *mainTextureRef;
+        const ITexture *sphereTextureRef;
+        const ITexture *toonTextureRef;
+        IMaterial::SphereTextureRenderMode sphereTextureRenderMode;
+        int numIndices;
+        bool isCullingDisabled;
+        bool isShadowMapEnabled;
+        bool isEdgeEnabled;
+        bool isCastingShadowEnabled;
+        bool isCastingShadowMapEnabled;
+    };
+    struct Command {
+        /* index of the first material, its state is used for the whole command */
+        int materialIndex;
+        int numMaterials;
+        /* offset and count are in indices, not bytes */
+        vsize offset;
+        int count;
+    };
+
+    MaterialDrawList()
+        : m_mergeEnabled(true),
+          m_dirty(true)
+    {
+    }
+    ~MaterialDrawList() {
+        m_mergeEnabled = false;
+        m_dirty = false;
+    }
+
+    /**
+     * Textures are resolved at upload time and kept until the next call with the same index.
+     */
+    void setTextureRefs(int index, const ITexture *mainTextureRef, const ITexture *sphereTextureRef, const ITexture *toonTextureRef) {
+        if (index >= m_states.count()) {
+            m_states.resize(index + 1);
+        }
+        State &state = m_states[index];
+        state.mainTextureRef = mainTextureRef;
+        state.sphereTextureRef = sphereTextureRef;
+        state.toonTextureRef = toonTextureRef;
+        m_dirty = true;
+    }
+    /**
+     * Captures states of the materials and rebuilds the commands only if any of them changed.
+     *
+     * Returns true if the commands are rebuilt.
+     */
+    bool build(const Array<IMaterial *> &materials) {
+        const int nmaterials = materials.count();
+        bool dirty = m_dirty;
+        if (m_states.count() != nmaterials) {
+            m_states.resize(nmaterials);
+            dirty = true;
+        }
+        for (int i = 0; i < nmaterials; i++) {
+            const IMaterial *material = materials[i];
+            State &state = m_states[i];
+            State newState(state);
+            newState.ambient = material->ambient();
+            newState.diffuse = material->diffuse();
+            newState.specular = material->specular();
+            newState.mainTextureBlend = material->mainTextureBlend();
+            newState.sphereTextureBlend = material->sphereTextureBlend();
+            newState.toonTextureBlend = material->toonTextureBlend();
+            newState.edgeColor = material->edgeColor();
+            newState.shininess = material->shininess();
+            newState.edgeSize = material->edgeSize();
+            newState.sphereTextureRenderMode = material->sphereTextureRenderMode();
+            newState.numIndices = material->indexRange().count;
+            newState.isCullingDisabled = material->isCullingDisabled();
+            newState.isShadowMapEnabled = material->isShadowMapEnabled();
+            newState.isEdgeEnabled = material->isEdgeEnabled();
+            newState.isCastingShadowEnabled = material->isCastingShadowEnabled();
+            newState.isCastingShadowMapEnabled = material->isCastingShadowMapEnabled();
+            if (!dirty && !newState.equals(state)) {
+                dirty = true;
+            }
+            state = newState;
+        }
+        if (dirty) {
+            for (int i = 0; i < kMaxPassType; i++) {
+                rebuildCommands(static_cast<PassType>(i));
+            }
+            m_dirty = false;
+        }
+        return dirty;
+    }
+
+    /**
+     * Merging must be disabled when each material needs its own uniforms that are not
+     * part of the state (e.g. bone matrices of vertex shader skinning).
+     */
+    bool isMergeEnabled() const {
+        return m_mergeEnabled;
+    }
+    void setMergeEnabled(bool value) {
+        if (m_mergeEnabled != value) {
+            m_mergeEnabled = value;
+            m_dirty = true;
+        }
+    }
+    int countCommands(PassType type) const {
+        return m_commands[type].count();
+    }
+    const Command &commandAt(PassType type, int index) const {
+        return m_commands[type][index];
+    }
+    int countStates() const {
+        return m_states.count();
+    }
+    const State &stateAt(int index) const {
+        return m_states[index];
+    }
+
+private:
+    void rebuildCommands(PassType type) {
+        Array<Command> &commands = m_commands[type];
+        const int nstates = m_states.count();
+        vsize offset = 0;
+        commands.clear();
+        for (int i = 0; i < nstates; i++) {
+            const State &state = m_states[i];
+            const int nindices = state.numIndices;
+            if (state.isDrawable(type)) {
+                const int ncommands = commands.count();
+                Command *lastCommand = ncommands > 0 ? &commands[ncommands - 1] : 0;
+                if (m_mergeEnabled && lastCommand
+                        && lastCommand->offset + lastCommand->count == offset
+                        && m_states[lastCommand->materialIndex].isSameAs(state, type)) {
+                    lastCommand->count += nindices;
+                    lastCommand->numMaterials++;
+                }
+                else {
+                    Command command;
+                    command.materialIndex = i;
+                    command.numMaterials = 1;
+                    command.offset = offset;
+                    command.count = nindices;
+                    commands.append(command);
+                }
+            }
+            offset += nindices;
+        }
+    }
+
+    Array<State> m_states;
+    Array<Command> m_commands[kMaxPassType];
+    bool m_mergeEnabled;
+    bool m_dirty;
+
+    VPVL2_DISABLE_COPY_AND_ASSIGN(MaterialDrawList)
+};
+
+} /* namespace internal */
+} /* namespace VPVL2_VERSION_NS */
+} /* namespace vpvl2 */
+
+#endif
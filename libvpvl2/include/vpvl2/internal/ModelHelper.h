@@ -65,6 +65,13 @@ enum {
 
 class ModelHelper VPVL2_DECL_FINAL {
 public:
+    class IndexPredication VPVL2_DECL_FINAL {
+    public:
+        bool operator()(int left, int right) const VPVL2_DECL_NOEXCEPT {
+            return left < right;
+        }
+    };
+
     static inline void transformVertex(const Transform &transform,
                                        const Vector3 &inPosition,
                                        const Vector3 &inNormal,
@@ -136,7 +143,8 @@ public:
     template<typename T, typename I>
     static inline void getObjectRefs(const Array<T *> &objects, Array<I *> &value) {
         const int nobjects = objects.count();
-        value.clear();
+        /* resize(0) keeps the storage of the array for callers that reuse it */
+        value.resize(0);
         value.reserve(nobjects);
         for (int i = 0; i < nobjects; i++) {
             T *object = objects[i];
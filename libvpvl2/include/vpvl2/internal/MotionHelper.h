@@ -65,6 +65,80 @@ public:
         }
     };
 
+    /* forward playback usually finds the next keyframe within a few steps from the last index */
+    static const int kMaxLinearSearchCount = 8;
+
+    template<typename T>
+    static int findLowerBoundKeyframeIndex(const IKeyframe::TimeIndex &timeIndex,
+                                           int first,
+                                           int last,
+                                           const Array<T *> &keyframes) VPVL2_DECL_NOEXCEPT
+    {
+        /* returns the first index of [first, last) which time index is equal or greater than timeIndex */
+        while (first < last) {
+            const int middle = first + ((last - first) >> 1);
+            if (keyframes[middle]->timeIndex() < timeIndex) {
+                first = middle + 1;
+            }
+            else {
+                last = middle;
+            }
+        }
+        return first;
+    }
+    template<typename T>
+    static void insertKeyframe(T *keyframe, Array<T *> &keyframes)
+    {
+        /* inserts after keyframes of the same time index to keep the order of KeyframeTimeIndexPredication */
+        const KeyframeTimeIndexPredication predication;
+        int first = 0, last = keyframes.count();
+        while (first < last) {
+            const int middle = first + ((last - first) >> 1);
+            if (predication(keyframe, keyframes[middle])) {
+                last = middle;
+            }
+            else {
+                first = middle + 1;
+            }
+        }
+        keyframes.append(keyframe);
+        for (int i = keyframes.count() - 1; i > first; i--) {
+            keyframes[i] = keyframes[i - 1];
+        }
+        keyframes[first] = keyframe;
+    }
+    template<typename T>
+    static bool removeKeyframe(const IKeyframe *keyframe, Array<T *> &keyframes)
+    {
+        int index = 0;
+        return removeKeyframe(keyframe, keyframes, index);
+    }
+    template<typename T>
+    static bool removeKeyframe(const IKeyframe *keyframe, Array<T *> &keyframes, int &removedIndex)
+    {
+        const IKeyframe::TimeIndex &timeIndex = keyframe->timeIndex();
+        const int nkeyframes = keyframes.count();
+        int index = findLowerBoundKeyframeIndex(timeIndex, 0, nkeyframes, keyframes);
+        while (index < nkeyframes && keyframes[index] != keyframe && keyframes[index]->timeIndex() == timeIndex) {
+            index++;
+        }
+        if (index >= nkeyframes || keyframes[index] != keyframe) {
+            /* time index of the keyframe may be changed after inserting */
+            index = 0;
+            while (index < nkeyframes && keyframes[index] != keyframe) {
+                index++;
+            }
+            if (index == nkeyframes) {
+                return false;
+            }
+        }
+        for (int i = index; i < nkeyframes - 1; i++) {
+            keyframes[i] = keyframes[i + 1];
+        }
+        keyframes.resize(nkeyframes - 1);
+        removedIndex = index;
+        return true;
+    }
     template<typename T>
     static void findKeyframeIndices(const IKeyframe::TimeIndex &seekIndex,
                                     IKeyframe::TimeIndex &currentKeyframe,
@@ -76,15 +150,36 @@ public:
         const int nframes = keyframes.count();
         IKeyframe *lastKeyFrame = keyframes[nframes - 1];
         currentKeyframe = btMin(seekIndex, lastKeyFrame->timeIndex());
+        if (!checkBound(lastIndex, 0, nframes)) {
+            lastIndex = 0;
+        }
+        /*
+         * keyframes are sorted by layer index and time index, so time index is monotonic
+         * (and binary search is available) only if all keyframes are in the same layer.
+         */
+        const bool isMonotonic = keyframes[0]->layerIndex() == lastKeyFrame->layerIndex();
         // Find the next frame index bigger than the frame index of last key frame
         fromIndex = toIndex = 0;
         if (currentKeyframe >= keyframes[lastIndex]->timeIndex()) {
-            for (int i = lastIndex; i < nframes; i++) {
+            const int end = isMonotonic ? btMin(lastIndex + kMaxLinearSearchCount, nframes) : nframes;
+            int i = lastIndex;
+            for (; i < end; i++) {
                 if (currentKeyframe <= keyframes[i]->timeIndex()) {
                     toIndex = i;
                     break;
                 }
             }
+            if (i == end && end < nframes) {
+                /* seeking far forward, fall back to binary search */
+                const int index = findLowerBoundKeyframeIndex(currentKeyframe, end, nframes, keyframes);
+                toIndex = index < nframes ? index : 0;
+            }
+        }
+        else if (isMonotonic) {
+            /* seeking backward, the keyframe must be found in [0, lastIndex] */
+            const int end = btMin(lastIndex + 1, nframes);
+            const int index = findLowerBoundKeyframeIndex(currentKeyframe, 0, end, keyframes);
+            toIndex = index < end ? index : 0;
         }
         else {
             for (int i = 0; i <= lastIndex && i < nframes; i++) {
@@ -121,10 +216,7 @@ public:
     static inline IKeyframe::SmoothPrecision calculateInterpolatedWeight(const InterpolationTable &t,
                                                                          const IKeyframe::SmoothPrecision &weight) VPVL2_DECL_NOEXCEPT
     {
-        const internal::InterpolationTable::Value &v = t.table;
-        const uint16 index = static_cast<int16>(weight * t.size);
-        const IKeyframe::SmoothPrecision &value = v[index] + (v[index + 1] - v[index]) * (weight * t.size - index);
-        return value;
+        return InterpolationTableCache::lookup(t.table, t.parameter, t.size, weight);
     }
     static inline void interpolate(const InterpolationTable &t,
                                    const Vector3 &from,
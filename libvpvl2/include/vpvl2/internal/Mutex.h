@@ -0,0 +1,105 @@
+/**
+
+ Copyright (c) 2010-2014  hkrn
+
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or
+ without modification, are permitted provided that the following
+ conditions are met:
+
+ - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following
+   disclaimer in the documentation and/or other materials provided
+   with the distribution.
+ - Neither the name of the MMDAI project team nor the names of
+   its contributors may be used to endorse or promote products
+   derived from this software without specific prior written
+   permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+#ifndef VPVL2_INTERNAL_MUTEX_H_
+#define VPVL2_INTERNAL_MUTEX_H_
+
+#include "vpvl2/Common.h"
+
+#if defined(VPVL2_LINK_INTEL_TBB)
+#include <tbb/mutex.h>
+#elif defined(VPVL2_OS_WINDOWS)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+namespace vpvl2
+{
+namespace VPVL2_VERSION_NS
+{
+namespace internal
+{
+
+class Mutex VPVL2_DECL_FINAL {
+public:
+#if defined(VPVL2_LINK_INTEL_TBB)
+    Mutex() {}
+    ~Mutex() {}
+    void lock() { m_mutex.lock(); }
+    void unlock() { m_mutex.unlock(); }
+private:
+    tbb::mutex m_mutex;
+#elif defined(VPVL2_OS_WINDOWS)
+    Mutex() { InitializeCriticalSection(&m_section); }
+    ~Mutex() { DeleteCriticalSection(&m_section); }
+    void lock() { EnterCriticalSection(&m_section); }
+    void unlock() { LeaveCriticalSection(&m_section); }
+private:
+    CRITICAL_SECTION m_section;
+#else
+    Mutex() { pthread_mutex_init(&m_mutex, 0); }
+    ~Mutex() { pthread_mutex_destroy(&m_mutex); }
+    void lock() { pthread_mutex_lock(&m_mutex); }
+    void unlock() { pthread_mutex_unlock(&m_mutex); }
+private:
+    pthread_mutex_t m_mutex;
+#endif
+    VPVL2_DISABLE_COPY_AND_ASSIGN(Mutex)
+};
+
+class ScopedLock VPVL2_DECL_FINAL {
+public:
+    ScopedLock(Mutex &mutex)
+        : m_mutexRef(mutex)
+    {
+        m_mutexRef.lock();
+    }
+    ~ScopedLock() {
+        m_mutexRef.unlock();
+    }
+private:
+    Mutex &m_mutexRef;
+    VPVL2_DISABLE_COPY_AND_ASSIGN(ScopedLock)
+};
+
+} /* namespace internal */
+} /* namespace VPVL2_VERSION_NS */
+} /* namespace vpvl2 */
+
+#endif
@@ -0,0 +1,563 @@
+/**
+
+ Copyright (c) 2010-2014  hkrn
+
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or
+ without modification, are permitted provided that the following
+ conditions are met:
+
+ - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following
+   disclaimer in the documentation and/or other materials provided
+   with the distribution.
+ - Neither the name of the MMDAI project team nor the names of
+   its contributors may be used to endorse or promote products
+   derived from this software without specific prior written
+   permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+#ifndef VPVL2_INTERNAL_PACKEDVERTEXSTORE_H_
+#define VPVL2_INTERNAL_PACKEDVERTEXSTORE_H_
+
+#include <vpvl2/Common.h>
+#include <vpvl2/Factory.h>
+#include <vpvl2/IBone.h>
+#include <vpvl2/IMaterial.h>
+#include <vpvl2/IVertex.h>
+#include <vpvl2/internal/util.h>
+
+#if !defined(BT_USE_DOUBLE_PRECISION) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define VPVL2_PACKED_VERTEX_STORE_SSE
+#include <emmintrin.h>
+#if defined(__AVX__)
+#define VPVL2_PACKED_VERTEX_STORE_AVX
+#include <immintrin.h>
+#endif /* __AVX__ */
+#endif /* BT_USE_DOUBLE_PRECISION */
+
+namespace vpvl2
+{
+namespace VPVL2_VERSION_NS
+{
+namespace internal
+{
+
+/**
+ * PackedVertexStore keeps vertex attributes needed by CPU skinning as structure-of-arrays
+ * grouped by deformation type, so skinning kernels run over contiguous memory instead of
+ * calling IVertex#performSkinning through each vertex's private context.
+ *
+ * The store is a snapshot: it must be rebuilt when vertices, bones or materials are edited.
+ * Morph results are pulled at every update only from vertices referenced by vertex/UV morphs.
+ *
+ * SDEF and QDEF vertices are deformed as BDEF2 and BDEF4 same as IVertex#performSkinning,
+ * so SDEF parameters (C/R0/R1) are not packed.
+ */
+class PackedVertexStore VPVL2_DECL_FINAL {
+public:
+    enum GroupType {
+        kBdef1Group,
+        kBdef2Group,
+        kBdef4Group,
+        kSdefGroup,
+        kQdefGroup,
+        kMaxGroupType
+    };
+    static const int kMatrixSize = 16;
+    /* output unit without UVA, written as a split per-frame stream */
+    struct SkinningUnit {
+        Vector3 position;
+        Vector3 normal;
+        Vector3 edge;
+    };
+
+    PackedVertexStore()
+        : m_numVertices(0)
+    {
+    }
+    ~PackedVertexStore() {
+        m_numVertices = 0;
+    }
+
+    static inline int boneStride(GroupType type) VPVL2_DECL_NOEXCEPT {
+        switch (type) {
+        case kBdef1Group:
+            return 1;
+        case kBdef2Group:
+        case kSdefGroup:
+            return 2;
+        case kBdef4Group:
+        case kQdefGroup:
+            return 4;
+        case kMaxGroupType:
+        default:
+            return 0;
+        }
+    }
+    static inline GroupType groupOf(IVertex::Type type) VPVL2_DECL_NOEXCEPT {
+        switch (type) {
+        case IVertex::kBdef2:
+            return kBdef2Group;
+        case IVertex::kBdef4:
+            return kBdef4Group;
+        case IVertex::kSdef:
+            return kSdefGroup;
+        case IVertex::kQdef:
+            return kQdefGroup;
+        case IVertex::kBdef1:
+        case IVertex::kMaxType:
+        default:
+            return kBdef1Group;
+        }
+    }
+
+    template<typename TVertex, typename TBone, typename TMaterial>
+    void build(const Array<TVertex *> &vertices,
+               const Array<TBone *> &bones,
+               const Array<TMaterial *> &materials,
+               const Array<int> &morphTargets) {
+        release();
+        const int nvertices = vertices.count(), nbones = bones.count(), nmaterials = materials.count();
+        m_vertexGroups.resize(nvertices);
+        m_vertexSlots.resize(nvertices);
+        m_uvas.resize(nvertices * kMaxUVA);
+        for (int i = 0; i < nvertices; i++) {
+            const IVertex *vertex = vertices[i];
+            const GroupType type = groupOf(vertex->type());
+            Group &group = m_groups[type];
+            const int slot = group.vertexIndices.count();
+            const int stride = boneStride(type);
+            group.vertexIndices.append(i);
+            group.positions.append(vertex->origin() + vertex->delta());
+            group.normals.append(vertex->normal());
+            group.edgeSizes.append(vertex->edgeSize());
+            group.materialSlots.append(resolveSlot(vertex->materialRef()->index(), nmaterials));
+            for (int j = 0; j < stride; j++) {
+                group.boneSlots.append(resolveSlot(vertex->boneRef(j)->index(), nbones));
+            }
+            appendWeights(vertex, type, group);
+            for (int j = 0; j < kMaxUVA; j++) {
+                m_uvas[i * kMaxUVA + j] = vertex->uv(j);
+            }
+            m_vertexGroups[i] = type;
+            m_vertexSlots[i] = slot;
+        }
+        const int ntargets = morphTargets.count();
+        m_morphTargets.reserve(ntargets);
+        for (int i = 0; i < ntargets; i++) {
+            const int index = morphTargets[i];
+            if (checkBound(index, 0, nvertices)) {
+                m_morphTargets.append(index);
+            }
+        }
+        m_boneMatrices.resize((nbones + 1) * kMatrixSize);
+        m_materialEdgeSizes.resize(nmaterials + 1);
+        m_numVertices = nvertices;
+    }
+    template<typename TVertex, typename TBone, typename TMaterial>
+    void update(const Array<TVertex *> &vertices,
+                const Array<TBone *> &bones,
+                const Array<TMaterial *> &materials) {
+        const int nbones = bones.count(), nmaterials = materials.count();
+        if (m_boneMatrices.count() != (nbones + 1) * kMatrixSize || m_materialEdgeSizes.count() != nmaterials + 1) {
+            return;
+        }
+        Scalar *matrices = &m_boneMatrices[0];
+        Factory::sharedNullBoneRef()->localTransform().getOpenGLMatrix(matrices);
+        for (int i = 0; i < nbones; i++) {
+            const IBone *bone = bones[i];
+            bone->localTransform().getOpenGLMatrix(&matrices[(i + 1) * kMatrixSize]);
+        }
+        m_materialEdgeSizes[0] = Factory::sharedNullMaterialRef()->edgeSize();
+        for (int i = 0; i < nmaterials; i++) {
+            const IMaterial *material = materials[i];
+            m_materialEdgeSizes[i + 1] = material->edgeSize();
+        }
+        syncMorphTargets(vertices, m_morphTargets);
+    }
+    template<typename TVertex>
+    void syncMorphTargets(const Array<TVertex *> &vertices, const Array<int> &targets) {
+        const int ntargets = targets.count(), nvertices = vertices.count();
+        for (int i = 0; i < ntargets; i++) {
+            const int index = targets[i];
+            if (checkBound(index, 0, nvertices)) {
+                const IVertex *vertex = vertices[index];
+                Group &group = m_groups[m_vertexGroups[index]];
+                group.positions[m_vertexSlots[index]] = vertex->origin() + vertex->delta();
+                for (int j = 0; j < kMaxUVA; j++) {
+                    m_uvas[index * kMaxUVA + j] = vertex->uv(j);
+                }
+            }
+        }
+    }
+    template<typename TUnit>
+    void performSkinning(GroupType type,
+                         int begin,
+                         int end,
+                         const IVertex::EdgeSizePrecision &edgeScaleFactor,
+                         TUnit *bufferPtr) const {
+        NullBoundingBox box;
+        performSkinningGroup(type, begin, end, edgeScaleFactor, bufferPtr, box);
+    }
+    /* same as above but also merges skinned positions into aabbMin/aabbMax in the same pass */
+    template<typename TUnit>
+    void performSkinning(GroupType type,
+                         int begin,
+                         int end,
+                         const IVertex::EdgeSizePrecision &edgeScaleFactor,
+                         TUnit *bufferPtr,
+                         Vector3 &aabbMin,
+                         Vector3 &aabbMax) const {
+        BoundingBox box;
+        performSkinningGroup(type, begin, end, edgeScaleFactor, bufferPtr, box);
+        box.merge(aabbMin, aabbMax);
+    }
+    void release() {
+        for (int i = 0; i < kMaxGroupType; i++) {
+            m_groups[i].clear();
+        }
+        m_vertexGroups.clear();
+        m_vertexSlots.clear();
+        m_morphTargets.clear();
+        m_uvas.clear();
+        m_boneMatrices.clear();
+        m_materialEdgeSizes.clear();
+        m_numVertices = 0;
+    }
+
+    int count(GroupType type) const VPVL2_DECL_NOEXCEPT {
+        return checkBound(type, kBdef1Group, kMaxGroupType) ? m_groups[type].vertexIndices.count() : 0;
+    }
+    int numVertices() const VPVL2_DECL_NOEXCEPT {
+        return m_numVertices;
+    }
+    const Array<int> &morphTargets() const VPVL2_DECL_NOEXCEPT {
+        return m_morphTargets;
+    }
+
+private:
+    static const int kMaxUVA = 4;
+    struct Group {
+        void clear() {
+            positions.clear();
+            normals.clear();
+            weights.clear();
+            edgeSizes.clear();
+            boneSlots.clear();
+            materialSlots.clear();
+            vertexIndices.clear();
+        }
+        Array<Vector3> positions;
+        Array<Vector3> normals;
+        Array<Scalar> weights;
+        Array<IVertex::EdgeSizePrecision> edgeSizes;
+        Array<int> boneSlots;
+        Array<int> materialSlots;
+        Array<int> vertexIndices;
+    };
+
+    static inline int resolveSlot(int index, int count) VPVL2_DECL_NOEXCEPT {
+        return checkBound(index, 0, count) ? index + 1 : 0;
+    }
+    static void appendWeights(const IVertex *vertex, GroupType type, Group &group) {
+        switch (type) {
+        case kBdef2Group:
+        case kSdefGroup: {
+            group.weights.append(Scalar(vertex->weight(0)));
+            break;
+        }
+        case kBdef4Group:
+        case kQdefGroup: {
+            const IVertex::WeightPrecision &w1 = vertex->weight(0), &w2 = vertex->weight(1),
+                    &w3 = vertex->weight(2), &w4 = vertex->weight(3), &s = w1 + w2 + w3 + w4;
+            group.weights.append(Scalar(w1 / s));
+            group.weights.append(Scalar(w2 / s));
+            group.weights.append(Scalar(w3 / s));
+            group.weights.append(Scalar(w4 / s));
+            break;
+        }
+        case kBdef1Group:
+        case kMaxGroupType:
+        default:
+            break;
+        }
+    }
+    inline const Scalar *boneMatrixAt(int slot) const VPVL2_DECL_NOEXCEPT {
+        return &m_boneMatrices[slot * kMatrixSize];
+    }
+    inline Scalar edgeSizeAt(const Group &group, int i, const IVertex::EdgeSizePrecision &edgeScaleFactor) const VPVL2_DECL_NOEXCEPT {
+        const IVertex::EdgeSizePrecision &materialEdgeSize = m_materialEdgeSizes[group.materialSlots[i]] * edgeScaleFactor;
+        return Scalar(group.edgeSizes[i] * materialEdgeSize);
+    }
+    template<typename TUnit>
+    inline void storeUVA(int vertexIndex, TUnit &unit) const VPVL2_DECL_NOEXCEPT {
+        const Vector4 *uvas = &m_uvas[vertexIndex * kMaxUVA];
+        unit.uva1 = uvas[0];
+        unit.uva2 = uvas[1];
+        unit.uva3 = uvas[2];
+        unit.uva4 = uvas[3];
+    }
+    inline void storeUVA(int /* vertexIndex */, SkinningUnit & /* unit */) const VPVL2_DECL_NOEXCEPT {
+    }
+
+#ifdef VPVL2_PACKED_VERTEX_STORE_SSE
+    struct Matrix {
+        __m128 c0;
+        __m128 c1;
+        __m128 c2;
+        __m128 c3;
+    };
+    static inline void loadMatrix(const Scalar *m, Matrix &matrix) VPVL2_DECL_NOEXCEPT {
+        /* m_boneMatrices is allocated by btAlignedAllocator with 16 bytes alignment */
+        matrix.c0 = _mm_load_ps(m);
+        matrix.c1 = _mm_load_ps(m + 4);
+        matrix.c2 = _mm_load_ps(m + 8);
+        matrix.c3 = _mm_load_ps(m + 12);
+    }
+    static inline void blendMatrix(const Matrix &a, const Matrix &b, __m128 w, Matrix &matrix) VPVL2_DECL_NOEXCEPT {
+        const __m128 rw = _mm_sub_ps(_mm_set1_ps(1.0f), w);
+        matrix.c0 = _mm_add_ps(_mm_mul_ps(a.c0, w), _mm_mul_ps(b.c0, rw));
+        matrix.c1 = _mm_add_ps(_mm_mul_ps(a.c1, w), _mm_mul_ps(b.c1, rw));
+        matrix.c2 = _mm_add_ps(_mm_mul_ps(a.c2, w), _mm_mul_ps(b.c2, rw));
+        matrix.c3 = _mm_add_ps(_mm_mul_ps(a.c3, w), _mm_mul_ps(b.c3, rw));
+    }
+    static inline void accumulateMatrix(const Scalar *m, __m128 w, Matrix &matrix) VPVL2_DECL_NOEXCEPT {
+        matrix.c0 = _mm_add_ps(matrix.c0, _mm_mul_ps(_mm_load_ps(m), w));
+        matrix.c1 = _mm_add_ps(matrix.c1, _mm_mul_ps(_mm_load_ps(m + 4), w));
+        matrix.c2 = _mm_add_ps(matrix.c2, _mm_mul_ps(_mm_load_ps(m + 8), w));
+        matrix.c3 = _mm_add_ps(matrix.c3, _mm_mul_ps(_mm_load_ps(m + 12), w));
+    }
+    struct NullBoundingBox {
+        inline void merge(__m128 /* position */) VPVL2_DECL_NOEXCEPT {}
+    };
+    struct BoundingBox {
+        BoundingBox()
+            : min(_mm_set1_ps(SIMD_INFINITY)),
+              max(_mm_set1_ps(-SIMD_INFINITY))
+        {
+        }
+        inline void merge(__m128 position) VPVL2_DECL_NOEXCEPT {
+            min = _mm_min_ps(min, position);
+            max = _mm_max_ps(max, position);
+        }
+        inline void merge(Vector3 &aabbMin, Vector3 &aabbMax) const VPVL2_DECL_NOEXCEPT {
+            Vector3 a, b;
+            _mm_storeu_ps(static_cast<Scalar *>(a), min);
+            _mm_storeu_ps(static_cast<Scalar *>(b), max);
+            aabbMin.setMin(a);
+            aabbMax.setMax(b);
+        }
+        __m128 min;
+        __m128 max;
+    };
+    template<typename TUnit>
+    static inline __m128 storeVertex(const Matrix &matrix, const Vector3 &p, const Vector3 &n, const Scalar &edgeSize, TUnit &unit) VPVL2_DECL_NOEXCEPT {
+        const __m128 mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+        __m128 position = _mm_add_ps(_mm_add_ps(_mm_mul_ps(matrix.c0, _mm_set1_ps(p.x())),
+                                                _mm_mul_ps(matrix.c1, _mm_set1_ps(p.y()))),
+                                     _mm_add_ps(_mm_mul_ps(matrix.c2, _mm_set1_ps(p.z())), matrix.c3));
+        __m128 normal = _mm_add_ps(_mm_add_ps(_mm_mul_ps(matrix.c0, _mm_set1_ps(n.x())),
+                                              _mm_mul_ps(matrix.c1, _mm_set1_ps(n.y()))),
+                                   _mm_mul_ps(matrix.c2, _mm_set1_ps(n.z())));
+        position = _mm_and_ps(position, mask);
+        normal = _mm_and_ps(normal, mask);
+        const __m128 edge = _mm_add_ps(position, _mm_mul_ps(normal, _mm_set1_ps(edgeSize)));
+        _mm_storeu_ps(static_cast<Scalar *>(unit.position), position);
+        _mm_storeu_ps(static_cast<Scalar *>(unit.normal), normal);
+        _mm_storeu_ps(static_cast<Scalar *>(unit.edge), edge);
+        return position;
+    }
+#else /* VPVL2_PACKED_VERTEX_STORE_SSE */
+    struct Matrix {
+        Scalar m[kMatrixSize];
+    };
+    static inline void loadMatrix(const Scalar *m, Matrix &matrix) VPVL2_DECL_NOEXCEPT {
+        for (int i = 0; i < kMatrixSize; i++) {
+            matrix.m[i] = m[i];
+        }
+    }
+    static inline void blendMatrix(const Matrix &a, const Matrix &b, const Scalar &w, Matrix &matrix) VPVL2_DECL_NOEXCEPT {
+        const Scalar rw = 1 - w;
+        for (int i = 0; i < kMatrixSize; i++) {
+            matrix.m[i] = a.m[i] * w + b.m[i] * rw;
+        }
+    }
+    static inline void accumulateMatrix(const Scalar *m, const Scalar &w, Matrix &matrix) VPVL2_DECL_NOEXCEPT {
+        for (int i = 0; i < kMatrixSize; i++) {
+            matrix.m[i] += m[i] * w;
+        }
+    }
+    struct NullBoundingBox {
+        inline void merge(const Vector3 & /* position */) VPVL2_DECL_NOEXCEPT {}
+    };
+    struct BoundingBox {
+        BoundingBox()
+            : min(SIMD_INFINITY, SIMD_INFINITY, SIMD_INFINITY),
+              max(-SIMD_INFINITY, -SIMD_INFINITY, -SIMD_INFINITY)
+        {
+        }
+        inline void merge(const Vector3 &position) VPVL2_DECL_NOEXCEPT {
+            min.setMin(position);
+            max.setMax(position);
+        }
+        inline void merge(Vector3 &aabbMin, Vector3 &aabbMax) const VPVL2_DECL_NOEXCEPT {
+            aabbMin.setMin(min);
+            aabbMax.setMax(max);
+        }
+        Vector3 min;
+        Vector3 max;
+    };
+    template<typename TUnit>
+    static inline Vector3 storeVertex(const Matrix &matrix, const Vector3 &p, const Vector3 &n, const Scalar &edgeSize, TUnit &unit) VPVL2_DECL_NOEXCEPT {
+        const Scalar *m = matrix.m;
+        const Vector3 position(m[0] * p.x() + m[4] * p.y() + m[8] * p.z() + m[12],
+                               m[1] * p.x() + m[5] * p.y() + m[9] * p.z() + m[13],
+                               m[2] * p.x() + m[6] * p.y() + m[10] * p.z() + m[14]);
+        const Vector3 normal(m[0] * n.x() + m[4] * n.y() + m[8] * n.z(),
+                             m[1] * n.x() + m[5] * n.y() + m[9] * n.z(),
+                             m[2] * n.x() + m[6] * n.y() + m[10] * n.z());
+        unit.position = position;
+        unit.normal = normal;
+        unit.edge = position + normal * edgeSize;
+        return position;
+    }
+#endif /* VPVL2_PACKED_VERTEX_STORE_SSE */
+
+    template<typename TUnit, typename TBoundingBox>
+    void performSkinningGroup(GroupType type,
+                              int begin,
+                              int end,
+                              const IVertex::EdgeSizePrecision &edgeScaleFactor,
+                              TUnit *bufferPtr,
+                              TBoundingBox &box) const {
+        switch (type) {
+        case kBdef1Group:
+            performSkinningBdef1(begin, end, edgeScaleFactor, bufferPtr, box);
+            break;
+        case kBdef2Group:
+        case kSdefGroup:
+            /* SDEF is deformed as BDEF2 same as pmx::Vertex#performSkinning */
+            performSkinningBdef2(m_groups[type], begin, end, edgeScaleFactor, bufferPtr, box);
+            break;
+        case kBdef4Group:
+        case kQdefGroup:
+            /* QDEF is deformed as BDEF4 same as pmx::Vertex#performSkinning */
+            performSkinningBdef4(m_groups[type], begin, end, edgeScaleFactor, bufferPtr, box);
+            break;
+        case kMaxGroupType:
+        default:
+            break;
+        }
+    }
+    template<typename TUnit, typename TBoundingBox>
+    void performSkinningBdef1(int begin, int end, const IVertex::EdgeSizePrecision &edgeScaleFactor, TUnit *bufferPtr, TBoundingBox &box) const {
+        const Group &group = m_groups[kBdef1Group];
+        Matrix matrix;
+        for (int i = begin; i < end; i++) {
+            const int vertexIndex = group.vertexIndices[i];
+            TUnit &unit = bufferPtr[vertexIndex];
+            loadMatrix(boneMatrixAt(group.boneSlots[i]), matrix);
+            box.merge(storeVertex(matrix, group.positions[i], group.normals[i], edgeSizeAt(group, i, edgeScaleFactor), unit));
+            storeUVA(vertexIndex, unit);
+        }
+    }
+    template<typename TUnit, typename TBoundingBox>
+    void performSkinningBdef2(const Group &group, int begin, int end, const IVertex::EdgeSizePrecision &edgeScaleFactor, TUnit *bufferPtr, TBoundingBox &box) const {
+        Matrix matrix, a, b;
+        for (int i = begin; i < end; i++) {
+            const int vertexIndex = group.vertexIndices[i], offset = i * 2;
+            const Scalar &weight = group.weights[i];
+            TUnit &unit = bufferPtr[vertexIndex];
+            if (btFuzzyZero(1 - weight)) {
+                loadMatrix(boneMatrixAt(group.boneSlots[offset]), matrix);
+            }
+            else if (btFuzzyZero(weight)) {
+                loadMatrix(boneMatrixAt(group.boneSlots[offset + 1]), matrix);
+            }
+            else {
+                loadMatrix(boneMatrixAt(group.boneSlots[offset]), a);
+                loadMatrix(boneMatrixAt(group.boneSlots[offset + 1]), b);
+#ifdef VPVL2_PACKED_VERTEX_STORE_SSE
+                blendMatrix(a, b, _mm_set1_ps(weight), matrix);
+#else
+                blendMatrix(a, b, weight, matrix);
+#endif
+            }
+            box.merge(storeVertex(matrix, group.positions[i], group.normals[i], edgeSizeAt(group, i, edgeScaleFactor), unit));
+            storeUVA(vertexIndex, unit);
+        }
+    }
+    template<typename TUnit, typename TBoundingBox>
+    void performSkinningBdef4(const Group &group, int begin, int end, const IVertex::EdgeSizePrecision &edgeScaleFactor, TUnit *bufferPtr, TBoundingBox &box) const {
+        Matrix matrix;
+        for (int i = begin; i < end; i++) {
+            const int vertexIndex = group.vertexIndices[i], offset = i * 4;
+            const Scalar *weights = &group.weights[offset];
+            const int *slots = &group.boneSlots[offset];
+            TUnit &unit = bufferPtr[vertexIndex];
+#if defined(VPVL2_PACKED_VERTEX_STORE_AVX)
+            /* blend two columns of the bone matrices at once with 256bit registers */
+            __m256 c01 = _mm256_setzero_ps(), c23 = _mm256_setzero_ps();
+            for (int j = 0; j < 4; j++) {
+                const Scalar *m = boneMatrixAt(slots[j]);
+                const __m256 w = _mm256_set1_ps(weights[j]);
+                c01 = _mm256_add_ps(c01, _mm256_mul_ps(_mm256_loadu_ps(m), w));
+                c23 = _mm256_add_ps(c23, _mm256_mul_ps(_mm256_loadu_ps(m + 8), w));
+            }
+            matrix.c0 = _mm256_castps256_ps128(c01);
+            matrix.c1 = _mm256_extractf128_ps(c01, 1);
+            matrix.c2 = _mm256_castps256_ps128(c23);
+            matrix.c3 = _mm256_extractf128_ps(c23, 1);
+#elif defined(VPVL2_PACKED_VERTEX_STORE_SSE)
+            matrix.c0 = matrix.c1 = matrix.c2 = matrix.c3 = _mm_setzero_ps();
+            for (int j = 0; j < 4; j++) {
+                accumulateMatrix(boneMatrixAt(slots[j]), _mm_set1_ps(weights[j]), matrix);
+            }
+#else
+            zerofill(&matrix, sizeof(matrix));
+            for (int j = 0; j < 4; j++) {
+                accumulateMatrix(boneMatrixAt(slots[j]), weights[j], matrix);
+            }
+#endif
+            box.merge(storeVertex(matrix, group.positions[i], group.normals[i], edgeSizeAt(group, i, edgeScaleFactor), unit));
+            storeUVA(vertexIndex, unit);
+        }
+    }
+
+    Group m_groups[kMaxGroupType];
+    Array<int> m_vertexGroups;
+    Array<int> m_vertexSlots;
+    Array<int> m_morphTargets;
+    Array<Vector4> m_uvas;
+    Array<Scalar> m_boneMatrices;
+    Array<IVertex::EdgeSizePrecision> m_materialEdgeSizes;
+    int m_numVertices;
+
+    VPVL2_DISABLE_COPY_AND_ASSIGN(PackedVertexStore)
+};
+
+} /* namespace internal */
+} /* namespace VPVL2_VERSION_NS */
+} /* namespace vpvl2 */
+
+#endif
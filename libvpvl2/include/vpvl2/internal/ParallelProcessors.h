@@ -41,6 +41,8 @@
 
 #include <vpvl2/Common.h>
 #include <vpvl2/IMaterial.h>
+#include <vpvl2/IModel.h>
+#include <vpvl2/internal/PackedVertexStore.h>
 
 #ifdef VPVL2_LINK_INTEL_TBB
 #include <tbb/tbb.h>
@@ -53,6 +55,33 @@ namespace VPVL2_VERSION_NS
 namespace internal
 {
 
+#ifdef VPVL2_LINK_INTEL_TBB
+typedef tbb::affinity_partitioner AffinityPartitioner;
+#else
+struct AffinityPartitioner {};
+#endif
+
+/*
+ * An affinity partitioner must be owned by each caller (vertex buffer) and must not be shared,
+ * because models (and their render engines) may be updated concurrently.
+ */
+template<typename TProcessor>
+static inline void ParallelForAffinity(int size, const TProcessor &processor, AffinityPartitioner *partitionerRef)
+{
+#ifdef VPVL2_LINK_INTEL_TBB
+    if (partitionerRef) {
+        tbb::parallel_for(tbb::blocked_range<int>(0, size), processor, *partitionerRef);
+    }
+    else {
+        tbb::parallel_for(tbb::blocked_range<int>(0, size), processor);
+    }
+#else
+    (void) size;
+    (void) processor;
+    (void) partitionerRef;
+#endif
+}
+
 static const Vector3 kAabbMin = Vector3(SIMD_INFINITY, SIMD_INFINITY, SIMD_INFINITY);
 static const Vector3 kAabbMax = Vector3(-SIMD_INFINITY, -SIMD_INFINITY, -SIMD_INFINITY);
 
@@ -98,23 +127,23 @@ public:
         }
     }
 #endif /* VPVL2_LINK_INTEL_TBB */
-    void execute(bool enableParallel) {
+    void execute(bool enableParallel, AffinityPartitioner *partitionerRef = 0) {
         const int nvertices = m_verticesRef->count();
 #if defined(VPVL2_LINK_INTEL_TBB)
         if (enableParallel) {
-            static tbb::affinity_partitioner affinityPartitioner;
-            tbb::parallel_for(tbb::blocked_range<int>(0, nvertices), *this, affinityPartitioner);
+            ParallelForAffinity(nvertices, *this, partitionerRef);
         }
         else {
 #else
         {
             (void) enableParallel;
+            (void) partitionerRef;
 #endif
-            Vector3 position;
 #ifdef VPVL2_ENABLE_OPENMP
 #pragma omp parallel for
 #endif
             for (int i = 0; i < nvertices; ++i) {
+                Vector3 position;
                 performTransform(i, position);
             }
         }
@@ -126,6 +155,329 @@ private:
     TUnit *m_bufferPtr;
 };
 
+template<typename TUnit>
+class ParallelPackedSkinningVertexProcessor VPVL2_DECL_FINAL {
+public:
+    ParallelPackedSkinningVertexProcessor(const PackedVertexStore *storeRef,
+                                          const IVertex::EdgeSizePrecision &edgeScaleFactor,
+                                          void *address)
+        : m_storeRef(storeRef),
+          m_edgeScaleFactor(edgeScaleFactor),
+          m_bufferPtr(static_cast<TUnit *>(address)),
+          m_type(PackedVertexStore::kBdef1Group)
+    {
+    }
+    ~ParallelPackedSkinningVertexProcessor() {
+        m_storeRef = 0;
+        m_bufferPtr = 0;
+    }
+
+#ifdef VPVL2_LINK_INTEL_TBB
+    void operator()(const tbb::blocked_range<int> &range) const {
+        m_storeRef->performSkinning(m_type, range.begin(), range.end(), m_edgeScaleFactor, m_bufferPtr);
+    }
+#endif /* VPVL2_LINK_INTEL_TBB */
+    void execute(bool enableParallel) {
+        for (int i = 0; i < PackedVertexStore::kMaxGroupType; i++) {
+            m_type = static_cast<PackedVertexStore::GroupType>(i);
+            const int nvertices = m_storeRef->count(m_type);
+            if (nvertices == 0) {
+                continue;
+            }
+#if defined(VPVL2_LINK_INTEL_TBB)
+            if (enableParallel) {
+                tbb::parallel_for(tbb::blocked_range<int>(0, nvertices, kChunkSize), *this);
+            }
+            else {
+#else
+            {
+                (void) enableParallel;
+#endif
+                const int nchunks = (nvertices + kChunkSize - 1) / kChunkSize;
+#ifdef VPVL2_ENABLE_OPENMP
+#pragma omp parallel for
+#endif
+                for (int j = 0; j < nchunks; j++) {
+                    const int begin = j * kChunkSize, end = btMin(begin + kChunkSize, nvertices);
+                    m_storeRef->performSkinning(m_type, begin, end, m_edgeScaleFactor, m_bufferPtr);
+                }
+            }
+        }
+    }
+
+private:
+    static const int kChunkSize = 1024;
+    const PackedVertexStore *m_storeRef;
+    const IVertex::EdgeSizePrecision m_edgeScaleFactor;
+    TUnit *m_bufferPtr;
+    PackedVertexStore::GroupType m_type;
+};
+
+/* same as ParallelPackedSkinningVertexProcessor but reduces the bounding box in the same pass */
+template<typename TUnit>
+class ParallelPackedSkinningAabbVertexProcessor VPVL2_DECL_FINAL {
+public:
+    ParallelPackedSkinningAabbVertexProcessor(const PackedVertexStore *storeRef,
+                                              const IVertex::EdgeSizePrecision &edgeScaleFactor,
+                                              void *address)
+        : m_storeRef(storeRef),
+          m_edgeScaleFactor(edgeScaleFactor),
+          m_bufferPtr(static_cast<TUnit *>(address))
+    {
+    }
+    ~ParallelPackedSkinningAabbVertexProcessor() {
+        m_storeRef = 0;
+        m_bufferPtr = 0;
+    }
+
+    inline void performSkinning(PackedVertexStore::GroupType type, int begin, int end, Vector3 &aabbMin, Vector3 &aabbMax) const {
+        m_storeRef->performSkinning(type, begin, end, m_edgeScaleFactor, m_bufferPtr, aabbMin, aabbMax);
+    }
+
+#ifdef VPVL2_LINK_INTEL_TBB
+    struct Reducer {
+        Reducer(const ParallelPackedSkinningAabbVertexProcessor *processorRef, PackedVertexStore::GroupType type)
+            : processorRef(processorRef),
+              type(type),
+              min(kAabbMin),
+              max(kAabbMax)
+        {
+        }
+        Reducer(const Reducer &self, tbb::split /* split */)
+            : processorRef(self.processorRef),
+              type(self.type),
+              min(kAabbMin),
+              max(kAabbMax)
+        {
+        }
+        void join(const Reducer &self) VPVL2_DECL_NOEXCEPT {
+            min.setMin(self.min);
+            max.setMax(self.max);
+        }
+        void operator()(const tbb::blocked_range<int> &range) {
+            processorRef->performSkinning(type, range.begin(), range.end(), min, max);
+        }
+        const ParallelPackedSkinningAabbVertexProcessor *processorRef;
+        PackedVertexStore::GroupType type;
+        Vector3 min;
+        Vector3 max;
+    };
+#endif /* VPVL2_LINK_INTEL_TBB */
+
+    void execute(bool enableParallel, Vector3 &aabbMin, Vector3 &aabbMax) const {
+        aabbMin = kAabbMin;
+        aabbMax = kAabbMax;
+        for (int i = 0; i < PackedVertexStore::kMaxGroupType; i++) {
+            const PackedVertexStore::GroupType type = static_cast<PackedVertexStore::GroupType>(i);
+            const int nvertices = m_storeRef->count(type);
+            if (nvertices == 0) {
+                continue;
+            }
+#if defined(VPVL2_LINK_INTEL_TBB)
+            if (enableParallel) {
+                Reducer reducer(this, type);
+                tbb::parallel_reduce(tbb::blocked_range<int>(0, nvertices, kChunkSize), reducer);
+                aabbMin.setMin(reducer.min);
+                aabbMax.setMax(reducer.max);
+            }
+            else {
+#else
+            {
+                (void) enableParallel;
+#endif
+                /* each chunk has its own bounding box and they are merged after skinning */
+                const int nchunks = (nvertices + kChunkSize - 1) / kChunkSize;
+                Array<Vector3> chunkAabbs;
+                chunkAabbs.resize(nchunks * 2);
+#ifdef VPVL2_ENABLE_OPENMP
+#pragma omp parallel for
+#endif
+                for (int j = 0; j < nchunks; j++) {
+                    const int begin = j * kChunkSize, end = btMin(begin + kChunkSize, nvertices);
+                    Vector3 chunkMin(kAabbMin), chunkMax(kAabbMax);
+                    performSkinning(type, begin, end, chunkMin, chunkMax);
+                    chunkAabbs[j * 2] = chunkMin;
+                    chunkAabbs[j * 2 + 1] = chunkMax;
+                }
+                for (int j = 0; j < nchunks; j++) {
+                    aabbMin.setMin(chunkAabbs[j * 2]);
+                    aabbMax.setMax(chunkAabbs[j * 2 + 1]);
+                }
+            }
+        }
+    }
+
+private:
+    static const int kChunkSize = 1024;
+    const PackedVertexStore *m_storeRef;
+    const IVertex::EdgeSizePrecision m_edgeScaleFactor;
+    TUnit *m_bufferPtr;
+};
+
+template<typename TVertex>
+class ParallelSkinningAabbVertexProcessor VPVL2_DECL_FINAL {
+public:
+    static const int kMaxUVA = 4;
+    struct Layout {
+        Layout(vsize strideSize, vsize positionOffset, vsize normalOffset, vsize edgeOffset)
+            : strideSize(strideSize),
+              positionOffset(positionOffset),
+              normalOffset(normalOffset),
+              edgeOffset(edgeOffset),
+              hasUVA(false)
+        {
+            for (int i = 0; i < kMaxUVA; i++) {
+                uvaOffsets[i] = 0;
+            }
+        }
+        explicit Layout(const IModel::DynamicVertexBuffer *dynamicBufferRef)
+            : strideSize(dynamicBufferRef->strideSize()),
+              positionOffset(dynamicBufferRef->strideOffset(IModel::DynamicVertexBuffer::kVertexStride)),
+              normalOffset(dynamicBufferRef->strideOffset(IModel::DynamicVertexBuffer::kNormalStride)),
+              edgeOffset(dynamicBufferRef->strideOffset(IModel::DynamicVertexBuffer::kEdgeVertexStride)),
+              hasUVA(true)
+        {
+            static const IModel::DynamicVertexBuffer::StrideType kUVAStrides[] = {
+                IModel::DynamicVertexBuffer::kUVA1Stride,
+                IModel::DynamicVertexBuffer::kUVA2Stride,
+                IModel::DynamicVertexBuffer::kUVA3Stride,
+                IModel::DynamicVertexBuffer::kUVA4Stride
+            };
+            for (int i = 0; i < kMaxUVA; i++) {
+                uvaOffsets[i] = dynamicBufferRef->strideOffset(kUVAStrides[i]);
+            }
+        }
+        vsize strideSize;
+        vsize positionOffset;
+        vsize normalOffset;
+        vsize edgeOffset;
+        vsize uvaOffsets[kMaxUVA];
+        bool hasUVA;
+    };
+
+    ParallelSkinningAabbVertexProcessor(const Array<TVertex *> *verticesRef,
+                                        const IModel::DynamicVertexBuffer *dynamicBufferRef,
+                                        const IVertex::EdgeSizePrecision &edgeScaleFactor,
+                                        void *address)
+        : m_verticesRef(verticesRef),
+          m_edgeScaleFactor(edgeScaleFactor),
+          m_bufferPtr(static_cast<uint8 *>(address)),
+          m_layout(dynamicBufferRef)
+    {
+    }
+    /* UVA is not written with this layout (split per-frame stream) */
+    ParallelSkinningAabbVertexProcessor(const Array<TVertex *> *verticesRef,
+                                        const Layout &layout,
+                                        const IVertex::EdgeSizePrecision &edgeScaleFactor,
+                                        void *address)
+        : m_verticesRef(verticesRef),
+          m_edgeScaleFactor(edgeScaleFactor),
+          m_bufferPtr(static_cast<uint8 *>(address)),
+          m_layout(layout)
+    {
+    }
+    ~ParallelSkinningAabbVertexProcessor() {
+        m_verticesRef = 0;
+        m_bufferPtr = 0;
+    }
+
+    /* writes the same values to the same offsets as ParallelSkinningVertexProcessor */
+    inline void performTransform(int i, Vector3 &aabbMin, Vector3 &aabbMax) const {
+        const TVertex *vertex = m_verticesRef->at(i);
+        const IMaterial *material = vertex->materialRef();
+        const float materialEdgeSize = material->edgeSize() * m_edgeScaleFactor;
+        const IVertex::EdgeSizePrecision &edgeSize = vertex->edgeSize() * materialEdgeSize;
+        Vector3 position, normal;
+        vertex->performSkinning(position, normal);
+        uint8 *ptr = m_bufferPtr + m_layout.strideSize * i;
+        *reinterpret_cast<Vector3 *>(ptr + m_layout.positionOffset) = position;
+        *reinterpret_cast<Vector3 *>(ptr + m_layout.normalOffset) = normal;
+        *reinterpret_cast<Vector3 *>(ptr + m_layout.edgeOffset) = position + normal * Scalar(edgeSize);
+        if (m_layout.hasUVA) {
+            for (int j = 0; j < kMaxUVA; j++) {
+                *reinterpret_cast<Vector4 *>(ptr + m_layout.uvaOffsets[j]) = vertex->uv(j);
+            }
+        }
+        aabbMin.setMin(position);
+        aabbMax.setMax(position);
+    }
+
+#ifdef VPVL2_LINK_INTEL_TBB
+    struct Reducer {
+        Reducer(const ParallelSkinningAabbVertexProcessor *processorRef)
+            : processorRef(processorRef),
+              min(kAabbMin),
+              max(kAabbMax)
+        {
+        }
+        Reducer(const Reducer &self, tbb::split /* split */)
+            : processorRef(self.processorRef),
+              min(kAabbMin),
+              max(kAabbMax)
+        {
+        }
+        void join(const Reducer &self) VPVL2_DECL_NOEXCEPT {
+            min.setMin(self.min);
+            max.setMax(self.max);
+        }
+        void operator()(const tbb::blocked_range<int> &range) {
+            for (int i = range.begin(), end = range.end(); i != end; ++i) {
+                processorRef->performTransform(i, min, max);
+            }
+        }
+        const ParallelSkinningAabbVertexProcessor *processorRef;
+        Vector3 min;
+        Vector3 max;
+    };
+#endif /* VPVL2_LINK_INTEL_TBB */
+
+    void execute(bool enableParallel, Vector3 &aabbMin, Vector3 &aabbMax) const {
+        const int nvertices = m_verticesRef->count();
+        aabbMin = kAabbMin;
+        aabbMax = kAabbMax;
+#if defined(VPVL2_LINK_INTEL_TBB)
+        if (enableParallel) {
+            Reducer reducer(this);
+            tbb::parallel_reduce(tbb::blocked_range<int>(0, nvertices, kChunkSize), reducer);
+            aabbMin = reducer.min;
+            aabbMax = reducer.max;
+        }
+        else {
+#else
+        {
+            (void) enableParallel;
+#endif
+            /* each chunk has its own bounding box and they are merged after skinning */
+            const int nchunks = (nvertices + kChunkSize - 1) / kChunkSize;
+            Array<Vector3> chunkAabbs;
+            chunkAabbs.resize(nchunks * 2);
+#ifdef VPVL2_ENABLE_OPENMP
+#pragma omp parallel for
+#endif
+            for (int j = 0; j < nchunks; j++) {
+                const int begin = j * kChunkSize, end = btMin(begin + kChunkSize, nvertices);
+                Vector3 chunkMin(kAabbMin), chunkMax(kAabbMax);
+                for (int i = begin; i < end; i++) {
+                    performTransform(i, chunkMin, chunkMax);
+                }
+                chunkAabbs[j * 2] = chunkMin;
+                chunkAabbs[j * 2 + 1] = chunkMax;
+            }
+            for (int j = 0; j < nchunks; j++) {
+                aabbMin.setMin(chunkAabbs[j * 2]);
+                aabbMax.setMax(chunkAabbs[j * 2 + 1]);
+            }
+        }
+    }
+
+private:
+    static const int kChunkSize = 1024;
+    const Array<TVertex *> *m_verticesRef;
+    const IVertex::EdgeSizePrecision m_edgeScaleFactor;
+    uint8 *m_bufferPtr;
+    const Layout m_layout;
+};
+
 template<typename TModel, typename TVertex, typename TUnit>
 class ParallelBindPoseVertexProcessor VPVL2_DECL_FINAL {
 public:
@@ -152,17 +504,17 @@ public:
         }
     }
 #endif /* VPVL2_LINK_INTEL_TBB */
-    void execute(bool enableParallel) {
+    void execute(bool enableParallel, AffinityPartitioner *partitionerRef = 0) {
         const int nvertices = m_verticesRef->count();
 #if defined(VPVL2_LINK_INTEL_TBB)
         if (enableParallel) {
-            static tbb::affinity_partitioner affinityPartitioner;
-            tbb::parallel_for(tbb::blocked_range<int>(0, nvertices), *this, affinityPartitioner);
+            ParallelForAffinity(nvertices, *this, partitionerRef);
         }
         else {
 #else
         {
             (void) enableParallel;
+            (void) partitionerRef;
 #endif
 #ifdef VPVL2_ENABLE_OPENMP
 #pragma omp parallel for
@@ -182,17 +534,21 @@ template<typename TModel, typename TVertex, typename TUnit>
 class ParallelVertexMorphProcessor VPVL2_DECL_FINAL {
 public:
     ParallelVertexMorphProcessor(const Array<TVertex *> *verticesRef,
-                                 void *address)
+                                 void *address,
+                                 const Array<int> *indicesRef = 0)
         : m_verticesRef(verticesRef),
+          m_indicesRef(indicesRef),
           m_bufferPtr(static_cast<TUnit *>(address))
     {
     }
     ~ParallelVertexMorphProcessor() {
         m_verticesRef = 0;
+        m_indicesRef = 0;
         m_bufferPtr = 0;
     }
 
-    inline void performTransform(int index) const VPVL2_DECL_NOEXCEPT {
+    inline void performTransform(int i) const VPVL2_DECL_NOEXCEPT {
+        const int index = m_indicesRef ? m_indicesRef->at(i) : i;
         const TVertex *vertex = m_verticesRef->at(index);
         TUnit &v = m_bufferPtr[index];
         v.setPosition(vertex);
@@ -204,17 +560,18 @@ public:
         }
     }
 #endif /* VPVL2_LINK_INTEL_TBB */
-    void execute(bool enableParallel) {
-        const int nvertices = m_verticesRef->count();
+    void execute(bool enableParallel, AffinityPartitioner *partitionerRef = 0) {
+        const int nvertices = m_indicesRef ? m_indicesRef->count() : m_verticesRef->count();
 #if defined(VPVL2_LINK_INTEL_TBB)
         if (enableParallel) {
-            static tbb::affinity_partitioner affinityPartitioner;
-            tbb::parallel_for(tbb::blocked_range<int>(0, nvertices), *this, affinityPartitioner);
+            /* a partitioner is meaningful only if the range is same as the last execution */
+            ParallelForAffinity(nvertices, *this, m_indicesRef ? 0 : partitionerRef);
         }
         else {
 #else
         {
             (void) enableParallel;
+            (void) partitionerRef;
 #endif
 #ifdef VPVL2_ENABLE_OPENMP
 #pragma omp parallel for
@@ -227,22 +584,25 @@ public:
 
 private:
     const Array<TVertex *> *m_verticesRef;
+    const Array<int> *m_indicesRef;
     TUnit *m_bufferPtr;
 };
 
 template<typename TVertex>
 class ParallelResetVertexProcessor VPVL2_DECL_FINAL {
 public:
-    ParallelResetVertexProcessor(const Array<TVertex *> *verticesRef)
-        : m_verticesRef(verticesRef)
+    ParallelResetVertexProcessor(const Array<TVertex *> *verticesRef, const Array<int> *indicesRef = 0)
+        : m_verticesRef(verticesRef),
+          m_indicesRef(indicesRef)
     {
     }
     ~ParallelResetVertexProcessor() {
         m_verticesRef = 0;
+        m_indicesRef = 0;
     }
 
     inline void performTransform(int index) const VPVL2_DECL_NOEXCEPT {
-        TVertex *vertex = m_verticesRef->at(index);
+        TVertex *vertex = m_verticesRef->at(m_indicesRef ? m_indicesRef->at(index) : index);
         vertex->reset();
     }
 #ifdef VPVL2_LINK_INTEL_TBB
@@ -254,10 +614,10 @@ public:
 #endif /* VPVL2_LINK_INTEL_TBB */
 
     void execute() {
-        const int nvertices = m_verticesRef->count();
+        const int nvertices = m_indicesRef ? m_indicesRef->count() : m_verticesRef->count();
 #if defined(VPVL2_LINK_INTEL_TBB)
-        static tbb::affinity_partitioner affinityPartitioner;
-        tbb::parallel_for(tbb::blocked_range<int>(0, nvertices), *this, affinityPartitioner);
+        /* don't share static affinity_partitioner because models may be updated concurrently by Scene */
+        tbb::parallel_for(tbb::blocked_range<int>(0, nvertices), *this);
 #else
 #ifdef VPVL2_ENABLE_OPENMP
 #pragma omp parallel for
@@ -270,6 +630,7 @@ public:
 
 private:
     const Array<TVertex *> *m_verticesRef;
+    const Array<int> *m_indicesRef;
 };
 
 template<typename TBone>
@@ -298,8 +659,8 @@ public:
     void execute() const {
         const int nbones = m_boneRefs->count();
 #ifdef VPVL2_LINK_INTEL_TBB
-        static tbb::affinity_partitioner partitioner;
-        tbb::parallel_for(tbb::blocked_range<int>(0, nbones), *this, partitioner);
+        /* same as ParallelResetVertexProcessor */
+        tbb::parallel_for(tbb::blocked_range<int>(0, nbones), *this);
 #else
 #ifdef VPVL2_ENABLE_OPENMP
 #pragma omp parallel for
@@ -354,6 +715,153 @@ private:
     mutable Array<TRigidBody *> *m_rigidBodyRefs;
 };
 
+template<typename TModel>
+class ParallelUpdateModelProcessor VPVL2_DECL_FINAL {
+public:
+    ParallelUpdateModelProcessor(const Array<TModel *> *modelRefs)
+        : m_modelRefs(modelRefs)
+    {
+    }
+    ~ParallelUpdateModelProcessor() {
+        m_modelRefs = 0;
+    }
+
+    inline void performTransform(int index) const {
+        TModel *model = m_modelRefs->at(index);
+        model->performUpdate();
+    }
+#ifdef VPVL2_LINK_INTEL_TBB
+    void operator()(const tbb::blocked_range<int> &range) const {
+        for (int i = range.begin(), end = range.end(); i != end; ++i) {
+            performTransform(i);
+        }
+    }
+#endif /* VPVL2_LINK_INTEL_TBB */
+
+    void execute(bool enableParallel) const {
+        const int nmodels = m_modelRefs->count();
+#if defined(VPVL2_LINK_INTEL_TBB)
+        if (enableParallel) {
+            /* a model is a coarse grained task so split the range to each model */
+            tbb::parallel_for(tbb::blocked_range<int>(0, nmodels, 1), *this, tbb::simple_partitioner());
+        }
+        else {
+#else
+        {
+#endif
+#ifdef VPVL2_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(enableParallel)
+#else
+            (void) enableParallel;
+#endif
+            for (int i = 0; i < nmodels; i++) {
+                performTransform(i);
+            }
+        }
+    }
+
+private:
+    const Array<TModel *> *m_modelRefs;
+};
+
+template<typename TRenderEngine>
+class ParallelUpdateRenderEngineProcessor VPVL2_DECL_FINAL {
+public:
+    ParallelUpdateRenderEngineProcessor(const Array<TRenderEngine *> *engineRefs)
+        : m_engineRefs(engineRefs)
+    {
+    }
+    ~ParallelUpdateRenderEngineProcessor() {
+        m_engineRefs = 0;
+    }
+
+    inline void performTransform(int index) const {
+        TRenderEngine *engine = m_engineRefs->at(index);
+        engine->performUpdate();
+    }
+#ifdef VPVL2_LINK_INTEL_TBB
+    void operator()(const tbb::blocked_range<int> &range) const {
+        for (int i = range.begin(), end = range.end(); i != end; ++i) {
+            performTransform(i);
+        }
+    }
+#endif /* VPVL2_LINK_INTEL_TBB */
+
+    void execute(bool enableParallel) const {
+        const int nengines = m_engineRefs->count();
+#if defined(VPVL2_LINK_INTEL_TBB)
+        if (enableParallel) {
+            /* CPU skinning of each engine is also split by vertices inside */
+            tbb::parallel_for(tbb::blocked_range<int>(0, nengines, 1), *this, tbb::simple_partitioner());
+        }
+        else {
+#else
+        {
+#endif
+#ifdef VPVL2_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(enableParallel)
+#else
+            (void) enableParallel;
+#endif
+            for (int i = 0; i < nengines; i++) {
+                performTransform(i);
+            }
+        }
+    }
+
+private:
+    const Array<TRenderEngine *> *m_engineRefs;
+};
+
+template<typename TTask>
+class ParallelExecuteTaskProcessor VPVL2_DECL_FINAL {
+public:
+    ParallelExecuteTaskProcessor(const Array<TTask> *tasks)
+        : m_tasks(tasks)
+    {
+    }
+    ~ParallelExecuteTaskProcessor() {
+        m_tasks = 0;
+    }
+
+    inline void performTransform(int index) const {
+        const TTask &task = m_tasks->at(index);
+        task.execute();
+    }
+#ifdef VPVL2_LINK_INTEL_TBB
+    void operator()(const tbb::blocked_range<int> &range) const {
+        for (int i = range.begin(), end = range.end(); i != end; ++i) {
+            performTransform(i);
+        }
+    }
+#endif /* VPVL2_LINK_INTEL_TBB */
+
+    void execute(bool enableParallel) const {
+        const int ntasks = m_tasks->count();
+#if defined(VPVL2_LINK_INTEL_TBB)
+        if (enableParallel) {
+            /* tasks have uneven costs so each of them is scheduled separately */
+            tbb::parallel_for(tbb::blocked_range<int>(0, ntasks, 1), *this, tbb::simple_partitioner());
+        }
+        else {
+#else
+        {
+#endif
+#ifdef VPVL2_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(enableParallel)
+#else
+            (void) enableParallel;
+#endif
+            for (int i = 0; i < ntasks; i++) {
+                performTransform(i);
+            }
+        }
+    }
+
+private:
+    const Array<TTask> *m_tasks;
+};
+
 template<typename TMaterial, typename TUnit>
 class ParallelComputeAabbProcessor VPVL2_DECL_FINAL {
 public:
@@ -63,6 +63,8 @@ public:
     static void disableIncludeCallback();
     static void enableMessageCallback();
     static void disableMessageCallback();
+    /* container is nvFX::IContainer, shared with nvfxcc to make the same shader sources (and cache keys) */
+    static void appendShaderHeader(void *container, int shaderVersion, bool enableCoreProfile);
 
     EffectContext();
     ~EffectContext();
@@ -202,6 +202,7 @@ public:
     void removeMorph(IMorph *value);
     void removeRigidBody(IRigidBody *value);
     void removeVertex(IVertex *value);
+    int structureRevision() const;
     IProgressReporter *progressReporterRef() const;
     void setProgressReporterRef(IProgressReporter *value);
     void addBoneHash(Bone *bone);
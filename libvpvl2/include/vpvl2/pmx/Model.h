@@ -51,6 +51,10 @@ namespace vpvl2
 {
 namespace VPVL2_VERSION_NS
 {
+namespace internal
+{
+class PackedVertexStore;
+}
 namespace pmx
 {
 
@@ -137,6 +141,16 @@ public:
         uint8 *endPtr;
     };
 
+    /**
+     * Storage of a model file kept alive while the model is loaded such as a mapped file.
+     */
+    class MappedData {
+    public:
+        virtual ~MappedData() {}
+        virtual const uint8 *address() const = 0;
+        virtual vsize size() const = 0;
+    };
+
     /**
      * Constructor
      */
@@ -144,6 +158,18 @@ public:
     ~Model();
 
     bool load(const uint8 *data, vsize size);
+    /**
+     * Same as load but indices are not decoded at load and read from data directly until
+     * indices() or getIndices or setIndices is called.
+     *
+     * The model takes ownership of data even if loading fails, and releases it at
+     * destruction or the next load.
+     *
+     * @brief loadMapped
+     * @param data
+     * @return
+     */
+    bool loadMapped(MappedData *data);
     void save(uint8 *data, vsize &written) const;
     vsize estimateSize() const;
 
@@ -177,6 +203,7 @@ public:
     Type type() const;
     const Array<Vertex *> &vertices() const;
     const Array<int> &indices() const;
+    int indexAt(int value) const;
     const Hash<HashString, IString *> &textures() const;
     const Array<Material *> &materials() const;
     const Array<Bone *> &bones() const;
@@ -224,6 +251,50 @@ public:
     void setAabb(const Vector3 &min, const Vector3 &max);
     void getAabb(Vector3 &min, Vector3 &max) const;
 
+    /**
+     * Returns packed vertex store for CPU skinning kernels or null if it's disabled.
+     *
+     * The store is rebuilt lazily if it's invalidated by editing vertices, bones,
+     * materials or morphs. Invalidating also makes the next performUpdate report
+     * all vertices as touched by morphs.
+     *
+     * @brief packedVertexStoreRef
+     * @return
+     */
+    internal::PackedVertexStore *packedVertexStoreRef() const;
+    bool isPackedVertexStoreEnabled() const;
+    void setPackedVertexStoreEnable(bool value);
+    void invalidatePackedVertexStore();
+
+    /**
+     * Returns sorted indices of vertices touched by vertex/UV morphs at the last performUpdate.
+     *
+     * The indices include both vertices reset from the previous frame and vertices
+     * accumulated at the current frame, so only these vertices need to be uploaded.
+     * All vertices are reported after invalidatePackedVertexStore is called.
+     *
+     * @brief morphTouchedVertexIndices
+     * @return
+     */
+    const Array<int> &morphTouchedVertexIndices() const;
+    int numMorphTouchedVertices() const;
+    /**
+     * Returns the serial number incremented at each performUpdate to detect skipped frames.
+     *
+     * @brief morphUpdateSerial
+     * @return
+     */
+    int morphUpdateSerial() const;
+    void touchVertexByMorph(const IVertex *value);
+    /**
+     * Returns whether sections are parsed concurrently at load. Default is true.
+     *
+     * @brief isParallelLoadEnabled
+     * @return
+     */
+    bool isParallelLoadEnabled() const;
+    void setParallelLoadEnable(bool value);
+
     float32 version() const;
     void setVersion(float32 value);
     IString::Codec encodingType() const;
@@ -263,6 +334,7 @@ public:
     void removeRigidBody(IRigidBody *value);
     void removeSoftBody(ISoftBody *value);
     void removeVertex(IVertex *value);
+    int structureRevision() const;
     IProgressReporter *progressReporterRef() const;
     void setProgressReporterRef(IProgressReporter *value);
     void addBoneHash(Bone *bone);
@@ -274,6 +346,8 @@ public:
     void removeTexture(IString *&value);
 
 private:
+    bool load(const uint8 *data, vsize size, MappedData *mappedData);
+
     struct PrivateContext;
     PrivateContext *m_context;
 
@@ -64,7 +64,7 @@ public:
     Morph(Model *modelRef);
     ~Morph();
 
-    static bool preparse(uint8 *&ptr, vsize &rest, Model::DataInfo &info);
+    static bool preparse(uint8 *&ptr, vsize &rest, Model::DataInfo &info, Array<uint8 *> *chunkPtrs = 0, int chunkSize = 0);
     static bool loadMorphs(const Array<Morph *> &morphs,
                            const Array<pmx::Bone *> &bones,
                            const Array<pmx::Material *> &materials,
@@ -124,6 +124,7 @@ public:
     void setCategory(Category value);
     void setType(Type value);
     void setIndex(int value);
+    void setParentMorphRef(Morph *value);
     void setInternalWeight(const WeightPrecision &value);
 
     void getBoneMorphs(Array<Bone *> &morphs) const;
@@ -74,7 +74,13 @@ public:
     Vertex(IModel *modelRef);
     ~Vertex();
 
-    static bool preparse(uint8 *&data, vsize &rest, Model::DataInfo &info);
+    /**
+     * Validates the vertex section and sets the position of it to info.
+     *
+     * When chunkPtrs is not null, the start position of every chunkSize vertices is appended
+     * to split the section for parsing in parallel.
+     */
+    static bool preparse(uint8 *&data, vsize &rest, Model::DataInfo &info, Array<uint8 *> *chunkPtrs = 0, int chunkSize = 0);
     static bool loadVertices(const Array<Vertex *> &vertices, const Array<Bone *> &bones);
     static void writeVertices(const Array<Vertex *> &vertices, const Model::DataInfo &info, uint8 *&data);
     static vsize estimateTotalSize(const Array<Vertex *> &vertices, const Model::DataInfo &info);
@@ -77,19 +77,40 @@ public:
     void addKeyframe(IKeyframe *keyframe);
     void removeKeyframe(IKeyframe *keyframe);
     void deleteKeyframe(IKeyframe *&keyframe);
+    void beginBatchEdit();
+    void endBatchEdit();
     void getKeyframes(const IKeyframe::TimeIndex &timeIndex, Array<IKeyframe *> &keyframes) const;
     void getAllKeyframes(Array<IKeyframe *> &value) const;
     void setAllKeyframes(const Array<IKeyframe *> &value, IKeyframe::Type type);
     IKeyframe::SmoothPrecision interpolateTimeIndex(const IKeyframe::TimeIndex &from, const IKeyframe::TimeIndex &to) const;
 
     int countKeyframes() const { return m_keyframes.count(); }
+    bool isBatchEditing() const { return m_batchEditDepth > 0; }
     IKeyframe::TimeIndex previousTimeIndex() const { return m_previousTimeIndex; }
     IKeyframe::TimeIndex currentTimeIndex() const { return m_currentTimeIndex; }
     IKeyframe::TimeIndex duration() const { return m_durationTimeIndex; }
 
 protected:
+    /*
+     * called on adding or removing a keyframe to keep per track indices sorted. keyframes are
+     * only appended in batch edit and each dirty track is sorted once at endBatchEdit.
+     */
+    virtual void insertKeyframeRef(IKeyframe *keyframe);
+    virtual void removeKeyframeRef(IKeyframe *keyframe);
+    virtual void sortKeyframeRefs();
+    virtual void updateDurationTimeIndex();
+
     template<typename T>
-    static int findKeyframeIndex(const IKeyframe::TimeIndex &key, const Array<T *> &keyframes) {
+    static int findKeyframeIndex(const IKeyframe::TimeIndex &key, const Array<T *> &keyframes, bool sorted = true) {
+        if (!sorted) {
+            /* keyframes appended in batch edit are not sorted yet */
+            const int nkeyframes = keyframes.count();
+            for (int i = 0; i < nkeyframes; i++) {
+                if (keyframes[i]->timeIndex() == key)
+                    return i;
+            }
+            return -1;
+        }
         int min = 0, max = keyframes.count() - 1;
         while (min < max) {
             int mid = (min + max) / 2;
@@ -109,6 +130,8 @@ protected:
 
     PointerArray<IKeyframe> m_keyframes;
     int m_lastTimeIndex;
+    int m_batchEditDepth;
+    bool m_dirty;
     IKeyframe::TimeIndex m_durationTimeIndex;
     IKeyframe::TimeIndex m_currentTimeIndex;
     IKeyframe::TimeIndex m_previousTimeIndex;
@@ -76,6 +76,7 @@ public:
     void seek(const IKeyframe::TimeIndex &timeIndexAt);
     void createFirstKeyframeUnlessFound();
     void reset();
+    void update();
     void setParentModelRef(IModel *model);
     BoneKeyframe *findKeyframeAt(int i) const;
     BoneKeyframe *findKeyframe(const IKeyframe::TimeIndex &timeIndex, const IString *name) const;
@@ -94,6 +95,10 @@ private:
                             const IKeyframe::SmoothPrecision &w,
                             int at,
                             IKeyframe::SmoothPrecision &value);
+    void insertKeyframeRef(IKeyframe *value);
+    void removeKeyframeRef(IKeyframe *value);
+    void sortKeyframeRefs();
+    void updateDurationTimeIndex();
     void createPrivateContexts(IModel *model);
     void calculateKeyframes(const IKeyframe::TimeIndex &timeIndexAt, PrivateContext *context);
 
@@ -78,6 +78,7 @@ public:
     void createFirstKeyframeUnlessFound();
     void setParentModelRef(IModel *model);
     void reset();
+    void update();
     MorphKeyframe *findKeyframeAt(int i) const;
     MorphKeyframe *findKeyframe(const IKeyframe::TimeIndex &timeIndex, const IString *name) const;
 
@@ -86,6 +87,10 @@ public:
 
 private:
     struct PrivateContext;
+    void insertKeyframeRef(IKeyframe *value);
+    void removeKeyframeRef(IKeyframe *value);
+    void sortKeyframeRefs();
+    void updateDurationTimeIndex();
     void createPrivateContexts(const IModel *model);
     void calculateFrames(const IKeyframe::TimeIndex &timeIndexAt, PrivateContext *context);
 
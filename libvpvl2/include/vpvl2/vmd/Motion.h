@@ -154,6 +154,9 @@ public:
     void deleteKeyframe(IKeyframe *&value);
     void deleteKeyframes(const IKeyframe::TimeIndex &timeIndex, IKeyframe::Type type);
     void update(IKeyframe::Type type);
+    /* keyframes added between them are sorted at once by the outermost endBatchEdit */
+    void beginBatchEdit();
+    void endBatchEdit();
     void getAllKeyframeRefs(Array<IKeyframe *> &value, IKeyframe::Type type);
     void setAllKeyframes(const Array<IKeyframe *> &value, IKeyframe::Type type);
     void createFirstKeyframesUnlessFound();
@@ -0,0 +1,472 @@
+/**
+
+ Copyright (c) 2010-2014  hkrn
+
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or
+ without modification, are permitted provided that the following
+ conditions are met:
+
+ - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following
+   disclaimer in the documentation and/or other materials provided
+   with the distribution.
+ - Neither the name of the MMDAI project team nor the names of
+   its contributors may be used to endorse or promote products
+   derived from this software without specific prior written
+   permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "../helper.h"
+#include <vpvl2/extensions/XMLProject.h>
+#include <vpvl2/extensions/egl/ApplicationContext.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include <tbb/tick_count.h>
+
+using namespace vpvl2::extensions::egl;
+using namespace vpvl2::extensions::icu4c;
+
+namespace {
+
+/*
+ * Renders a project or models with a motion into image files or a raw frame stream
+ * without any window. The context is created on a pbuffer surface so it also works
+ * with a software rasterizer (e.g. EGL_PLATFORM=surfaceless with Mesa llvmpipe).
+ *
+ * usage: vpvl2_batch [config.ini] [key=value ...]
+ */
+
+enum Stage {
+    kSeekStage,
+    kPhysicsStage,
+    kUpdateStage,
+    kRenderStage,
+    kReadbackStage,
+    kWriteStage,
+    kMaxStages
+};
+
+static const char *const kStageNames[kMaxStages] = {
+    "seek",
+    "physics",
+    "update",
+    "render",
+    "readback",
+    "write"
+};
+
+class StageTimer {
+public:
+    StageTimer()
+        : m_numFrames(0)
+    {
+        for (int i = 0; i < kMaxStages; i++) {
+            m_elapsed[i] = 0;
+        }
+    }
+    ~StageTimer() {
+    }
+
+    void start() {
+        m_last = tbb::tick_count::now();
+    }
+    void mark(Stage stage) {
+        const tbb::tick_count &now = tbb::tick_count::now();
+        m_elapsed[stage] += (now - m_last).seconds();
+        m_last = now;
+    }
+    void nextFrame() {
+        m_numFrames++;
+    }
+    void report(std::ostream &stream) const {
+        double total = 0;
+        const double nframes = m_numFrames > 0 ? m_numFrames : 1;
+        for (int i = 0; i < kMaxStages; i++) {
+            stream << kStageNames[i] << ": total=" << m_elapsed[i] * 1000 << "ms average=" << (m_elapsed[i] * 1000) / nframes << "ms" << std::endl;
+            total += m_elapsed[i];
+        }
+        stream << "frames: " << m_numFrames << " total=" << total * 1000 << "ms average=" << (total * 1000) / nframes << "ms" << std::endl;
+    }
+
+private:
+    tbb::tick_count m_last;
+    double m_elapsed[kMaxStages];
+    int m_numFrames;
+};
+
+class FrameWriter {
+public:
+    FrameWriter(const std::string &output, int width, int height)
+        : m_output(output),
+          m_width(width),
+          m_height(height),
+          m_numDigits(0),
+          m_pixels(width * height * 4)
+    {
+        splitOutputPath();
+    }
+    ~FrameWriter() {
+    }
+
+    void readPixels() {
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, &m_pixels[0]);
+    }
+    bool write(int frameIndex) {
+        if (m_output == "-") {
+            /* bottom-up RGBA frames for an encoder reading rawvideo (flip it with vflip) */
+            return std::fwrite(&m_pixels[0], 1, m_pixels.size(), stdout) == m_pixels.size();
+        }
+        /* the output path is never used as the format string */
+        char path[1024];
+        internal::snprintf(path, sizeof(path), "%s%0*d%s", m_prefix.c_str(), m_numDigits, frameIndex, m_suffix.c_str());
+        return writeTGA(path);
+    }
+
+private:
+    void splitOutputPath() {
+        /* only the first "%d" or "%0Nd" is replaced with the frame index and the others are written as is */
+        std::string::size_type offset = 0;
+        while ((offset = m_output.find('%', offset)) != std::string::npos) {
+            std::string::size_type end = offset + 1;
+            int ndigits = 0;
+            while (end < m_output.size() && m_output[end] >= '0' && m_output[end] <= '9') {
+                ndigits = ndigits * 10 + (m_output[end] - '0');
+                end++;
+            }
+            if (end < m_output.size() && m_output[end] == 'd' && ndigits < 16) {
+                m_prefix = m_output.substr(0, offset);
+                m_suffix = m_output.substr(end + 1);
+                m_numDigits = ndigits;
+                return;
+            }
+            offset = end;
+        }
+        /* appends the frame index before the extension if no placeholder is found */
+        const std::string::size_type dot = m_output.rfind('.');
+        const std::string::size_type slash = m_output.find_last_of("/\\");
+        const bool hasExtension = dot != std::string::npos && (slash == std::string::npos || dot > slash);
+        m_prefix = (hasExtension ? m_output.substr(0, dot) : m_output) + "-";
+        m_suffix = hasExtension ? m_output.substr(dot) : std::string();
+        m_numDigits = 6;
+    }
+
+    bool writeTGA(const char *path) {
+        FILE *fp = std::fopen(path, "wb");
+        if (!fp) {
+            std::cerr << "Cannot open " << path << std::endl;
+            return false;
+        }
+        /* uncompressed 32bit true color image with bottom-left origin as same as OpenGL */
+        uint8 header[18] = { 0 };
+        header[2] = 2;
+        header[12] = uint8(m_width & 0xff);
+        header[13] = uint8((m_width >> 8) & 0xff);
+        header[14] = uint8(m_height & 0xff);
+        header[15] = uint8((m_height >> 8) & 0xff);
+        header[16] = 32;
+        header[17] = 8;
+        std::fwrite(header, 1, sizeof(header), fp);
+        for (vsize i = 0, size = m_pixels.size(); i < size; i += 4) {
+            std::swap(m_pixels[i], m_pixels[i + 2]);
+        }
+        const bool ok = std::fwrite(&m_pixels[0], 1, m_pixels.size(), fp) == m_pixels.size();
+        std::fclose(fp);
+        return ok;
+    }
+
+    const std::string m_output;
+    const int m_width;
+    const int m_height;
+    std::string m_prefix;
+    std::string m_suffix;
+    int m_numDigits;
+    std::vector<uint8> m_pixels;
+};
+
+class ProjectDelegate : public XMLProject::IDelegate {
+public:
+    ProjectDelegate(Factory *factoryRef, IEncoding *encodingRef)
+        : m_applicationContextRef(0),
+          m_sceneRef(0),
+          m_factoryRef(factoryRef),
+          m_encodingRef(encodingRef),
+          m_updateOptions(IRenderEngine::kNone)
+    {
+    }
+    ~ProjectDelegate() {
+        m_applicationContextRef = 0;
+        m_sceneRef = 0;
+        m_factoryRef = 0;
+        m_encodingRef = 0;
+    }
+
+    void setContext(BaseApplicationContext *applicationContextRef, Scene *sceneRef, int updateOptions) {
+        m_applicationContextRef = applicationContextRef;
+        m_sceneRef = sceneRef;
+        m_updateOptions = updateOptions;
+    }
+    std::string toStdFromString(const IString *value) const {
+        return value ? static_cast<const String *>(value)->toStdString() : std::string();
+    }
+    IString *toStringFromStd(const std::string &value) const {
+        return String::create(value);
+    }
+    bool loadModel(const XMLProject::UUID & /* uuid */, const StringMap &settings, IModel::Type /* type */, IModel *&model, IRenderEngine *&engine, int &priority) {
+        const std::string &archiveURI = settings.value(XMLProject::kSettingArchiveURIKey, std::string());
+        const std::string &uri = archiveURI.empty() ? settings.value(XMLProject::kSettingURIKey, std::string()) : archiveURI;
+        const UnicodeString &modelPath = UnicodeString::fromUTF8(uri);
+        icu4c::String dir(modelPath.tempSubString(0, modelPath.lastIndexOf("/")));
+        ArchiveSmartPtr archive;
+        IModelSmartPtr modelPtr;
+        model = 0;
+        engine = 0;
+        if (::ui::loadModel(modelPath, m_applicationContextRef, m_factoryRef, m_encodingRef, archive, modelPtr)) {
+            BaseApplicationContext::ModelContext modelContext(m_applicationContextRef, archive.get(), &dir, modelPtr->type() == IModel::kAssetModel);
+            modelContext.decodeTextures(modelPtr.get());
+            IRenderEngineSmartPtr enginePtr(m_sceneRef->createRenderEngine(m_applicationContextRef, modelPtr.get(), Scene::kEffectCapable));
+            enginePtr->setUpdateOptions(m_updateOptions);
+            if (enginePtr->upload(&modelContext)) {
+                m_applicationContextRef->addModelFilePath(modelPtr.get(), uri);
+                priority = XMLProject::toIntFromString(settings.value(XMLProject::kSettingOrderKey, std::string("0")));
+                engine = enginePtr.release();
+                model = modelPtr.release();
+            }
+        }
+        if (!model) {
+            std::cerr << "Cannot load a model of the project: " << uri << std::endl;
+        }
+        return model != 0;
+    }
+
+private:
+    BaseApplicationContext *m_applicationContextRef;
+    Scene *m_sceneRef;
+    Factory *m_factoryRef;
+    IEncoding *m_encodingRef;
+    int m_updateOptions;
+};
+
+static void parseArguments(int argc, char **argv, StringMap &settings)
+{
+    int offset = 1;
+    if (argc > 1 && std::string(argv[1]).find('=') == std::string::npos) {
+        ::ui::loadSettings(argv[1], settings);
+        offset = 2;
+    }
+    else {
+        ::ui::loadSettings("config.ini", settings);
+    }
+    /* overrides settings such as batch.frame.begin=0 batch.frame.end=299 to split frame ranges */
+    for (int i = offset; i < argc; i++) {
+        const std::string argument(argv[i]);
+        std::string::size_type pos = argument.find('=');
+        if (pos != std::string::npos) {
+            settings[argument.substr(0, pos)] = argument.substr(pos + 1);
+        }
+    }
+}
+
+static void UITerminateEGLSession(EGLDisplay display, EGLSurface surface, EGLContext context)
+{
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(display, context);
+    eglDestroySurface(display, surface);
+    eglTerminate(display);
+}
+
+} /* namespace anonymous */
+
+int main(int argc, char **argv)
+{
+    tbb::task_scheduler_init initializer; (void) initializer;
+    BaseApplicationContext::initializeOnce(argv[0], 0, 2);
+
+    StringMap settings;
+    parseArguments(argc, argv, settings);
+    int width = settings.value("window.width", 640),
+            height = settings.value("window.height", 480);
+    bool enableGLES = settings.value("opengl.enable.gles", false);
+
+    eglBindAPI(enableGLES ? EGL_OPENGL_ES_API : EGL_OPENGL_API);
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLint major, minor;
+    if (!eglInitialize(display, &major, &minor)) {
+        std::cerr << "Cannot initialize EGL session: " << eglGetError() << std::endl;
+        return EXIT_FAILURE;
+    }
+    Array<EGLint> attrs;
+    attrs.append(EGL_RED_SIZE);
+    attrs.append(settings.value("opengl.size.red", 8));
+    attrs.append(EGL_GREEN_SIZE);
+    attrs.append(settings.value("opengl.size.green", 8));
+    attrs.append(EGL_BLUE_SIZE);
+    attrs.append(settings.value("opengl.size.blue", 8));
+    attrs.append(EGL_ALPHA_SIZE);
+    attrs.append(settings.value("opengl.size.alpha", 8));
+    attrs.append(EGL_DEPTH_SIZE);
+    attrs.append(settings.value("opengl.size.depth", 24));
+    attrs.append(EGL_STENCIL_SIZE);
+    attrs.append(settings.value("opengl.size.stencil", 8));
+    attrs.append(EGL_SURFACE_TYPE);
+    attrs.append(EGL_PBUFFER_BIT);
+    attrs.append(EGL_RENDERABLE_TYPE);
+    attrs.append(enableGLES ? EGL_OPENGL_ES_BIT : EGL_OPENGL_BIT);
+    attrs.append(EGL_NONE);
+    EGLConfig configs;
+    EGLint nconfigs;
+    if (!eglChooseConfig(display, &attrs[0], &configs, 1, &nconfigs) || nconfigs == 0) {
+        std::cerr << "Cannot choose EGL configuration: " << eglGetError() << std::endl;
+        UITerminateEGLSession(display, 0, 0);
+        return EXIT_FAILURE;
+    }
+    EGLint surfaceAttribs[] = {
+        EGL_WIDTH, width,
+        EGL_HEIGHT, height,
+        EGL_NONE
+    };
+    EGLSurface surface = eglCreatePbufferSurface(display, configs, surfaceAttribs);
+    if (surface == EGL_NO_SURFACE) {
+        std::cerr << "Cannot create EGL pbuffer surface: " << eglGetError() << std::endl;
+        UITerminateEGLSession(display, surface, 0);
+        return EXIT_FAILURE;
+    }
+    Array<EGLint> contextAttribs;
+    if (enableGLES) {
+        contextAttribs.append(EGL_CONTEXT_CLIENT_VERSION);
+        contextAttribs.append(3);
+    }
+    contextAttribs.append(EGL_NONE);
+    EGLContext context = eglCreateContext(display, configs, EGL_NO_CONTEXT, &contextAttribs[0]);
+    if (context == EGL_NO_CONTEXT) {
+        std::cerr << "Cannot create EGL context: " << eglGetError() << std::endl;
+        UITerminateEGLSession(display, surface, context);
+        return EXIT_FAILURE;
+    }
+    if (!eglMakeCurrent(display, surface, surface, context)) {
+        std::cerr << "Cannot make OpenGL context current: " << eglGetError() << std::endl;
+        UITerminateEGLSession(display, surface, context);
+        return EXIT_FAILURE;
+    }
+    std::cerr << "GL_VERSION: " << glGetString(GL_VERSION) << std::endl;
+    std::cerr << "GL_RENDERER: " << glGetString(GL_RENDERER) << std::endl;
+    if (!Scene::initialize(ApplicationContext::staticSharedFunctionResolverInstance())) {
+        UITerminateEGLSession(display, surface, context);
+        std::cerr << "Cannot initialize Scene" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Encoding::Dictionary dictionary;
+    Encoding encoding(&dictionary);
+    Factory factory(&encoding);
+    ProjectDelegate delegate(&factory, &encoding);
+    const std::string &projectPath = settings.value("file.project", std::string());
+    SceneSmartPtr scene(projectPath.empty() ? new Scene(true) : new XMLProject(&delegate, &factory, true));
+    ApplicationContext applicationContext(scene.get(), &encoding, &settings, enableGLES);
+    World world;
+    applicationContext.initialize(false);
+    applicationContext.setViewportRegion(glm::vec4(0, 0, width, height));
+    applicationContext.updateCameraMatrices();
+    ::ui::initializeDictionary(settings, dictionary);
+    if (!projectPath.empty()) {
+        const int updateOptions = (settings.value("enable.parallel", true) ? IRenderEngine::kParallelUpdate : IRenderEngine::kNone)
+                | (settings.value("enable.legacyupload", false) ? IRenderEngine::kLegacyVertexUpload : IRenderEngine::kNone);
+        delegate.setContext(&applicationContext, scene.get(), updateOptions);
+        if (!static_cast<XMLProject *>(scene.get())->load(projectPath.c_str())) {
+            std::cerr << "Cannot load the project: " << projectPath << std::endl;
+            scene->reset();
+            applicationContext.release();
+            UITerminateEGLSession(display, surface, context);
+            return EXIT_FAILURE;
+        }
+    }
+    else {
+        ::ui::loadAllModels(settings, &applicationContext, scene.get(), &factory, &encoding);
+    }
+    scene->setWorldRef(world.dynamicWorldRef());
+    /* every substep is simulated so that any frame range produces the same result */
+    world.setSteppingPolicy(World::kExactStepping);
+
+    const Scalar &fps = settings.value("batch.fps", Scene::defaultFPS());
+    const Scalar &step = Scene::defaultFPS() / fps;
+    const int lastFrameIndex = int(scene->durationTimeIndex() / step);
+    const int beginFrameIndex = btMax(settings.value("batch.frame.begin", 0), 0);
+    const int endFrameIndex = btMin(settings.value("batch.frame.end", lastFrameIndex), lastFrameIndex);
+    FrameWriter writer(settings.value("batch.output", std::string("frame-%06d.tga")), width, height);
+    StageTimer warmupTimer, frameTimer;
+
+    scene->seekTimeIndex(0, Scene::kUpdateAll);
+    scene->update(Scene::kUpdateAll | Scene::kResetMotionState);
+    /* physics has no random access so frames before the range are simulated without rendering */
+    IKeyframe::TimeIndex lastTimeIndex = 0;
+    for (int i = 1; i < beginFrameIndex; i++) {
+        const IKeyframe::TimeIndex &timeIndex = i * step;
+        warmupTimer.start();
+        scene->seekTimeIndex(timeIndex, Scene::kUpdateAll);
+        warmupTimer.mark(kSeekStage);
+        world.stepSimulation(timeIndex - lastTimeIndex, Scene::defaultFPS());
+        warmupTimer.mark(kPhysicsStage);
+        scene->update(Scene::kUpdateAll);
+        warmupTimer.mark(kUpdateStage);
+        warmupTimer.nextFrame();
+        lastTimeIndex = timeIndex;
+    }
+    bool ok = true;
+    for (int i = beginFrameIndex; ok && i <= endFrameIndex; i++) {
+        const IKeyframe::TimeIndex &timeIndex = i * step;
+        frameTimer.start();
+        scene->seekTimeIndex(timeIndex, Scene::kUpdateAll);
+        frameTimer.mark(kSeekStage);
+        world.stepSimulation(timeIndex - lastTimeIndex, Scene::defaultFPS());
+        frameTimer.mark(kPhysicsStage);
+        scene->update(Scene::kUpdateAll);
+        frameTimer.mark(kUpdateStage);
+        glViewport(0, 0, width, height);
+        glClearColor(1, 1, 1, 1);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        ::ui::drawScreen(*scene);
+        glFinish();
+        frameTimer.mark(kRenderStage);
+        writer.readPixels();
+        frameTimer.mark(kReadbackStage);
+        ok = writer.write(i);
+        frameTimer.mark(kWriteStage);
+        frameTimer.nextFrame();
+        lastTimeIndex = timeIndex;
+    }
+    std::fflush(stdout);
+    if (beginFrameIndex > 1) {
+        std::cerr << "== warmup (frames 1-" << beginFrameIndex - 1 << ") ==" << std::endl;
+        warmupTimer.report(std::cerr);
+    }
+    std::cerr << "== frames " << beginFrameIndex << "-" << endFrameIndex << " at " << fps << "fps ==" << std::endl;
+    frameTimer.report(std::cerr);
+
+    scene->setWorldRef(0);
+    scene->reset();
+    applicationContext.release();
+    UITerminateEGLSession(display, surface, context);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -272,6 +272,7 @@ public:
                                     0
                                     );
         m_world->dynamicWorldRef()->setDebugDrawer(m_debugDrawer.get());
+        m_world->setSteppingPolicy(World::kInterpolateStepping);
         m_scene->setWorldRef(m_world->dynamicWorldRef());
         m_scene->seekTimeIndex(0, Scene::kUpdateAll);
         m_scene->update(Scene::kUpdateAll | Scene::kResetMotionState);
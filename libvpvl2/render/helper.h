@@ -38,6 +38,7 @@
 #include <vpvl2/vpvl2.h>
 #include <vpvl2/extensions/Archive.h>
 #include <vpvl2/extensions/BaseApplicationContext.h>
+#include <vpvl2/extensions/EffectCache.h>
 #include <vpvl2/extensions/World.h>
 #include <vpvl2/extensions/StringMap.h>
 #include <vpvl2/extensions/icu4c/Encoding.h>
@@ -165,6 +166,7 @@ static bool loadModel(const UnicodeString &path,
                     const uint8 *data = reinterpret_cast<const uint8 *>(bytes->data());
                     archive->setBasePath(icu4c::String::toStdString(filename.tempSubString(0, offset)));
                     model.reset(factoryRef->createModel(data, bytes->size(), ok));
+                    archive->releaseEntry(*it);
                     break;
                 }
             }
@@ -185,6 +187,8 @@ static void loadAllModels(const StringMap &settings,
     const std::string &globalMotionPath = settings.value("file.motion", std::string());
     int nmodels = settings.value("models/size", 0);
     bool parallel = settings.value("enable.parallel", true), ok = false;
+    const int updateOptions = (parallel ? IRenderEngine::kParallelUpdate : IRenderEngine::kNone)
+            | (settings.value("enable.legacyupload", false) ? IRenderEngine::kLegacyVertexUpload : IRenderEngine::kNone);
     ArchiveSmartPtr archive;
     IModelSmartPtr model;
     std::ostringstream stream;
@@ -194,6 +198,11 @@ static void loadAllModels(const StringMap &settings,
     else if (settings.value("enable.opencl", false)) {
         sceneRef->setAccelerationType(Scene::kOpenCLAccelerationType1);
     }
+    else if (settings.value("enable.cpuskinning", false)) {
+        sceneRef->setAccelerationType(Scene::kCPUAccelerationType1);
+    }
+    sceneRef->setSkipUnchangedModelsEnable(settings.value("enable.skipunchanged", false));
+    EffectCache::setDirectory(settings.value("dir.cache.effects", std::string()));
     for (int i = 0; i < nmodels; i++) {
         stream.str(std::string());
         stream << "models/" << (i + 1);
@@ -207,6 +216,8 @@ static void loadAllModels(const StringMap &settings,
         icu4c::String dir(modelPath.tempSubString(0, indexOf));
         if (loadModel(modelPath, applicationContextRef, factoryRef, encodingRef, archive, model)) {
             BaseApplicationContext::ModelContext modelContext(applicationContextRef, archive.get(), &dir, model->type() == IModel::kAssetModel);
+            /* starts decoding textures on worker threads, IRenderEngine#upload takes the decoded ones and decodes the rest here */
+            modelContext.decodeTextures(model.get());
             IRenderEngineSmartPtr engine(sceneRef->createRenderEngine(applicationContextRef, model.get(), flags));
             IEffect *effectRef = 0;
             /*
@@ -226,8 +237,10 @@ static void loadAllModels(const StringMap &settings,
                  engine->setEffect(effectRef, IEffect::kAutoDetection, &modelContext);
 #endif
             }
+            /* some options such as kLegacyVertexUpload must be set before uploading */
+            engine->setUpdateOptions(updateOptions);
             if (engine->upload(&modelContext)) {
-                engine->setUpdateOptions(parallel ? IRenderEngine::kParallelUpdate : IRenderEngine::kNone);
+                engine->setUpdateOptions(updateOptions);
                 model->setEdgeWidth(settings.value(prefix + "/edge.width", 1.0f));
                 model->setPhysicsEnable(settings.value(prefix + "/enable.physics", true));
                 sceneRef->addModel(model.get(), engine.release(), i);
@@ -258,6 +271,13 @@ static void loadAllModels(const StringMap &settings,
             }
         }
     }
+    if (EffectCache::isEnabled()) {
+        EffectCache::Statistics statistics;
+        EffectCache::getStatistics(statistics);
+        VPVL2_LOG(INFO, "EffectCache: source=" << statistics.numSourceHits << "/" << (statistics.numSourceHits + statistics.numSourceMisses)
+                  << " binary=" << statistics.numProgramBinaryHits << "/" << (statistics.numProgramBinaryHits + statistics.numProgramBinaryMisses)
+                  << " rejects=" << statistics.numRejects << " stores=" << statistics.numStores);
+    }
 }
 
 }
@@ -605,6 +605,7 @@ Model::Model(IEncoding *encoding)
       m_rotation(Quaternion::getIdentity()),
       m_opacity(1),
       m_scaleFactor(10),
+      m_structureRevision(0),
       m_visible(false)
 {
 #if defined(VPVL2_LINK_ASSIMP) || defined(VPVL2_LINK_ASSIMP3)
@@ -771,6 +772,7 @@ void Model::getBoundingBox(Vector3 &min, Vector3 &max) const
 void Model::setName(const IString *value, IEncoding::LanguageType /* type */)
 {
     internal::setString(value, m_name);
+    m_structureRevision++;
 }
 
 void Model::setComment(const IString *value, IEncoding::LanguageType /* type */)
@@ -1018,6 +1020,11 @@ void Model::removeVertex(IVertex * /* value */)
     /* do nothing */
 }
 
+int Model::structureRevision() const
+{
+    return m_structureRevision;
+}
+
 IProgressReporter *Model::progressReporterRef() const
 {
     return m_progressReporterRef;
@@ -38,6 +38,7 @@
 #include "vpvl2/vpvl2.h"
 #include "vpvl2/IApplicationContext.h"
 #include "vpvl2/internal/util.h"
+#include "vpvl2/internal/ParallelProcessors.h"
 
 #include "vpvl2/asset/Model.h"
 #include "vpvl2/mvd/Motion.h"
@@ -323,7 +324,9 @@ struct Scene::PrivateContext VPVL2_DECL_FINAL
         ModelPtr(IModel *v, int p, bool o)
             : value(v),
               priority(p),
-              ownMemory(o)
+              structureRevision(v->structureRevision()),
+              ownMemory(o),
+              isUpdated(true)
         {
         }
         ~ModelPtr() {
@@ -332,8 +335,13 @@ struct Scene::PrivateContext VPVL2_DECL_FINAL
             }
         }
         IModel *value;
+        /* captured at the last performUpdate to detect unchanged models */
+        Array<Scalar> updatedState;
         int priority;
+        /* IModel#setName also changes the structure revision */
+        int structureRevision;
         bool ownMemory;
+        bool isUpdated;
     };
     struct MotionPtr VPVL2_DECL_FINAL {
         MotionPtr(IMotion *v, int p, bool o)
@@ -389,8 +397,12 @@ struct Scene::PrivateContext VPVL2_DECL_FINAL
           currentTimeIndex(0),
           currentSeconds(0),
           preferredFPS(Scene::defaultFPS()),
+          modelRevision(0),
+          enableParallelUpdate(false),
+          enableSkipUnchangedModels(false),
           ownMemory(ownMemory)
     {
+        internal::zerofill(&updateStatistics, sizeof(updateStatistics));
     }
     ~PrivateContext() {
         destroyWorld();
@@ -408,6 +420,7 @@ struct Scene::PrivateContext VPVL2_DECL_FINAL
         engines.append(new RenderEnginePtr(engine, priority, ownMemory));
         model2engineRef.insert(model, engine);
         model->joinWorld(worldRef);
+        modelRevision++;
     }
     void addMotionPtr(IMotion *motion) {
         motions.append(new MotionPtr(motion, 0, ownMemory));
@@ -455,6 +468,7 @@ struct Scene::PrivateContext VPVL2_DECL_FINAL
                 model->leaveWorld(worldRef);
                 v->ownMemory = false;
                 models.removeAt(i);
+                modelRevision++;
                 break;
             }
         }
@@ -511,11 +525,207 @@ struct Scene::PrivateContext VPVL2_DECL_FINAL
             worldRef->getConstraintSolver()->reset();
         }
     }
-    void updateModels() {
+    static IModel *findParentModelRef(const IModel *model) {
+        if (IModel *parentModelRef = model->parentModelRef()) {
+            return parentModelRef;
+        }
+        else if (const IBone *parentBoneRef = model->parentBoneRef()) {
+            return parentBoneRef->parentModelRef();
+        }
+        return 0;
+    }
+    int resolveModelDepth(const IModel *model) const {
+        const int nmodels = models.count();
+        const IModel *parentModelRef = findParentModelRef(model);
+        int depth = 0;
+        /* limit depth to the number of models to avoid infinite loop by circular reference */
+        while (parentModelRef && parentModelRef != model && depth < nmodels) {
+            parentModelRef = findParentModelRef(parentModelRef);
+            depth++;
+        }
+        return depth;
+    }
+    static void appendState(const Vector3 &value, Array<Scalar> &state) {
+        state.append(value.x());
+        state.append(value.y());
+        state.append(value.z());
+    }
+    static void appendState(const Quaternion &value, Array<Scalar> &state) {
+        state.append(value.x());
+        state.append(value.y());
+        state.append(value.z());
+        state.append(value.w());
+    }
+    static void appendState(const Color &value, Array<Scalar> &state) {
+        appendState(Quaternion(value.x(), value.y(), value.z(), value.w()), state);
+    }
+    /*
+     * Captures everything performUpdate and IRenderEngine#update depend on. Motions change the model
+     * only through bone local transforms and morph weights, so seeking to the same time index also
+     * yields the same state. The arrays are members and shrunk with resize(0) instead of clear() to
+     * keep their storage across frames.
+     */
+    void captureModelState(const IModel *model, Array<Scalar> &state) {
+        Array<IBone *> &bones = stateBoneRefs;
+        Array<IMorph *> &morphs = stateMorphRefs;
+        Array<IMaterial *> &materials = stateMaterialRefs;
+        Array<IRigidBody *> &bodies = stateRigidBodyRefs;
+        state.resize(0);
+        appendState(camera.position(), state);
+        appendState(model->worldTranslation(), state);
+        appendState(model->worldOrientation(), state);
+        appendState(model->edgeColor(), state);
+        state.append(model->opacity());
+        state.append(model->scaleFactor());
+        state.append(Scalar(model->edgeWidth()));
+        state.append(model->isVisible());
+        state.append(model->isPhysicsEnabled());
+        model->getBoneRefs(bones);
+        const int nbones = bones.count();
+        for (int i = 0; i < nbones; i++) {
+            const IBone *bone = bones[i];
+            appendState(bone->localTranslation(), state);
+            appendState(bone->localOrientation(), state);
+            state.append(bone->isInverseKinematicsEnabled());
+        }
+        model->getMorphRefs(morphs);
+        const int nmorphs = morphs.count();
+        for (int i = 0; i < nmorphs; i++) {
+            state.append(Scalar(morphs[i]->weight()));
+        }
+        model->getMaterialRefs(materials);
+        const int nmaterials = materials.count();
+        for (int i = 0; i < nmaterials; i++) {
+            const IMaterial *material = materials[i];
+            appendState(material->ambient(), state);
+            appendState(material->diffuse(), state);
+            appendState(material->specular(), state);
+            appendState(material->edgeColor(), state);
+            appendState(material->mainTextureBlend(), state);
+            appendState(material->sphereTextureBlend(), state);
+            appendState(material->toonTextureBlend(), state);
+            state.append(material->shininess());
+            state.append(Scalar(material->edgeSize()));
+            state.append(material->isVisible());
+            state.append(material->isEdgeEnabled());
+            state.append(material->isCullingDisabled());
+            state.append(material->isCastingShadowEnabled());
+            state.append(material->isCastingShadowMapEnabled());
+            state.append(material->isShadowMapEnabled());
+        }
+        /* rigid bodies never deactivate, so simulated bodies that stopped moving are treated as asleep */
+        if (worldRef && model->isPhysicsEnabled()) {
+            model->getRigidBodyRefs(bodies);
+            const int nbodies = bodies.count();
+            for (int i = 0; i < nbodies; i++) {
+                const btRigidBody *body = static_cast<const btRigidBody *>(bodies[i]->bodyPtr());
+                if (body && !body->isStaticOrKinematicObject()) {
+                    const Transform &transform = body->getWorldTransform();
+                    appendState(transform.getOrigin(), state);
+                    appendState(transform.getRotation(), state);
+                }
+            }
+        }
+    }
+    static bool isSameState(const Array<Scalar> &left, const Array<Scalar> &right) {
+        static const Scalar kTolerance = 1e-5f;
+        const int nvalues = left.count();
+        if (nvalues != right.count()) {
+            return false;
+        }
+        for (int i = 0; i < nvalues; i++) {
+            if (btFabs(left[i] - right[i]) > kTolerance) {
+                return false;
+            }
+        }
+        return true;
+    }
+    ModelPtr *findModelPtr(const IModel *model) const {
         const int nmodels = models.count();
         for (int i = 0; i < nmodels; i++) {
-            IModel *model = models[i]->value;
-            model->performUpdate();
+            ModelPtr *v = models[i];
+            if (v->value == model) {
+                return v;
+            }
+        }
+        return 0;
+    }
+    bool checkModelChanged(ModelPtr *v, bool forceUpdate) {
+        if (!enableSkipUnchangedModels) {
+            return true;
+        }
+        /* a child model follows the parent model that was updated in this frame */
+        if (const IModel *parentModelRef = findParentModelRef(v->value)) {
+            const ModelPtr *parent = findModelPtr(parentModelRef);
+            forceUpdate |= parent && parent->isUpdated;
+        }
+        captureModelState(v->value, currentModelState);
+        if (forceUpdate || !isSameState(currentModelState, v->updatedState)) {
+            v->updatedState.copy(currentModelState);
+            return true;
+        }
+        return false;
+    }
+    void updateModels(bool forceUpdate) {
+        /*
+         * Models are updated by depth of parent model (or parent bone) dependency, so a child model
+         * always refers the updated parent. Models in the same depth don't depend on each other and
+         * are updated concurrently. The order is same regardless of enableParallelUpdate.
+         */
+        const int nmodels = models.count();
+        Array<int> depths;
+        Array<IModel *> modelRefs;
+        int maxDepth = 0;
+        depths.resize(nmodels);
+        for (int i = 0; i < nmodels; i++) {
+            const int depth = resolveModelDepth(models[i]->value);
+            depths[i] = depth;
+            maxDepth = btMax(maxDepth, depth);
+        }
+        updateStatistics.numUpdatedModels = updateStatistics.numSkippedModels = 0;
+        for (int depth = 0; depth <= maxDepth; depth++) {
+            modelRefs.clear();
+            for (int i = 0; i < nmodels; i++) {
+                if (depths[i] == depth) {
+                    ModelPtr *v = models[i];
+                    v->isUpdated = checkModelChanged(v, forceUpdate);
+                    if (v->isUpdated) {
+                        modelRefs.append(v->value);
+                        updateStatistics.numUpdatedModels++;
+                    }
+                    else {
+                        skippedModelRefs.insert(v->value, v->value);
+                        updateStatistics.numSkippedModels++;
+                    }
+                }
+            }
+            internal::ParallelUpdateModelProcessor<IModel> processor(&modelRefs);
+            processor.execute(enableParallelUpdate && modelRefs.count() > 1);
+        }
+        updateStatistics.totalUpdatedModels += updateStatistics.numUpdatedModels;
+        updateStatistics.totalSkippedModels += updateStatistics.numSkippedModels;
+    }
+    void updateModelNames() {
+        const int nmodels = models.count();
+        bool changed = false;
+        for (int i = 0; i < nmodels; i++) {
+            ModelPtr *v = models[i];
+            const int revision = v->value->structureRevision();
+            if (v->structureRevision != revision) {
+                v->structureRevision = revision;
+                changed = true;
+            }
+        }
+        /* a renamed model is found by the new name and references resolved by names must be resolved again */
+        if (changed) {
+            name2modelRef.clear();
+            for (int i = 0; i < nmodels; i++) {
+                IModel *model = models[i]->value;
+                if (const IString *name = model->name(IEncoding::kDefaultLanguage)) {
+                    name2modelRef.insert(name->toHashString(), model);
+                }
+            }
+            modelRevision++;
         }
     }
     void markAllMorphsDirty() {
@@ -533,10 +743,36 @@ struct Scene::PrivateContext VPVL2_DECL_FINAL
         }
     }
     void updateRenderEngines() {
+        /*
+         * Buffers are mapped and unmapped on the calling (GL) thread and CPU skinning of engines
+         * between them runs concurrently. Engines that can't split the update are updated as is.
+         */
         const int nengines = engines.count();
+        const bool hasSkippedModels = skippedModelRefs.count() > 0;
+        Array<IRenderEngine *> deferredEngineRefs;
         for (int i = 0; i < nengines; i++) {
             IRenderEngine *engine = engines[i]->value;
-            engine->update();
+            if (hasSkippedModels) {
+                const IModel *model = engine->parentModelRef();
+                if (model && skippedModelRefs.find(model)) {
+                    /* effect parameters (TIME, mouse, viewport and so on) still change on skipped models */
+                    engine->updateSceneParameters();
+                    continue;
+                }
+            }
+            if (enableParallelUpdate && engine->beginUpdate()) {
+                deferredEngineRefs.append(engine);
+            }
+            else {
+                engine->update();
+            }
+        }
+        const int ndeferred = deferredEngineRefs.count();
+        internal::ParallelUpdateRenderEngineProcessor<IRenderEngine> processor(&deferredEngineRefs);
+        processor.execute(ndeferred > 1);
+        for (int i = 0; i < ndeferred; i++) {
+            IRenderEngine *engine = deferredEngineRefs[i];
+            engine->endUpdate();
         }
     }
     void updateCamera() {
@@ -623,6 +859,7 @@ struct Scene::PrivateContext VPVL2_DECL_FINAL
 #endif
     Hash<HashPtr, IRenderEngine *> model2engineRef;
     Hash<HashString, IModel *> name2modelRef;
+    Hash<HashPtr, const IModel *> skippedModelRefs;
     Array<ModelPtr *> models;
     Array<MotionPtr *> motions;
     Array<RenderEnginePtr *> engines;
@@ -632,6 +869,15 @@ struct Scene::PrivateContext VPVL2_DECL_FINAL
     IKeyframe::TimeIndex currentTimeIndex;
     float64 currentSeconds;
     Scalar preferredFPS;
+    int modelRevision;
+    Scene::UpdateStatistics updateStatistics;
+    Array<Scalar> currentModelState;
+    Array<IBone *> stateBoneRefs;
+    Array<IMorph *> stateMorphRefs;
+    Array<IMaterial *> stateMaterialRefs;
+    Array<IRigidBody *> stateRigidBodyRefs;
+    bool enableParallelUpdate;
+    bool enableSkipUnchangedModels;
     bool ownMemory;
 };
 
@@ -975,6 +1221,9 @@ void Scene::updateModel(IModel *model) const
 
 void Scene::update(int flags)
 {
+    /* render engines are skipped only if their models are skipped in the same call */
+    m_context->skippedModelRefs.clear();
+    m_context->updateModelNames();
     if (internal::hasFlagBits(flags, kUpdateCamera)) {
         m_context->updateCamera();
     }
@@ -982,7 +1231,8 @@ void Scene::update(int flags)
         m_context->markAllMorphsDirty();
     }
     if (internal::hasFlagBits(flags, kUpdateModels)) {
-        m_context->updateModels();
+        const bool forceUpdate = internal::hasFlagBits(flags, kForceUpdateAllMorphs) || internal::hasFlagBits(flags, kResetMotionState);
+        m_context->updateModels(forceUpdate);
     }
     /*
      * Call updateMotionAfter after #updateModels() to resolve dependency
@@ -1168,5 +1418,40 @@ void Scene::setWorldRef(btDiscreteDynamicsWorld *worldRef) VPVL2_DECL_NOEXCEPT
     m_context->setWorldRef(worldRef);
 }
 
+bool Scene::isParallelUpdateEnabled() const VPVL2_DECL_NOEXCEPT
+{
+    return m_context->enableParallelUpdate;
+}
+
+void Scene::setParallelUpdateEnable(bool value) VPVL2_DECL_NOEXCEPT
+{
+    m_context->enableParallelUpdate = value;
+}
+
+int Scene::modelRevision() const VPVL2_DECL_NOEXCEPT
+{
+    return m_context->modelRevision;
+}
+
+void Scene::invalidateModelRevision() VPVL2_DECL_NOEXCEPT
+{
+    m_context->modelRevision++;
+}
+
+bool Scene::isSkipUnchangedModelsEnabled() const VPVL2_DECL_NOEXCEPT
+{
+    return m_context->enableSkipUnchangedModels;
+}
+
+void Scene::setSkipUnchangedModelsEnable(bool value) VPVL2_DECL_NOEXCEPT
+{
+    m_context->enableSkipUnchangedModels = value;
+}
+
+void Scene::getUpdateStatistics(UpdateStatistics &value) const VPVL2_DECL_NOEXCEPT
+{
+    value = m_context->updateStatistics;
+}
+
 } /* namespace VPVL2_VERSION_NS */
 } /* namespace vpvl2 */
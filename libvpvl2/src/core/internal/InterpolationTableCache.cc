@@ -0,0 +1,241 @@
+/**
+
+ Copyright (c) 2010-2014  hkrn
+
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or
+ without modification, are permitted provided that the following
+ conditions are met:
+
+ - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following
+   disclaimer in the documentation and/or other materials provided
+   with the distribution.
+ - Neither the name of the MMDAI project team nor the names of
+   its contributors may be used to endorse or promote products
+   derived from this software without specific prior written
+   permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "vpvl2/vpvl2.h"
+#include "vpvl2/internal/util.h"
+#include "vpvl2/internal/InterpolationTableCache.h"
+#include "vpvl2/internal/Keyframe.h"
+#include "vpvl2/internal/Mutex.h"
+
+namespace
+{
+
+using namespace vpvl2::VPVL2_VERSION_NS;
+
+struct Entry {
+    Entry(int k, int s)
+        : next(0),
+          table(new IKeyframe::SmoothPrecision[s + 1]),
+          key(k),
+          size(s),
+          numReferences(0)
+    {
+    }
+    ~Entry() {
+        internal::deleteObjectArray(table);
+        next = 0;
+        key = 0;
+        size = 0;
+        numReferences = 0;
+    }
+    Entry *next;
+    IKeyframe::SmoothPrecision *table;
+    int key;
+    int size;
+    int numReferences;
+};
+
+struct Storage {
+    Storage()
+        : numTables(0),
+          numReferences(0),
+          sharedBytes(0),
+          unsharedBytes(0),
+          evaluationMode(internal::InterpolationTableCache::kTableEvaluation)
+    {
+    }
+    static int makeKey(const QuadWord &parameter) {
+        /* each control point is 7 bits on both VMD and MVD */
+        const int x1 = btClamped(int(parameter.x()), 0, 127);
+        const int y1 = btClamped(int(parameter.y()), 0, 127);
+        const int x2 = btClamped(int(parameter.z()), 0, 127);
+        const int y2 = btClamped(int(parameter.w()), 0, 127);
+        return (x1 << 21) | (y1 << 14) | (x2 << 7) | y2;
+    }
+
+    internal::Mutex mutex;
+    Hash<HashInt, Entry *> entries;
+    Hash<HashPtr, Entry *> tables;
+    int numTables;
+    int numReferences;
+    vsize sharedBytes;
+    vsize unsharedBytes;
+    internal::InterpolationTableCache::EvaluationMode evaluationMode;
+};
+
+/*
+ * never destroyed because keyframes owned by static objects may release their tables after static
+ * destruction. tables still referenced at exit are left to the process.
+ */
+static Storage &sharedStorage()
+{
+    static Storage *storage = new Storage();
+    return *storage;
+}
+
+}
+
+namespace vpvl2
+{
+namespace VPVL2_VERSION_NS
+{
+namespace internal
+{
+
+const IKeyframe::SmoothPrecision *InterpolationTableCache::acquire(const QuadWord &parameter, int size)
+{
+    VPVL2_DCHECK_GT(size, 0);
+    Storage &storage = sharedStorage();
+    internal::ScopedLock lock(storage.mutex);
+    if (storage.evaluationMode == kAnalyticEvaluation) {
+        return 0;
+    }
+    const int key = Storage::makeKey(parameter);
+    Entry *const *headPtr = storage.entries.find(key), *head = headPtr ? *headPtr : 0, *entry = head;
+    while (entry && entry->size != size) {
+        entry = entry->next;
+    }
+    const vsize bytes = sizeof(IKeyframe::SmoothPrecision) * (size + 1);
+    if (!entry) {
+        entry = new Entry(key, size);
+        InterpolationTable::build(((key >> 21) & 0x7f) / 127.0f, // x1
+                                  ((key >>  7) & 0x7f) / 127.0f, // x2
+                                  ((key >> 14) & 0x7f) / 127.0f, // y1
+                                  ((key >>  0) & 0x7f) / 127.0f, // y2
+                                  size,
+                                  entry->table);
+        entry->next = head;
+        storage.entries.insert(key, entry);
+        storage.tables.insert(entry->table, entry);
+        storage.numTables++;
+        storage.sharedBytes += bytes;
+    }
+    entry->numReferences++;
+    storage.numReferences++;
+    storage.unsharedBytes += bytes;
+    return entry->table;
+}
+
+void InterpolationTableCache::release(const IKeyframe::SmoothPrecision *table)
+{
+    if (!table) {
+        return;
+    }
+    Storage &storage = sharedStorage();
+    internal::ScopedLock lock(storage.mutex);
+    Entry *const *entryPtr = storage.tables.find(table);
+    VPVL2_DCHECK(entryPtr);
+    if (!entryPtr) {
+        return;
+    }
+    Entry *entry = *entryPtr;
+    const vsize bytes = sizeof(IKeyframe::SmoothPrecision) * (entry->size + 1);
+    storage.numReferences--;
+    storage.unsharedBytes -= bytes;
+    if (--entry->numReferences > 0) {
+        return;
+    }
+    const int key = entry->key;
+    Entry *head = *storage.entries.find(key);
+    if (head == entry) {
+        if (entry->next) {
+            storage.entries.insert(key, entry->next);
+        }
+        else {
+            storage.entries.remove(key);
+        }
+    }
+    else {
+        Entry *prev = head;
+        while (prev->next != entry) {
+            prev = prev->next;
+        }
+        prev->next = entry->next;
+    }
+    storage.tables.remove(table);
+    storage.numTables--;
+    storage.sharedBytes -= bytes;
+    internal::deleteObject(entry);
+}
+
+void InterpolationTableCache::getStatistics(Statistics &value)
+{
+    Storage &storage = sharedStorage();
+    internal::ScopedLock lock(storage.mutex);
+    value.numTables = storage.numTables;
+    value.numReferences = storage.numReferences;
+    value.sharedBytes = storage.sharedBytes;
+    value.unsharedBytes = storage.unsharedBytes;
+}
+
+InterpolationTableCache::EvaluationMode InterpolationTableCache::evaluationMode()
+{
+    Storage &storage = sharedStorage();
+    internal::ScopedLock lock(storage.mutex);
+    return storage.evaluationMode;
+}
+
+void InterpolationTableCache::setEvaluationMode(EvaluationMode value)
+{
+    Storage &storage = sharedStorage();
+    internal::ScopedLock lock(storage.mutex);
+    storage.evaluationMode = value;
+}
+
+IKeyframe::SmoothPrecision InterpolationTableCache::evaluate(const QuadWord &parameter, const IKeyframe::SmoothPrecision &weight)
+{
+    static const int kMaxIterations = 16;
+    const IKeyframe::SmoothPrecision &x1 = parameter.x() / 127.0f, &x2 = parameter.z() / 127.0f;
+    const IKeyframe::SmoothPrecision &y1 = parameter.y() / 127.0f, &y2 = parameter.w() / 127.0f;
+    IKeyframe::SmoothPrecision t = weight;
+    for (int i = 0; i < kMaxIterations; i++) {
+        const IKeyframe::SmoothPrecision &v = InterpolationTable::spline1(t, x1, x2) - weight;
+        if (btFabs(btScalar(v)) < 0.0001f) {
+            break;
+        }
+        const IKeyframe::SmoothPrecision &tt = InterpolationTable::spline2(t, x1, x2);
+        if (btFuzzyZero(btScalar(tt))) {
+            break;
+        }
+        t -= v / tt;
+    }
+    return InterpolationTable::spline1(t, y1, y2);
+}
+
+} /* namespace internal */
+} /* namespace VPVL2_VERSION_NS */
+} /* namespace vpvl2 */
@@ -294,7 +294,8 @@ void MorphSection::addKeyframe(IKeyframe *keyframe)
     MorphAnimationTrack *const *track = m_context->name2tracks.find(key), *trackPtr = 0;
     if (track) {
         trackPtr = *track;
-        trackPtr->keyframes.append(keyframe);
+        /* keep the track sorted to seek without calling update */
+        internal::MotionHelper::insertKeyframe(keyframe, trackPtr->keyframes);
         m_context->allKeyframeRefs.append(keyframe);
     }
     else if (m_context->modelRef) {
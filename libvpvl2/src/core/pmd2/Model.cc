@@ -338,13 +338,21 @@ struct DefaultDynamicVertexBuffer : public IModel::DynamicVertexBuffer {
     void update(void *address) const {
         const PointerArray<Vertex> &vertices = modelRef->vertices();
         internal::ParallelVertexMorphProcessor<pmd2::Model, pmd2::Vertex, Unit> processor(&vertices, address);
-        processor.execute(enableParallelUpdate);
+        processor.execute(enableParallelUpdate, &morphPartitioner);
+    }
+    void update(void *address, const Array<int> & /* indices */) const {
+        update(address);
+    }
+    bool getMorphTouchedVertexIndices(Array<int> &indices, int &serial) const {
+        indices.clear();
+        serial = 0;
+        return false;
     }
     void performTransform(void *address, const Vector3 &cameraPosition) const {
         const PointerArray<Vertex> &vertices = modelRef->vertices();
         Unit *bufferPtr = static_cast<Unit *>(address);
         internal::ParallelSkinningVertexProcessor<pmd2::Model, pmd2::Vertex, Unit> processor(modelRef, &vertices, cameraPosition, bufferPtr);
-        processor.execute(enableParallelUpdate);
+        processor.execute(enableParallelUpdate, &skinningPartitioner);
     }
     void computeAabb(const void *address, Array<Vector3> &values) const {
         const Array<Material *> &materials = modelRef->materials();
@@ -360,6 +368,9 @@ struct DefaultDynamicVertexBuffer : public IModel::DynamicVertexBuffer {
 
     const Model *modelRef;
     const IModel::IndexBuffer *indexBufferRef;
+    /* owned by each buffer as render engines of models may be updated concurrently */
+    mutable internal::AffinityPartitioner morphPartitioner;
+    mutable internal::AffinityPartitioner skinningPartitioner;
     bool enableParallelUpdate;
 };
 const DefaultDynamicVertexBuffer::Unit DefaultDynamicVertexBuffer::kIdent = DefaultDynamicVertexBuffer::Unit();
@@ -577,6 +588,7 @@ struct Model::PrivateContext {
           parentModelRef(0),
           parentBoneRef(0),
           progressReporterRef(0),
+          structureRevision(0),
           namePtr(0),
           englishNamePtr(0),
           commentPtr(0),
@@ -863,6 +875,7 @@ struct Model::PrivateContext {
     IModel *parentModelRef;
     IBone *parentBoneRef;
     IProgressReporter *progressReporterRef;
+    int structureRevision;
     IString *namePtr;
     IString *englishNamePtr;
     IString *commentPtr;
@@ -1591,6 +1604,7 @@ IVertex::EdgeSizePrecision Model::edgeScaleFactor(const Vector3 &cameraPosition)
 void Model::setName(const IString *value, IEncoding::LanguageType type)
 {
     internal::ModelHelper::setName(value, m_context->namePtr, m_context->englishNamePtr, type);
+    m_context->structureRevision++;
 }
 
 void Model::setComment(const IString *value, IEncoding::LanguageType type)
@@ -1904,6 +1918,11 @@ void Model::removeVertex(IVertex *value)
     }
 }
 
+int Model::structureRevision() const
+{
+    return m_context->structureRevision;
+}
+
 IProgressReporter *Model::progressReporterRef() const
 {
     return m_context->progressReporterRef;
@@ -1917,6 +1936,7 @@ void Model::setProgressReporterRef(IProgressReporter *value)
 void Model::addBoneHash(Bone *bone)
 {
     VPVL2_DCHECK(bone);
+    m_context->structureRevision++;
     if (const IString *name = bone->name(IEncoding::kJapanese)) {
         m_context->name2boneRefs.insert(name->toHashString(), bone);
     }
@@ -1928,6 +1948,7 @@ void Model::addBoneHash(Bone *bone)
 void Model::removeBoneHash(const IBone *bone)
 {
     VPVL2_DCHECK(bone);
+    m_context->structureRevision++;
     if (const IString *name = bone->name(IEncoding::kJapanese)) {
         m_context->name2boneRefs.remove(name->toHashString());
     }
@@ -1939,6 +1960,7 @@ void Model::removeBoneHash(const IBone *bone)
 void Model::addMorphHash(Morph *morph)
 {
     VPVL2_DCHECK(morph);
+    m_context->structureRevision++;
     if (const IString *name = morph->name(IEncoding::kJapanese)) {
         m_context->name2morphRefs.insert(name->toHashString(), morph);
     }
@@ -1950,6 +1972,7 @@ void Model::addMorphHash(Morph *morph)
 void Model::removeMorphHash(const IMorph *morph)
 {
     VPVL2_DCHECK(morph);
+    m_context->structureRevision++;
     if (const IString *name = morph->name(IEncoding::kJapanese)) {
         m_context->name2morphRefs.remove(name->toHashString());
     }
@@ -37,6 +37,7 @@
 
 #include "vpvl2/vpvl2.h"
 #include "vpvl2/internal/ModelHelper.h"
+#include "vpvl2/internal/Mutex.h"
 
 #include "vpvl2/pmx/Bone.h"
 #include "vpvl2/pmx/Joint.h"
@@ -183,7 +184,6 @@ struct DefaultStaticVertexBuffer : public IModel::StaticVertexBuffer {
     static void updateBoneIndexHashes(const pmx::Model *modelRef, PointerArray<BoneIndexHash> &boneIndexHashes) {
         const Array<pmx::Material *> &materialRefs = modelRef->materials();
         const Array<pmx::Vertex *> &verticeRefs = modelRef->vertices();
-        const Array<int> &indices = modelRef->indices();
         BoneIndices boneIndices;
         boneIndexHashes.releaseAll();
         const int nmaterials = materialRefs.count();
@@ -193,7 +193,7 @@ struct DefaultStaticVertexBuffer : public IModel::StaticVertexBuffer {
             boneIndices.clear();
             boneIndices.push_back(-1);
             for (int j = 0; j < nindices; j++) {
-                const int vertexIndex = indices[offset + j];
+                const int vertexIndex = modelRef->indexAt(offset + j);
                 const IVertex *vertexRef = verticeRefs[vertexIndex];
                 addBoneIndices(vertexRef, boneIndices);
             }
@@ -248,7 +248,6 @@ struct DefaultStaticVertexBuffer : public IModel::StaticVertexBuffer {
     }
     void update(void *address) const {
         const Array<pmx::Material *> &materials = modelRef->materials();
-        const Array<int> &indices = modelRef->indices();
         const Array<pmx::Vertex *> &vertices = modelRef->vertices();
         const int nmaterials = materials.count();
         Unit *unitPtr = static_cast<Unit *>(address);
@@ -258,7 +257,7 @@ struct DefaultStaticVertexBuffer : public IModel::StaticVertexBuffer {
             const BoneIndexHash *boneIndexHashRef = boneIndexHashes[i];
             const int nindices = materialRef->indexRange().count;
             for (int j = 0; j < nindices; j++) {
-                const int vertexIndex = indices[offset + j];
+                const int vertexIndex = modelRef->indexAt(offset + j);
                 const IVertex *vertex = vertices[vertexIndex];
                 unitPtr[vertexIndex].update(vertex, boneIndexHashRef);
             }
@@ -372,13 +371,30 @@ struct DefaultDynamicVertexBuffer : public IModel::DynamicVertexBuffer {
     void update(void *address) const {
         const Array<pmx::Vertex *> &vertices = modelRef->vertices();
         internal::ParallelVertexMorphProcessor<pmx::Model, pmx::Vertex, Unit> processor(&vertices, address);
+        processor.execute(enableParallelUpdate, &morphPartitioner);
+    }
+    void update(void *address, const Array<int> &indices) const {
+        const Array<pmx::Vertex *> &vertices = modelRef->vertices();
+        internal::ParallelVertexMorphProcessor<pmx::Model, pmx::Vertex, Unit> processor(&vertices, address, &indices);
         processor.execute(enableParallelUpdate);
     }
+    bool getMorphTouchedVertexIndices(Array<int> &indices, int &serial) const {
+        indices.copy(modelRef->morphTouchedVertexIndices());
+        serial = modelRef->morphUpdateSerial();
+        return true;
+    }
     void performTransform(void *address, const Vector3 &cameraPosition) const {
         const Array<pmx::Vertex *> &verticeRefs = modelRef->vertices();
         Unit *bufferPtr = static_cast<Unit *>(address);
-        internal::ParallelSkinningVertexProcessor<pmx::Model, pmx::Vertex, Unit> processor(modelRef, &verticeRefs, cameraPosition, bufferPtr);
-        processor.execute(enableParallelUpdate);
+        if (internal::PackedVertexStore *storeRef = modelRef->packedVertexStoreRef()) {
+            storeRef->update(verticeRefs, modelRef->bones(), modelRef->materials());
+            internal::ParallelPackedSkinningVertexProcessor<Unit> processor(storeRef, modelRef->edgeScaleFactor(cameraPosition), bufferPtr);
+            processor.execute(enableParallelUpdate);
+        }
+        else {
+            internal::ParallelSkinningVertexProcessor<pmx::Model, pmx::Vertex, Unit> processor(modelRef, &verticeRefs, cameraPosition, bufferPtr);
+            processor.execute(enableParallelUpdate, &skinningPartitioner);
+        }
     }
     void computeAabb(const void *address, Array<Vector3> &values) const {
         const Array<pmx::Material *> &materials = modelRef->materials();
@@ -391,16 +407,19 @@ struct DefaultDynamicVertexBuffer : public IModel::DynamicVertexBuffer {
 
     const pmx::Model *modelRef;
     const IModel::IndexBuffer *indexBufferRef;
+    /* owned by each buffer as render engines of models may be updated concurrently */
+    mutable internal::AffinityPartitioner morphPartitioner;
+    mutable internal::AffinityPartitioner skinningPartitioner;
     bool enableParallelUpdate;
 };
 const DefaultDynamicVertexBuffer::Unit DefaultDynamicVertexBuffer::kIdent = DefaultDynamicVertexBuffer::Unit();
 
 struct DefaultIndexBuffer : public IModel::IndexBuffer {
     static const int kIdent = 0;
-    DefaultIndexBuffer(const Array<int> &indices, const int nvertices)
+    DefaultIndexBuffer(const pmx::Model *modelRef, const int nvertices)
         : indexType(kIndex32),
           indices32Ptr(0),
-          nindices(indices.count())
+          nindices(modelRef->count(IModel::kIndex))
     {
         if (nindices < 65536) {
             indexType = kIndex16;
@@ -414,7 +433,7 @@ struct DefaultIndexBuffer : public IModel::IndexBuffer {
             indices32Ptr = new int[nindices];
         }
         for (int i = 0; i < nindices; i++) {
-            const int index = indices[i];
+            const int index = modelRef->indexAt(i);
             if (index >= 0 && index < nvertices) {
                 setIndexAt(i, index);
             }
@@ -591,7 +610,6 @@ struct DefaultMatrixBuffer : public IModel::MatrixBuffer {
     void initialize() {
         const Array<pmx::Material *> &materialRefs = modelRef->materials();
         const Array<pmx::Vertex *> &verticeRefs = modelRef->vertices();
-        const Array<int> &indices = modelRef->indices();
         const int nmaterials = materialRefs.count();
         DefaultStaticVertexBuffer::BoneIndices boneIndices;
         meshes.bones.reserve(nmaterials);
@@ -603,7 +621,7 @@ struct DefaultMatrixBuffer : public IModel::MatrixBuffer {
             boneIndices.clear();
             boneIndices.push_back(-1);
             for (int j = 0; j < nindices; j++) {
-                const int vertexIndex = indices[offset + j];
+                const int vertexIndex = modelRef->indexAt(offset + j);
                 const IVertex *vertexRef = verticeRefs[vertexIndex];
                 DefaultStaticVertexBuffer::addBoneIndices(vertexRef, boneIndices);
             }
@@ -621,6 +639,49 @@ struct DefaultMatrixBuffer : public IModel::MatrixBuffer {
     SkinningMeshes meshes;
 };
 
+/* serializes string conversions of sections parsed concurrently as IEncoding is not thread safe */
+class SynchronizedEncoding VPVL2_DECL_FINAL : public IEncoding {
+public:
+    SynchronizedEncoding(IEncoding *encodingRef)
+        : m_encodingRef(encodingRef)
+    {
+    }
+    ~SynchronizedEncoding() {
+        m_encodingRef = 0;
+    }
+
+    IString *toString(const uint8 *value, vsize size, IString::Codec codec) const {
+        internal::ScopedLock lock(m_mutex);
+        return m_encodingRef->toString(value, size, codec);
+    }
+    IString *toString(const uint8 *value, IString::Codec codec, vsize maxlen) const {
+        internal::ScopedLock lock(m_mutex);
+        return m_encodingRef->toString(value, codec, maxlen);
+    }
+    vsize estimateSize(const IString *value, IString::Codec codec) const {
+        internal::ScopedLock lock(m_mutex);
+        return m_encodingRef->estimateSize(value, codec);
+    }
+    uint8 *toByteArray(const IString *value, IString::Codec codec, int &size) const {
+        internal::ScopedLock lock(m_mutex);
+        return m_encodingRef->toByteArray(value, codec, size);
+    }
+    void disposeByteArray(uint8 *&value) const {
+        internal::ScopedLock lock(m_mutex);
+        m_encodingRef->disposeByteArray(value);
+    }
+    const IString *stringConstant(ConstantType value) const {
+        internal::ScopedLock lock(m_mutex);
+        return m_encodingRef->stringConstant(value);
+    }
+
+private:
+    IEncoding *m_encodingRef;
+    mutable internal::Mutex m_mutex;
+
+    VPVL2_DISABLE_COPY_AND_ASSIGN(SynchronizedEncoding)
+};
+
 }
 
 namespace vpvl2
@@ -631,6 +692,55 @@ namespace pmx
 {
 
 struct Model::PrivateContext {
+    enum MorphTouchedMark {
+        kMorphTouchedThisFrame = 0x1,
+        kMorphTouchedLastFrame = 0x2
+    };
+    static const int kVertexChunkSize = 4096;
+    static const int kIndexChunkSize = 65536;
+    static const int kMorphChunkSize = 32;
+    struct ParseTask {
+        enum Type {
+            kVertices,
+            kIndices,
+            kMorphs,
+            kTextures,
+            kMaterials,
+            kBones,
+            kLabels,
+            kRigidBodies,
+            kJoints,
+            kSoftBodies
+        };
+        ParseTask()
+            : contextRef(0),
+              infoRef(0),
+              ptr(0),
+              type(kVertices),
+              begin(0),
+              end(0)
+        {
+        }
+        ParseTask(PrivateContext *context, const Model::DataInfo *info, Type t, uint8 *p = 0, int b = 0, int e = 0)
+            : contextRef(context),
+              infoRef(info),
+              ptr(p),
+              type(t),
+              begin(b),
+              end(e)
+        {
+        }
+        void execute() const {
+            contextRef->executeParseTask(*this);
+            contextRef->reportParseTaskFinished();
+        }
+        PrivateContext *contextRef;
+        const Model::DataInfo *infoRef;
+        uint8 *ptr;
+        Type type;
+        int begin;
+        int end;
+    };
     PrivateContext(IEncoding *encoding, Model *self)
         : encodingRef(encoding),
           selfRef(self),
@@ -638,6 +748,11 @@ struct Model::PrivateContext {
           parentModelRef(0),
           parentBoneRef(0),
           progressReporterRef(0),
+          structureRevision(0),
+          mappedData(0),
+          mappedIndicesPtr(0),
+          mappedIndexSize(0),
+          numMappedIndices(0),
           namePtr(0),
           englishNamePtr(0),
           commentPtr(0),
@@ -652,7 +767,14 @@ struct Model::PrivateContext {
           scaleFactor(1),
           edgeWidth(0),
           visible(false),
-          enablePhysics(false)
+          enablePhysics(false),
+          morphUpdateSerial(0),
+          enablePackedVertexStore(true),
+          dirtyPackedVertexStore(true),
+          resetAllMorphTouchedVertices(true),
+          numParseTasks(0),
+          numFinishedParseTasks(0),
+          enableParallelLoad(true)
     {
         internal::zerofill(&dataInfo, sizeof(dataInfo));
         dataInfo.encoding = encodingRef;
@@ -671,6 +793,15 @@ struct Model::PrivateContext {
         joints.releaseAll();
         rigidBodies.releaseAll();
         bones.releaseAll();
+        indices.clear();
+        releaseMappedData();
+        vertexStore.release();
+        dirtyPackedVertexStore = true;
+        morphTouchedVertices.clear();
+        lastMorphTouchedVertices.clear();
+        morphAffectedVertices.clear();
+        morphTouchedMarks.clear();
+        resetAllMorphTouchedVertices = true;
         internal::zerofill(&dataInfo, sizeof(dataInfo));
         dataInfo.encoding = encodingRef;
         dataInfo.version = 2.0f;
@@ -697,28 +828,49 @@ struct Model::PrivateContext {
         internal::setStringDirect(encodingRef->toString(info.commentPtr, info.commentSize, info.codec), commentPtr);
         internal::setStringDirect(encodingRef->toString(info.englishCommentPtr, info.englishCommentSize, info.codec), englishCommentPtr);
     }
-    void parseVertices(const Model::DataInfo &info) {
-        const int nvertices = int(info.verticesCount);
-        uint8 *ptr = info.verticesPtr;
+    void releaseMappedData() {
+        mappedIndicesPtr = 0;
+        mappedIndexSize = 0;
+        numMappedIndices = 0;
+        internal::deleteObject(mappedData);
+    }
+    int countIndices() const {
+        return mappedIndicesPtr ? numMappedIndices : indices.count();
+    }
+    int indexAt(int i) const {
+        if (mappedIndicesPtr) {
+            uint8 *ptr = const_cast<uint8 *>(mappedIndicesPtr) + i * mappedIndexSize;
+            const int index = internal::readUnsignedIndex(ptr, mappedIndexSize);
+            return internal::checkBound(index, 0, vertices.count()) ? index : 0;
+        }
+        return indices[i];
+    }
+    /* decodes indices from the mapping once they are requested as an array or edited */
+    void materializeIndices() const {
+        if (mappedIndicesPtr) {
+            const int nindices = numMappedIndices;
+            indices.resize(nindices);
+            for (int i = 0; i < nindices; i++) {
+                indices[i] = indexAt(i);
+            }
+            mappedIndicesPtr = 0;
+            numMappedIndices = 0;
+        }
+    }
+    void parseVertices(const Model::DataInfo &info, int begin, int end, uint8 *ptr) {
         vsize size;
-        for (int i = 0; i < nvertices; i++) {
-            Vertex *vertex = vertices.append(new Vertex(selfRef));
-            vertex->read(ptr, info, size);
+        for (int i = begin; i < end; i++) {
+            vertices[i]->read(ptr, info, size);
             ptr += size;
         }
     }
-    void parseIndices(const Model::DataInfo &info) {
-        const int nindices = int(info.indicesCount), nvertices = int(info.verticesCount);
-        uint8 *ptr = info.indicesPtr;
+    void parseIndices(const Model::DataInfo &info, int begin, int end) {
+        const int nvertices = int(info.verticesCount);
         vsize size = info.vertexIndexSize;
-        for (int i = 0; i < nindices; i++) {
+        uint8 *ptr = info.indicesPtr + begin * size;
+        for (int i = begin; i < end; i++) {
             int index = internal::readUnsignedIndex(ptr, size);
-            if (internal::checkBound(index, 0, nvertices)) {
-                indices.append(index);
-            }
-            else {
-                indices.append(0);
-            }
+            indices[i] = internal::checkBound(index, 0, nvertices) ? index : 0;
         }
     }
     void parseTextures(const Model::DataInfo &info) {
@@ -727,30 +879,38 @@ struct Model::PrivateContext {
         uint8 *ptr = info.texturesPtr;
         uint8 *texturePtr = 0;
         int size;
+        textures.reserve(ntextures);
         for (int i = 0; i < ntextures; i++) {
             internal::getText(ptr, rest, texturePtr, size);
-            IString *value = encodingRef->toString(texturePtr, size, info.codec);
+            IString *value = info.encoding->toString(texturePtr, size, info.codec);
             const HashString &key = value->toHashString();
             name2textureRefs.insert(key, value);
             textures.append(value);
         }
     }
     void parseMaterials(const Model::DataInfo &info) {
-        const int nmaterials = int(info.materialsCount), nindices = indices.count();
-        int offset = 0;
+        const int nmaterials = int(info.materialsCount);
         uint8 *ptr = info.materialsPtr;
         vsize size;
+        materials.reserve(nmaterials);
         for (int i = 0; i < nmaterials; i++) {
             Material *material = materials.append(new Material(selfRef));
             material->read(ptr, info, size);
             ptr += size;
+        }
+    }
+    void linkMaterialIndexRanges() {
+        const int nmaterials = materials.count(), nindices = countIndices();
+        int offset = 0;
+        for (int i = 0; i < nmaterials; i++) {
+            Material *material = materials[i];
             IMaterial::IndexRange range = material->indexRange();
             int offsetTo = offset + range.count;
             if (offset < offsetTo && offsetTo <= nindices) {
                 range.start = nindices;
                 range.end = 0;
                 for (int j = offset; j < offsetTo; j++) {
-                    const int index = indices.at(j);
+                    const int index = indexAt(j);
                     IVertex *vertex = vertices[index];
                     vertex->setMaterialRef(material);
                     btSetMin(range.start, index);
@@ -768,6 +928,7 @@ struct Model::PrivateContext {
         const int nbones = int(info.bonesCount);
         uint8 *ptr = info.bonesPtr;
         vsize size;
+        bones.reserve(nbones);
         for (int i = 0; i < nbones; i++) {
             Bone *bone = bones.append(new Bone(selfRef));
             bone->read(ptr, info, size);
@@ -776,22 +937,26 @@ struct Model::PrivateContext {
             ptr += size;
         }
     }
-    void parseMorphs(const Model::DataInfo &info) {
-        const int nmorphs = int(info.morphsCount);
-        uint8 *ptr = info.morphsPtr;
+    void parseMorphs(const Model::DataInfo &info, int begin, int end, uint8 *ptr) {
         vsize size;
-        for(int i = 0; i < nmorphs; i++) {
-            Morph *morph = morphs.append(new Morph(selfRef));
-            morph->read(ptr, info, size);
+        for (int i = begin; i < end; i++) {
+            morphs[i]->read(ptr, info, size);
+            ptr += size;
+        }
+    }
+    void registerMorphNames() {
+        const int nmorphs = morphs.count();
+        for (int i = 0; i < nmorphs; i++) {
+            Morph *morph = morphs[i];
             name2morphRefs.insert(morph->name(IEncoding::kJapanese)->toHashString(), morph);
             name2morphRefs.insert(morph->name(IEncoding::kEnglish)->toHashString(), morph);
-            ptr += size;
         }
     }
     void parseLabels(const Model::DataInfo &info) {
         const int nlabels = int(info.labelsCount);
         uint8 *ptr = info.labelsPtr;
         vsize size;
+        labels.reserve(nlabels);
         for(int i = 0; i < nlabels; i++) {
             Label *label = labels.append(new Label(selfRef));
             label->read(ptr, info, size);
@@ -802,6 +967,7 @@ struct Model::PrivateContext {
         const int numRigidBodies = int(info.rigidBodiesCount);
         uint8 *ptr = info.rigidBodiesPtr;
         vsize size;
+        rigidBodies.reserve(numRigidBodies);
         for(int i = 0; i < numRigidBodies; i++) {
             RigidBody *rigidBody = rigidBodies.append(new RigidBody(selfRef, encodingRef));
             rigidBody->read(ptr, info, size);
@@ -812,6 +978,7 @@ struct Model::PrivateContext {
         const int njoints = int(info.jointsCount);
         uint8 *ptr = info.jointsPtr;
         vsize size;
+        joints.reserve(njoints);
         for(int i = 0; i < njoints; i++) {
             Joint *joint = joints.append(new Joint(selfRef));
             joint->read(ptr, info, size);
@@ -830,6 +997,238 @@ struct Model::PrivateContext {
             }
         }
     }
+    void executeParseTask(const ParseTask &task) {
+        const Model::DataInfo &info = *task.infoRef;
+        switch (task.type) {
+        case ParseTask::kVertices:
+            parseVertices(info, task.begin, task.end, task.ptr);
+            break;
+        case ParseTask::kIndices:
+            parseIndices(info, task.begin, task.end);
+            break;
+        case ParseTask::kMorphs:
+            parseMorphs(info, task.begin, task.end, task.ptr);
+            break;
+        case ParseTask::kTextures:
+            parseTextures(info);
+            break;
+        case ParseTask::kMaterials:
+            parseMaterials(info);
+            break;
+        case ParseTask::kBones:
+            parseBones(info);
+            break;
+        case ParseTask::kLabels:
+            parseLabels(info);
+            break;
+        case ParseTask::kRigidBodies:
+            parseRigidBodies(info);
+            break;
+        case ParseTask::kJoints:
+            parseJoints(info);
+            break;
+        case ParseTask::kSoftBodies:
+            parseSoftBodies(info);
+            break;
+        default:
+            break;
+        }
+    }
+    /*
+     * reports steps 3 to 11 (of 15 in Model#load) as parse tasks finish. tasks run concurrently so
+     * reporting is serialized, and every step is reported once in order even if tasks are fewer than steps.
+     */
+    void reportParseTaskFinished() {
+        static const int kFirstStep = 2, kNumSteps = 9, kNumTotalSteps = 15;
+        if (progressReporterRef && numParseTasks > 0) {
+            internal::ScopedLock lock(parseProgressMutex);
+            const int lastStep = kNumSteps * numFinishedParseTasks / numParseTasks;
+            numFinishedParseTasks++;
+            const int step = kNumSteps * numFinishedParseTasks / numParseTasks;
+            for (int i = lastStep + 1; i <= step; i++) {
+                reportProgress(float(kFirstStep + i) / kNumTotalSteps);
+            }
+        }
+    }
+    void appendChunkTasks(ParseTask::Type type, const Array<uint8 *> &chunkPtrs, int chunkSize, int count,
+                          const Model::DataInfo *info, Array<ParseTask> &tasks) {
+        const int nchunks = chunkPtrs.count();
+        for (int i = 0; i < nchunks; i++) {
+            const int begin = i * chunkSize;
+            tasks.append(ParseTask(this, info, type, chunkPtrs[i], begin, btMin(begin + chunkSize, count)));
+        }
+    }
+    void parseSections(const Model::DataInfo &info) {
+        /*
+         * sections are independent until linking so parse them concurrently. vertices and morphs
+         * are created in advance to parse them by chunks found at preparse.
+         */
+        const int nvertices = int(info.verticesCount), nindices = int(info.indicesCount), nmorphs = int(info.morphsCount);
+        SynchronizedEncoding encoding(info.encoding);
+        Model::DataInfo parallelInfo = info;
+        parallelInfo.encoding = &encoding;
+        vertices.reserve(nvertices);
+        for (int i = 0; i < nvertices; i++) {
+            vertices.append(new Vertex(selfRef));
+        }
+        if (mappedData) {
+            /* indices are read from the mapping by indexAt instead of parsing them */
+            mappedIndicesPtr = info.indicesPtr;
+            mappedIndexSize = info.vertexIndexSize;
+            numMappedIndices = nindices;
+        }
+        else {
+            indices.resize(nindices);
+        }
+        morphs.reserve(nmorphs);
+        for (int i = 0; i < nmorphs; i++) {
+            morphs.append(new Morph(selfRef));
+        }
+        Array<ParseTask> tasks;
+        appendChunkTasks(ParseTask::kVertices, vertexChunkPtrs, kVertexChunkSize, nvertices, &parallelInfo, tasks);
+        appendChunkTasks(ParseTask::kMorphs, morphChunkPtrs, kMorphChunkSize, nmorphs, &parallelInfo, tasks);
+        for (int i = 0; !mappedData && i < nindices; i += kIndexChunkSize) {
+            tasks.append(ParseTask(this, &parallelInfo, ParseTask::kIndices, 0, i, btMin(i + kIndexChunkSize, nindices)));
+        }
+        tasks.append(ParseTask(this, &parallelInfo, ParseTask::kTextures));
+        tasks.append(ParseTask(this, &parallelInfo, ParseTask::kMaterials));
+        tasks.append(ParseTask(this, &parallelInfo, ParseTask::kBones));
+        tasks.append(ParseTask(this, &parallelInfo, ParseTask::kLabels));
+        tasks.append(ParseTask(this, &parallelInfo, ParseTask::kRigidBodies));
+        tasks.append(ParseTask(this, &parallelInfo, ParseTask::kJoints));
+        tasks.append(ParseTask(this, &parallelInfo, ParseTask::kSoftBodies));
+        numParseTasks = tasks.count();
+        numFinishedParseTasks = 0;
+        internal::ParallelExecuteTaskProcessor<ParseTask> processor(&tasks);
+        processor.execute(enableParallelLoad);
+        numParseTasks = 0;
+        vertexChunkPtrs.clear();
+        morphChunkPtrs.clear();
+        registerMorphNames();
+        linkMaterialIndexRanges();
+    }
+    void collectMorphTargets(Array<int> &value) const {
+        const int nvertices = vertices.count(), nmorphs = morphs.count();
+        Array<uint8> targets;
+        targets.resize(nvertices);
+        internal::zerofill(&targets[0], nvertices);
+        for (int i = 0; i < nmorphs; i++) {
+            const Morph *morph = morphs[i];
+            switch (morph->type()) {
+            case IMorph::kVertexMorph: {
+                const Array<Morph::Vertex *> &children = morph->vertices();
+                const int nchildren = children.count();
+                for (int j = 0; j < nchildren; j++) {
+                    if (const IVertex *vertex = children[j]->vertex) {
+                        const int index = vertex->index();
+                        if (internal::checkBound(index, 0, nvertices)) {
+                            targets[index] = 1;
+                        }
+                    }
+                }
+                break;
+            }
+            case IMorph::kTexCoordMorph:
+            case IMorph::kUVA1Morph:
+            case IMorph::kUVA2Morph:
+            case IMorph::kUVA3Morph:
+            case IMorph::kUVA4Morph: {
+                const Array<Morph::UV *> &children = morph->uvs();
+                const int nchildren = children.count();
+                for (int j = 0; j < nchildren; j++) {
+                    if (const IVertex *vertex = children[j]->vertex) {
+                        const int index = vertex->index();
+                        if (internal::checkBound(index, 0, nvertices)) {
+                            targets[index] = 1;
+                        }
+                    }
+                }
+                break;
+            }
+            default:
+                break;
+            }
+        }
+        for (int i = 0; i < nvertices; i++) {
+            if (targets[i]) {
+                value.append(i);
+            }
+        }
+    }
+    void buildPackedVertexStore() {
+        Array<int> morphTargets;
+        if (vertices.count() > 0) {
+            collectMorphTargets(morphTargets);
+        }
+        vertexStore.build(vertices, bones, materials, morphTargets);
+        dirtyPackedVertexStore = false;
+    }
+    void resetMorphTouchedVertices() {
+        const int nvertices = vertices.count();
+        lastMorphTouchedVertices.clear();
+        if (resetAllMorphTouchedVertices || morphTouchedMarks.count() != nvertices) {
+            internal::ParallelResetVertexProcessor<pmx::Vertex> processor(&vertices);
+            processor.execute();
+            morphTouchedVertices.clear();
+            morphTouchedMarks.resize(nvertices);
+            if (nvertices > 0) {
+                internal::zerofill(&morphTouchedMarks[0], nvertices);
+            }
+            resetAllMorphTouchedVertices = false;
+            /* all vertices are reported as touched at this frame */
+            morphAffectedVertices.resize(nvertices);
+            for (int i = 0; i < nvertices; i++) {
+                morphAffectedVertices[i] = i;
+            }
+            return;
+        }
+        /* vertices touched at the previous frame become the reset targets of this frame */
+        const int ntouched = morphTouchedVertices.count();
+        for (int i = 0; i < ntouched; i++) {
+            const int index = morphTouchedVertices[i];
+            morphTouchedMarks[index] = kMorphTouchedLastFrame;
+            lastMorphTouchedVertices.append(index);
+        }
+        morphTouchedVertices.clear();
+        morphAffectedVertices.clear();
+        internal::ParallelResetVertexProcessor<pmx::Vertex> processor(&vertices, &lastMorphTouchedVertices);
+        processor.execute();
+    }
+    void touchVertexByMorph(int index) {
+        if (internal::checkBound(index, 0, morphTouchedMarks.count())) {
+            uint8 &mark = morphTouchedMarks[index];
+            if ((mark & kMorphTouchedThisFrame) == 0) {
+                mark |= kMorphTouchedThisFrame;
+                morphTouchedVertices.append(index);
+            }
+        }
+    }
+    void collectMorphAffectedVertices() {
+        if (morphAffectedVertices.count() == 0) {
+            /* union of vertices reset from the previous frame and vertices accumulated at this frame */
+            const int nlast = lastMorphTouchedVertices.count();
+            for (int i = 0; i < nlast; i++) {
+                const int index = lastMorphTouchedVertices[i];
+                morphAffectedVertices.append(index);
+                morphTouchedMarks[index] &= ~kMorphTouchedLastFrame;
+            }
+            const int ntouched = morphTouchedVertices.count();
+            for (int i = 0; i < ntouched; i++) {
+                const int index = morphTouchedVertices[i];
+                if (morphTouchedMarks[index] == kMorphTouchedThisFrame) {
+                    morphAffectedVertices.append(index);
+                }
+            }
+            morphAffectedVertices.sort(internal::ModelHelper::IndexPredication());
+        }
+        else {
+            const int nlast = lastMorphTouchedVertices.count();
+            for (int i = 0; i < nlast; i++) {
+                morphTouchedMarks[lastMorphTouchedVertices[i]] &= ~kMorphTouchedLastFrame;
+            }
+        }
+        morphUpdateSerial++;
+    }
     void assignIndexSize(Model::DataInfo &info) const {
         info.boneIndexSize = Flags::estimateSize(bones.count());
         info.materialIndexSize = Flags::estimateSize(materials.count());
@@ -858,8 +1257,13 @@ struct Model::PrivateContext {
     IModel *parentModelRef;
     IBone *parentBoneRef;
     IProgressReporter *progressReporterRef;
+    int structureRevision;
     PointerArray<Vertex> vertices;
-    Array<int> indices;
+    mutable Array<int> indices;
+    Model::MappedData *mappedData;
+    mutable const uint8 *mappedIndicesPtr;
+    vsize mappedIndexSize;
+    mutable int numMappedIndices;
     PointerArray<IString> textures;
     Hash<HashString, IString *> name2textureRefs;
     PointerArray<Material> materials;
@@ -887,8 +1291,23 @@ struct Model::PrivateContext {
     Scalar scaleFactor;
     IVertex::EdgeSizePrecision edgeWidth;
     DataInfo dataInfo;
+    internal::PackedVertexStore vertexStore;
+    Array<int> morphTouchedVertices;
+    Array<int> lastMorphTouchedVertices;
+    Array<int> morphAffectedVertices;
+    Array<uint8> morphTouchedMarks;
+    int morphUpdateSerial;
     bool visible;
     bool enablePhysics;
+    bool enablePackedVertexStore;
+    bool dirtyPackedVertexStore;
+    bool resetAllMorphTouchedVertices;
+    Array<uint8 *> vertexChunkPtrs;
+    Array<uint8 *> morphChunkPtrs;
+    internal::Mutex parseProgressMutex;
+    int numParseTasks;
+    int numFinishedParseTasks;
+    bool enableParallelLoad;
 };
 
 Model::Model(IEncoding *encoding)
@@ -903,6 +1322,19 @@ Model::~Model()
 }
 
 bool Model::load(const uint8 *data, vsize size)
+{
+    return load(data, size, 0);
+}
+
+bool Model::loadMapped(MappedData *data)
+{
+    if (data) {
+        return load(data->address(), data->size(), data);
+    }
+    return false;
+}
+
+bool Model::load(const uint8 *data, vsize size, MappedData *mappedData)
 {
     DataInfo info;
     internal::zerofill(&info, sizeof(info));
@@ -910,30 +1342,14 @@ bool Model::load(const uint8 *data, vsize size)
 #define VPVL2_CALCULATE_PROGRESS_PERCENTAGE(value) (value / 15.0)
         m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(1));
         m_context->release();
+        m_context->mappedData = mappedData;
         m_context->parseNamesAndComments(info);
         m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(2));
-        m_context->parseVertices(info);
-        m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(3));
-        m_context->parseIndices(info);
-        m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(4));
-        m_context->parseTextures(info);
-        m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(5));
-        m_context->parseMaterials(info);
-        m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(6));
-        m_context->parseBones(info);
-        m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(7));
-        m_context->parseMorphs(info);
-        m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(8));
-        m_context->parseLabels(info);
-        m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(9));
-        m_context->parseRigidBodies(info);
-        m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(10));
-        m_context->parseJoints(info);
-        m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(11));
-        m_context->parseSoftBodies(info);
+        /* steps 3 to 11 are reported by parse tasks of the sections */
+        m_context->parseSections(info);
         m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(12));
         if (!Bone::loadBones(m_context->bones)
-                || !Material::loadMaterials(m_context->materials, m_context->textures, m_context->indices.count())
+                || !Material::loadMaterials(m_context->materials, m_context->textures, m_context->countIndices())
                 || !Vertex::loadVertices(m_context->vertices, m_context->bones)
                 || !Morph::loadMorphs(m_context->morphs, m_context->bones, m_context->materials, m_context->rigidBodies, m_context->vertices)
                 || !Label::loadLabels(m_context->labels, m_context->bones, m_context->morphs)
@@ -945,6 +1361,7 @@ bool Model::load(const uint8 *data, vsize size)
         }
         m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(13));
         Bone::sortBones(m_context->bones, m_context->bonesBeforePhysics, m_context->bonesAfterPhysics);
+        m_context->buildPackedVertexStore();
         m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(14));
         performUpdate();
         m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(15));
@@ -954,6 +1371,7 @@ bool Model::load(const uint8 *data, vsize size)
     }
     else {
         m_context->dataInfo.error = info.error;
+        internal::deleteObject(mappedData);
     }
     return false;
 }
@@ -982,10 +1400,10 @@ void Model::save(uint8 *data, vsize &written) const
     internal::writeString(m_context->commentPtr, encodingRef, codec, data);
     internal::writeString(m_context->englishCommentPtr, encodingRef, codec, data);
     Vertex::writeVertices(m_context->vertices, info, data);
-    const int nindices = m_context->indices.count();
+    const int nindices = m_context->countIndices();
     internal::writeBytes(&nindices, sizeof(nindices), data);
     for (int i = 0; i < nindices; i++) {
-        const int index = m_context->indices[i];
+        const int index = m_context->indexAt(i);
         internal::writeSignedIndex(index, flags.vertexIndexSize, data);
     }
     const int ntextures = m_context->textures.count();
@@ -1019,7 +1437,7 @@ vsize Model::estimateSize() const
     size += internal::estimateSize(m_context->commentPtr, encodingRef, codec);
     size += internal::estimateSize(m_context->englishCommentPtr, encodingRef, codec);
     size += Vertex::estimateTotalSize(m_context->vertices, info);
-    const int nindices = m_context->indices.count();
+    const int nindices = m_context->countIndices();
     size += sizeof(nindices);
     size += info.vertexIndexSize * nindices;
     const int ntextures = m_context->textures.count();
@@ -1109,8 +1527,7 @@ void Model::performUpdate()
         Material *material = m_context->materials[i];
         material->reset();
     }
-    internal::ParallelResetVertexProcessor<pmx::Vertex> processor(&m_context->vertices);
-    processor.execute();
+    m_context->resetMorphTouchedVertices();
     const int nmorphs = m_context->morphs.count();
     for (int i = 0; i < nmorphs; i++) {
         Morph *morph = m_context->morphs[i];
@@ -1118,8 +1535,15 @@ void Model::performUpdate()
     }
     for (int i = 0; i < nmorphs; i++) {
         Morph *morph = m_context->morphs[i];
-        morph->update();
+        /*
+         * morphs in group morph are updated through the parent group morph at every frame, updating them
+         * here again merges vertex/UV deltas twice or with the weight of the previous frame
+         */
+        if (!morph->hasParent()) {
+            morph->update();
+        }
     }
+    m_context->collectMorphAffectedVertices();
     // before physics simulation
     updateLocalTransform(m_context->bonesBeforePhysics);
     if (m_context->enablePhysics) {
@@ -1169,7 +1593,7 @@ int Model::count(ObjectType value) const
         return nIK;
     }
     case kIndex: {
-        return m_context->indices.count();
+        return m_context->countIndices();
     }
     case kJoint: {
         return m_context->joints.count();
@@ -1238,7 +1662,11 @@ void Model::getVertexRefs(Array<IVertex *> &value) const
 
 void Model::getIndices(Array<int> &value) const
 {
-    value.copy(m_context->indices);
+    const int nindices = m_context->countIndices();
+    value.resize(nindices);
+    for (int i = 0; i < nindices; i++) {
+        value[i] = m_context->indexAt(i);
+    }
 }
 
 void Model::getIKConstraintRefs(Array<IBone::IKConstraint *> &value) const
@@ -1341,7 +1769,9 @@ bool Model::preparse(const uint8 *data, vsize size, DataInfo &info)
     VPVL2_VLOG(1, "PMXComment(English): ptr=" << static_cast<const void*>(info.englishCommentPtr) << " size=" << info.englishCommentSize);
 
     /* vertex */
-    if (!Vertex::preparse(ptr, rest, info)) {
+    m_context->vertexChunkPtrs.clear();
+    m_context->morphChunkPtrs.clear();
+    if (!Vertex::preparse(ptr, rest, info, &m_context->vertexChunkPtrs, PrivateContext::kVertexChunkSize)) {
         m_context->dataInfo.error = kInvalidVerticesError;
         return false;
     }
@@ -1392,7 +1822,7 @@ bool Model::preparse(const uint8 *data, vsize size, DataInfo &info)
     VPVL2_VLOG(1, "PMXBones: ptr=" << static_cast<const void*>(info.bonesPtr) << " size=" << info.bonesCount);
 
     /* morph */
-    if (!Morph::preparse(ptr, rest, info)) {
+    if (!Morph::preparse(ptr, rest, info, &m_context->morphChunkPtrs, PrivateContext::kMorphChunkSize)) {
         m_context->dataInfo.error = kInvalidMorphsError;
         return false;
     }
@@ -1460,9 +1890,15 @@ const Array<Vertex *> &Model::vertices() const
 
 const Array<int> &Model::indices() const
 {
+    m_context->materializeIndices();
     return m_context->indices;
 }
 
+int Model::indexAt(int value) const
+{
+    return internal::checkBound(value, 0, m_context->countIndices()) ? m_context->indexAt(value) : 0;
+}
+
 const Hash<HashString, IString *> &Model::textures() const
 {
     return m_context->name2textureRefs;
@@ -1592,6 +2028,7 @@ IBone *Model::parentBoneRef() const
 void Model::setName(const IString *value, IEncoding::LanguageType type)
 {
     internal::ModelHelper::setName(value, m_context->namePtr, m_context->englishNamePtr, type);
+    m_context->structureRevision++;
 }
 
 void Model::setComment(const IString *value, IEncoding::LanguageType type)
@@ -1668,7 +2105,7 @@ void Model::updateLocalTransform(Array<Bone *> &bones)
 void Model::getIndexBuffer(IndexBuffer *&indexBuffer) const
 {
     internal::deleteObject(indexBuffer);
-    indexBuffer = new DefaultIndexBuffer(m_context->indices, m_context->vertices.count());
+    indexBuffer = new DefaultIndexBuffer(this, m_context->vertices.count());
 }
 
 void Model::getStaticVertexBuffer(StaticVertexBuffer *&staticBuffer) const
@@ -1717,6 +2154,66 @@ void Model::getAabb(Vector3 &min, Vector3 &max) const
     max = m_context->aabbMax;
 }
 
+internal::PackedVertexStore *Model::packedVertexStoreRef() const
+{
+    if (!m_context->enablePackedVertexStore) {
+        return 0;
+    }
+    if (m_context->dirtyPackedVertexStore) {
+        m_context->buildPackedVertexStore();
+    }
+    return &m_context->vertexStore;
+}
+
+bool Model::isPackedVertexStoreEnabled() const
+{
+    return m_context->enablePackedVertexStore;
+}
+
+void Model::setPackedVertexStoreEnable(bool value)
+{
+    m_context->enablePackedVertexStore = value;
+}
+
+void Model::invalidatePackedVertexStore()
+{
+    m_context->dirtyPackedVertexStore = true;
+    /* edited vertices may not be touched by morphs so all vertices are reported at the next update */
+    m_context->resetAllMorphTouchedVertices = true;
+}
+
+const Array<int> &Model::morphTouchedVertexIndices() const
+{
+    return m_context->morphAffectedVertices;
+}
+
+int Model::numMorphTouchedVertices() const
+{
+    return m_context->morphAffectedVertices.count();
+}
+
+int Model::morphUpdateSerial() const
+{
+    return m_context->morphUpdateSerial;
+}
+
+void Model::touchVertexByMorph(const IVertex *value)
+{
+    if (value && value->parentModelRef() == this) {
+        m_context->touchVertexByMorph(value->index());
+    }
+}
+
+bool Model::isParallelLoadEnabled() const
+{
+    return m_context->enableParallelLoad;
+}
+
+void Model::setParallelLoadEnable(bool value)
+{
+    m_context->enableParallelLoad = value;
+}
+
 float32 Model::version() const
 {
     return m_context->dataInfo.version;
@@ -1835,6 +2332,9 @@ void Model::setIndices(const Array<int> &value)
 {
     const int nindices = value.count();
     const int nvertices = m_context->vertices.count();
+    /* the mapping is kept until the next load because it's not referred any more */
+    m_context->mappedIndicesPtr = 0;
+    m_context->numMappedIndices = 0;
     m_context->indices.clear();
     for (int i = 0; i < nindices; i++) {
         int index = value[i];
@@ -1850,6 +2350,7 @@ void Model::setIndices(const Array<int> &value)
 void Model::addBone(IBone *value)
 {
     internal::ModelHelper::addObject(this, value, m_context->bones);
+    invalidatePackedVertexStore();
     if (value) {
         if (const IString *name = value->name(IEncoding::kJapanese)) {
             m_context->name2boneRefs.insert(name->toHashString(), value);
@@ -1874,11 +2375,13 @@ void Model::addLabel(ILabel *value)
 void Model::addMaterial(IMaterial *value)
 {
     internal::ModelHelper::addObject(this, value, m_context->materials);
+    invalidatePackedVertexStore();
 }
 
 void Model::addMorph(IMorph *value)
 {
     internal::ModelHelper::addObject(this, value, m_context->morphs);
+    invalidatePackedVertexStore();
     if (value) {
         if (const IString *name = value->name(IEncoding::kJapanese)) {
             m_context->name2morphRefs.insert(name->toHashString(), value);
@@ -1902,11 +2405,13 @@ void Model::addSoftBody(ISoftBody *value)
 void Model::addVertex(IVertex *value)
 {
     internal::ModelHelper::addObject(this, value, m_context->vertices);
+    invalidatePackedVertexStore();
 }
 
 void Model::removeBone(IBone *value)
 {
     internal::ModelHelper::removeObject(this, value, m_context->bones);
+    invalidatePackedVertexStore();
     internal::ModelHelper::removeBoneReferenceInBones(value, m_context->bones);
     internal::ModelHelper::removeBoneReferenceInRigidBodies(value, m_context->rigidBodies);
     internal::ModelHelper::removeBoneReferenceInVertices(value, m_context->vertices);
@@ -1942,6 +2447,7 @@ void Model::removeLabel(ILabel *value)
 void Model::removeMaterial(IMaterial *value)
 {
     internal::ModelHelper::removeObject(this, value, m_context->materials);
+    invalidatePackedVertexStore();
     internal::ModelHelper::removeMaterialReferenceInVertices(value, m_context->vertices);
     const int nmorphs = m_context->morphs.count();
     for (int i = 0; i < nmorphs; i++) {
@@ -1965,8 +2471,22 @@ void Model::removeMaterial(IMaterial *value)
 void Model::removeMorph(IMorph *value)
 {
     internal::ModelHelper::removeObject(this, value, m_context->morphs);
+    invalidatePackedVertexStore();
     if (value) {
         removeMorphHash(value);
+        if (value->parentModelRef() == this) {
+            Morph *morph = static_cast<Morph *>(value);
+            morph->setParentMorphRef(0);
+            /* children of the removed group morph are updated by the model again */
+            const Array<Morph::Group *> &children = morph->groups();
+            const int nchildren = children.count();
+            for (int i = 0; i < nchildren; i++) {
+                Morph *child = static_cast<Morph *>(children[i]->morph);
+                if (child && child != morph) {
+                    child->setParentMorphRef(0);
+                }
+            }
+        }
     }
     const int nmorphs = m_context->morphs.count();
     for (int i = 0; i < nmorphs; i++) {
@@ -2028,6 +2548,7 @@ void Model::removeSoftBody(ISoftBody *value)
 void Model::removeVertex(IVertex *value)
 {
     internal::ModelHelper::removeObject(this, value, m_context->vertices);
+    invalidatePackedVertexStore();
     const int nmorphs = m_context->morphs.count();
     for (int i = 0; i < nmorphs; i++) {
         Morph *morph = m_context->morphs[i];
@@ -2065,6 +2586,11 @@ void Model::removeVertex(IVertex *value)
     }
 }
 
+int Model::structureRevision() const
+{
+    return m_context->structureRevision;
+}
+
 IProgressReporter *Model::progressReporterRef() const
 {
     return m_context->progressReporterRef;
@@ -2078,6 +2604,7 @@ void Model::setProgressReporterRef(IProgressReporter *value)
 void Model::addBoneHash(Bone *bone)
 {
     VPVL2_DCHECK(bone);
+    m_context->structureRevision++;
     if (const IString *name = bone->name(IEncoding::kJapanese)) {
         m_context->name2boneRefs.insert(name->toHashString(), bone);
     }
@@ -2089,6 +2616,7 @@ void Model::addBoneHash(Bone *bone)
 void Model::removeBoneHash(const IBone *bone)
 {
     VPVL2_DCHECK(bone);
+    m_context->structureRevision++;
     if (const IString *name = bone->name(IEncoding::kJapanese)) {
         m_context->name2boneRefs.remove(name->toHashString());
     }
@@ -2100,6 +2628,7 @@ void Model::removeBoneHash(const IBone *bone)
 void Model::addMorphHash(Morph *morph)
 {
     VPVL2_DCHECK(morph);
+    m_context->structureRevision++;
     if (const IString *name = morph->name(IEncoding::kJapanese)) {
         m_context->name2morphRefs.insert(name->toHashString(), morph);
     }
@@ -2111,6 +2640,7 @@ void Model::addMorphHash(Morph *morph)
 void Model::removeMorphHash(const IMorph *morph)
 {
     VPVL2_DCHECK(morph);
+    m_context->structureRevision++;
     if (const IString *name = morph->name(IEncoding::kJapanese)) {
         m_context->name2morphRefs.remove(name->toHashString());
     }
@@ -100,6 +100,20 @@ struct ImpulseMorph {
 
 #pragma pack(pop)
 
+static inline bool isUVMorph(IMorph::Type type)
+{
+    switch (type) {
+    case IMorph::kTexCoordMorph:
+    case IMorph::kUVA1Morph:
+    case IMorph::kUVA2Morph:
+    case IMorph::kUVA3Morph:
+    case IMorph::kUVA4Morph:
+        return true;
+    default:
+        return false;
+    }
+}
+
 }
 
 namespace vpvl2
@@ -145,6 +159,11 @@ struct Morph::PrivateContext {
         dirty = false;
     }
 
+    void invalidatePackedVertexStore() {
+        if (parentModelRef) {
+            parentModelRef->invalidatePackedVertexStore();
+        }
+    }
     static bool loadBones(const Array<pmx::Bone *> &bones, Morph *morph) {
         const int nMorphBones = morph->m_context->bones.count();
         const int nbones = bones.count();
@@ -521,7 +540,7 @@ Morph::~Morph()
     internal::deleteObject(m_context);
 }
 
-bool Morph::preparse(uint8 *&ptr, vsize &rest, Model::DataInfo &info)
+bool Morph::preparse(uint8 *&ptr, vsize &rest, Model::DataInfo &info, Array<uint8 *> *chunkPtrs, int chunkSize)
 {
     int32 nmorphs = 0, size = 0;
     if (!internal::getTyped<int32>(ptr, rest, nmorphs)) {
@@ -531,6 +550,9 @@ bool Morph::preparse(uint8 *&ptr, vsize &rest, Model::DataInfo &info)
     info.morphsPtr = ptr;
     MorphUnit morph;
     for (int32 i = 0; i < nmorphs; i++) {
+        if (chunkPtrs && i % chunkSize == 0) {
+            chunkPtrs->append(ptr);
+        }
         uint8 *namePtr;
         /* name in Japanese */
         if (!internal::getText(ptr, rest, namePtr, size)) {
@@ -853,9 +875,13 @@ void Morph::update()
 {
     Type type = m_context->type;
     if (type == kVertexMorph && !m_context->parentMorphRef) {
-        /* force updating vertex morph except in group morph because vertices alway will be reset by IModel#performUpdate */
+        /* force updating vertex morph except in group morph because touched vertices will be reset by IModel#performUpdate */
         updateVertexMorphs(m_context->internalWeight);
     }
+    else if (isUVMorph(type) && !m_context->parentMorphRef) {
+        /* same as vertex morph because UV morph deltas are also reset by IModel#performUpdate */
+        updateUVMorphs(m_context->internalWeight);
+    }
     else if (type == kGroupMorph) {
         /* force updating group morph to update morph children correctly even weight is not changed (not dirty) */
         updateGroupMorphs(m_context->internalWeight, false);
@@ -896,6 +922,18 @@ void Morph::update()
 void Morph::markDirty()
 {
     m_context->dirty = true;
+    if (m_context->type == kGroupMorph) {
+        /* morphs in group morph are updated only through the group morph so they must be marked too */
+        const int nmorphs = m_context->groups.count();
+        for (int i = 0; i < nmorphs; i++) {
+            Group *v = m_context->groups[i];
+            if (Morph *morph = static_cast<Morph *>(v->morph)) {
+                if (morph != this) {
+                    morph->markDirty();
+                }
+            }
+        }
+    }
 }
 
 void Morph::syncWeight()
@@ -926,11 +964,19 @@ void Morph::syncWeight()
 
 void Morph::updateVertexMorphs(const WeightPrecision &value)
 {
+    /* zero weight morph doesn't change any vertices so skip to touch them */
+    if (value == 0) {
+        return;
+    }
     const int nmorphs = m_context->vertices.count();
+    Model *parentModelRef = m_context->parentModelRef;
     for (int i = 0; i < nmorphs; i++) {
         Vertex *v = m_context->vertices[i];
         if (pmx::Vertex *vertex = static_cast<pmx::Vertex *>(v->vertex)) {
             vertex->mergeMorph(v, value);
+            if (parentModelRef) {
+                parentModelRef->touchVertexByMorph(vertex);
+            }
         }
     }
 }
@@ -948,11 +994,18 @@ void Morph::updateBoneMorphs(const WeightPrecision &value)
 
 void Morph::updateUVMorphs(const WeightPrecision &value)
 {
+    if (value == 0) {
+        return;
+    }
     const int nmorphs = m_context->uvs.count();
+    Model *parentModelRef = m_context->parentModelRef;
     for (int i = 0; i < nmorphs; i++) {
         UV *v = m_context->uvs[i];
         if (pmx::Vertex *vertex = static_cast<pmx::Vertex *>(v->vertex)) {
             vertex->mergeMorph(v, value);
+            if (parentModelRef) {
+                parentModelRef->touchVertexByMorph(vertex);
+            }
         }
     }
 }
@@ -1116,15 +1169,21 @@ void Morph::removeBoneMorph(Bone *value)
 
 void Morph::addGroupMorph(Group *value)
 {
-    const IMorph *morphRef = value->morph;
+    IMorph *morphRef = value->morph;
     if (morphRef && morphRef->parentModelRef() == m_context->parentModelRef) {
         m_context->groups.append(value);
+        static_cast<Morph *>(morphRef)->setParentMorphRef(this);
     }
 }
 
 void Morph::removeGroupMorph(Group *value)
 {
     m_context->groups.remove(value);
+    if (Morph *morphRef = static_cast<Morph *>(value->morph)) {
+        if (morphRef->m_context->parentMorphRef == this) {
+            morphRef->setParentMorphRef(0);
+        }
+    }
 }
 
 void Morph::addMaterialMorph(Material *value)
@@ -1145,12 +1204,14 @@ void Morph::addUVMorph(UV *value)
     const IVertex *vertexRef = value->vertex;
     if (vertexRef && vertexRef->parentModelRef() == m_context->parentModelRef) {
         m_context->uvs.append(value);
+        m_context->invalidatePackedVertexStore();
     }
 }
 
 void Morph::removeUVMorph(UV *value)
 {
     m_context->uvs.remove(value);
+    m_context->invalidatePackedVertexStore();
 }
 
 void Morph::addVertexMorph(Vertex *value)
@@ -1158,12 +1219,14 @@ void Morph::addVertexMorph(Vertex *value)
     const IVertex *vertexRef = value->vertex;
     if (vertexRef && vertexRef->parentModelRef() == m_context->parentModelRef) {
         m_context->vertices.append(value);
+        m_context->invalidatePackedVertexStore();
     }
 }
 
 void Morph::removeVertexMorph(Vertex *value)
 {
     m_context->vertices.remove(value);
+    m_context->invalidatePackedVertexStore();
 }
 
 void Morph::addFlipMorph(Flip *value)
@@ -1212,6 +1275,11 @@ void Morph::setIndex(int value)
     m_context->index = value;
 }
 
+void Morph::setParentMorphRef(Morph *value)
+{
+    m_context->parentMorphRef = value;
+}
+
 void Morph::setInternalWeight(const WeightPrecision &value)
 {
     m_context->internalWeight = value;
@@ -39,6 +39,7 @@
 #include "vpvl2/internal/ModelHelper.h"
 
 #include "vpvl2/pmx/Bone.h"
+#include "vpvl2/pmx/Model.h"
 #include "vpvl2/pmx/Vertex.h"
 
 namespace
@@ -153,6 +154,12 @@ struct Vertex::PrivateContext {
     IVertex::WeightPrecision weight[kMaxBones];
     int boneIndices[kMaxBones];
     int index;
+
+    void invalidatePackedVertexStore() {
+        if (modelRef && modelRef->type() == IModel::kPMXModel) {
+            static_cast<Model *>(modelRef)->invalidatePackedVertexStore();
+        }
+    }
 };
 
 Vertex::Vertex(IModel *modelRef)
@@ -165,7 +172,7 @@ Vertex::~Vertex()
     internal::deleteObject(m_context);
 }
 
-bool Vertex::preparse(uint8 *&ptr, vsize &rest, Model::DataInfo &info)
+bool Vertex::preparse(uint8 *&ptr, vsize &rest, Model::DataInfo &info, Array<uint8 *> *chunkPtrs, int chunkSize)
 {
     int32 nvertices = 0;
     if (!internal::getTyped<int32>(ptr, rest, nvertices)) {
@@ -179,6 +186,9 @@ bool Vertex::preparse(uint8 *&ptr, vsize &rest, Model::DataInfo &info)
     info.verticesPtr = ptr;
     vsize baseSize = sizeof(VertexUnit) + sizeof(AdditinalUVUnit) * info.additionalUVSize;
     for (int i = 0; i < nvertices; i++) {
+        if (chunkPtrs && i % chunkSize == 0) {
+            chunkPtrs->append(ptr);
+        }
         if (!internal::validateSize(ptr, baseSize, rest)) {
             VPVL2_LOG(WARNING, "Invalid size of PMX base vertex unit detected: index=" << i << " ptr=" << static_cast<const void *>(ptr) << " rest=" << rest);
             return false;
@@ -547,7 +557,8 @@ void Vertex::performSkinning(Vector3 &position, Vector3 &normal) const
         }
         break;
     }
-    case kBdef4: {
+    case kBdef4:
+    case kQdef: {
         const Transform &transformA = m_context->boneRefs[0]->localTransform();
         const Transform &transformB = m_context->boneRefs[1]->localTransform();
         const Transform &transformC = m_context->boneRefs[2]->localTransform();
@@ -664,22 +675,26 @@ IMaterial *Vertex::materialRef() const
 void Vertex::setOrigin(const Vector3 &value)
 {
     m_context->origin = value;
+    m_context->invalidatePackedVertexStore();
 }
 
 void Vertex::setNormal(const Vector3 &value)
 {
     m_context->normal = value;
+    m_context->invalidatePackedVertexStore();
 }
 
 void Vertex::setTextureCoord(const Vector3 &value)
 {
     m_context->texcoord = value;
+    m_context->invalidatePackedVertexStore();
 }
 
 void Vertex::setOriginUV(int index, const Vector4 &value)
 {
     if (internal::checkBound(index, 0, kMaxBones - 1)) {
         m_context->originUVs[index + 1] = value;
+        m_context->invalidatePackedVertexStore();
     }
 }
 
@@ -687,23 +702,27 @@ void Vertex::setMorphUV(int index, const Vector4 &value)
 {
     if (internal::checkBound(index, 0, kMaxBones - 1)) {
         m_context->morphUVs[index + 1] = value;
+        m_context->invalidatePackedVertexStore();
     }
 }
 
 void Vertex::setType(Type value)
 {
     m_context->type = value;
+    m_context->invalidatePackedVertexStore();
 }
 
 void Vertex::setEdgeSize(const EdgeSizePrecision &value)
 {
     m_context->edgeSize = value;
+    m_context->invalidatePackedVertexStore();
 }
 
 void Vertex::setWeight(int index, const WeightPrecision &weight)
 {
     if (internal::checkBound(index, 0, kMaxBones)) {
         m_context->weight[index] = weight;
+        m_context->invalidatePackedVertexStore();
     }
 }
 
@@ -718,27 +737,32 @@ void Vertex::setBoneRef(int index, IBone *value)
             m_context->boneRefs[index] = Factory::sharedNullBoneRef();
             m_context->boneIndices[index] = -1;
         }
+        m_context->invalidatePackedVertexStore();
     }
 }
 
 void Vertex::setMaterialRef(IMaterial *value)
 {
     m_context->materialRef = value ? value : Factory::sharedNullMaterialRef();
+    m_context->invalidatePackedVertexStore();
 }
 
 void Vertex::setSdefC(const Vector3 &value)
 {
     m_context->c = value;
+    m_context->invalidatePackedVertexStore();
 }
 
 void Vertex::setSdefR0(const Vector3 &value)
 {
     m_context->r0 = value;
+    m_context->invalidatePackedVertexStore();
 }
 
 void Vertex::setSdefR1(const Vector3 &value)
 {
     m_context->r1 = value;
+    m_context->invalidatePackedVertexStore();
 }
 
 void Vertex::setIndex(int value)
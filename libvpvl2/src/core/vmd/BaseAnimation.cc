@@ -51,6 +51,8 @@ namespace vmd
 
 BaseAnimation::BaseAnimation()
     : m_lastTimeIndex(0),
+      m_batchEditDepth(0),
+      m_dirty(false),
       m_durationTimeIndex(0),
       m_currentTimeIndex(0),
       m_previousTimeIndex(0)
@@ -61,6 +63,8 @@ BaseAnimation::~BaseAnimation()
 {
     m_keyframes.releaseAll();
     m_lastTimeIndex = 0;
+    m_batchEditDepth = 0;
+    m_dirty = false;
     m_durationTimeIndex = 0.0f;
     m_currentTimeIndex = 0.0f;
     m_previousTimeIndex = 0.0f;
@@ -86,12 +90,36 @@ void BaseAnimation::reset()
 
 void BaseAnimation::addKeyframe(IKeyframe *keyframe)
 {
-    m_keyframes.append(keyframe);
+    if (isBatchEditing()) {
+        m_keyframes.append(keyframe);
+        m_dirty = true;
+    }
+    else {
+        internal::MotionHelper::insertKeyframe(keyframe, m_keyframes);
+    }
+    insertKeyframeRef(keyframe);
 }
 
 void BaseAnimation::removeKeyframe(IKeyframe *keyframe)
 {
-    m_keyframes.remove(keyframe);
+    bool removed = false;
+    if (isBatchEditing()) {
+        const int nkeyframes = m_keyframes.count();
+        m_keyframes.remove(keyframe);
+        removed = m_keyframes.count() < nkeyframes;
+        m_dirty = true;
+    }
+    else {
+        int index = 0;
+        removed = internal::MotionHelper::removeKeyframe(keyframe, m_keyframes, index);
+        if (removed && index < m_lastTimeIndex) {
+            /* keeps the seek hint on the same keyframe instead of resorting the animation */
+            m_lastTimeIndex--;
+        }
+    }
+    if (removed) {
+        removeKeyframeRef(keyframe);
+    }
 }
 
 void BaseAnimation::deleteKeyframe(IKeyframe *&keyframe)
@@ -100,13 +128,38 @@ void BaseAnimation::deleteKeyframe(IKeyframe *&keyframe)
     internal::deleteObject(keyframe);
 }
 
+void BaseAnimation::beginBatchEdit()
+{
+    m_batchEditDepth++;
+}
+
+void BaseAnimation::endBatchEdit()
+{
+    if (m_batchEditDepth > 0 && --m_batchEditDepth == 0 && m_dirty) {
+        /* sort all keyframes at once instead of inserting each of them to the sorted position */
+        m_keyframes.sort(internal::MotionHelper::KeyframeTimeIndexPredication());
+        sortKeyframeRefs();
+        m_dirty = false;
+        updateDurationTimeIndex();
+    }
+}
+
 void BaseAnimation::getKeyframes(const IKeyframe::TimeIndex &timeIndex, Array<IKeyframe *> &keyframes) const
 {
     const int nkeyframes = m_keyframes.count();
-    for (int i = 0; i < nkeyframes; i++) {
-        IKeyframe *keyframe = m_keyframes[i];
-        if (keyframe->timeIndex() == timeIndex) {
-            keyframes.append(keyframe);
+    if (isBatchEditing()) {
+        /* keyframes are not sorted until the batch edit is finished */
+        for (int i = 0; i < nkeyframes; i++) {
+            IKeyframe *keyframe = m_keyframes[i];
+            if (keyframe->timeIndex() == timeIndex) {
+                keyframes.append(keyframe);
+            }
+        }
+    }
+    else {
+        int i = internal::MotionHelper::findLowerBoundKeyframeIndex(timeIndex, 0, nkeyframes, m_keyframes);
+        while (i < nkeyframes && m_keyframes[i]->timeIndex() == timeIndex) {
+            keyframes.append(m_keyframes[i++]);
         }
     }
 }
@@ -127,6 +180,30 @@ void BaseAnimation::setAllKeyframes(const Array<IKeyframe *> &value, IKeyframe::
             m_keyframes.append(keyframe);
         }
     }
+    m_keyframes.sort(internal::MotionHelper::KeyframeTimeIndexPredication());
+}
+
+void BaseAnimation::insertKeyframeRef(IKeyframe *keyframe)
+{
+    btSetMax(m_durationTimeIndex, keyframe->timeIndex());
+}
+
+void BaseAnimation::removeKeyframeRef(IKeyframe * /* keyframe */)
+{
+    if (!isBatchEditing()) {
+        updateDurationTimeIndex();
+    }
+}
+
+void BaseAnimation::sortKeyframeRefs()
+{
+    /* no per track index by default */
+}
+
+void BaseAnimation::updateDurationTimeIndex()
+{
+    const int nkeyframes = m_keyframes.count();
+    m_durationTimeIndex = nkeyframes > 0 ? m_keyframes[nkeyframes - 1]->timeIndex() : 0;
 }
 
 IKeyframe::SmoothPrecision BaseAnimation::interpolateTimeIndex(const IKeyframe::TimeIndex &from, const IKeyframe::TimeIndex &to) const
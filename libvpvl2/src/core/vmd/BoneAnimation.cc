@@ -52,11 +52,21 @@ namespace vmd
 {
 
 struct BoneAnimation::PrivateContext {
+    PrivateContext(IBone *boneRef)
+        : bone(boneRef),
+          position(kZeroV3),
+          rotation(Quaternion::getIdentity()),
+          lastIndex(0),
+          dirty(false)
+    {
+    }
+
     IBone *bone;
     Array<BoneKeyframe *> keyframeRefs;
     Vector3 position;
     Quaternion rotation;
     int lastIndex;
+    bool dirty;
 
     bool isNull() const {
         if (keyframeRefs.count() == 1) {
@@ -72,9 +82,14 @@ IKeyframe::SmoothPrecision BoneAnimation::weightValue(const BoneKeyframe *keyfra
                                                       const IKeyframe::SmoothPrecision &w,
                                                       int at)
 {
-    const uint16 index = static_cast<int16>(w * BoneKeyframe::kTableSize);
     const IKeyframe::SmoothPrecision *v = keyframe->interpolationTable()[at];
-    return v[index] + (v[index + 1] - v[index]) * (w * BoneKeyframe::kTableSize - index);
+    if (v) {
+        const uint16 index = static_cast<int16>(w * BoneKeyframe::kTableSize);
+        return v[index] + (v[index + 1] - v[index]) * (w * BoneKeyframe::kTableSize - index);
+    }
+    QuadWord parameter;
+    keyframe->getInterpolationParameter(static_cast<IBoneKeyframe::InterpolationType>(at), parameter);
+    return internal::InterpolationTableCache::evaluate(parameter, w);
 }
 
 void BoneAnimation::lerpVector3(const BoneKeyframe *keyframe,
@@ -118,6 +133,7 @@ void BoneAnimation::read(const uint8 *data, int size)
         keyframe->read(ptr);
         ptr += keyframe->estimateSize();
     }
+    m_keyframes.sort(internal::MotionHelper::KeyframeTimeIndexPredication());
 }
 
 void BoneAnimation::seek(const IKeyframe::TimeIndex &timeIndexAt)
@@ -145,19 +161,22 @@ void BoneAnimation::createFirstKeyframeUnlessFound()
         Array<IBone *> bones;
         m_modelRef->getBoneRefs(bones);
         const int nbones = bones.count();
+        /* per-bone indices are updated on each add and all keyframes are sorted once at last */
+        beginBatchEdit();
         for (int i = 0; i < nbones; i++) {
             const IBone *bone = bones[i];
             const IString *name = bone->name(IEncoding::kDefaultLanguage);
             if (name && name->size() > 0 && !findKeyframe(0, name)) {
-                BoneKeyframe *keyframe = m_keyframes.append(new BoneKeyframe(m_encodingRef));
+                BoneKeyframe *keyframe = new BoneKeyframe(m_encodingRef);
                 keyframe->setName(name);
                 keyframe->setTimeIndex(0);
                 keyframe->setLocalTranslation(kZeroV3);
                 keyframe->setLocalOrientation(Quaternion::getIdentity());
                 keyframe->setDefaultInterpolationParameter();
-                m_keyframes.sort(internal::MotionHelper::KeyframeTimeIndexPredication());
+                addKeyframe(keyframe);
             }
         }
+        endBatchEdit();
     }
 }
 
@@ -180,7 +199,7 @@ BoneKeyframe *BoneAnimation::findKeyframe(const IKeyframe::TimeIndex &timeIndex,
         if (ptr) {
             const PrivateContext *context = *ptr;
             const Array<BoneKeyframe *> &keyframeRefs = context->keyframeRefs;
-            int index = findKeyframeIndex(timeIndex, keyframeRefs);
+            int index = findKeyframeIndex(timeIndex, keyframeRefs, !context->dirty);
             return index != -1 ? keyframeRefs[index] : 0;
         }
     }
@@ -196,6 +215,7 @@ void BoneAnimation::createPrivateContexts(IModel *model)
         const int nkeyframes = m_keyframes.count();
         m_name2contexts.releaseAll();
         m_durationTimeIndex = 0;
+        m_keyframes.sort(internal::MotionHelper::KeyframeTimeIndexPredication());
         // Build internal node to find by name, not frame index
         for (int i = 0; i < nkeyframes; i++) {
             BoneKeyframe *keyframe = reinterpret_cast<BoneKeyframe *>(m_keyframes.at(i));
@@ -207,12 +227,8 @@ void BoneAnimation::createPrivateContexts(IModel *model)
                 context->keyframeRefs.append(keyframe);
             }
             else if (IBone *bone = model->findBoneRef(name)) {
-                PrivateContext *context = m_name2contexts.insert(key, new PrivateContext());
+                PrivateContext *context = m_name2contexts.insert(key, new PrivateContext(bone));
                 context->keyframeRefs.append(keyframe);
-                context->bone = bone;
-                context->lastIndex = 0;
-                context->position.setZero();
-                context->rotation.setValue(0.0f, 0.0f, 0.0f, 1.0f);
             }
         }
         // Sort frames from each internal nodes by frame index ascend
@@ -272,6 +288,99 @@ void BoneAnimation::calculateKeyframes(const IKeyframe::TimeIndex &timeIndexAt,
     }
 }
 
+void BoneAnimation::update()
+{
+    createPrivateContexts(m_modelRef);
+}
+
+void BoneAnimation::insertKeyframeRef(IKeyframe *value)
+{
+    BoneKeyframe *keyframe = reinterpret_cast<BoneKeyframe *>(value);
+    const IString *name = keyframe->name();
+    if (m_modelRef && name) {
+        const HashString &key = name->toHashString();
+        if (PrivateContext *const *ptr = m_name2contexts.find(key)) {
+            PrivateContext *context = *ptr;
+            if (isBatchEditing()) {
+                /* sorted once at endBatchEdit */
+                context->keyframeRefs.append(keyframe);
+                context->dirty = true;
+            }
+            else {
+                internal::MotionHelper::insertKeyframe(keyframe, context->keyframeRefs);
+            }
+        }
+        else if (IBone *bone = m_modelRef->findBoneRef(name)) {
+            PrivateContext *context = m_name2contexts.insert(key, new PrivateContext(bone));
+            context->keyframeRefs.append(keyframe);
+        }
+        else {
+            return;
+        }
+        btSetMax(m_durationTimeIndex, keyframe->timeIndex());
+    }
+}
+
+void BoneAnimation::removeKeyframeRef(IKeyframe *value)
+{
+    BoneKeyframe *keyframe = reinterpret_cast<BoneKeyframe *>(value);
+    const IString *name = keyframe->name();
+    if (m_modelRef && name) {
+        const HashString &key = name->toHashString();
+        if (PrivateContext *const *ptr = m_name2contexts.find(key)) {
+            PrivateContext *context = *ptr;
+            Array<BoneKeyframe *> &keyframeRefs = context->keyframeRefs;
+            bool removed = false;
+            if (isBatchEditing()) {
+                const int nkeyframes = keyframeRefs.count();
+                keyframeRefs.remove(keyframe);
+                removed = keyframeRefs.count() < nkeyframes;
+                context->dirty = true;
+            }
+            else {
+                int index = 0;
+                removed = internal::MotionHelper::removeKeyframe(keyframe, keyframeRefs, index);
+                if (removed && index < context->lastIndex) {
+                    /* keeps the seek hint of the track on the same keyframe */
+                    context->lastIndex--;
+                }
+            }
+            if (removed && keyframeRefs.count() == 0) {
+                /* seeking requires at least one keyframe in the context */
+                m_name2contexts.remove(key);
+                internal::deleteObject(context);
+            }
+            if (!isBatchEditing()) {
+                updateDurationTimeIndex();
+            }
+        }
+    }
+}
+
+void BoneAnimation::sortKeyframeRefs()
+{
+    const int ncontexts = m_name2contexts.count();
+    for (int i = 0; i < ncontexts; i++) {
+        PrivateContext *context = *m_name2contexts.value(i);
+        if (context->dirty) {
+            context->keyframeRefs.sort(internal::MotionHelper::KeyframeTimeIndexPredication());
+            context->lastIndex = 0;
+            context->dirty = false;
+        }
+    }
+}
+
+void BoneAnimation::updateDurationTimeIndex()
+{
+    const int ncontexts = m_name2contexts.count();
+    m_durationTimeIndex = 0;
+    for (int i = 0; i < ncontexts; i++) {
+        const PrivateContext *context = *m_name2contexts.value(i);
+        const Array<BoneKeyframe *> &keyframeRefs = context->keyframeRefs;
+        btSetMax(m_durationTimeIndex, keyframeRefs[keyframeRefs.count() - 1]->timeIndex());
+    }
+}
+
 void BoneAnimation::reset()
 {
     BaseAnimation::reset();
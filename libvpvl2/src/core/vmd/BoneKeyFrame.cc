@@ -39,6 +39,7 @@
 
 #include "vpvl2/vpvl2.h"
 #include "vpvl2/internal/util.h"
+#include "vpvl2/internal/InterpolationTableCache.h"
 
 #include "vpvl2/vmd/BoneKeyframe.h"
 
@@ -101,7 +102,7 @@ BoneKeyframe::~BoneKeyframe()
     m_enableIK = false;
     internal::deleteObject(m_ptr);
     for (int i = 0; i < kMaxBoneInterpolationType; i++) {
-        internal::deleteObjectArray(m_interpolationTable[i]);
+        internal::InterpolationTableCache::release(m_interpolationTable[i]);
     }
     internal::zerofill(m_linear, sizeof(m_linear));
     internal::zerofill(m_interpolationTable, sizeof(m_interpolationTable));
@@ -214,19 +215,10 @@ void BoneKeyframe::setInterpolationTable(const int8 *table)
     QuadWord v;
     for (int i = 0; i < kMaxBoneInterpolationType; i++) {
         getValueFromTable(table, i, v);
-        internal::deleteObjectArray(m_interpolationTable[i]);
-        if (m_linear[i]) {
-            m_interpolationTable[i] = 0;
-            setInterpolationParameterInternal(static_cast<InterpolationType>(i), v);
-            continue;
-        }
-        m_interpolationTable[i] = new SmoothPrecision[kTableSize + 1];
-        internal::InterpolationTable::build(v.x() / 127.0f, // x1
-                                            v.z() / 127.0f, // x2
-                                            v.y() / 127.0f, // y1
-                                            v.w() / 127.0f, // y2
-                                            kTableSize,
-                                            m_interpolationTable[i]);
+        internal::InterpolationTableCache::release(m_interpolationTable[i]);
+        setInterpolationParameterInternal(static_cast<InterpolationType>(i), v);
+        /* the table is shared with other keyframes and null on linear or analytic evaluation */
+        m_interpolationTable[i] = m_linear[i] ? 0 : internal::InterpolationTableCache::acquire(v, kTableSize);
     }
 }
 
@@ -54,9 +54,14 @@ IKeyframe::SmoothPrecision CameraAnimation::weightValue(const CameraKeyframe *ke
                                                         const IKeyframe::SmoothPrecision &w,
                                                         int at)
 {
-    const uint16 index = static_cast<int16>(w * CameraKeyframe::kTableSize);
     const IKeyframe::SmoothPrecision *v = keyframe->interpolationTable()[at];
-    return v[index] + (v[index + 1] - v[index]) * (w * CameraKeyframe::kTableSize - index);
+    if (v) {
+        const uint16 index = static_cast<int16>(w * CameraKeyframe::kTableSize);
+        return v[index] + (v[index + 1] - v[index]) * (w * CameraKeyframe::kTableSize - index);
+    }
+    QuadWord parameter;
+    keyframe->getInterpolationParameter(static_cast<ICameraKeyframe::InterpolationType>(at), parameter);
+    return internal::InterpolationTableCache::evaluate(parameter, w);
 }
 
 void CameraAnimation::lerpVector3(const CameraKeyframe *keyframe,
@@ -206,7 +211,7 @@ void CameraAnimation::update()
 
 CameraKeyframe *CameraAnimation::findKeyframe(const IKeyframe::TimeIndex &timeIndex) const
 {
-    int index = findKeyframeIndex(timeIndex, m_keyframes);
+    int index = findKeyframeIndex(timeIndex, m_keyframes, !m_dirty);
     return index != -1 ? reinterpret_cast<CameraKeyframe *>(m_keyframes[index]) : 0;
 }
 
@@ -123,7 +123,7 @@ void LightAnimation::update()
 
 LightKeyframe *LightAnimation::findKeyframe(const IKeyframe::TimeIndex &timeIndex) const
 {
-    int index = findKeyframeIndex(timeIndex, m_keyframes);
+    int index = findKeyframeIndex(timeIndex, m_keyframes, !m_dirty);
     return index != -1 ? reinterpret_cast<LightKeyframe *>(m_keyframes[index]) : 0;
 }
 
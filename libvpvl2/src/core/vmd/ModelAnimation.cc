@@ -130,7 +130,7 @@ ModelKeyframe *ModelAnimation::findKeyframeAt(int i) const
 
 ModelKeyframe *ModelAnimation::findKeyframe(const IKeyframe::TimeIndex &timeIndex) const
 {
-    int index = findKeyframeIndex(timeIndex, m_keyframes);
+    int index = findKeyframeIndex(timeIndex, m_keyframes, !m_dirty);
     return index != -1 ? reinterpret_cast<ModelKeyframe *>(m_keyframes[index]) : 0;
 }
 
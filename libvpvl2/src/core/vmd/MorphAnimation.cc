@@ -51,10 +51,19 @@ namespace vmd
 {
 
 struct MorphAnimation::PrivateContext {
+    PrivateContext(IMorph *morphRef)
+        : morph(morphRef),
+          weight(0),
+          lastIndex(0),
+          dirty(false)
+    {
+    }
+
     IMorph *morph;
     Array<MorphKeyframe *> keyframeRefs;
     IMorph::WeightPrecision weight;
     int lastIndex;
+    bool dirty;
 
     bool isNull() const {
         if (keyframeRefs.count() == 1) {
@@ -88,6 +97,7 @@ void MorphAnimation::read(const uint8 *data, int size)
         keyframe->read(ptr);
         ptr += keyframe->estimateSize();
     }
+    m_keyframes.sort(internal::MotionHelper::KeyframeTimeIndexPredication());
 }
 
 void MorphAnimation::seek(const IKeyframe::TimeIndex &timeIndexAt)
@@ -114,17 +124,20 @@ void MorphAnimation::createFirstKeyframeUnlessFound()
         Array<IMorph *> morphs;
         m_modelRef->getMorphRefs(morphs);
         const int nmorphs = morphs.count();
+        /* per-morph indices are updated on each add and all keyframes are sorted once at last */
+        beginBatchEdit();
         for (int i = 0; i < nmorphs; i++) {
             const IMorph *morph = morphs[i];
             const IString *name = morph->name(IEncoding::kDefaultLanguage);
             if (name && name->size() > 0 && !findKeyframe(0, name)) {
-                MorphKeyframe *keyframe = m_keyframes.append(new MorphKeyframe(m_encodingRef));
+                MorphKeyframe *keyframe = new MorphKeyframe(m_encodingRef);
                 keyframe->setName(name);
                 keyframe->setTimeIndex(0);
                 keyframe->setWeight(0);
-                m_keyframes.sort(internal::MotionHelper::KeyframeTimeIndexPredication());
+                addKeyframe(keyframe);
             }
         }
+        endBatchEdit();
     }
 }
 
@@ -140,6 +153,7 @@ void MorphAnimation::createPrivateContexts(const IModel *model)
         const int nkeyframes = m_keyframes.count();
         m_name2contexts.releaseAll();
         m_durationTimeIndex = 0;
+        m_keyframes.sort(internal::MotionHelper::KeyframeTimeIndexPredication());
         // Build internal node to find by name, not frame index
         for (int i = 0; i < nkeyframes; i++) {
             MorphKeyframe *keyframe = reinterpret_cast<MorphKeyframe *>(m_keyframes.at(i));
@@ -151,11 +165,8 @@ void MorphAnimation::createPrivateContexts(const IModel *model)
                 context->keyframeRefs.append(keyframe);
             }
             else if (IMorph *morph = model->findMorphRef(name)) {
-                PrivateContext *context = m_name2contexts.insert(key, new PrivateContext());
+                PrivateContext *context = m_name2contexts.insert(key, new PrivateContext(morph));
                 context->keyframeRefs.append(keyframe);
-                context->morph = morph;
-                context->lastIndex = 0;
-                context->weight = 0.0f;
             }
         }
         // Sort frames from each internal nodes by frame index ascend
@@ -169,6 +180,99 @@ void MorphAnimation::createPrivateContexts(const IModel *model)
     }
 }
 
+void MorphAnimation::update()
+{
+    createPrivateContexts(m_modelRef);
+}
+
+void MorphAnimation::insertKeyframeRef(IKeyframe *value)
+{
+    MorphKeyframe *keyframe = reinterpret_cast<MorphKeyframe *>(value);
+    const IString *name = keyframe->name();
+    if (m_modelRef && name) {
+        const HashString &key = name->toHashString();
+        if (PrivateContext *const *ptr = m_name2contexts.find(key)) {
+            PrivateContext *context = *ptr;
+            if (isBatchEditing()) {
+                /* sorted once at endBatchEdit */
+                context->keyframeRefs.append(keyframe);
+                context->dirty = true;
+            }
+            else {
+                internal::MotionHelper::insertKeyframe(keyframe, context->keyframeRefs);
+            }
+        }
+        else if (IMorph *morph = m_modelRef->findMorphRef(name)) {
+            PrivateContext *context = m_name2contexts.insert(key, new PrivateContext(morph));
+            context->keyframeRefs.append(keyframe);
+        }
+        else {
+            return;
+        }
+        btSetMax(m_durationTimeIndex, keyframe->timeIndex());
+    }
+}
+
+void MorphAnimation::removeKeyframeRef(IKeyframe *value)
+{
+    MorphKeyframe *keyframe = reinterpret_cast<MorphKeyframe *>(value);
+    const IString *name = keyframe->name();
+    if (m_modelRef && name) {
+        const HashString &key = name->toHashString();
+        if (PrivateContext *const *ptr = m_name2contexts.find(key)) {
+            PrivateContext *context = *ptr;
+            Array<MorphKeyframe *> &keyframeRefs = context->keyframeRefs;
+            bool removed = false;
+            if (isBatchEditing()) {
+                const int nkeyframes = keyframeRefs.count();
+                keyframeRefs.remove(keyframe);
+                removed = keyframeRefs.count() < nkeyframes;
+                context->dirty = true;
+            }
+            else {
+                int index = 0;
+                removed = internal::MotionHelper::removeKeyframe(keyframe, keyframeRefs, index);
+                if (removed && index < context->lastIndex) {
+                    /* keeps the seek hint of the track on the same keyframe */
+                    context->lastIndex--;
+                }
+            }
+            if (removed && keyframeRefs.count() == 0) {
+                /* seeking requires at least one keyframe in the context */
+                m_name2contexts.remove(key);
+                internal::deleteObject(context);
+            }
+            if (!isBatchEditing()) {
+                updateDurationTimeIndex();
+            }
+        }
+    }
+}
+
+void MorphAnimation::sortKeyframeRefs()
+{
+    const int ncontexts = m_name2contexts.count();
+    for (int i = 0; i < ncontexts; i++) {
+        PrivateContext *context = *m_name2contexts.value(i);
+        if (context->dirty) {
+            context->keyframeRefs.sort(internal::MotionHelper::KeyframeTimeIndexPredication());
+            context->lastIndex = 0;
+            context->dirty = false;
+        }
+    }
+}
+
+void MorphAnimation::updateDurationTimeIndex()
+{
+    const int ncontexts = m_name2contexts.count();
+    m_durationTimeIndex = 0;
+    for (int i = 0; i < ncontexts; i++) {
+        const PrivateContext *context = *m_name2contexts.value(i);
+        const Array<MorphKeyframe *> &keyframeRefs = context->keyframeRefs;
+        btSetMax(m_durationTimeIndex, keyframeRefs[keyframeRefs.count() - 1]->timeIndex());
+    }
+}
+
 void MorphAnimation::reset()
 {
     BaseAnimation::reset();
@@ -192,7 +296,7 @@ MorphKeyframe *MorphAnimation::findKeyframe(const IKeyframe::TimeIndex &timeInde
         if (ptr) {
             const PrivateContext *context = *ptr;
             const Array<MorphKeyframe *> &keyframeRefs = context->keyframeRefs;
-            int index = findKeyframeIndex(timeIndex, keyframeRefs);
+            int index = findKeyframeIndex(timeIndex, keyframeRefs, !context->dirty);
             return index != -1 ? keyframeRefs[index] : 0;
         }
     }
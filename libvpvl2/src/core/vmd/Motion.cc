@@ -82,6 +82,11 @@ struct Motion::PrivateContext {
         type2animationRefs.insert(IKeyframe::kMorphKeyframe, &morphMotion);
         type2animationRefs.insert(IKeyframe::kModelKeyframe, &modelMotion);
         type2animationRefs.insert(IKeyframe::kProjectKeyframe, &projectMotion);
+        if (modelRef) {
+            /* index added keyframes by the model without calling update */
+            boneMotion.setParentModelRef(modelRef);
+            morphMotion.setParentModelRef(modelRef);
+        }
     }
     ~PrivateContext() {
         release();
@@ -572,9 +577,9 @@ void Motion::replaceKeyframe(IKeyframe *value, bool alsoDelete)
     case IKeyframe::kModelKeyframe: {
         keyframeToDelete = m_context->modelMotion.findKeyframe(value->timeIndex());
         if (keyframeToDelete) {
-            m_context->morphMotion.removeKeyframe(keyframeToDelete);
+            m_context->modelMotion.removeKeyframe(keyframeToDelete);
         }
-        m_context->morphMotion.addKeyframe(value);
+        m_context->modelMotion.addKeyframe(value);
         break;
     }
     case IKeyframe::kProjectKeyframe: {
@@ -714,10 +719,10 @@ void Motion::removeKeyframe(IKeyframe *value)
         return;
     }
     IKeyframe::Type type = value->type();
-    if (BaseAnimation *const *animationPtr = m_context->type2animationRefs.find(value->type())) {
+    if (BaseAnimation *const *animationPtr = m_context->type2animationRefs.find(type)) {
         BaseAnimation *animation = *animationPtr;
+        /* the animation and the track of the keyframe keep their indices sorted by themselves */
         animation->removeKeyframe(value);
-        update(type);
     }
 }
 
@@ -729,10 +734,9 @@ void Motion::deleteKeyframe(IKeyframe *&value)
         return;
     }
     IKeyframe::Type type = value->type();
-    if (BaseAnimation *const *animationPtr = m_context->type2animationRefs.find(value->type())) {
+    if (BaseAnimation *const *animationPtr = m_context->type2animationRefs.find(type)) {
         BaseAnimation *animation = *animationPtr;
         animation->deleteKeyframe(value);
-        update(type);
         value = 0;
     }
 }
@@ -761,6 +765,24 @@ void Motion::update(IKeyframe::Type type)
     }
 }
 
+void Motion::beginBatchEdit()
+{
+    const int nanimations = m_context->type2animationRefs.count();
+    for (int i = 0; i < nanimations; i++) {
+        BaseAnimation *animation = *m_context->type2animationRefs.value(i);
+        animation->beginBatchEdit();
+    }
+}
+
+void Motion::endBatchEdit()
+{
+    const int nanimations = m_context->type2animationRefs.count();
+    for (int i = 0; i < nanimations; i++) {
+        BaseAnimation *animation = *m_context->type2animationRefs.value(i);
+        animation->endBatchEdit();
+    }
+}
+
 IMotion *Motion::clone() const
 {
     IMotion *dest = m_context->motionPtr = new Motion(m_context->parentModelRef, m_context->encodingRef);
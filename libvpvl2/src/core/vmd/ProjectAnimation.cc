@@ -114,7 +114,7 @@ void ProjectAnimation::update()
 
 ProjectKeyframe *ProjectAnimation::findKeyframe(const IKeyframe::TimeIndex &timeIndex) const
 {
-    int index = findKeyframeIndex(timeIndex, m_keyframes);
+    int index = findKeyframeIndex(timeIndex, m_keyframes, !m_dirty);
     return index != -1 ? reinterpret_cast<ProjectKeyframe *>(m_keyframes[index]) : 0;
 }
 
@@ -0,0 +1,342 @@
+/**
+
+ Copyright (c) 2010-2014  hkrn
+
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or
+ without modification, are permitted provided that the following
+ conditions are met:
+
+ - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following
+   disclaimer in the documentation and/or other materials provided
+   with the distribution.
+ - Neither the name of the MMDAI project team nor the names of
+   its contributors may be used to endorse or promote products
+   derived from this software without specific prior written
+   permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "vpvl2/vpvl2.h"
+#include "vpvl2/cpu/PMXAccelerator.h"
+#include "vpvl2/internal/util.h"
+#include "vpvl2/internal/ParallelProcessors.h"
+#include "vpvl2/pmx/Bone.h"
+#include "vpvl2/pmx/Material.h"
+#include "vpvl2/pmx/Model.h"
+#include "vpvl2/pmx/Vertex.h"
+
+namespace vpvl2
+{
+namespace VPVL2_VERSION_NS
+{
+namespace cpu
+{
+
+static const PMXAccelerator::StreamUnit kStreamIdent = PMXAccelerator::StreamUnit();
+static const PMXAccelerator::AttributeUnit kAttributeIdent = PMXAccelerator::AttributeUnit();
+
+/* same layout as the dynamic vertex buffer of pmx::Model */
+struct DynamicUnit {
+    Vector3 position;
+    Vector3 normal;
+    Vector3 edge;
+    Vector4 uva1;
+    Vector4 uva2;
+    Vector4 uva3;
+    Vector4 uva4;
+};
+static const DynamicUnit kDynamicIdent = DynamicUnit();
+
+static bool IsDynamicUnitLayout(const IModel::DynamicVertexBuffer *dynamicBufferRef)
+{
+    const uint8 *base = reinterpret_cast<const uint8 *>(&kDynamicIdent.position);
+    return dynamicBufferRef->strideSize() == sizeof(kDynamicIdent)
+            && dynamicBufferRef->strideOffset(IModel::Buffer::kVertexStride) == vsize(reinterpret_cast<const uint8 *>(&kDynamicIdent.position) - base)
+            && dynamicBufferRef->strideOffset(IModel::Buffer::kNormalStride) == vsize(reinterpret_cast<const uint8 *>(&kDynamicIdent.normal) - base)
+            && dynamicBufferRef->strideOffset(IModel::Buffer::kEdgeVertexStride) == vsize(reinterpret_cast<const uint8 *>(&kDynamicIdent.edge) - base)
+            && dynamicBufferRef->strideOffset(IModel::Buffer::kUVA1Stride) == vsize(reinterpret_cast<const uint8 *>(&kDynamicIdent.uva1) - base)
+            && dynamicBufferRef->strideOffset(IModel::Buffer::kUVA2Stride) == vsize(reinterpret_cast<const uint8 *>(&kDynamicIdent.uva2) - base)
+            && dynamicBufferRef->strideOffset(IModel::Buffer::kUVA3Stride) == vsize(reinterpret_cast<const uint8 *>(&kDynamicIdent.uva3) - base)
+            && dynamicBufferRef->strideOffset(IModel::Buffer::kUVA4Stride) == vsize(reinterpret_cast<const uint8 *>(&kDynamicIdent.uva4) - base);
+}
+
+struct PMXAccelerator::PrivateContext {
+    PrivateContext(const Scene *sceneRef, IModel *modelRef)
+        : sceneRef(sceneRef),
+          modelRef(modelRef),
+          lastMorphUpdateSerial(-1),
+          enableParallelUpdate(false),
+          isBufferAllocated(false)
+    {
+    }
+    ~PrivateContext() {
+        sceneRef = 0;
+        modelRef = 0;
+        isBufferAllocated = false;
+    }
+
+    internal::PackedVertexStore *updatePackedVertexStore() const {
+        if (modelRef->type() == IModel::kPMXModel) {
+            const pmx::Model *model = static_cast<const pmx::Model *>(modelRef);
+            if (internal::PackedVertexStore *storeRef = model->packedVertexStoreRef()) {
+                storeRef->update(model->vertices(), model->bones(), model->materials());
+                return storeRef;
+            }
+        }
+        return 0;
+    }
+    void markAllVerticesChanged() {
+        const int nvertices = vertexRefs.count();
+        changedVertexIndices.resize(nvertices);
+        for (int i = 0; i < nvertices; i++) {
+            changedVertexIndices[i] = i;
+        }
+    }
+
+    const Scene *sceneRef;
+    IModel *modelRef;
+    Array<IVertex *> vertexRefs;
+    Array<IMorph *> uvMorphRefs;
+    Array<IMorph::WeightPrecision> uvMorphWeights;
+    Array<int> changedVertexIndices;
+    int lastMorphUpdateSerial;
+    bool enableParallelUpdate;
+    bool isBufferAllocated;
+};
+
+vsize PMXAccelerator::streamStrideSize()
+{
+    return sizeof(kStreamIdent);
+}
+
+vsize PMXAccelerator::streamStrideOffset(IModel::Buffer::StrideType type)
+{
+    static const uint8 *base = reinterpret_cast<const uint8 *>(&kStreamIdent.position);
+    switch (type) {
+    case IModel::Buffer::kVertexStride:
+        return reinterpret_cast<const uint8 *>(&kStreamIdent.position) - base;
+    case IModel::Buffer::kNormalStride:
+        return reinterpret_cast<const uint8 *>(&kStreamIdent.normal) - base;
+    case IModel::Buffer::kEdgeVertexStride:
+        return reinterpret_cast<const uint8 *>(&kStreamIdent.edge) - base;
+    default:
+        return 0;
+    }
+}
+
+vsize PMXAccelerator::attributeStrideSize()
+{
+    return sizeof(kAttributeIdent);
+}
+
+vsize PMXAccelerator::attributeStrideOffset(IModel::Buffer::StrideType type)
+{
+    static const uint8 *base = reinterpret_cast<const uint8 *>(&kAttributeIdent.uva1);
+    switch (type) {
+    case IModel::Buffer::kUVA1Stride:
+        return reinterpret_cast<const uint8 *>(&kAttributeIdent.uva1) - base;
+    case IModel::Buffer::kUVA2Stride:
+        return reinterpret_cast<const uint8 *>(&kAttributeIdent.uva2) - base;
+    case IModel::Buffer::kUVA3Stride:
+        return reinterpret_cast<const uint8 *>(&kAttributeIdent.uva3) - base;
+    case IModel::Buffer::kUVA4Stride:
+        return reinterpret_cast<const uint8 *>(&kAttributeIdent.uva4) - base;
+    default:
+        return 0;
+    }
+}
+
+PMXAccelerator::PMXAccelerator(const Scene *sceneRef, IModel *modelRef)
+    : m_context(new PrivateContext(sceneRef, modelRef))
+{
+}
+
+PMXAccelerator::~PMXAccelerator()
+{
+    internal::deleteObject(m_context);
+}
+
+bool PMXAccelerator::isAvailable() const
+{
+    /* PMD units don't refresh UVA on skinning so only PMX shares the same writes */
+    return m_context->modelRef && m_context->modelRef->type() == IModel::kPMXModel;
+}
+
+void PMXAccelerator::upload()
+{
+    /* vertex references are only changed when the model is reloaded */
+    m_context->modelRef->getVertexRefs(m_context->vertexRefs);
+    /* group morphs are also tracked because they may drive UV morphs */
+    Array<IMorph *> morphRefs;
+    m_context->modelRef->getMorphRefs(morphRefs);
+    m_context->uvMorphRefs.clear();
+    m_context->uvMorphWeights.clear();
+    const int nmorphs = morphRefs.count();
+    for (int i = 0; i < nmorphs; i++) {
+        IMorph *morph = morphRefs[i];
+        switch (morph->type()) {
+        case IMorph::kGroupMorph:
+        case IMorph::kTexCoordMorph:
+        case IMorph::kUVA1Morph:
+        case IMorph::kUVA2Morph:
+        case IMorph::kUVA3Morph:
+        case IMorph::kUVA4Morph:
+            m_context->uvMorphRefs.append(morph);
+            m_context->uvMorphWeights.append(morph->weight());
+            break;
+        default:
+            break;
+        }
+    }
+    /* attributes are written entirely at upload so the next check compares from the current serial */
+    m_context->changedVertexIndices.clear();
+    m_context->lastMorphUpdateSerial = -1;
+    m_context->isBufferAllocated = true;
+}
+
+void PMXAccelerator::update(const IModel::DynamicVertexBuffer *dynamicBufferRef, void *address, Vector3 &aabbMin, Vector3 &aabbMax)
+{
+    if (!m_context->isBufferAllocated || !address) {
+        return;
+    }
+    const IModel *modelRef = m_context->modelRef;
+    const Vector3 &cameraPosition = m_context->sceneRef->cameraRef()->position();
+    const IVertex::EdgeSizePrecision &edgeScaleFactor = modelRef->edgeScaleFactor(cameraPosition);
+    internal::PackedVertexStore *storeRef = IsDynamicUnitLayout(dynamicBufferRef) ? m_context->updatePackedVertexStore() : 0;
+    if (storeRef) {
+        internal::ParallelPackedSkinningAabbVertexProcessor<DynamicUnit> processor(storeRef, edgeScaleFactor, address);
+        processor.execute(m_context->enableParallelUpdate, aabbMin, aabbMax);
+    }
+    else {
+        internal::ParallelSkinningAabbVertexProcessor<IVertex> processor(&m_context->vertexRefs, dynamicBufferRef, edgeScaleFactor, address);
+        processor.execute(m_context->enableParallelUpdate, aabbMin, aabbMax);
+    }
+}
+
+void PMXAccelerator::updateStream(void *address, Vector3 &aabbMin, Vector3 &aabbMax)
+{
+    if (!m_context->isBufferAllocated || !address) {
+        return;
+    }
+    const Vector3 &cameraPosition = m_context->sceneRef->cameraRef()->position();
+    const IVertex::EdgeSizePrecision &edgeScaleFactor = m_context->modelRef->edgeScaleFactor(cameraPosition);
+    if (internal::PackedVertexStore *storeRef = m_context->updatePackedVertexStore()) {
+        /* StreamUnit has the same layout as PackedVertexStore::SkinningUnit */
+        internal::ParallelPackedSkinningAabbVertexProcessor<internal::PackedVertexStore::SkinningUnit> processor(storeRef, edgeScaleFactor, address);
+        processor.execute(m_context->enableParallelUpdate, aabbMin, aabbMax);
+    }
+    else {
+        typedef internal::ParallelSkinningAabbVertexProcessor<IVertex> Processor;
+        const Processor::Layout layout(streamStrideSize(),
+                                       streamStrideOffset(IModel::Buffer::kVertexStride),
+                                       streamStrideOffset(IModel::Buffer::kNormalStride),
+                                       streamStrideOffset(IModel::Buffer::kEdgeVertexStride));
+        Processor processor(&m_context->vertexRefs, layout, edgeScaleFactor, address);
+        processor.execute(m_context->enableParallelUpdate, aabbMin, aabbMax);
+    }
+}
+
+void PMXAccelerator::updateAttributes(void *address) const
+{
+    updateAttributes(0, m_context->vertexRefs.count(), address);
+}
+
+void PMXAccelerator::updateAttributes(int offset, int nvertices, void *address) const
+{
+    if (!m_context->isBufferAllocated || !address) {
+        return;
+    }
+    AttributeUnit *units = static_cast<AttributeUnit *>(address);
+    const Array<IVertex *> &vertexRefs = m_context->vertexRefs;
+    const int end = btMin(offset + nvertices, vertexRefs.count());
+    for (int i = offset; i < end; i++) {
+        const IVertex *vertex = vertexRefs[i];
+        AttributeUnit &unit = units[i - offset];
+        unit.uva1 = vertex->uv(0);
+        unit.uva2 = vertex->uv(1);
+        unit.uva3 = vertex->uv(2);
+        unit.uva4 = vertex->uv(3);
+    }
+}
+
+bool PMXAccelerator::checkAttributesChanged(const IModel::DynamicVertexBuffer *dynamicBufferRef)
+{
+    Array<int> &indices = m_context->changedVertexIndices;
+    int serial = 0;
+    if (dynamicBufferRef && dynamicBufferRef->getMorphTouchedVertexIndices(indices, serial)) {
+        /*
+         * morphs (including flip and group morphs) report the vertices they touched and vertex
+         * or morph edits (setUV/setOriginUV and so on) report all vertices, so attributes are
+         * written only for the vertices the model reported since the last check
+         */
+        const int lastSerial = m_context->lastMorphUpdateSerial;
+        m_context->lastMorphUpdateSerial = serial;
+        if (serial == lastSerial) {
+            indices.clear();
+            return false;
+        }
+        else if (lastSerial < 0 || serial != lastSerial + 1) {
+            /* the model was updated more than once since the last check */
+            m_context->markAllVerticesChanged();
+        }
+        return indices.count() > 0;
+    }
+    bool changed = false;
+    const Array<IMorph *> &morphRefs = m_context->uvMorphRefs;
+    Array<IMorph::WeightPrecision> &weights = m_context->uvMorphWeights;
+    const int nmorphs = morphRefs.count();
+    for (int i = 0; i < nmorphs; i++) {
+        const IMorph::WeightPrecision &weight = morphRefs[i]->weight();
+        if (weights[i] != weight) {
+            weights[i] = weight;
+            changed = true;
+        }
+    }
+    indices.clear();
+    if (changed) {
+        m_context->markAllVerticesChanged();
+    }
+    return changed;
+}
+
+const Array<int> &PMXAccelerator::changedVertexIndices() const
+{
+    return m_context->changedVertexIndices;
+}
+
+void PMXAccelerator::release()
+{
+    m_context->vertexRefs.clear();
+    m_context->uvMorphRefs.clear();
+    m_context->uvMorphWeights.clear();
+    m_context->changedVertexIndices.clear();
+    m_context->isBufferAllocated = false;
+}
+
+void PMXAccelerator::setParallelUpdateEnable(bool value)
+{
+    m_context->enableParallelUpdate = value;
+}
+
+} /* namespace cpu */
+} /* namespace VPVL2_VERSION_NS */
+} /* namespace vpvl2 */
@@ -249,6 +249,27 @@ void AssetRenderEngine::release()
 }
 
 void AssetRenderEngine::update()
+{
+    updateSceneParameters();
+}
+
+bool AssetRenderEngine::beginUpdate()
+{
+    /* no CPU skinning to be deferred */
+    return false;
+}
+
+void AssetRenderEngine::performUpdate()
+{
+    /* do nothing */
+}
+
+void AssetRenderEngine::endUpdate()
+{
+    /* do nothing */
+}
+
+void AssetRenderEngine::updateSceneParameters()
 {
     m_currentEffectEngineRef->updateSceneParameters();
 }
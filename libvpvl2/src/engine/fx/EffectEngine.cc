@@ -642,7 +642,9 @@ void TimeSemantic::update()
 ControlObjectSemantic::ControlObjectSemantic(const Scene *sceneRef, const IApplicationContext *applicationContextRef)
     : BaseParameter(),
       m_sceneRef(sceneRef),
-      m_applicationContextRef(applicationContextRef)
+      m_applicationContextRef(applicationContextRef),
+      m_modelRevision(0),
+      m_compiled(false)
 {
 }
 
@@ -650,12 +652,15 @@ ControlObjectSemantic::~ControlObjectSemantic()
 {
     m_sceneRef = 0;
     m_applicationContextRef = 0;
+    m_modelRevision = 0;
+    m_compiled = false;
 }
 
 void ControlObjectSemantic::addParameter(IEffect::Parameter *parameterRef)
 {
     if (parameterRef->annotationRef("name")) {
         m_parameterRefs.append(parameterRef);
+        m_compiled = false;
     }
 }
 
@@ -663,125 +668,234 @@ void ControlObjectSemantic::invalidate()
 {
     BaseParameter::invalidate();
     m_parameterRefs.clear();
+    m_bindings.clear();
+    m_compiled = false;
 }
 
 void ControlObjectSemantic::update(const IModel *self)
+{
+    /*
+     * handles of models, bones and morphs are no longer valid after a model is added, removed or renamed,
+     * and the revision also changes when the application context maps another name to a model
+     */
+    const int modelRevision = m_sceneRef ? m_sceneRef->modelRevision() : 0;
+    if (!m_compiled || m_modelRevision != modelRevision || isBindingsChanged()) {
+        compileBindings(self);
+        m_modelRevision = modelRevision;
+    }
+    const int nbindings = m_bindings.count();
+    for (int i = 0; i < nbindings; i++) {
+        Binding &binding = m_bindings[i];
+        if (binding.targetType == Binding::kSelfTarget && binding.modelRef != self) {
+            bind(binding, self);
+        }
+        setParameter(binding);
+    }
+}
+
+bool ControlObjectSemantic::isBindingsChanged() const
+{
+    /* bones and morphs may be removed or renamed and the model itself may be renamed */
+    const int nbindings = m_bindings.count();
+    for (int i = 0; i < nbindings; i++) {
+        const Binding &binding = m_bindings[i];
+        if (binding.modelRef && binding.modelRef->structureRevision() != binding.modelRevision) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ControlObjectSemantic::compileBindings(const IModel *self)
 {
     const int nparameters = m_parameterRefs.count();
+    m_bindings.clear();
     for (int i = 0; i < nparameters; i++) {
         IEffect::Parameter *parameterRef = m_parameterRefs[i];
         if (const IEffect::Annotation *annotationRef = parameterRef->annotationRef("name")) {
             const char *name = annotationRef->stringValue();
             const vsize len = std::strlen(name);
             if (VPVL2_FX_STREQ_CONST(name, len, "(self)")) {
-                setParameter(self, parameterRef);
+                /* rebound at update only if the caller passes another model */
+                Binding binding(parameterRef, Binding::kSelfTarget);
+                bind(binding, self);
+                m_bindings.append(binding);
             }
             else if (VPVL2_FX_STREQ_CONST(name, len, "(OffscreenOwner)")) {
+                Binding binding(parameterRef, Binding::kOffscreenOwnerTarget);
                 if (IEffect *parent = parameterRef->parentEffectRef()->parentEffectRef()) {
-                    const IModel *model = m_applicationContextRef->findEffectModelRef(parent);
-                    setParameter(model, parameterRef);
+                    bind(binding, m_applicationContextRef->findEffectModelRef(parent));
+                }
+                else {
+                    /* keep the parameter as is like the owner is not found */
+                    binding.valueType = Binding::kNoValue;
                 }
+                m_bindings.append(binding);
             }
             else {
+                Binding binding(parameterRef, Binding::kNamedTarget);
                 IString *s = m_applicationContextRef->toUnicode(reinterpret_cast<const uint8 *>(name));
                 const IModel *model = m_applicationContextRef->findEffectModelRef(s);
                 internal::deleteObject(s);
-                setParameter(model, parameterRef);
+                bind(binding, model);
+                m_bindings.append(binding);
             }
         }
     }
+    m_compiled = true;
 }
 
-void ControlObjectSemantic::setParameter(const IModel *model, IEffect::Parameter *parameterRef)
+void ControlObjectSemantic::bind(Binding &binding, const IModel *model) const
 {
-    if (model) {
-        if (const IEffect::Annotation *annotationRef = parameterRef->annotationRef("item")) {
-            switch (model->type()) {
-            case IModel::kPMDModel:
-            case IModel::kPMXModel:
-                setModelBoneMorphParameter(model, annotationRef, parameterRef);
-                break;
-            default:
-                setAssetParameter(model, annotationRef, parameterRef);
-                break;
+    IEffect::Parameter *parameterRef = binding.parameterRef;
+    binding.modelRef = model;
+    binding.boneRef = 0;
+    binding.morphRef = 0;
+    binding.modelRevision = model ? model->structureRevision() : 0;
+    if (!model) {
+        binding.valueType = Binding::kNullValue;
+    }
+    else if (const IEffect::Annotation *annotationRef = parameterRef->annotationRef("item")) {
+        const char *item = annotationRef->stringValue();
+        const vsize len = std::strlen(item);
+        switch (model->type()) {
+        case IModel::kPMDModel:
+        case IModel::kPMXModel: {
+            IString *s = m_applicationContextRef->toUnicode(reinterpret_cast<const uint8 *>(item));
+            if ((binding.boneRef = model->findBoneRef(s))) {
+                binding.valueType = Binding::kBoneValue;
+            }
+            else if ((binding.morphRef = model->findMorphRef(s))) {
+                binding.valueType = Binding::kMorphValue;
             }
+            else {
+                binding.valueType = Binding::kNoValue;
+            }
+            internal::deleteObject(s);
+            break;
         }
-        else {
-            setModelParameter(model, parameterRef);
+        default:
+            if (VPVL2_FX_STREQ_CONST(item, len, "X")) {
+                binding.valueType = Binding::kAssetXValue;
+            }
+            else if (VPVL2_FX_STREQ_CONST(item, len, "Y")) {
+                binding.valueType = Binding::kAssetYValue;
+            }
+            else if (VPVL2_FX_STREQ_CONST(item, len, "Z")) {
+                binding.valueType = Binding::kAssetZValue;
+            }
+            else if (VPVL2_FX_STREQ_CONST(item, len, "XYZ")) {
+                binding.valueType = Binding::kAssetXYZValue;
+            }
+            else if (VPVL2_FX_STREQ_CONST(item, len, "Rx")) {
+                binding.valueType = Binding::kAssetRxValue;
+            }
+            else if (VPVL2_FX_STREQ_CONST(item, len, "Ry")) {
+                binding.valueType = Binding::kAssetRyValue;
+            }
+            else if (VPVL2_FX_STREQ_CONST(item, len, "Rz")) {
+                binding.valueType = Binding::kAssetRzValue;
+            }
+            else if (VPVL2_FX_STREQ_CONST(item, len, "Rxyz")) {
+                binding.valueType = Binding::kAssetRxyzValue;
+            }
+            else if (VPVL2_FX_STREQ_CONST(item, len, "Si")) {
+                binding.valueType = Binding::kAssetSiValue;
+            }
+            else if (VPVL2_FX_STREQ_CONST(item, len, "Tr")) {
+                binding.valueType = Binding::kAssetTrValue;
+            }
+            else {
+                binding.valueType = Binding::kNoValue;
+            }
+            break;
         }
     }
     else {
-        setNullParameter(parameterRef);
+        binding.valueType = Binding::kModelValue;
     }
 }
 
-void ControlObjectSemantic::setModelBoneMorphParameter(const IModel *model, const IEffect::Annotation *annotationRef, IEffect::Parameter *parameterRef)
+void ControlObjectSemantic::setParameter(const Binding &binding) const
 {
-    const char *item = annotationRef->stringValue();
-    const IString *s = m_applicationContextRef->toUnicode(reinterpret_cast<const uint8 *>(item));
-    IBone *bone = model->findBoneRef(s);
-    IMorph *morph = model->findMorphRef(s);
-    internal::deleteObject(s);
-    if (bone) {
+    IEffect::Parameter *parameterRef = binding.parameterRef;
+    switch (binding.valueType) {
+    case Binding::kNullValue:
+        setNullParameter(parameterRef);
+        break;
+    case Binding::kModelValue:
+        setModelParameter(binding.modelRef, parameterRef);
+        break;
+    case Binding::kBoneValue: {
         float matrix4x4[16] = { 0 };
         switch (parameterRef->type()) {
         case IEffect::Parameter::kFloat3:
         case IEffect::Parameter::kFloat4:
-            parameterRef->setValue(bone->worldTransform().getOrigin());
+            parameterRef->setValue(binding.boneRef->worldTransform().getOrigin());
             break;
         case IEffect::Parameter::kFloat4x4:
-            bone->worldTransform().getOpenGLMatrix(matrix4x4);
+            binding.boneRef->worldTransform().getOpenGLMatrix(matrix4x4);
             parameterRef->setMatrix(matrix4x4);
             break;
         default:
             break;
         }
+        break;
     }
-    else if (morph) {
-        parameterRef->setValue(float(morph->weight()));
+    case Binding::kMorphValue:
+        parameterRef->setValue(float(binding.morphRef->weight()));
+        break;
+    case Binding::kNoValue:
+        break;
+    default:
+        setAssetParameter(binding.modelRef, binding.valueType, parameterRef);
+        break;
     }
 }
 
-void ControlObjectSemantic::setAssetParameter(const IModel *model, const IEffect::Annotation *annotationRef, IEffect::Parameter *parameterRef)
+void ControlObjectSemantic::setAssetParameter(const IModel *model, Binding::ValueType valueType, IEffect::Parameter *parameterRef) const
 {
     const Vector3 &position = model->worldTranslation();
-    const Quaternion &rotation = model->worldOrientation();
-    const char *item = annotationRef->stringValue();
-    const vsize len = std::strlen(item);
-    if (VPVL2_FX_STREQ_CONST(item, len, "X")) {
+    switch (valueType) {
+    case Binding::kAssetXValue:
         parameterRef->setValue(position.x());
-    }
-    else if (VPVL2_FX_STREQ_CONST(item, len, "Y")) {
+        break;
+    case Binding::kAssetYValue:
         parameterRef->setValue(position.y());
-    }
-    else if (VPVL2_FX_STREQ_CONST(item, len, "Z")) {
+        break;
+    case Binding::kAssetZValue:
         parameterRef->setValue(position.z());
-    }
-    else if (VPVL2_FX_STREQ_CONST(item, len, "XYZ")) {
+        break;
+    case Binding::kAssetXYZValue:
         parameterRef->setValue(position);
-    }
-    else if (VPVL2_FX_STREQ_CONST(item, len, "Rx")) {
-        parameterRef->setValue(btDegrees(rotation.x()));
-    }
-    else if (VPVL2_FX_STREQ_CONST(item, len, "Ry")) {
-        parameterRef->setValue(btDegrees(rotation.y()));
-    }
-    else if (VPVL2_FX_STREQ_CONST(item, len, "Rz")) {
-        parameterRef->setValue(btDegrees(rotation.z()));
-    }
-    else if (VPVL2_FX_STREQ_CONST(item, len, "Rxyz")) {
+        break;
+    case Binding::kAssetRxValue:
+        parameterRef->setValue(btDegrees(model->worldOrientation().x()));
+        break;
+    case Binding::kAssetRyValue:
+        parameterRef->setValue(btDegrees(model->worldOrientation().y()));
+        break;
+    case Binding::kAssetRzValue:
+        parameterRef->setValue(btDegrees(model->worldOrientation().z()));
+        break;
+    case Binding::kAssetRxyzValue: {
+        const Quaternion &rotation = model->worldOrientation();
         const Vector3 rotationDegree(btDegrees(rotation.x()), btDegrees(rotation.y()), btDegrees(rotation.z()));
         parameterRef->setValue(rotationDegree);
+        break;
     }
-    else if (VPVL2_FX_STREQ_CONST(item, len, "Si")) {
+    case Binding::kAssetSiValue:
         parameterRef->setValue(model->scaleFactor());
-    }
-    else if (VPVL2_FX_STREQ_CONST(item, len, "Tr")) {
+        break;
+    case Binding::kAssetTrValue:
         parameterRef->setValue(model->opacity());
+        break;
+    default:
+        break;
     }
 }
 
-void ControlObjectSemantic::setModelParameter(const IModel *model, IEffect::Parameter *parameterRef)
+void ControlObjectSemantic::setModelParameter(const IModel *model, IEffect::Parameter *parameterRef) const
 {
     float matrix4x4[16] = { 0 };
     switch (parameterRef->type()) {
@@ -804,7 +918,7 @@ void ControlObjectSemantic::setModelParameter(const IModel *model, IEffect::Para
     }
 }
 
-void ControlObjectSemantic::setNullParameter(IEffect::Parameter *parameterRef)
+void ControlObjectSemantic::setNullParameter(IEffect::Parameter *parameterRef) const
 {
     float matrix4x4[16] = { 0 };
     switch (parameterRef->type()) {
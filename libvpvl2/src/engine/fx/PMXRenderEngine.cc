@@ -39,7 +39,9 @@
 
 #include "vpvl2/vpvl2.h"
 #include "vpvl2/internal/util.h" /* internal::snprintf */
+#include "vpvl2/internal/DynamicVertexUpdateTracker.h"
 #include "vpvl2/cl/PMXAccelerator.h"
+#include "vpvl2/cpu/PMXAccelerator.h"
 #include "vpvl2/gl/Texture2D.h"
 #include "vpvl2/gl/ShaderProgram.h"
 #include "vpvl2/gl/VertexBundle.h"
@@ -281,6 +283,7 @@ PMXRenderEngine::PMXRenderEngine(IApplicationContext *applicationContextRef,
       drawArrays(reinterpret_cast<PFNGLDRAWARRAYSPROC>(applicationContextRef->sharedFunctionResolverInstance()->resolveSymbol("glDrawArrays"))),
       m_currentEffectEngineRef(0),
       m_accelerator(accelerator),
+      m_cpuAccelerator(0),
       m_applicationContextRef(applicationContextRef),
       m_transformFeedbackProgram(0),
       m_sceneRef(sceneRef),
@@ -288,9 +291,12 @@ PMXRenderEngine::PMXRenderEngine(IApplicationContext *applicationContextRef,
       m_staticBuffer(0),
       m_dynamicBuffer(0),
       m_indexBuffer(0),
+      m_vertexUpdateTracker(0),
+      m_mappedAddress(0),
       m_bundle(0),
       m_defaultEffectRef(0),
       m_indexType(kGL_UNSIGNED_INT),
+      m_updateOptions(kNone),
       m_aabbMin(SIMD_INFINITY, SIMD_INFINITY, SIMD_INFINITY),
       m_aabbMax(-SIMD_INFINITY, -SIMD_INFINITY, -SIMD_INFINITY),
       m_cullFaceState(true),
@@ -399,6 +405,13 @@ bool PMXRenderEngine::upload(void *userData)
             internal::deleteObject(m_transformFeedbackProgram);
             m_transformFeedbackProgram = new TransformFeedbackProgram(m_applicationContextRef->sharedFunctionResolverInstance());
             m_transformFeedbackProgram->setupTexture(m_modelRef);
+            /* morphed vertices are kept in CPU memory and only changed ranges are uploaded */
+            internal::deleteObject(m_vertexUpdateTracker);
+            m_vertexUpdateTracker = new internal::DynamicVertexUpdateTracker(2);
+            m_morphedVertices.resize(int(m_dynamicBuffer->size()));
+            if (m_morphedVertices.count() > 0) {
+                m_dynamicBuffer->setupBindPose(&m_morphedVertices[0]);
+            }
 #if 0
             m_transformFeedbackProgram->create();
             IString *vertexShaderSource = m_applicationContextRef->loadShaderSource(IApplicationContext::kTransformFeedbackVertexShader, m_modelRef, 0);
@@ -416,6 +429,18 @@ bool PMXRenderEngine::upload(void *userData)
             }
 #endif
         }
+        else if (m_sceneRef->accelerationType() == Scene::kCPUAccelerationType1) {
+            internal::deleteObject(m_cpuAccelerator);
+            m_cpuAccelerator = new cpu::PMXAccelerator(m_sceneRef, m_modelRef);
+            if (m_cpuAccelerator->isAvailable()) {
+                /* setUpdateOptions may be called before the accelerator is created */
+                m_cpuAccelerator->setParallelUpdateEnable(internal::hasFlagBits(m_updateOptions, kParallelUpdate));
+                m_cpuAccelerator->upload();
+            }
+            else {
+                internal::deleteObject(m_cpuAccelerator);
+            }
+        }
     m_sceneRef->updateModel(m_modelRef);
     m_modelRef->setVisible(true);
     popAnnotationGroup(m_applicationContextRef);
@@ -437,6 +462,9 @@ void PMXRenderEngine::release()
     internal::deleteObject(m_dynamicBuffer);
     internal::deleteObject(m_indexBuffer);
     internal::deleteObject(m_transformFeedbackProgram);
+    internal::deleteObject(m_cpuAccelerator);
+    internal::deleteObject(m_vertexUpdateTracker);
+    m_morphedVertices.clear();
 #ifdef VPVL2_ENABLE_OPENCL
     internal::deleteObject(m_accelerator);
 #endif
@@ -450,6 +478,11 @@ void PMXRenderEngine::release()
 
 void PMXRenderEngine::update()
 {
+    if (beginUpdate()) {
+        performUpdate();
+        endUpdate();
+        return;
+    }
     if (!m_currentEffectEngineRef) {
         return;
     }
@@ -467,57 +500,126 @@ void PMXRenderEngine::update()
     }
     else
 #endif
-    {
-        if (m_transformFeedbackProgram) {
+    if (m_transformFeedbackProgram) {
 #if 0
-            VertexBundleLayout *layout = m_layouts[kBindPoseVertexArrayObject];
-            enable(VertexBundle::kGL_RASTERIZER_DISCARD);
-            m_transformFeedbackProgram->bind();
-            m_transformFeedbackProgram->updateBoneTransformTextureData(m_modelRef);
-            m_transformFeedbackProgram->activateBoneTransformTexture();
-            m_transformFeedbackProgram->setNumBoneIndices(m_modelRef->count(IModel::kBone));
-            m_bundle->beginTransform(kGL_POINTS, vbo);
-            layout->bind();
-            drawArrays(kGL_POINTS, 0, m_modelRef->count(IModel::kVertex));
-            layout->unbind();
-            m_bundle->endTransform();
-            disable(VertexBundle::kGL_RASTERIZER_DISCARD);
-            m_transformFeedbackProgram->unbind();
+        VertexBundleLayout *layout = m_layouts[kBindPoseVertexArrayObject];
+        enable(VertexBundle::kGL_RASTERIZER_DISCARD);
+        m_transformFeedbackProgram->bind();
+        m_transformFeedbackProgram->updateBoneTransformTextureData(m_modelRef);
+        m_transformFeedbackProgram->activateBoneTransformTexture();
+        m_transformFeedbackProgram->setNumBoneIndices(m_modelRef->count(IModel::kBone));
+        m_bundle->beginTransform(kGL_POINTS, vbo);
+        layout->bind();
+        drawArrays(kGL_POINTS, 0, m_modelRef->count(IModel::kVertex));
+        layout->unbind();
+        m_bundle->endTransform();
+        disable(VertexBundle::kGL_RASTERIZER_DISCARD);
+        m_transformFeedbackProgram->unbind();
 #else
-            m_transformFeedbackProgram->updateBoneTransformTextureData(m_modelRef);
-            m_transformFeedbackProgram->updateBoneTransformTexture();
-            m_currentEffectEngineRef->boneTransformTexture.setTexture(m_transformFeedbackProgram->textureRef());
-            m_currentEffectEngineRef->boneCount.setValue(m_modelRef->count(IModel::kBone));
-            m_currentEffectEngineRef->edgeScaleFactor.setValue(m_modelRef->edgeScaleFactor(m_sceneRef->cameraRef()->position()));
-            m_bundle->bind(VertexBundle::kVertexBuffer, vbo);
-            if (void *address = m_bundle->map(VertexBundle::kVertexBuffer, 0, m_dynamicBuffer->size())) {
-                m_dynamicBuffer->update(address);
-                m_bundle->unmap(VertexBundle::kVertexBuffer, address);
-            }
-            m_bundle->unbind(VertexBundle::kVertexBuffer);
+        m_transformFeedbackProgram->updateBoneTransformTextureData(m_modelRef);
+        m_transformFeedbackProgram->updateBoneTransformTexture();
+        m_currentEffectEngineRef->boneTransformTexture.setTexture(m_transformFeedbackProgram->textureRef());
+        m_currentEffectEngineRef->boneCount.setValue(m_modelRef->count(IModel::kBone));
+        m_currentEffectEngineRef->edgeScaleFactor.setValue(m_modelRef->edgeScaleFactor(m_sceneRef->cameraRef()->position()));
+        m_bundle->bind(VertexBundle::kVertexBuffer, vbo);
+        uploadMorphedVertices();
+        m_bundle->unbind(VertexBundle::kVertexBuffer);
 #endif
+    }
+    m_modelRef->setAabb(m_aabbMin, m_aabbMax);
+    m_updateEvenBuffer = m_updateEvenBuffer ? false :true;
+    popAnnotationGroup(m_applicationContextRef);
+}
+
+bool PMXRenderEngine::beginUpdate()
+{
+    /* only CPU skinning can be deferred as other paths call GL or OpenCL */
+    bool isOpenCLAcceleration = false;
+#ifdef VPVL2_ENABLE_OPENCL
+    isOpenCLAcceleration = m_accelerator && m_accelerator->isAvailable();
+#endif
+    if (!m_currentEffectEngineRef || !m_modelRef->isVisible() || m_transformFeedbackProgram || isOpenCLAcceleration) {
+        return false;
+    }
+    m_currentEffectEngineRef->updateSceneParameters();
+    VertexBufferObjectType vbo = m_updateEvenBuffer ? kModelDynamicVertexBufferEven : kModelDynamicVertexBufferOdd;
+    annotate("beginUpdate: model=%s type=%d", m_modelRef->name(IEncoding::kDefaultLanguage)->toByteArray(), vbo);
+    /* the mapped pointer stays valid after unbinding until the buffer is unmapped */
+    m_bundle->bind(VertexBundle::kVertexBuffer, vbo);
+    m_mappedAddress = m_bundle->map(VertexBundle::kVertexBuffer, 0, m_dynamicBuffer->size());
+    m_bundle->unbind(VertexBundle::kVertexBuffer);
+    return true;
+}
+
+void PMXRenderEngine::performUpdate()
+{
+    if (void *address = m_mappedAddress) {
+        if (m_cpuAccelerator) {
+            m_cpuAccelerator->update(m_dynamicBuffer, address, m_aabbMin, m_aabbMax);
         }
         else {
-            m_bundle->bind(VertexBundle::kVertexBuffer, vbo);
-            if (void *address = m_bundle->map(VertexBundle::kVertexBuffer, 0, m_dynamicBuffer->size())) {
-                m_dynamicBuffer->performTransform(address, m_sceneRef->cameraRef()->position());
+            m_dynamicBuffer->performTransform(address, m_sceneRef->cameraRef()->position());
+        }
 #if 0 // due to SEGV on several models
-                Array<Vector3> aabb;
-                m_dynamicBuffer->computeAabb(address, aabb);
+        Array<Vector3> aabb;
+        m_dynamicBuffer->computeAabb(address, aabb);
 #endif
-                m_bundle->unmap(VertexBundle::kVertexBuffer, address);
-            }
-            m_bundle->unbind(VertexBundle::kVertexBuffer);
-        }
+    }
+}
+
+void PMXRenderEngine::endUpdate()
+{
+    if (void *address = m_mappedAddress) {
+        VertexBufferObjectType vbo = m_updateEvenBuffer ? kModelDynamicVertexBufferEven : kModelDynamicVertexBufferOdd;
+        m_bundle->bind(VertexBundle::kVertexBuffer, vbo);
+        m_bundle->unmap(VertexBundle::kVertexBuffer, address);
+        m_bundle->unbind(VertexBundle::kVertexBuffer);
+        m_mappedAddress = 0;
     }
     m_modelRef->setAabb(m_aabbMin, m_aabbMax);
     m_updateEvenBuffer = m_updateEvenBuffer ? false :true;
-    popAnnotationGroup(m_applicationContextRef);
+}
+
+void PMXRenderEngine::updateSceneParameters()
+{
+    if (m_currentEffectEngineRef) {
+        m_currentEffectEngineRef->updateSceneParameters();
+    }
+}
+
+void PMXRenderEngine::uploadMorphedVertices()
+{
+    if (m_morphedVertices.count() == 0 || !m_vertexUpdateTracker) {
+        return;
+    }
+    const int nvertices = m_modelRef->count(IModel::kVertex);
+    uint8 *bytes = &m_morphedVertices[0];
+    if (m_vertexUpdateTracker->collect(m_dynamicBuffer, nvertices)) {
+        const Array<int> &indices = m_vertexUpdateTracker->currentVertexIndices();
+        if (indices.count() > 0) {
+            m_dynamicBuffer->update(bytes, indices);
+        }
+        const Array<internal::DynamicVertexUpdateTracker::Range> &ranges = m_vertexUpdateTracker->ranges(m_dynamicBuffer->strideSize());
+        const int nranges = ranges.count();
+        for (int i = 0; i < nranges; i++) {
+            const internal::DynamicVertexUpdateTracker::Range &range = ranges[i];
+            m_bundle->write(VertexBundle::kVertexBuffer, range.offset, range.size, bytes + range.offset);
+        }
+        annotate("uploadMorphedVertices: ranges=%d", nranges);
+    }
+    else {
+        m_dynamicBuffer->update(bytes);
+        m_bundle->write(VertexBundle::kVertexBuffer, 0, m_morphedVertices.count(), bytes);
+    }
 }
 
 void PMXRenderEngine::setUpdateOptions(int options)
 {
+    m_updateOptions = options;
     m_dynamicBuffer->setParallelUpdateEnable(internal::hasFlagBits(options, kParallelUpdate));
+    if (m_cpuAccelerator) {
+        m_cpuAccelerator->setParallelUpdateEnable(internal::hasFlagBits(options, kParallelUpdate));
+    }
 }
 
 void PMXRenderEngine::renderModel(IEffect::Pass *overridePass)
@@ -372,6 +372,22 @@ void AssetRenderEngine::update()
     /* do nothing */
 }
 
+bool AssetRenderEngine::beginUpdate()
+{
+    /* no CPU skinning to be deferred */
+    return false;
+}
+
+void AssetRenderEngine::performUpdate()
+{
+    /* do nothing */
+}
+
+void AssetRenderEngine::endUpdate()
+{
+    /* do nothing */
+}
+
 void AssetRenderEngine::setUpdateOptions(int /* options */)
 {
     /* do nothing */
@@ -661,9 +677,17 @@ bool AssetRenderEngine::createProgram(BaseShaderProgram *program,
     IString *fragmentShaderSource = 0;
     vertexShaderSource = m_applicationContextRef->loadShaderSource(vertexShaderType, m_modelRef, userData);
     fragmentShaderSource = m_applicationContextRef->loadShaderSource(fragmentShaderType, m_modelRef, userData);
-    program->addShaderSource(vertexShaderSource, ShaderProgram::kGL_VERTEX_SHADER);
-    program->addShaderSource(fragmentShaderSource, ShaderProgram::kGL_FRAGMENT_SHADER);
-    bool ok = program->linkProgram();
+    const std::string &cacheKey = BaseShaderProgram::makeCacheKey(m_applicationContextRef->sharedFunctionResolverInstance(),
+                                                                  vertexShaderSource, fragmentShaderSource);
+    bool ok = program->loadProgramBinary(cacheKey);
+    if (!ok) {
+        program->addShaderSource(vertexShaderSource, ShaderProgram::kGL_VERTEX_SHADER);
+        program->addShaderSource(fragmentShaderSource, ShaderProgram::kGL_FRAGMENT_SHADER);
+        ok = program->linkProgram();
+        if (ok) {
+            program->storeProgramBinary(cacheKey);
+        }
+    }
     internal::deleteObject(vertexShaderSource);
     internal::deleteObject(fragmentShaderSource);
     return ok;
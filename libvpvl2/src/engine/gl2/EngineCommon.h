@@ -42,8 +42,10 @@
 
 #include "vpvl2/vpvl2.h"
 #include "vpvl2/ITexture.h"
+#include "vpvl2/extensions/EffectCache.h"
 #include "vpvl2/gl/ShaderProgram.h"
 #include "vpvl2/gl/Texture2D.h"
+#include "vpvl2/internal/util.h"
 
 namespace vpvl2
 {
@@ -86,6 +88,38 @@ public:
         getUniformLocations();
         return true;
     }
+    static std::string makeCacheKey(const IApplicationContext::FunctionResolver *resolver, const IString *vertexShaderSource, const IString *fragmentShaderSource) {
+        /* binaries depend on the driver, the version is checked here and the rest by glProgramBinary */
+        char backend[64];
+        internal::snprintf(backend, sizeof(backend), "gl2:%d:%d:%d",
+                           resolver->query(IApplicationContext::FunctionResolver::kQueryVersion),
+                           resolver->query(IApplicationContext::FunctionResolver::kQueryShaderVersion),
+                           resolver->query(IApplicationContext::FunctionResolver::kQueryCoreProfile));
+        std::string source(internal::cstr(vertexShaderSource, ""));
+        source.push_back('\0');
+        source.append(internal::cstr(fragmentShaderSource, ""));
+        return extensions::EffectCache::makeKey(backend, source, extensions::StringMap(), extensions::StringList());
+    }
+    bool loadProgramBinary(const std::string &cacheKey) {
+        uint32 format;
+        Array<uint8> bytes;
+        if (isProgramBinarySupported() && extensions::EffectCache::find(cacheKey, extensions::EffectCache::kProgramBinary, format, bytes)) {
+            if (bytes.count() > 0 && loadBinary(format, &bytes[0], bytes.count())) {
+                VPVL2_VLOG(2, "Loaded a shader program from the effect cache (ID=" << m_program << ")");
+                getUniformLocations();
+                return true;
+            }
+            extensions::EffectCache::reject(cacheKey, extensions::EffectCache::kProgramBinary);
+        }
+        return false;
+    }
+    void storeProgramBinary(const std::string &cacheKey) const {
+        GLenum format;
+        Array<uint8> bytes;
+        if (extensions::EffectCache::isEnabled() && getBinary(format, bytes)) {
+            extensions::EffectCache::store(cacheKey, extensions::EffectCache::kProgramBinary, format, &bytes[0], bytes.count());
+        }
+    }
     void setModelViewProjectionMatrix(const float value[16]) {
         uniformMatrix4fv(m_modelViewProjectionUniformLocation, 1, gl::kGL_FALSE, value);
     }
@@ -42,31 +42,41 @@
 #include "EngineCommon.h"
 #include "vpvl2/gl/VertexBundle.h"
 #include "vpvl2/gl/VertexBundleLayout.h"
+#include "vpvl2/internal/MaterialDrawList.h"
 #include "vpvl2/internal/util.h" /* internal::snprintf */
 #include "vpvl2/gl2/PMXRenderEngine.h"
 #include "vpvl2/cl/PMXAccelerator.h"
+#include "vpvl2/cpu/PMXAccelerator.h"
 
 using namespace vpvl2::VPVL2_VERSION_NS;
 using namespace vpvl2::VPVL2_VERSION_NS::gl;
 using namespace vpvl2::VPVL2_VERSION_NS::gl2;
+using vpvl2::VPVL2_VERSION_NS::internal::MaterialDrawList;
 
 namespace {
 
+/* dynamic vertex buffers are rotated as a ring to avoid waiting for the previous frames */
+static const int kMaxDynamicVertexBuffers = 3;
+
 enum VertexBufferObjectType
 {
-    kModelDynamicVertexBufferEven,
-    kModelDynamicVertexBufferOdd,
+    kModelDynamicVertexBuffer0,
+    kModelDynamicVertexBuffer1,
+    kModelDynamicVertexBuffer2,
     kModelStaticVertexBuffer,
+    kModelVertexAttributeBuffer,
     kModelIndexBuffer,
     kMaxVertexBufferObjectType
 };
 
 enum VertexArrayObjectType
 {
-    kVertexArrayObjectEven,
-    kVertexArrayObjectOdd,
-    kEdgeVertexArrayObjectEven,
-    kEdgeVertexArrayObjectOdd,
+    kVertexArrayObject0,
+    kVertexArrayObject1,
+    kVertexArrayObject2,
+    kEdgeVertexArrayObject0,
+    kEdgeVertexArrayObject1,
+    kEdgeVertexArrayObject2,
     kMaxVertexArrayObjectType
 };
 
@@ -389,12 +399,15 @@ namespace gl2
 class PMXRenderEngine::PrivateContext
 {
 public:
+    static const int kAllPasses = (1 << MaterialDrawList::kMaxPassType) - 1;
+
     PrivateContext(const IModel *model, const IApplicationContext::FunctionResolver *resolver, bool isVertexShaderSkinning)
         : modelRef(model),
           indexBuffer(0),
           staticBuffer(0),
           dynamicBuffer(0),
           matrixBuffer(0),
+          cpuAccelerator(0),
           edgeProgram(0),
           modelProgram(0),
           shadowProgram(0),
@@ -403,8 +416,12 @@ public:
           aabbMin(SIMD_INFINITY, SIMD_INFINITY, SIMD_INFINITY),
           aabbMax(-SIMD_INFINITY, -SIMD_INFINITY, -SIMD_INFINITY),
           cullFaceState(true),
+          updateOptions(IRenderEngine::kNone),
+          updateSlot(0),
+          renderedPasses(kAllPasses),
+          mappedAddress(0),
           isVertexShaderSkinning(isVertexShaderSkinning),
-          updateEven(true)
+          isStreamingUpload(false)
     {
         model->getIndexBuffer(indexBuffer);
         model->getStaticVertexBuffer(staticBuffer);
@@ -430,12 +447,16 @@ public:
         for (int i = 0; i < kMaxVertexArrayObjectType; i++) {
             bundles[i] = new VertexBundleLayout(resolver);
         }
+        /* bone matrices of vertex shader skinning are set per material */
+        drawList.setMergeEnabled(!isVertexShaderSkinning);
+        internal::zerofill(&statistics, sizeof(statistics));
     }
     virtual ~PrivateContext() {
         for (int i = 0; i < kMaxVertexArrayObjectType; i++) {
             internal::deleteObject(bundles[i]);
         }
         allocatedTextures.releaseAll();
+        internal::deleteObject(cpuAccelerator);
         internal::deleteObject(indexBuffer);
         internal::deleteObject(dynamicBuffer);
         internal::deleteObject(staticBuffer);
@@ -447,26 +468,97 @@ public:
         aabbMax.setZero();
         cullFaceState = false;
         isVertexShaderSkinning = false;
+        isStreamingUpload = false;
     }
 
+    static VertexBufferObjectType dynamicVertexBufferType(int slot) {
+        return static_cast<VertexBufferObjectType>(kModelDynamicVertexBuffer0 + slot);
+    }
+    /* the last written buffer is used to render */
+    int renderSlot() const {
+        return (updateSlot + kMaxDynamicVertexBuffers - 1) % kMaxDynamicVertexBuffers;
+    }
+    vsize dynamicVertexBufferSize() const {
+        return isStreamingUpload ? cpu::PMXAccelerator::streamStrideSize() * modelRef->count(IModel::kVertex) : dynamicBuffer->size();
+    }
+    vsize vertexAttributeBufferSize() const {
+        return cpu::PMXAccelerator::attributeStrideSize() * modelRef->count(IModel::kVertex);
+    }
     void getVertexBundleType(VertexArrayObjectType &vao, VertexBufferObjectType &vbo) {
-        if (updateEven) {
-            vao = kVertexArrayObjectOdd;
-            vbo = kModelDynamicVertexBufferOdd;
-        }
-        else {
-            vao = kVertexArrayObjectEven;
-            vbo = kModelDynamicVertexBufferEven;
-        }
+        const int slot = renderSlot();
+        vao = static_cast<VertexArrayObjectType>(kVertexArrayObject0 + slot);
+        vbo = dynamicVertexBufferType(slot);
     }
     void getEdgeBundleType(VertexArrayObjectType &vao, VertexBufferObjectType &vbo) {
-        if (updateEven) {
-            vao = kEdgeVertexArrayObjectOdd;
-            vbo = kModelDynamicVertexBufferOdd;
+        const int slot = renderSlot();
+        vao = static_cast<VertexArrayObjectType>(kEdgeVertexArrayObject0 + slot);
+        vbo = dynamicVertexBufferType(slot);
+    }
+    /*
+     * Statistics are reset at the first pass of a frame rather than at endUpdate, because the
+     * update of an unchanged model is skipped by Scene while the model is still rendered. A pass
+     * rendered again starts a new frame as well.
+     */
+    void beginRenderPass(MaterialDrawList::PassType pass) {
+        const int bit = 1 << pass;
+        if (internal::hasFlagBits(renderedPasses, bit)) {
+            internal::zerofill(&statistics, sizeof(statistics));
+            renderedPasses = 0;
         }
-        else {
-            vao = kEdgeVertexArrayObjectEven;
-            vbo = kModelDynamicVertexBufferEven;
+        renderedPasses |= bit;
+    }
+    /* sets uniforms and textures of the state only if they differ from the last applied state */
+    void applyModelState(const MaterialDrawList::State &state,
+                         const MaterialDrawList::State *lastState,
+                         const Vector3 &lc,
+                         GLuint depthTextureID) {
+        if (!lastState || lastState->ambient != state.ambient || lastState->diffuse != state.diffuse) {
+            const Color &ma = state.ambient, &md = state.diffuse;
+            modelProgram->setMaterialColor(Color(ma.x() + md.x() * lc.x(), ma.y() + md.y() * lc.y(), ma.z() + md.z() * lc.z(), md.w()));
+            statistics.numUniformUpdates++;
+        }
+        if (!lastState || lastState->specular != state.specular) {
+            const Color &ms = state.specular;
+            modelProgram->setMaterialSpecular(Color(ms.x() * lc.x(), ms.y() * lc.y(), ms.z() * lc.z(), 1.0));
+            statistics.numUniformUpdates++;
+        }
+        if (!lastState || lastState->shininess != state.shininess) {
+            modelProgram->setMaterialShininess(state.shininess);
+            statistics.numUniformUpdates++;
+        }
+        if (!lastState || lastState->mainTextureBlend != state.mainTextureBlend) {
+            modelProgram->setMainTextureBlend(state.mainTextureBlend);
+            statistics.numUniformUpdates++;
+        }
+        if (!lastState || lastState->sphereTextureBlend != state.sphereTextureBlend) {
+            modelProgram->setSphereTextureBlend(state.sphereTextureBlend);
+            statistics.numUniformUpdates++;
+        }
+        if (!lastState || lastState->toonTextureBlend != state.toonTextureBlend) {
+            modelProgram->setToonTextureBlend(state.toonTextureBlend);
+            statistics.numUniformUpdates++;
+        }
+        if (!lastState || lastState->mainTextureRef != state.mainTextureRef) {
+            modelProgram->setMainTexture(state.mainTextureRef);
+            statistics.numTextureBinds += state.mainTextureRef ? 1 : 0;
+            statistics.numUniformUpdates++;
+        }
+        if (!lastState || lastState->sphereTextureRef != state.sphereTextureRef
+                || lastState->sphereTextureRenderMode != state.sphereTextureRenderMode) {
+            modelProgram->setSphereTexture(state.sphereTextureRef, state.sphereTextureRenderMode);
+            statistics.numTextureBinds += state.sphereTextureRef ? 1 : 0;
+            statistics.numUniformUpdates++;
+        }
+        if (!lastState || lastState->toonTextureRef != state.toonTextureRef) {
+            modelProgram->setToonTexture(state.toonTextureRef);
+            statistics.numTextureBinds += state.toonTextureRef ? 1 : 0;
+            statistics.numUniformUpdates++;
+        }
+        if (!lastState || lastState->isShadowMapEnabled != state.isShadowMapEnabled) {
+            const bool hasDepthTexture = depthTextureID && state.isShadowMapEnabled;
+            modelProgram->setDepthTexture(hasDepthTexture ? depthTextureID : 0);
+            statistics.numTextureBinds += hasDepthTexture ? 1 : 0;
+            statistics.numUniformUpdates++;
         }
     }
 
@@ -475,6 +567,7 @@ public:
     IModel::StaticVertexBuffer *staticBuffer;
     IModel::DynamicVertexBuffer *dynamicBuffer;
     IModel::MatrixBuffer *matrixBuffer;
+    cpu::PMXAccelerator *cpuAccelerator;
     EdgeProgram *edgeProgram;
     ModelProgram *modelProgram;
     ShadowProgram *shadowProgram;
@@ -484,14 +577,21 @@ public:
     GLenum indexType;
     PointerHash<HashPtr, ITexture> allocatedTextures;
     Array<MaterialTextureRefs> materialTextureRefs;
+    Array<uint8> attributeBytes;
+    MaterialDrawList drawList;
+    PMXRenderEngine::RenderStatistics statistics;
     Vector3 aabbMin;
     Vector3 aabbMax;
 #ifdef VPVL2_ENABLE_OPENCL
     cl::PMXAccelerator::VertexBufferBridgeArray buffers;
 #endif
+    int updateOptions;
+    int updateSlot;
+    int renderedPasses;
+    void *mappedAddress;
     bool cullFaceState;
     bool isVertexShaderSkinning;
-    bool updateEven;
+    bool isStreamingUpload;
 };
 
 PMXRenderEngine::PMXRenderEngine(IApplicationContext *applicationContextRef,
@@ -579,10 +679,52 @@ bool PMXRenderEngine::upload(void *userData)
     if (!uploadMaterials(userData)) {
         return false;
     }
+    bool isOpenCLAcceleration = false;
+#ifdef VPVL2_ENABLE_OPENCL
+    isOpenCLAcceleration = m_accelerator && m_accelerator->isAvailable();
+#endif
+    if (!vss && !isOpenCLAcceleration) {
+        const bool isLegacyUpload = internal::hasFlagBits(m_context->updateOptions, kLegacyVertexUpload);
+        /*
+         * the accelerator runs the same packed skinning kernels as the dynamic vertex buffer,
+         * so the streamed upload is used by default and kCPUAccelerationType1 changes nothing here.
+         * models other than PMX keep the dynamic vertex buffer with the whole buffer mapped.
+         */
+        internal::deleteObject(m_context->cpuAccelerator);
+        cpu::PMXAccelerator *cpuAccelerator = m_context->cpuAccelerator = new cpu::PMXAccelerator(m_sceneRef, m_modelRef);
+        if (cpuAccelerator->isAvailable()) {
+            cpuAccelerator->setParallelUpdateEnable(internal::hasFlagBits(m_context->updateOptions, kParallelUpdate));
+            cpuAccelerator->upload();
+            m_context->isStreamingUpload = !isLegacyUpload;
+        }
+        else {
+            internal::deleteObject(m_context->cpuAccelerator);
+        }
+    }
     VertexBundle &buffer = m_context->buffer;
-    buffer.create(VertexBundle::kVertexBuffer, kModelDynamicVertexBufferEven, VertexBundle::kGL_DYNAMIC_DRAW, 0, m_context->dynamicBuffer->size());
-    buffer.create(VertexBundle::kVertexBuffer, kModelDynamicVertexBufferOdd, VertexBundle::kGL_DYNAMIC_DRAW, 0, m_context->dynamicBuffer->size());
-    VPVL2_VLOG(2, "Binding model dynamic vertex buffer to the vertex buffer object: size=" << m_context->dynamicBuffer->size());
+    const VertexBundle::UploadStrategy strategy = buffer.detectUploadStrategy();
+    const vsize dynamicBufferSize = m_context->dynamicVertexBufferSize();
+    for (int i = 0; i < kMaxDynamicVertexBuffers; i++) {
+        const VertexBufferObjectType vbo = PrivateContext::dynamicVertexBufferType(i);
+        if (m_context->isStreamingUpload) {
+            buffer.createStream(vbo, strategy, dynamicBufferSize);
+        }
+        else {
+            buffer.create(VertexBundle::kVertexBuffer, vbo, VertexBundle::kGL_DYNAMIC_DRAW, 0, dynamicBufferSize);
+        }
+    }
+    VPVL2_VLOG(2, "Binding model dynamic vertex buffer to the vertex buffer object: size=" << dynamicBufferSize << " streaming=" << m_context->isStreamingUpload << " strategy=" << strategy);
+    if (m_context->isStreamingUpload) {
+        /* UVA is written only when UV morphs are changed */
+        const vsize attributeBufferSize = m_context->vertexAttributeBufferSize();
+        buffer.create(VertexBundle::kVertexBuffer, kModelVertexAttributeBuffer, VertexBundle::kGL_DYNAMIC_DRAW, 0, attributeBufferSize);
+        buffer.bind(VertexBundle::kVertexBuffer, kModelVertexAttributeBuffer);
+        if (void *address = buffer.map(VertexBundle::kVertexBuffer, 0, attributeBufferSize)) {
+            m_context->cpuAccelerator->updateAttributes(address);
+            buffer.unmap(VertexBundle::kVertexBuffer, address);
+        }
+        buffer.unbind(VertexBundle::kVertexBuffer);
+    }
     const IModel::StaticVertexBuffer *staticBuffer = m_context->staticBuffer;
     buffer.create(VertexBundle::kVertexBuffer, kModelStaticVertexBuffer, VertexBundle::kGL_STATIC_DRAW, 0, staticBuffer->size());
     buffer.bind(VertexBundle::kVertexBuffer, kModelStaticVertexBuffer);
@@ -594,30 +736,21 @@ bool PMXRenderEngine::upload(void *userData)
     const IModel::IndexBuffer *indexBuffer = m_context->indexBuffer;
     buffer.create(VertexBundle::kIndexBuffer, kModelIndexBuffer, VertexBundle::kGL_STATIC_DRAW, indexBuffer->bytes(), indexBuffer->size());
     VPVL2_VLOG(2, "Binding indices to the vertex buffer object: ptr=" << indexBuffer->bytes() << " size=" << indexBuffer->size());
-    VertexBundleLayout *bundleME = m_context->bundles[kVertexArrayObjectEven];
-    if (bundleME->create() && bundleME->bind()) {
-        VPVL2_VLOG(2, "Binding an vertex array object for even frame: " << bundleME->name());
-        createVertexBundle(kModelDynamicVertexBufferEven);
-    }
-    bundleME->unbind();
-    VertexBundleLayout *bundleMO = m_context->bundles[kVertexArrayObjectOdd];
-    if (bundleMO->create() && bundleMO->bind()) {
-        VPVL2_VLOG(2, "Binding an vertex array object for odd frame: " << bundleMO->name());
-        createVertexBundle(kModelDynamicVertexBufferOdd);
-    }
-    bundleMO->unbind();
-    VertexBundleLayout *bundleEE = m_context->bundles[kEdgeVertexArrayObjectEven];
-    if (bundleEE->create() && bundleEE->bind()) {
-        VPVL2_VLOG(2, "Binding an edge vertex array object for even frame: " << bundleEE->name());
-        createEdgeBundle(kModelDynamicVertexBufferEven);
-    }
-    bundleEE->unbind();
-    VertexBundleLayout *bundleEO = m_context->bundles[kEdgeVertexArrayObjectOdd];
-    if (bundleEO->create() && bundleEO->bind()) {
-        VPVL2_VLOG(2, "Binding an edge vertex array object for odd frame: " << bundleEO->name());
-        createEdgeBundle(kModelDynamicVertexBufferOdd);
-    }
-    bundleEO->unbind();
+    for (int i = 0; i < kMaxDynamicVertexBuffers; i++) {
+        const VertexBufferObjectType vbo = PrivateContext::dynamicVertexBufferType(i);
+        VertexBundleLayout *bundleM = m_context->bundles[kVertexArrayObject0 + i];
+        if (bundleM->create() && bundleM->bind()) {
+            VPVL2_VLOG(2, "Binding an vertex array object for frame " << i << ": " << bundleM->name());
+            createVertexBundle(vbo);
+        }
+        bundleM->unbind();
+        VertexBundleLayout *bundleE = m_context->bundles[kEdgeVertexArrayObject0 + i];
+        if (bundleE->create() && bundleE->bind()) {
+            VPVL2_VLOG(2, "Binding an edge vertex array object for frame " << i << ": " << bundleE->name());
+            createEdgeBundle(vbo);
+        }
+        bundleE->unbind();
+    }
     buffer.unbind(VertexBundle::kVertexBuffer);
     buffer.unbind(VertexBundle::kIndexBuffer);
 #ifdef VPVL2_ENABLE_OPENCL
@@ -625,14 +758,16 @@ bool PMXRenderEngine::upload(void *userData)
         const VertexBundle &buffer = m_context->buffer;
         cl::PMXAccelerator::VertexBufferBridgeArray &buffers = m_context->buffers;
         m_accelerator->release(buffers);
-        buffers.append(cl::PMXAccelerator::VertexBufferBridge(buffer.findName(kModelDynamicVertexBufferEven)));
-        buffers.append(cl::PMXAccelerator::VertexBufferBridge(buffer.findName(kModelDynamicVertexBufferOdd)));
+        for (int i = 0; i < kMaxDynamicVertexBuffers; i++) {
+            buffers.append(cl::PMXAccelerator::VertexBufferBridge(buffer.findName(PrivateContext::dynamicVertexBufferType(i))));
+        }
         m_accelerator->upload(buffers, m_context->indexBuffer);
     }
 #endif
     m_modelRef->setVisible(true);
-    update(); // for updating even frame
-    update(); // for updating odd frame
+    for (int i = 0; i < kMaxDynamicVertexBuffers; i++) {
+        update(); // for filling all buffers of the ring
+    }
     VPVL2_VLOG(2, "Created the model: jp=" << internal::cstr(m_modelRef->name(IEncoding::kJapanese), "(null)") << " en=" << internal::cstr(m_modelRef->name(IEncoding::kEnglish), "(null)"));
     return ret;
 }
@@ -651,37 +786,126 @@ void PMXRenderEngine::release()
 }
 
 void PMXRenderEngine::update()
+{
+    if (beginUpdate()) {
+        performUpdate();
+        endUpdate();
+    }
+}
+
+bool PMXRenderEngine::beginUpdate()
 {
     if (!m_modelRef || !m_modelRef->isVisible() || !m_context)
+        return false;
+    const VertexBufferObjectType vbo = PrivateContext::dynamicVertexBufferType(m_context->updateSlot);
+    VertexBundle &buffer = m_context->buffer;
+    if (m_context->isStreamingUpload) {
+        /* all draw calls reading the last written buffer were issued before this */
+        buffer.fenceStream(PrivateContext::dynamicVertexBufferType(m_context->renderSlot()));
+        m_context->mappedAddress = buffer.mapStream(vbo);
+    }
+    else {
+        /* the mapped pointer stays valid after unbinding until the buffer is unmapped */
+        buffer.bind(VertexBundle::kVertexBuffer, vbo);
+        m_context->mappedAddress = buffer.map(VertexBundle::kVertexBuffer, 0, m_context->dynamicBuffer->size());
+        buffer.unbind(VertexBundle::kVertexBuffer);
+    }
+    return true;
+}
+
+void PMXRenderEngine::performUpdate()
+{
+    void *address = m_context ? m_context->mappedAddress : 0;
+    if (!address)
         return;
-    VertexBufferObjectType vbo = m_context->updateEven
-            ? kModelDynamicVertexBufferEven : kModelDynamicVertexBufferOdd;
-    IModel::DynamicVertexBuffer *dynamicBuffer = m_context->dynamicBuffer;
-    m_context->buffer.bind(VertexBundle::kVertexBuffer, vbo);
-    if (void *address = m_context->buffer.map(VertexBundle::kVertexBuffer, 0, dynamicBuffer->size())) {
-        const ICamera *camera = m_sceneRef->cameraRef();
-        dynamicBuffer->performTransform(address, camera->position());
+    cpu::PMXAccelerator *cpuAccelerator = m_context->cpuAccelerator;
+    if (m_context->isStreamingUpload) {
+        cpuAccelerator->updateStream(address, m_context->aabbMin, m_context->aabbMax);
+    }
+    else {
+        IModel::DynamicVertexBuffer *dynamicBuffer = m_context->dynamicBuffer;
+        if (cpuAccelerator) {
+            /* skinning and bounding box are computed in one pass to the same layout */
+            cpuAccelerator->update(dynamicBuffer, address, m_context->aabbMin, m_context->aabbMax);
+        }
+        else {
+            const ICamera *camera = m_sceneRef->cameraRef();
+            dynamicBuffer->performTransform(address, camera->position());
+        }
         if (m_context->isVertexShaderSkinning) {
             m_context->matrixBuffer->update(address);
         }
-        m_context->buffer.unmap(VertexBundle::kVertexBuffer, address);
     }
-    m_context->buffer.unbind(VertexBundle::kVertexBuffer);
+}
+
+void PMXRenderEngine::endUpdate()
+{
+    if (!m_modelRef || !m_modelRef->isVisible() || !m_context)
+        return;
+    const int slot = m_context->updateSlot;
+    VertexBufferObjectType vbo = PrivateContext::dynamicVertexBufferType(slot);
+    VertexBundle &buffer = m_context->buffer;
+    void *address = m_context->mappedAddress;
+    m_context->mappedAddress = 0;
+    if (m_context->isStreamingUpload) {
+        cpu::PMXAccelerator *cpuAccelerator = m_context->cpuAccelerator;
+        if (address) {
+            buffer.unmapStream(vbo, address);
+        }
+        if (cpuAccelerator->checkAttributesChanged(m_context->dynamicBuffer)) {
+            /* consecutive changed vertices are written at once */
+            const Array<int> &indices = cpuAccelerator->changedVertexIndices();
+            const vsize stride = cpu::PMXAccelerator::attributeStrideSize();
+            const int nindices = indices.count();
+            Array<uint8> &bytes = m_context->attributeBytes;
+            buffer.bind(VertexBundle::kVertexBuffer, kModelVertexAttributeBuffer);
+            for (int i = 0; i < nindices;) {
+                const int offset = indices[i];
+                int nvertices = 1;
+                while (++i < nindices && indices[i] == offset + nvertices) {
+                    nvertices++;
+                }
+                bytes.resize(int(nvertices * stride));
+                cpuAccelerator->updateAttributes(offset, nvertices, &bytes[0]);
+                buffer.write(VertexBundle::kVertexBuffer, offset * stride, nvertices * stride, &bytes[0]);
+            }
+            buffer.unbind(VertexBundle::kVertexBuffer);
+        }
+    }
+    else if (address) {
+        buffer.bind(VertexBundle::kVertexBuffer, vbo);
+        buffer.unmap(VertexBundle::kVertexBuffer, address);
+        buffer.unbind(VertexBundle::kVertexBuffer);
+    }
 #ifdef VPVL2_ENABLE_OPENCL
     if (m_accelerator && m_accelerator->isAvailable()) {
-        const cl::PMXAccelerator::VertexBufferBridge &buffer = m_context->buffers[m_context->updateEven ? 0 : 1];
-        m_accelerator->update(dynamicBuffer, buffer, m_context->aabbMin, m_context->aabbMax);
+        IModel::DynamicVertexBuffer *dynamicBuffer = m_context->dynamicBuffer;
+        const cl::PMXAccelerator::VertexBufferBridge &bridge = m_context->buffers[slot];
+        m_accelerator->update(dynamicBuffer, bridge, m_context->aabbMin, m_context->aabbMax);
     }
 #endif
     m_modelRef->setAabb(m_context->aabbMin, m_context->aabbMax);
-    m_context->updateEven = m_context->updateEven ? false :true;
+    m_context->updateSlot = (slot + 1) % kMaxDynamicVertexBuffers;
+    Array<IMaterial *> materials;
+    m_modelRef->getMaterialRefs(materials);
+    if (m_context->drawList.build(materials)) {
+        VPVL2_VLOG(2, "Rebuilt the draw list: materials=" << materials.count() << " model=" << m_context->drawList.countCommands(MaterialDrawList::kModelPass) << " edge=" << m_context->drawList.countCommands(MaterialDrawList::kEdgePass));
+    }
+    const RenderStatistics &statistics = m_context->statistics;
+    VPVL2_VLOG(3, "GL calls of the last frame: materials=" << statistics.numMaterialDraws << " draws=" << statistics.numDrawCalls << " uniforms=" << statistics.numUniformUpdates << " textures=" << statistics.numTextureBinds << " states=" << statistics.numStateChanges);
+    m_context->renderedPasses = PrivateContext::kAllPasses;
 }
 
 void PMXRenderEngine::setUpdateOptions(int options)
 {
     if (m_context) {
+        /* kLegacyVertexUpload is applied at PMXRenderEngine#upload */
+        m_context->updateOptions = options;
         IModel::DynamicVertexBuffer *dynamicBuffer = m_context->dynamicBuffer;
         dynamicBuffer->setParallelUpdateEnable(internal::hasFlagBits(options, kParallelUpdate));
+        if (cpu::PMXAccelerator *cpuAccelerator = m_context->cpuAccelerator) {
+            cpuAccelerator->setParallelUpdateEnable(internal::hasFlagBits(options, kParallelUpdate));
+        }
     }
 }
 
@@ -722,56 +946,47 @@ void PMXRenderEngine::renderModel(IEffect::Pass * /* overridePass */)
     modelProgram->setCameraPosition(m_sceneRef->cameraRef()->lookAt());
     const Scalar &opacity = m_modelRef->opacity();
     modelProgram->setOpacity(opacity);
-    Array<IMaterial *> materials;
-    m_modelRef->getMaterialRefs(materials);
-    const int nmaterials = materials.count();
+    const MaterialDrawList &drawList = m_context->drawList;
+    const int ncommands = drawList.countCommands(MaterialDrawList::kModelPass);
     const bool hasModelTransparent = !btFuzzyZero(opacity - 1.0f),
             isVertexShaderSkinning = m_context->isVertexShaderSkinning;
     const Vector3 &lc = light->color();
     bool &cullFaceState = m_context->cullFaceState;
-    Color diffuse, specular;
-    vsize offset = 0, size = m_context->indexBuffer->strideSize();
+    m_context->beginRenderPass(MaterialDrawList::kModelPass);
+    RenderStatistics &statistics = m_context->statistics;
+    const MaterialDrawList::State *lastState = 0;
+    vsize size = m_context->indexBuffer->strideSize();
     bindVertexBundle();
-    for (int i = 0; i < nmaterials; i++) {
-        const IMaterial *material = materials[i];
-        const MaterialTextureRefs &materialPrivate = m_context->materialTextureRefs[i];
-        const Color &ma = material->ambient(), &md = material->diffuse(), &ms = material->specular();
-        diffuse.setValue(ma.x() + md.x() * lc.x(), ma.y() + md.y() * lc.y(), ma.z() + md.z() * lc.z(), md.w());
-        specular.setValue(ms.x() * lc.x(), ms.y() * lc.y(), ms.z() * lc.z(), 1.0);
-        modelProgram->setMaterialColor(diffuse);
-        modelProgram->setMaterialSpecular(specular);
-        modelProgram->setMaterialShininess(material->shininess());
-        modelProgram->setMainTextureBlend(material->mainTextureBlend());
-        modelProgram->setSphereTextureBlend(material->sphereTextureBlend());
-        modelProgram->setToonTextureBlend(material->toonTextureBlend());
-        modelProgram->setMainTexture(materialPrivate.mainTextureRef);
-        modelProgram->setSphereTexture(materialPrivate.sphereTextureRef, material->sphereTextureRenderMode());
-        modelProgram->setToonTexture(materialPrivate.toonTextureRef);
-        if (textureID && material->isShadowMapEnabled())
-            modelProgram->setDepthTexture(textureID);
-        else
-            modelProgram->setDepthTexture(0);
+    for (int i = 0; i < ncommands; i++) {
+        const MaterialDrawList::Command &command = drawList.commandAt(MaterialDrawList::kModelPass, i);
+        const MaterialDrawList::State &state = drawList.stateAt(command.materialIndex);
+        m_context->applyModelState(state, lastState, lc, textureID);
         if (isVertexShaderSkinning) {
             const IModel::MatrixBuffer *matrixBuffer = m_context->matrixBuffer;
-            modelProgram->setBoneMatrices(matrixBuffer->bytes(i), matrixBuffer->size(i));
+            modelProgram->setBoneMatrices(matrixBuffer->bytes(command.materialIndex), matrixBuffer->size(command.materialIndex));
+            statistics.numUniformUpdates++;
         }
-        if (!hasModelTransparent && cullFaceState && material->isCullingDisabled()) {
+        if (!hasModelTransparent && cullFaceState && state.isCullingDisabled) {
             disable(kGL_CULL_FACE);
             cullFaceState = false;
+            statistics.numStateChanges++;
         }
-        else if (!cullFaceState && !material->isCullingDisabled()) {
+        else if (!cullFaceState && !state.isCullingDisabled) {
             enable(kGL_CULL_FACE);
             cullFaceState = true;
+            statistics.numStateChanges++;
         }
-        const int nindices = material->indexRange().count;
-        drawElements(kGL_TRIANGLES, nindices, m_context->indexType, reinterpret_cast<const GLvoid *>(offset));
-        offset += nindices * size;
+        drawElements(kGL_TRIANGLES, command.count, m_context->indexType, reinterpret_cast<const GLvoid *>(command.offset * size));
+        statistics.numMaterialDraws += command.numMaterials;
+        statistics.numDrawCalls++;
+        lastState = &state;
     }
     unbindVertexBundle();
     modelProgram->unbind();
     if (!cullFaceState) {
         enable(kGL_CULL_FACE);
         cullFaceState = true;
+        statistics.numStateChanges++;
     }
 }
 
@@ -791,27 +1006,28 @@ void PMXRenderEngine::renderShadow(IEffect::Pass * /* overridePass */)
     const ILight *light = m_sceneRef->lightRef();
     shadowProgram->setLightColor(light->color());
     shadowProgram->setLightDirection(light->direction());
-    Array<IMaterial *> materials;
-    m_modelRef->getMaterialRefs(materials);
-    const int nmaterials = materials.count();
+    const MaterialDrawList &drawList = m_context->drawList;
+    const int ncommands = drawList.countCommands(MaterialDrawList::kShadowPass);
     const bool isVertexShaderSkinning = m_context->isVertexShaderSkinning;
-    vsize offset = 0, size = m_context->indexBuffer->strideSize();
+    m_context->beginRenderPass(MaterialDrawList::kShadowPass);
+    RenderStatistics &statistics = m_context->statistics;
+    vsize size = m_context->indexBuffer->strideSize();
     bindVertexBundle();
     disable(kGL_CULL_FACE);
-    for (int i = 0; i < nmaterials; i++) {
-        const IMaterial *material = materials[i];
-        const int nindices = material->indexRange().count;
-        if (material->isCastingShadowEnabled()) {
-            if (isVertexShaderSkinning) {
-                const IModel::MatrixBuffer *matrixBuffer = m_context->matrixBuffer;
-                shadowProgram->setBoneMatrices(matrixBuffer->bytes(i), matrixBuffer->size(i));
-            }
-            drawElements(kGL_TRIANGLES, nindices, m_context->indexType, reinterpret_cast<const GLvoid *>(offset));
+    for (int i = 0; i < ncommands; i++) {
+        const MaterialDrawList::Command &command = drawList.commandAt(MaterialDrawList::kShadowPass, i);
+        if (isVertexShaderSkinning) {
+            const IModel::MatrixBuffer *matrixBuffer = m_context->matrixBuffer;
+            shadowProgram->setBoneMatrices(matrixBuffer->bytes(command.materialIndex), matrixBuffer->size(command.materialIndex));
+            statistics.numUniformUpdates++;
         }
-        offset += nindices * size;
+        drawElements(kGL_TRIANGLES, command.count, m_context->indexType, reinterpret_cast<const GLvoid *>(command.offset * size));
+        statistics.numMaterialDraws += command.numMaterials;
+        statistics.numDrawCalls++;
     }
     unbindVertexBundle();
     enable(kGL_CULL_FACE);
+    statistics.numStateChanges += 2;
     shadowProgram->unbind();
 }
 
@@ -830,40 +1046,53 @@ void PMXRenderEngine::renderEdge(IEffect::Pass * /* overridePass */)
                                        | IApplicationContext::kCameraMatrix);
     edgeProgram->setModelViewProjectionMatrix(matrix4x4);
     edgeProgram->setOpacity(opacity);
-    Array<IMaterial *> materials;
-    m_modelRef->getMaterialRefs(materials);
-    const int nmaterials = materials.count();
+    const MaterialDrawList &drawList = m_context->drawList;
+    const int ncommands = drawList.countCommands(MaterialDrawList::kEdgePass);
     const bool isVertexShaderSkinning = m_context->isVertexShaderSkinning;
     IVertex::EdgeSizePrecision edgeScaleFactor = 0;
     if (isVertexShaderSkinning) {
         const ICamera *camera = m_sceneRef->cameraRef();
         edgeScaleFactor = m_modelRef->edgeScaleFactor(camera->position());
     }
-    vsize offset = 0, size = m_context->indexBuffer->strideSize();
+    m_context->beginRenderPass(MaterialDrawList::kEdgePass);
+    RenderStatistics &statistics = m_context->statistics;
+    const MaterialDrawList::State *lastState = 0;
+    vsize size = m_context->indexBuffer->strideSize();
     bool isOpaque = btFuzzyZero(opacity - 1);
     if (isOpaque) {
         disable(kGL_BLEND);
+        statistics.numStateChanges++;
     }
     cullFace(kGL_FRONT);
+    statistics.numStateChanges++;
     bindEdgeBundle();
-    for (int i = 0; i < nmaterials; i++) {
-        const IMaterial *material = materials[i];
-        const int nindices = material->indexRange().count;
-        edgeProgram->setColor(material->edgeColor());
-        if (material->isEdgeEnabled()) {
-            if (isVertexShaderSkinning) {
-                const IModel::MatrixBuffer *matrixBuffer = m_context->matrixBuffer;
-                edgeProgram->setBoneMatrices(matrixBuffer->bytes(i), matrixBuffer->size(i));
-                edgeProgram->setSize(Scalar(material->edgeSize() * edgeScaleFactor));
+    for (int i = 0; i < ncommands; i++) {
+        const MaterialDrawList::Command &command = drawList.commandAt(MaterialDrawList::kEdgePass, i);
+        const MaterialDrawList::State &state = drawList.stateAt(command.materialIndex);
+        if (!lastState || lastState->edgeColor != state.edgeColor) {
+            edgeProgram->setColor(state.edgeColor);
+            statistics.numUniformUpdates++;
+        }
+        if (isVertexShaderSkinning) {
+            const IModel::MatrixBuffer *matrixBuffer = m_context->matrixBuffer;
+            edgeProgram->setBoneMatrices(matrixBuffer->bytes(command.materialIndex), matrixBuffer->size(command.materialIndex));
+            statistics.numUniformUpdates++;
+            if (!lastState || lastState->edgeSize != state.edgeSize) {
+                edgeProgram->setSize(Scalar(state.edgeSize * edgeScaleFactor));
+                statistics.numUniformUpdates++;
             }
-            drawElements(kGL_TRIANGLES, nindices, m_context->indexType, reinterpret_cast<const GLvoid *>(offset));
         }
-        offset += nindices * size;
+        drawElements(kGL_TRIANGLES, command.count, m_context->indexType, reinterpret_cast<const GLvoid *>(command.offset * size));
+        statistics.numMaterialDraws += command.numMaterials;
+        statistics.numDrawCalls++;
+        lastState = &state;
     }
     unbindVertexBundle();
     cullFace(kGL_BACK);
+    statistics.numStateChanges++;
     if (isOpaque) {
         enable(kGL_BLEND);
+        statistics.numStateChanges++;
     }
     edgeProgram->unbind();
 }
@@ -881,27 +1110,28 @@ void PMXRenderEngine::renderZPlot(IEffect::Pass * /* overridePass */)
                                        | IApplicationContext::kProjectionMatrix
                                        | IApplicationContext::kLightMatrix);
     zplotProgram->setModelViewProjectionMatrix(matrix4x4);
-    Array<IMaterial *> materials;
-    m_modelRef->getMaterialRefs(materials);
-    const int nmaterials = materials.count();
+    const MaterialDrawList &drawList = m_context->drawList;
+    const int ncommands = drawList.countCommands(MaterialDrawList::kZPlotPass);
     const bool isVertexShaderSkinning = m_context->isVertexShaderSkinning;
-    vsize offset = 0, size = m_context->indexBuffer->strideSize();
+    m_context->beginRenderPass(MaterialDrawList::kZPlotPass);
+    RenderStatistics &statistics = m_context->statistics;
+    vsize size = m_context->indexBuffer->strideSize();
     bindVertexBundle();
     disable(kGL_CULL_FACE);
-    for (int i = 0; i < nmaterials; i++) {
-        const IMaterial *material = materials[i];
-        const int nindices = material->indexRange().count;
-        if (material->isCastingShadowMapEnabled()) {
-            if (isVertexShaderSkinning) {
-                const IModel::MatrixBuffer *matrixBuffer = m_context->matrixBuffer;
-                zplotProgram->setBoneMatrices(matrixBuffer->bytes(i), matrixBuffer->size(i));
-            }
-            drawElements(kGL_TRIANGLES, nindices, m_context->indexType, reinterpret_cast<const GLvoid *>(offset));
+    for (int i = 0; i < ncommands; i++) {
+        const MaterialDrawList::Command &command = drawList.commandAt(MaterialDrawList::kZPlotPass, i);
+        if (isVertexShaderSkinning) {
+            const IModel::MatrixBuffer *matrixBuffer = m_context->matrixBuffer;
+            zplotProgram->setBoneMatrices(matrixBuffer->bytes(command.materialIndex), matrixBuffer->size(command.materialIndex));
+            statistics.numUniformUpdates++;
         }
-        offset += nindices * size;
+        drawElements(kGL_TRIANGLES, command.count, m_context->indexType, reinterpret_cast<const GLvoid *>(command.offset * size));
+        statistics.numMaterialDraws += command.numMaterials;
+        statistics.numDrawCalls++;
     }
     unbindVertexBundle();
     enable(kGL_CULL_FACE);
+    statistics.numStateChanges += 2;
     zplotProgram->unbind();
 }
 
@@ -950,6 +1180,16 @@ bool PMXRenderEngine::testVisible()
     return true;
 }
 
+void PMXRenderEngine::getRenderStatistics(RenderStatistics &value) const
+{
+    if (m_context) {
+        value = m_context->statistics;
+    }
+    else {
+        internal::zerofill(&value, sizeof(value));
+    }
+}
+
 bool PMXRenderEngine::createProgram(BaseShaderProgram *program,
                                     IApplicationContext::ShaderType vertexShaderType,
                                     IApplicationContext::ShaderType vertexSkinningShaderType,
@@ -965,9 +1205,17 @@ bool PMXRenderEngine::createProgram(BaseShaderProgram *program,
         vertexShaderSource = m_applicationContextRef->loadShaderSource(vertexShaderType, m_modelRef, userData);
     }
     fragmentShaderSource = m_applicationContextRef->loadShaderSource(fragmentShaderType, m_modelRef, userData);
-    program->addShaderSource(vertexShaderSource, ShaderProgram::kGL_VERTEX_SHADER);
-    program->addShaderSource(fragmentShaderSource, ShaderProgram::kGL_FRAGMENT_SHADER);
-    bool ok = program->linkProgram();
+    const std::string &cacheKey = BaseShaderProgram::makeCacheKey(m_applicationContextRef->sharedFunctionResolverInstance(),
+                                                                  vertexShaderSource, fragmentShaderSource);
+    bool ok = program->loadProgramBinary(cacheKey);
+    if (!ok) {
+        program->addShaderSource(vertexShaderSource, ShaderProgram::kGL_VERTEX_SHADER);
+        program->addShaderSource(fragmentShaderSource, ShaderProgram::kGL_FRAGMENT_SHADER);
+        ok = program->linkProgram();
+        if (ok) {
+            program->storeProgramBinary(cacheKey);
+        }
+    }
     delete vertexShaderSource;
     delete fragmentShaderSource;
     return ok;
@@ -1030,6 +1278,7 @@ bool PMXRenderEngine::uploadMaterials(void *userData)
                 return false;
             }
         }
+        m_context->drawList.setTextureRefs(i, materialPrivate.mainTextureRef, materialPrivate.sphereTextureRef, materialPrivate.toonTextureRef);
     }
     return true;
 }
@@ -1100,6 +1349,10 @@ void PMXRenderEngine::unbindVertexBundle()
 
 void PMXRenderEngine::bindDynamicVertexAttributePointers()
 {
+    if (m_context->isStreamingUpload) {
+        bindStreamVertexAttributePointers(false);
+        return;
+    }
     const IModel::DynamicVertexBuffer *dynamicBuffer = m_context->dynamicBuffer;
     vsize offset = dynamicBuffer->strideOffset(IModel::DynamicVertexBuffer::kVertexStride);
     const int size = int(dynamicBuffer->strideSize());
@@ -1118,6 +1371,10 @@ void PMXRenderEngine::bindDynamicVertexAttributePointers()
 
 void PMXRenderEngine::bindEdgeVertexAttributePointers()
 {
+    if (m_context->isStreamingUpload) {
+        bindStreamVertexAttributePointers(true);
+        return;
+    }
     const IModel::DynamicVertexBuffer *dynamicBuffer = m_context->dynamicBuffer;
     const int size = int(dynamicBuffer->strideSize());
     vsize offset = dynamicBuffer->strideOffset(m_context->isVertexShaderSkinning ? IModel::DynamicVertexBuffer::kVertexStride
@@ -1133,6 +1390,28 @@ void PMXRenderEngine::bindEdgeVertexAttributePointers()
     }
 }
 
+void PMXRenderEngine::bindStreamVertexAttributePointers(bool isEdge)
+{
+    int size = int(cpu::PMXAccelerator::streamStrideSize());
+    vsize offset = cpu::PMXAccelerator::streamStrideOffset(isEdge ? IModel::Buffer::kEdgeVertexStride : IModel::Buffer::kVertexStride);
+    vertexAttribPointer(IModel::Buffer::kVertexStride, 3, kGL_FLOAT, kGL_FALSE,
+                        size, reinterpret_cast<const GLvoid *>(offset));
+    enableVertexAttribArray(IModel::Buffer::kVertexStride);
+    if (!isEdge) {
+        offset = cpu::PMXAccelerator::streamStrideOffset(IModel::Buffer::kNormalStride);
+        vertexAttribPointer(IModel::Buffer::kNormalStride, 3, kGL_FLOAT, kGL_FALSE,
+                            size, reinterpret_cast<const GLvoid *>(offset));
+        enableVertexAttribArray(IModel::Buffer::kNormalStride);
+        /* UVA comes from the separated attribute buffer */
+        m_context->buffer.bind(VertexBundle::kVertexBuffer, kModelVertexAttributeBuffer);
+        size = int(cpu::PMXAccelerator::attributeStrideSize());
+        offset = cpu::PMXAccelerator::attributeStrideOffset(IModel::Buffer::kUVA1Stride);
+        vertexAttribPointer(IModel::Buffer::kUVA1Stride, 4, kGL_FLOAT, kGL_FALSE,
+                            size, reinterpret_cast<const GLvoid *>(offset));
+        enableVertexAttribArray(IModel::Buffer::kUVA1Stride);
+    }
+}
+
 void PMXRenderEngine::bindStaticVertexAttributePointers()
 {
     const IModel::StaticVertexBuffer *staticBuffer = m_context->staticBuffer;
@@ -117,45 +117,9 @@ static IEffect::Parameter::Type toEffectType(nvFX::IUniform::Type type)
 
 static void appendShaderHeader(nvFX::IContainer *container, const IApplicationContext::FunctionResolver *resolver)
 {
-    static const char kAppendingShaderHeader[] =
-            "#if defined(GL_ES) || __VERSION__ >= 150\n"
-            "precision highp float;\n"
-            "#else\n"
-            "#define highp\n"
-            "#define mediump\n"
-            "#define lowp\n"
-            "#endif\n"
-            "#if __VERSION__ >= 130\n"
-            "#define vpvl2FXGetTexturePixel2D(samp, uv) texture(samp, (uv))\n"
-            "#else\n"
-            "#define vpvl2FXGetTexturePixel2D(samp, uv) texture2D(samp, (uv))\n"
-            "#define layout(expr)\n"
-            "#endif\n"
-            "#if __VERSION__ >= 400\n"
-            "#define vpvl2FXFMA(v, m, a) fma((v), (m), (a))\n"
-            "#else\n"
-            "#define vpvl2FXFMA(v, m, a) ((v) * (m) + (a))\n"
-            "#endif\n"
-            "#define vpvl2FXSaturate(v) clamp((v), float(0), float(1))\n"
-            ;
-    char appendingHeader[1024];
-    int version = resolver->query(IApplicationContext::FunctionResolver::kQueryShaderVersion);
-    if (resolver->query(IApplicationContext::FunctionResolver::kQueryCoreProfile) != 0) {
-        static const char kFormat[] = "#version %d core\n%s";
-        internal::snprintf(appendingHeader, sizeof(appendingHeader), kFormat, version, kAppendingShaderHeader);
-    }
-    else {
-        static const char kFormat[] = "#version %d\n%s";
-        internal::snprintf(appendingHeader, sizeof(appendingHeader), kFormat, version, kAppendingShaderHeader);
-    }
-    int i = 0;
-    while (nvFX::IShader *shader = container->findShader(i++)) {
-        nvFX::TargetType type = shader->getType();
-        const char *name = shader->getName();
-        if (*name == '\0' && type == nvFX::TGLSL) {
-            shader->getExInterface()->addHeaderCode(appendingHeader);
-        }
-    }
+    EffectContext::appendShaderHeader(container,
+                                      resolver->query(IApplicationContext::FunctionResolver::kQueryShaderVersion),
+                                      resolver->query(IApplicationContext::FunctionResolver::kQueryCoreProfile) != 0);
 }
 
 struct Effect::NvFXAnnotation : IEffect::Annotation {
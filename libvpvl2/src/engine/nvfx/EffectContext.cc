@@ -49,6 +49,7 @@
 #ifndef GLhandleARB
 #define GLhandleARB void *
 #endif
+#include <FxLib.h>
 #include <FxParser.h>
 
 namespace {
@@ -174,6 +175,49 @@ void EffectContext::disableMessageCallback()
     nvFX::setMessageCallback(discardsMessageCallback);
 }
 
+void EffectContext::appendShaderHeader(void *container, int shaderVersion, bool enableCoreProfile)
+{
+    static const char kAppendingShaderHeader[] =
+            "#if defined(GL_ES) || __VERSION__ >= 150\n"
+            "precision highp float;\n"
+            "#else\n"
+            "#define highp\n"
+            "#define mediump\n"
+            "#define lowp\n"
+            "#endif\n"
+            "#if __VERSION__ >= 130\n"
+            "#define vpvl2FXGetTexturePixel2D(samp, uv) texture(samp, (uv))\n"
+            "#else\n"
+            "#define vpvl2FXGetTexturePixel2D(samp, uv) texture2D(samp, (uv))\n"
+            "#define layout(expr)\n"
+            "#endif\n"
+            "#if __VERSION__ >= 400\n"
+            "#define vpvl2FXFMA(v, m, a) fma((v), (m), (a))\n"
+            "#else\n"
+            "#define vpvl2FXFMA(v, m, a) ((v) * (m) + (a))\n"
+            "#endif\n"
+            "#define vpvl2FXSaturate(v) clamp((v), float(0), float(1))\n"
+            ;
+    char appendingHeader[1024];
+    if (enableCoreProfile) {
+        static const char kFormat[] = "#version %d core\n%s";
+        internal::snprintf(appendingHeader, sizeof(appendingHeader), kFormat, shaderVersion, kAppendingShaderHeader);
+    }
+    else {
+        static const char kFormat[] = "#version %d\n%s";
+        internal::snprintf(appendingHeader, sizeof(appendingHeader), kFormat, shaderVersion, kAppendingShaderHeader);
+    }
+    nvFX::IContainer *containerRef = static_cast<nvFX::IContainer *>(container);
+    int i = 0;
+    while (nvFX::IShader *shader = containerRef->findShader(i++)) {
+        nvFX::TargetType type = shader->getType();
+        const char *name = shader->getName();
+        if (*name == '\0' && type == nvFX::TGLSL) {
+            shader->getExInterface()->addHeaderCode(appendingHeader);
+        }
+    }
+}
+
 EffectContext::EffectContext()
 {
     enableMessageCallback();
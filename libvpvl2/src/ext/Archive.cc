@@ -37,6 +37,7 @@
 
 #include <vpvl2/vpvl2.h>
 #include <vpvl2/extensions/Archive.h>
+#include <vpvl2/internal/ParallelProcessors.h>
 #include <vpvl2/internal/util.h>
 
 #ifdef VPVL2_ENABLE_QT
@@ -48,11 +49,210 @@ using namespace vpvl2::VPVL2_VERSION_NS::extensions::icu4c;
 #endif
 
 #include <algorithm>
+#include <cstring>
 #include <map>
+#include <set>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "ioapi.h"
 #include "unzip.h"
 
+namespace {
+
+using namespace vpvl2;
+
+struct MappedRegion {
+    MappedRegion()
+        : address(0),
+          size(0),
+          opaque(0)
+    {
+    }
+    ~MappedRegion() {
+        unmap();
+    }
+
+    bool map(const char *path) {
+#ifdef _WIN32
+        /* the path is UTF-8 so it's converted to UTF-16 not to depend on the ANSI code page */
+        int length = ::MultiByteToWideChar(CP_UTF8, 0, path, -1, 0, 0);
+        if (length == 0) {
+            return false;
+        }
+        Array<wchar_t> widePath;
+        widePath.resize(length);
+        ::MultiByteToWideChar(CP_UTF8, 0, path, -1, &widePath[0], length);
+        HANDLE file = ::CreateFileW(&widePath[0], GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        opaque = reinterpret_cast<intptr_t>(file);
+        LARGE_INTEGER fileSize;
+        if (!::GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+            return false;
+        }
+        size = vsize(fileSize.QuadPart);
+        /* the view keeps the mapping object alive so its handle can be closed right after mapping */
+        HANDLE mapping = ::CreateFileMappingW(file, 0, PAGE_READONLY, 0, 0, 0);
+        if (!mapping) {
+            return false;
+        }
+        void *ptr = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        ::CloseHandle(mapping);
+        if (!ptr) {
+            return false;
+        }
+        address = static_cast<uint8 *>(ptr);
+#else
+        int fd = ::open(path, O_RDONLY);
+        if (fd == -1) {
+            return false;
+        }
+        opaque = fd;
+        struct stat sb;
+        if (::fstat(fd, &sb) == -1 || sb.st_size == 0) {
+            return false;
+        }
+        size = sb.st_size;
+        void *ptr = ::mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (ptr == MAP_FAILED) {
+            return false;
+        }
+        address = static_cast<uint8 *>(ptr);
+#endif
+        return true;
+    }
+    void unmap() {
+#ifdef _WIN32
+        if (address) {
+            ::UnmapViewOfFile(address);
+        }
+        if (HANDLE file = reinterpret_cast<HANDLE>(opaque)) {
+            ::CloseHandle(file);
+        }
+#else
+        if (address) {
+            ::munmap(address, size);
+        }
+        if (opaque > 0) {
+            ::close(int(opaque));
+        }
+#endif
+        address = 0;
+        size = 0;
+        opaque = 0;
+    }
+
+    uint8 *address;
+    vsize size;
+    intptr_t opaque;
+};
+
+/* minizip I/O functions reading from the mapped region so each thread can open its own handle */
+struct MemoryStream {
+    const MappedRegion *regionRef;
+    ZPOS64_T offset;
+};
+
+static voidpf ZCALLBACK OpenMemoryStream(voidpf opaque, const void * /* filename */, int mode)
+{
+    if ((mode & ZLIB_FILEFUNC_MODE_READWRITEFILTER) != ZLIB_FILEFUNC_MODE_READ) {
+        return 0;
+    }
+    MemoryStream *stream = new MemoryStream();
+    stream->regionRef = static_cast<const MappedRegion *>(opaque);
+    stream->offset = 0;
+    return stream;
+}
+
+static uLong ZCALLBACK ReadMemoryStream(voidpf /* opaque */, voidpf value, void *buf, uLong size)
+{
+    MemoryStream *stream = static_cast<MemoryStream *>(value);
+    const MappedRegion *regionRef = stream->regionRef;
+    ZPOS64_T rest = regionRef->size - stream->offset;
+    uLong nread = uLong(btMin(ZPOS64_T(size), rest));
+    memcpy(buf, regionRef->address + stream->offset, nread);
+    stream->offset += nread;
+    return nread;
+}
+
+static uLong ZCALLBACK WriteMemoryStream(voidpf /* opaque */, voidpf /* stream */, const void * /* buf */, uLong /* size */)
+{
+    return 0;
+}
+
+static ZPOS64_T ZCALLBACK TellMemoryStream(voidpf /* opaque */, voidpf value)
+{
+    return static_cast<const MemoryStream *>(value)->offset;
+}
+
+static long ZCALLBACK SeekMemoryStream(voidpf /* opaque */, voidpf value, ZPOS64_T offset, int origin)
+{
+    MemoryStream *stream = static_cast<MemoryStream *>(value);
+    ZPOS64_T size = stream->regionRef->size, newOffset = 0;
+    switch (origin) {
+    case ZLIB_FILEFUNC_SEEK_SET:
+        newOffset = offset;
+        break;
+    case ZLIB_FILEFUNC_SEEK_CUR:
+        newOffset = stream->offset + offset;
+        break;
+    case ZLIB_FILEFUNC_SEEK_END:
+        newOffset = size + offset;
+        break;
+    default:
+        return -1;
+    }
+    if (newOffset > size) {
+        return -1;
+    }
+    stream->offset = newOffset;
+    return 0;
+}
+
+static int ZCALLBACK CloseMemoryStream(voidpf /* opaque */, voidpf value)
+{
+    delete static_cast<MemoryStream *>(value);
+    return 0;
+}
+
+static int ZCALLBACK TestMemoryStreamError(voidpf /* opaque */, voidpf /* stream */)
+{
+    return 0;
+}
+
+static bool IsASCIIString(const std::string &value)
+{
+    for (std::string::const_iterator it = value.begin(); it != value.end(); ++it) {
+        if (static_cast<uint8>(*it) >= 0x80) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::string ToLowerASCIIString(const std::string &value)
+{
+    std::string ln = value;
+    for (std::string::iterator it = ln.begin(), end = ln.end(); it != end; ++it) {
+        const unsigned char c = static_cast<unsigned char>(*it);
+        if (c >= 'A' && c <= 'Z') {
+            *it = static_cast<char>(c - 'A' + 'a');
+        }
+    }
+    return ln;
+}
+
+}
+
 namespace vpvl2
 {
 namespace VPVL2_VERSION_NS
@@ -61,60 +261,251 @@ namespace extensions
 {
 
 struct Archive::PrivateContext {
+    struct Entry {
+        Entry(const std::string &name, const unz64_file_pos &position, const unz_file_info64 &info)
+            : name(name),
+              position(position),
+              uncompressedSize(vsize(info.uncompressed_size)),
+              compressionMethod(int(info.compression_method)),
+              bytes(0),
+              mappedAddress(0)
+        {
+        }
+        ~Entry() {
+            internal::deleteObject(bytes);
+            mappedAddress = 0;
+        }
+        bool isStored() const {
+            return compressionMethod == 0;
+        }
+
+        const std::string name;
+        const unz64_file_pos position;
+        const vsize uncompressedSize;
+        const int compressionMethod;
+        std::string *bytes;
+        const uint8 *mappedAddress;
+    };
+    struct UncompressTask {
+        void execute() const {
+            std::string *bytes = new std::string();
+            if (contextRef->readEntry(entryRef, *bytes, errorRef)) {
+                entryRef->bytes = bytes;
+            }
+            else {
+                internal::deleteObject(bytes);
+            }
+        }
+        const PrivateContext *contextRef;
+        Entry *entryRef;
+        Archive::ErrorType *errorRef;
+    };
+    typedef std::map<std::string, Entry *> EntryMap;
+
     PrivateContext(IEncoding *encodingRef)
         : file(0),
           error(kNone),
           encodingRef(encodingRef)
     {
+        functions.zopen64_file = OpenMemoryStream;
+        functions.zread_file = ReadMemoryStream;
+        functions.zwrite_file = WriteMemoryStream;
+        functions.ztell64_file = TellMemoryStream;
+        functions.zseek64_file = SeekMemoryStream;
+        functions.zclose_file = CloseMemoryStream;
+        functions.zerror_file = TestMemoryStreamError;
+        functions.opaque = &region;
     }
     ~PrivateContext() {
         close();
     }
 
+    unzFile openHandle() const {
+        return unzOpen2_64(&region, const_cast<zlib_filefunc64_def *>(&functions));
+    }
     bool close() {
-        originalEntries.clear();
-        unicodePath2RawPath.clear();
-        int ret = unzClose(file);
+        for (EntryMap::iterator it = entries.begin(); it != entries.end(); ++it) {
+            delete it->second;
+        }
+        entries.clear();
+        int ret = file ? unzClose(file) : Z_OK;
         file = 0;
+        region.unmap();
         return ret == Z_OK;
     }
-    bool uncompressEntry(const std::string &entry, const unz_file_info &finfo) {
-        std::string &bytes = originalEntries[entry];
-        uint32 size(finfo.uncompressed_size);
+    bool buildIndex(EntryNames &names) {
+        unz_file_info64 info;
+        unz64_file_pos position;
+        std::string path, value;
+        uLong nentries = header.number_entry;
+        int err = UNZ_OK;
+        for (uLong i = 0; i < nentries; i++) {
+            err = unzGetCurrentFileInfo64(file, &info, 0, 0, 0, 0, 0, 0);
+            if (err == UNZ_OK && (info.compression_method == 0 || info.compression_method == Z_DEFLATED)) {
+                path.resize(info.size_filename);
+                err = unzGetCurrentFileInfo64(file, &info, &path[0], info.size_filename, 0, 0, 0, 0);
+                if (err == UNZ_OK) {
+                    /* Shift_JIS conversion is required only for non ASCII filename */
+                    if (IsASCIIString(path)) {
+                        value = path;
+                    }
+                    else {
+                        const uint8 *ptr = reinterpret_cast<const uint8 *>(path.data());
+                        IString *s = encodingRef->toString(ptr, path.size(), IString::kShiftJIS);
+                        value = String::toStdString(static_cast<const String *>(s)->value());
+                        internal::deleteObject(s);
+                    }
+                    unzGetFilePos64(file, &position);
+                    Entry *&entryRef = entries[normalizeName(value)];
+                    internal::deleteObject(entryRef);
+                    entryRef = new Entry(value, position, info);
+                    names.push_back(value);
+                }
+                else {
+                    VPVL2_LOG(WARNING, "Cannot get current file " << path << " in zip: " << err);
+                    error = kGetCurrentFileError;
+                    break;
+                }
+            }
+            else {
+                VPVL2_LOG(WARNING, "Cannot get current file " << path << " in zip: " << err);
+                error = kGetCurrentFileError;
+                break;
+            }
+            if (i + 1 < nentries) {
+                err = unzGoToNextFile(file);
+                if (err != UNZ_OK) {
+                    VPVL2_LOG(WARNING, "Cannot seek next current file from " << path << " in zip: " << err);
+                    error = kGoToNextFileError;
+                    break;
+                }
+            }
+        }
+        return err == UNZ_OK;
+    }
+    /* entries are compared case insensitively including non ASCII letters such as fullwidth ones */
+    std::string normalizeName(const std::string &value) const {
+        if (IsASCIIString(value)) {
+            return ToLowerASCIIString(value);
+        }
+        const uint8 *ptr = reinterpret_cast<const uint8 *>(value.data());
+        IString *s = encodingRef->toString(ptr, value.size(), IString::kUTF8);
+        const std::string &ln = String::toStdString(static_cast<const String *>(s)->value().toLower());
+        internal::deleteObject(s);
+        return ln;
+    }
+    Entry *findEntry(const std::string &name) const {
+        EntryMap::const_iterator it = entries.find(normalizeName(name));
+        return it != entries.end() ? it->second : 0;
+    }
+    const uint8 *locateStoredData(const Entry *entry) const {
+        const uint8 *address = 0;
+        if (entry->isStored()) {
+            if (unzFile handle = openHandle()) {
+                if (unzGoToFilePos64(handle, &entry->position) == UNZ_OK && unzOpenCurrentFile(handle) == UNZ_OK) {
+                    ZPOS64_T offset = unzGetCurrentFileZStreamPos64(handle);
+                    if (offset + entry->uncompressedSize <= region.size) {
+                        address = region.address + offset;
+                    }
+                    unzCloseCurrentFile(handle);
+                }
+                unzClose(handle);
+            }
+        }
+        return address;
+    }
+    const uint8 *resolveMappedAddress(Entry *entry) const {
+        if (!entry->mappedAddress) {
+            entry->mappedAddress = locateStoredData(entry);
+        }
+        return entry->mappedAddress;
+    }
+    /* opens an own handle so this can be called from several threads at the same time */
+    bool readEntry(const Entry *entry, std::string &bytes, Archive::ErrorType *errorRef) const {
+        vsize size = entry->uncompressedSize;
         bytes.resize(size);
-        VPVL2_VLOG(2, "filename=" << entry << " size=" << size);
-        int err = unzOpenCurrentFile(file);
-        if (err != Z_OK) {
-            VPVL2_LOG(WARNING, "Cannot open the file " << entry << " in zip: " << err);
-            error = kOpenCurrentFileError;
+        if (size == 0) {
+            return true;
+        }
+        if (const uint8 *address = entry->mappedAddress ? entry->mappedAddress : locateStoredData(entry)) {
+            memcpy(&bytes[0], address, size);
+            return true;
+        }
+        unzFile handle = openHandle();
+        if (!handle) {
+            *errorRef = kOpenCurrentFileError;
+            return false;
+        }
+        VPVL2_VLOG(2, "filename=" << entry->name << " size=" << size);
+        int err = unzGoToFilePos64(handle, &entry->position);
+        if (err != UNZ_OK) {
+            VPVL2_LOG(WARNING, "Cannot locate to the file " << entry->name << " in zip: " << err);
+            *errorRef = kGetCurrentFileError;
+            unzClose(handle);
+            return false;
+        }
+        err = unzOpenCurrentFile(handle);
+        if (err != UNZ_OK) {
+            VPVL2_LOG(WARNING, "Cannot open the file " << entry->name << " in zip: " << err);
+            *errorRef = kOpenCurrentFileError;
+            unzClose(handle);
             return false;
         }
-        err = unzReadCurrentFile(file, &bytes[0], size);
+        err = unzReadCurrentFile(handle, &bytes[0], unsigned(size));
         if (err < 0) {
-            VPVL2_LOG(WARNING, "Cannot read the file " << entry << " in zip: " << err);
-            error = kReadCurrentFileError;
+            VPVL2_LOG(WARNING, "Cannot read the file " << entry->name << " in zip: " << err);
+            *errorRef = kReadCurrentFileError;
+            unzCloseCurrentFile(handle);
+            unzClose(handle);
             return false;
         }
-        err = unzCloseCurrentFile(file);
-        if (err != Z_OK) {
-            VPVL2_LOG(WARNING, "Cannot close the file " << entry << " in zip: " << err);
-            error = kCloseCurrentFileError;
+        err = unzCloseCurrentFile(handle);
+        unzClose(handle);
+        if (err != UNZ_OK) {
+            VPVL2_LOG(WARNING, "Cannot close the file " << entry->name << " in zip: " << err);
+            *errorRef = kCloseCurrentFileError;
             return false;
         }
         return true;
     }
+    bool uncompressEntries(const Array<Entry *> &targets) {
+        const int ntargets = targets.count();
+        Array<UncompressTask> tasks;
+        Array<Archive::ErrorType> errors;
+        tasks.resize(ntargets);
+        errors.resize(ntargets);
+        for (int i = 0; i < ntargets; i++) {
+            UncompressTask &task = tasks[i];
+            task.contextRef = this;
+            task.entryRef = targets[i];
+            task.errorRef = &errors[i];
+            errors[i] = kNone;
+        }
+        /* resolve addresses of stored entries first not to write them from several threads */
+        for (int i = 0; i < ntargets; i++) {
+            resolveMappedAddress(targets[i]);
+        }
+        internal::ParallelExecuteTaskProcessor<UncompressTask> processor(&tasks);
+        processor.execute(ntargets > 1);
+        for (int i = 0; i < ntargets; i++) {
+            if (errors[i] != kNone) {
+                error = errors[i];
+                return false;
+            }
+        }
+        return true;
+    }
     std::string resolvePath(const std::string &value) const {
         return basePath.empty() ? value : basePath + "/" + value;
     }
 
-    typedef std::map<std::string, std::string> EntryDataMap;
-    typedef std::map<std::string, std::string> UnicodePath2RawPathMap;
+    MappedRegion region;
+    zlib_filefunc64_def functions;
     unzFile file;
-    unz_global_info header;
+    unz_global_info64 header;
     Archive::ErrorType error;
     const IEncoding *encodingRef;
-    EntryDataMap originalEntries;
-    UnicodePath2RawPathMap unicodePath2RawPath;
+    EntryMap entries;
     std::string basePath;
 };
 
@@ -130,55 +521,25 @@ Archive::~Archive()
 
 bool Archive::open(const IString *filename, EntryNames &entries)
 {
-    m_context->file = unzOpen(reinterpret_cast<const char *>(filename->toByteArray()));
+    m_context->close();
+    const char *path = reinterpret_cast<const char *>(filename->toByteArray());
+    if (!m_context->region.map(path)) {
+        VPVL2_LOG(WARNING, "Cannot map the archive " << path);
+        m_context->error = kMapFileError;
+        m_context->region.unmap();
+        return false;
+    }
+    m_context->file = m_context->openHandle();
     if (m_context->file) {
-        unz_file_info info;
-        std::string path;
-        int err = unzGetGlobalInfo(m_context->file, &m_context->header);
-        if (err == UNZ_OK) {
-            uLong nentries = m_context->header.number_entry;
-            for (uLong i = 0; i < nentries; i++) {
-                err = unzGetCurrentFileInfo(m_context->file, &info, 0, 0, 0, 0, 0, 0);
-                if (err == UNZ_OK && (info.compression_method == 0 || info.compression_method == Z_DEFLATED)) {
-                    path.resize(info.size_filename);
-                    err = unzGetCurrentFileInfo(m_context->file, &info, &path[0], info.size_filename, 0, 0, 0, 0);
-                    if (err == UNZ_OK) {
-                        const uint8 *ptr = reinterpret_cast<const uint8 *>(path.data());
-                        IString *s = m_context->encodingRef->toString(ptr, path.size(), IString::kShiftJIS);
-                        const std::string &value = String::toStdString(static_cast<const String *>(s)->value());
-                        entries.push_back(value);
-                        m_context->unicodePath2RawPath.insert(std::make_pair(value, path));
-                        internal::deleteObject(s);
-                    }
-                    else {
-                        VPVL2_LOG(WARNING, "Cannot get current file " << path << " in zip: " << err);
-                        m_context->error = kGetCurrentFileError;
-                        break;
-                    }
-                }
-                else {
-                    VPVL2_LOG(WARNING, "Cannot get current file " << path << " in zip: " << err);
-                    m_context->error = kGetCurrentFileError;
-                    break;
-                }
-                if (i + 1 < nentries) {
-                    err = unzGoToNextFile(m_context->file);
-                    if (err != UNZ_OK) {
-                        VPVL2_LOG(WARNING, "Cannot seek next current file from " << path << " in zip: " << err);
-                        m_context->error = kGoToNextFileError;
-                        break;
-                    }
-                }
-            }
-            if (err == Z_OK) {
-                err = unzGoToFirstFile(m_context->file);
-                if (err != Z_OK) {
-                    VPVL2_LOG(WARNING, "Cannot seek to the first file in zip: " << err);
-                    m_context->error = kGoToFirstFileError;
-                }
+        int err = unzGetGlobalInfo64(m_context->file, &m_context->header);
+        if (err == UNZ_OK && m_context->buildIndex(entries)) {
+            err = unzGoToFirstFile(m_context->file);
+            if (err != UNZ_OK) {
+                VPVL2_LOG(WARNING, "Cannot seek to the first file in zip: " << err);
+                m_context->error = kGoToFirstFileError;
             }
+            return err == UNZ_OK;
         }
-        return err == Z_OK;
     }
     return false;
 }
@@ -193,72 +554,31 @@ bool Archive::uncompress(const EntrySet &entries)
     if (m_context->file == 0) {
         return false;
     }
-    unz_file_info info;
-    std::string filename, entry;
-    uLong nentries = m_context->header.number_entry;
-    int err = Z_OK;
-    for (uLong i = 0; i < nentries; i++) {
-        err = unzGetCurrentFileInfo(m_context->file, &info, 0, 0, 0, 0, 0, 0);
-        if (err == UNZ_OK && (info.compression_method == 0 || info.compression_method == Z_DEFLATED)) {
-            filename.resize(info.size_filename);
-            err = unzGetCurrentFileInfo(m_context->file, &info, &filename[0], info.size_filename, 0, 0, 0, 0);
-            if (err == UNZ_OK) {
-                const uint8 *ptr = reinterpret_cast<const uint8 *>(filename.data());
-                if (IString *name = m_context->encodingRef->toString(ptr, filename.size(), IString::kShiftJIS)) {
-                    /* normalize filename with lower */
-                    entry.assign(String::toStdString(static_cast<const String *>(name)->value().toLower()));
-                    internal::deleteObject(name);
-                }
-                if (entries.find(entry) != entries.end() && !m_context->uncompressEntry(entry, info)) {
-                    return false;
-                }
-            }
-            else {
-                m_context->error = kGetCurrentFileError;
-                break;
-            }
-        }
-        else {
-            m_context->error = kGetCurrentFileError;
-            break;
-        }
-        if (i + 1 < nentries) {
-            err = unzGoToNextFile(m_context->file);
-            if (err != UNZ_OK) {
-                VPVL2_LOG(WARNING, "Cannot seek next current file in zip: " << err);
-                m_context->error = kGoToNextFileError;
-                break;
-            }
+    /* different names may point the same entry as they are compared case insensitively */
+    std::set<PrivateContext::Entry *> found;
+    Array<PrivateContext::Entry *> targets;
+    for (EntrySet::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+        PrivateContext::Entry *entry = m_context->findEntry(*it);
+        if (entry && !entry->bytes && found.insert(entry).second) {
+            targets.append(entry);
         }
     }
-    if (err == Z_OK) {
-        err = unzGoToFirstFile(m_context->file);
-        if (err != Z_OK) {
-            VPVL2_LOG(WARNING, "Cannot seek to the first file in zip: " << err);
-            m_context->error = kGoToFirstFileError;
-        }
-    }
-    return err == Z_OK;
+    return m_context->uncompressEntries(targets);
 }
 
 bool Archive::uncompressEntry(const std::string &name)
 {
-    const std::string &key = m_context->resolvePath(name);
-    PrivateContext::UnicodePath2RawPathMap::const_iterator it = m_context->unicodePath2RawPath.find(key);
-    bool ok = false;
-    if (it != m_context->unicodePath2RawPath.end()) {
-        int err = unzLocateFile(m_context->file, it->second.c_str(), 1);
-        if (err == Z_OK) {
-            unz_file_info finfo;
-            unzGetCurrentFileInfo(m_context->file, &finfo, 0, 0, 0, 0, 0, 0);
-            ok = m_context->uncompressEntry(it->first, finfo);
-            unzGoToFirstFile(m_context->file);
-        }
-        else {
-            VPVL2_LOG(WARNING, "Cannot locate to the file << " << name << " in zip: " << err);
-        }
-    }
-    return ok;
+    PrivateContext::Entry *entry = m_context->findEntry(m_context->resolvePath(name));
+    if (!entry) {
+        VPVL2_LOG(WARNING, "Cannot locate to the file << " << name << " in zip");
+        return false;
+    }
+    else if (entry->bytes) {
+        return true;
+    }
+    Array<PrivateContext::Entry *> targets;
+    targets.append(entry);
+    return m_context->uncompressEntries(targets);
 }
 
 void Archive::setBasePath(const std::string &value)
@@ -273,10 +593,12 @@ Archive::ErrorType Archive::error() const
 
 const Archive::EntryNames Archive::entryNames() const
 {
-    PrivateContext::EntryDataMap::const_iterator it = m_context->originalEntries.begin();
+    PrivateContext::EntryMap::const_iterator it = m_context->entries.begin();
     EntryNames names;
-    while (it != m_context->originalEntries.end()) {
-        names.push_back(it->first);
+    while (it != m_context->entries.end()) {
+        if (it->second->bytes) {
+            names.push_back(it->first);
+        }
         ++it;
     }
     return names;
@@ -284,10 +606,45 @@ const Archive::EntryNames Archive::entryNames() const
 
 const std::string *Archive::dataRef(const std::string &name) const
 {
-    std::string ln = name;
-    std::transform(ln.begin(), ln.end(), ln.begin(), ::tolower);
-    PrivateContext::EntryDataMap::const_iterator it = m_context->originalEntries.find(m_context->resolvePath(ln));
-    return it != m_context->originalEntries.end() ? &it->second : 0;
+    const PrivateContext::Entry *entry = m_context->findEntry(m_context->resolvePath(name));
+    return entry ? entry->bytes : 0;
+}
+
+const uint8 *Archive::mappedDataRef(const std::string &name, vsize &size)
+{
+    if (PrivateContext::Entry *entry = m_context->findEntry(m_context->resolvePath(name))) {
+        if (const uint8 *address = m_context->resolveMappedAddress(entry)) {
+            size = entry->uncompressedSize;
+            return address;
+        }
+    }
+    size = 0;
+    return 0;
+}
+
+bool Archive::readEntry(const std::string &name, std::string &bytes) const
+{
+    if (const PrivateContext::Entry *entry = m_context->findEntry(m_context->resolvePath(name))) {
+        Archive::ErrorType error = kNone;
+        return m_context->readEntry(entry, bytes, &error);
+    }
+    return false;
+}
+
+void Archive::releaseEntry(const std::string &name)
+{
+    if (PrivateContext::Entry *entry = m_context->findEntry(m_context->resolvePath(name))) {
+        internal::deleteObject(entry->bytes);
+    }
+}
+
+void Archive::releaseAllEntries()
+{
+    PrivateContext::EntryMap::const_iterator it = m_context->entries.begin();
+    while (it != m_context->entries.end()) {
+        internal::deleteObject(it->second->bytes);
+        ++it;
+    }
 }
 
 } /* namespace extensions */
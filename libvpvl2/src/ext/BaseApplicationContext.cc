@@ -43,9 +43,15 @@
 #include <vpvl2/extensions/Archive.h>
 #include <vpvl2/extensions/StringMap.h>
 #include <vpvl2/extensions/SimpleShadowMap.h>
+#include <vpvl2/extensions/TextureCache.h>
 #include <vpvl2/extensions/fx/Util.h>
 #include <vpvl2/gl/FrameBufferObject.h>
 #include <vpvl2/gl/Texture2D.h>
+#include <vpvl2/internal/Mutex.h>
+
+#ifdef VPVL2_LINK_INTEL_TBB
+#include <tbb/task_group.h>
+#endif
 
 #ifdef VPVL2_ENABLE_EXTENSION_ARCHIVE
 #include <vpvl2/extensions/Archive.h>
@@ -81,6 +87,7 @@ typedef unsigned int ETwMouseAction;
 #endif
 
 /* STL */
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -348,6 +355,30 @@ static inline IString *toIStringFromUtf8(const std::string &bytes)
     return bytes.empty() ? 0 : String::create(bytes);
 }
 
+static std::string toTextureName(const IString *name)
+{
+    std::string newName = static_cast<const String *>(name)->toStdString();
+    std::string::size_type pos(newName.find('\\'));
+    while (pos != std::string::npos) {
+        newName.replace(pos, 1, "/");
+        pos = newName.find('\\', pos + 1);
+    }
+    return newName;
+}
+
+static void flipImageVertically(stbi_uc *ptr, int width, int height, int ncomponents)
+{
+    const vsize stride = vsize(width) * ncomponents;
+    std::vector<stbi_uc> row(stride);
+    for (int j = 0, half = height >> 1; j < half; ++j) {
+        stbi_uc *p1 = ptr + j * stride;
+        stbi_uc *p2 = ptr + (height - 1 - j) * stride;
+        std::memcpy(&row[0], p1, stride);
+        std::memcpy(p1, p2, stride);
+        std::memcpy(p2, &row[0], stride);
+    }
+}
+
 } /* namespace anonymous */
 
 namespace vpvl2
@@ -358,22 +389,181 @@ namespace extensions
 {
 using namespace gl;
 
+struct BaseApplicationContext::ModelContext::DecodedImage {
+    enum State {
+        kPending,
+        kDecoding,
+        kDecoded
+    };
+    DecodedImage(const std::string &key, const std::string &path, int flags)
+        : key(key),
+          path(path),
+          size(kZeroV3),
+          flags(flags),
+          state(kPending)
+    {
+    }
+    ~DecodedImage() {
+    }
+    const std::string key;
+    const std::string path;
+    std::string sharedKey;
+    Array<uint8> pixels;
+    Vector3 size;
+    const int flags;
+    State state;
+};
+
+/* decodes images on worker threads, only DecodedImage objects and both queues are shared with them */
+struct BaseApplicationContext::ModelContext::TextureDecoder {
+    typedef std::map<std::string, DecodedImage *> DecodedImageMap;
+    struct DecodeNextImageTask {
+        DecodeNextImageTask(TextureDecoder *decoder)
+            : decoderRef(decoder)
+        {
+        }
+        void operator()() const {
+            decoderRef->decodeNextImage();
+        }
+        TextureDecoder *decoderRef;
+    };
+
+    TextureDecoder(const BaseApplicationContext *applicationContextRef, const Archive *archiveRef, bool flipVertically)
+        : applicationContextRef(applicationContextRef),
+          archiveRef(archiveRef),
+          flipVertically(flipVertically)
+    {
+    }
+    ~TextureDecoder() {
+        {
+            /* images not started yet are never decoded */
+            internal::ScopedLock lock(mutex);
+            pendingImages.clear();
+        }
+#ifdef VPVL2_LINK_INTEL_TBB
+        taskGroup.wait();
+#endif
+        for (DecodedImageMap::const_iterator it = images.begin(); it != images.end(); it++) {
+            delete it->second;
+        }
+        images.clear();
+    }
+
+    void enqueue(DecodedImage *image) {
+        images.insert(std::make_pair(image->key, image));
+        internal::ScopedLock lock(mutex);
+        pendingImages.append(image);
+    }
+    void start() {
+        int nimages = 0;
+        {
+            internal::ScopedLock lock(mutex);
+            nimages = pendingImages.count();
+        }
+        VPVL2_VLOG(2, "Decoding " << nimages << " textures of the model");
+#ifdef VPVL2_LINK_INTEL_TBB
+        for (int i = 0; i < nimages; i++) {
+            taskGroup.run(DecodeNextImageTask(this));
+        }
+#endif
+    }
+    bool decodeNextImage() {
+        DecodedImage *image = 0;
+        {
+            internal::ScopedLock lock(mutex);
+            const int nimages = pendingImages.count();
+            if (nimages == 0) {
+                return false;
+            }
+            image = pendingImages[nimages - 1];
+            pendingImages.removeAt(nimages - 1);
+            image->state = DecodedImage::kDecoding;
+        }
+        decode(image);
+        internal::ScopedLock lock(mutex);
+        image->state = DecodedImage::kDecoded;
+        decodedImages.append(image);
+        return true;
+    }
+    void decode(DecodedImage *image) const {
+        MapBuffer buffer(applicationContextRef);
+        std::string bytes;
+        const uint8 *data = 0;
+        vsize size = 0;
+        if (archiveRef) {
+            /* readEntry opens its own handle so entries can be read concurrently */
+            if (archiveRef->readEntry(image->key, bytes)) {
+                data = reinterpret_cast<const uint8 *>(bytes.data());
+                size = bytes.size();
+            }
+        }
+        else if (applicationContextRef->mapFile(image->path, &buffer)) {
+            data = buffer.address;
+            size = buffer.size;
+        }
+        if (data && size > 0 && applicationContextRef->decodeTextureOpaque(data, size, flipVertically, image->size, image->pixels)) {
+            image->sharedKey = TextureCache::makeKey(data, size, image->flags, flipVertically);
+        }
+    }
+    void takeDecodedImages(Array<DecodedImage *> &value) {
+        internal::ScopedLock lock(mutex);
+        value.copy(decodedImages);
+        decodedImages.clear();
+    }
+    /* returns the image only if no worker is decoding it */
+    DecodedImage *take(const std::string &key) {
+        DecodedImageMap::iterator it = images.find(key);
+        if (it == images.end()) {
+            return 0;
+        }
+        DecodedImage *image = it->second;
+        internal::ScopedLock lock(mutex);
+        switch (image->state) {
+        case DecodedImage::kPending:
+            pendingImages.remove(image);
+            break;
+        case DecodedImage::kDecoded:
+            decodedImages.remove(image);
+            break;
+        case DecodedImage::kDecoding:
+        default:
+            return 0;
+        }
+        images.erase(it);
+        return image;
+    }
+    void remove(DecodedImage *image) {
+        images.erase(image->key);
+    }
+
+    const BaseApplicationContext *applicationContextRef;
+    const Archive *archiveRef;
+    const bool flipVertically;
+    /* images is only accessed on the thread owning ModelContext */
+    DecodedImageMap images;
+    internal::Mutex mutex;
+    Array<DecodedImage *> pendingImages;
+    Array<DecodedImage *> decodedImages;
+#ifdef VPVL2_LINK_INTEL_TBB
+    tbb::task_group taskGroup;
+#endif
+};
+
 BaseApplicationContext::ModelContext::ModelContext(BaseApplicationContext *applicationContextRef, extensions::Archive *archiveRef, const IString *directory, bool flipVertically)
     : m_directoryRef(directory),
       m_archiveRef(archiveRef),
       m_applicationContextRef(applicationContextRef),
-      m_maxAnisotropyValue(0),
+      m_textureDecoder(new TextureDecoder(applicationContextRef, archiveRef, flipVertically)),
+      m_maxAnisotropyValue(-1),
       m_flipVertically(flipVertically)
 {
-    IApplicationContext::FunctionResolver *resolver = applicationContextRef->sharedFunctionResolverInstance();
-    if (resolver->hasExtension("EXT_texture_filter_anisotropic")) {
-        typedef void (GLAPIENTRY * PFNGLGETFLOATVPROC)(GLenum pname, GLfloat *values);
-        reinterpret_cast<PFNGLGETFLOATVPROC>(resolver->resolveSymbol("glGetFloatv"))(BaseTexture::kGL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &m_maxAnisotropyValue);
-    }
+    /* GL is not touched here to start decoding textures before the model is uploaded on the render thread */
 }
 
 BaseApplicationContext::ModelContext::~ModelContext()
 {
+    /* waits for images being decoded and deletes images never requested by the render engine */
+    internal::deleteObject(m_textureDecoder);
     m_archiveRef = 0;
     m_applicationContextRef = 0;
     m_directoryRef = 0;
@@ -402,23 +592,72 @@ void BaseApplicationContext::ModelContext::storeTexture(const std::string &key,
     VPVL2_DCHECK(!key.empty());
     if (textureRef) {
         pushAnnotationGroup("BaseApplicationContext::ModelContext#cacheTexture", m_applicationContextRef);
-        textureRef->bind();
-        textureRef->setParameter(BaseTexture::kGL_TEXTURE_MAG_FILTER, int(BaseTexture::kGL_LINEAR));
-        textureRef->setParameter(BaseTexture::kGL_TEXTURE_MIN_FILTER, int(BaseTexture::kGL_LINEAR));
-        if (internal::hasFlagBits(flags, IApplicationContext::kToonTexture)) {
-            textureRef->setParameter(BaseTexture::kGL_TEXTURE_WRAP_S, int(BaseTexture::kGL_CLAMP_TO_EDGE));
-            textureRef->setParameter(BaseTexture::kGL_TEXTURE_WRAP_T, int(BaseTexture::kGL_CLAMP_TO_EDGE));
-        }
-        if (m_maxAnisotropyValue > 0) {
-            textureRef->setParameter(BaseTexture::kGL_TEXTURE_MAX_ANISOTROPY_EXT, m_maxAnisotropyValue);
-        }
-        textureRef->unbind();
-        annotateObject(BaseTexture::kGL_TEXTURE, textureRef->data(), ("key=" + key).c_str(), m_applicationContextRef->sharedFunctionResolverInstance());
-        addTextureCache(key, textureRef);
+        setTextureParameters(flags, textureRef);
+        registerTexture(key, textureRef);
         popAnnotationGroup(m_applicationContextRef);
     }
 }
 
+void BaseApplicationContext::ModelContext::setTextureParameters(int flags, ITexture *texture)
+{
+    texture->bind();
+    texture->setParameter(BaseTexture::kGL_TEXTURE_MAG_FILTER, int(BaseTexture::kGL_LINEAR));
+    texture->setParameter(BaseTexture::kGL_TEXTURE_MIN_FILTER, int(BaseTexture::kGL_LINEAR));
+    if (internal::hasFlagBits(flags, IApplicationContext::kToonTexture)) {
+        texture->setParameter(BaseTexture::kGL_TEXTURE_WRAP_S, int(BaseTexture::kGL_CLAMP_TO_EDGE));
+        texture->setParameter(BaseTexture::kGL_TEXTURE_WRAP_T, int(BaseTexture::kGL_CLAMP_TO_EDGE));
+    }
+    if (m_maxAnisotropyValue < 0) {
+        IApplicationContext::FunctionResolver *resolver = m_applicationContextRef->sharedFunctionResolverInstance();
+        m_maxAnisotropyValue = 0;
+        if (resolver->hasExtension("EXT_texture_filter_anisotropic")) {
+            typedef void (GLAPIENTRY * PFNGLGETFLOATVPROC)(GLenum pname, GLfloat *values);
+            reinterpret_cast<PFNGLGETFLOATVPROC>(resolver->resolveSymbol("glGetFloatv"))(BaseTexture::kGL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &m_maxAnisotropyValue);
+        }
+    }
+    if (m_maxAnisotropyValue > 0) {
+        texture->setParameter(BaseTexture::kGL_TEXTURE_MAX_ANISOTROPY_EXT, m_maxAnisotropyValue);
+    }
+    texture->unbind();
+}
+
+void BaseApplicationContext::ModelContext::registerTexture(const std::string &key, ITexture *textureRef)
+{
+    annotateObject(BaseTexture::kGL_TEXTURE, textureRef->data(), ("key=" + key).c_str(), m_applicationContextRef->sharedFunctionResolverInstance());
+    addTextureCache(key, textureRef);
+}
+
+std::string BaseApplicationContext::ModelContext::sharedTextureKey(const uint8 *data, vsize size, int flags) const
+{
+    return TextureCache::makeKey(data, size, flags, m_flipVertically);
+}
+
+ITexture *BaseApplicationContext::ModelContext::findSharedTexture(const std::string &sharedKey, const std::string &key)
+{
+    ITexture *textureRef = TextureCache::acquire(sharedKey);
+    if (textureRef) {
+        VPVL2_VLOG(2, key << " is shared with other models.");
+        addTextureCache(key, textureRef);
+    }
+    return textureRef;
+}
+
+ITexture *BaseApplicationContext::ModelContext::storeSharedTexture(const std::string &sharedKey, const std::string &key, int flags, ITexture *texturePtr)
+{
+    VPVL2_DCHECK(!key.empty());
+    if (!texturePtr) {
+        return 0;
+    }
+    /* references of the shared texture ignore setParameter, so parameters are set before storing */
+    pushAnnotationGroup("BaseApplicationContext::ModelContext#cacheTexture", m_applicationContextRef);
+    setTextureParameters(flags, texturePtr);
+    /* the cache owns the texture and the model context holds a reference of it */
+    ITexture *textureRef = TextureCache::store(sharedKey, texturePtr);
+    registerTexture(key, textureRef);
+    popAnnotationGroup(m_applicationContextRef);
+    return textureRef;
+}
+
 int BaseApplicationContext::ModelContext::countTextures() const
 {
     return m_textureRefCache.size();
@@ -454,9 +693,11 @@ ITexture *BaseApplicationContext::ModelContext::createTextureFromFile(const std:
         VPVL2_VLOG(2, path << " is already cached, skipped.");
     }
     else {
-        IStringSmartPtr pathPtr(String::create(path));
-        textureRef = m_applicationContextRef->uploadTextureFromFile(pathPtr.get(), m_flipVertically);
-        storeTexture(path, flags, textureRef);
+        /* read the file to find the same content uploaded by other models */
+        MapBuffer buffer(m_applicationContextRef);
+        if (m_applicationContextRef->mapFile(path, &buffer) && buffer.size > 0) {
+            textureRef = createTextureFromMemory(buffer.address, buffer.size, path, flags);
+        }
     }
     return textureRef;
 }
@@ -469,15 +710,110 @@ ITexture *BaseApplicationContext::ModelContext::createTextureFromMemory(const ui
         VPVL2_VLOG(2, key << " is already cached, skipped.");
         return textureRef;
     }
-    textureRef = m_applicationContextRef->uploadTextureFromMemory(data, size, m_flipVertically);
-    if (!textureRef) {
+    const std::string &sharedKey = sharedTextureKey(data, size, flags);
+    if ((textureRef = findSharedTexture(sharedKey, key)) != 0) {
+        return textureRef;
+    }
+    ITexture *texturePtr = m_applicationContextRef->uploadTextureFromMemory(data, size, m_flipVertically);
+    if (!texturePtr) {
         VPVL2_LOG(WARNING, "Cannot load texture with key " << key << ": " << stbi_failure_reason());
         return 0;
     }
-    storeTexture(key, flags, textureRef);
+    return storeSharedTexture(sharedKey, key, flags, texturePtr);
+}
+
+void BaseApplicationContext::ModelContext::decodeTextures(const IModel *modelRef)
+{
+    VPVL2_DCHECK(modelRef);
+    /* asset models resolve their textures by themselves */
+    if (modelRef->type() == IModel::kAssetModel) {
+        return;
+    }
+    Array<IMaterial *> materialRefs;
+    modelRef->getMaterialRefs(materialRefs);
+    const int nmaterials = materialRefs.count();
+    for (int i = 0; i < nmaterials; i++) {
+        const IMaterial *materialRef = materialRefs[i];
+        addDecodeTarget(materialRef->mainTexture(), 0);
+        addDecodeTarget(materialRef->sphereTexture(), 0);
+        if (!materialRef->isSharedToonTextureUsed()) {
+            addDecodeTarget(materialRef->toonTexture(), IApplicationContext::kToonTexture);
+        }
+    }
+    /* returns immediately, decoded images are uploaded by uploadDecodedTextures or uploadDecodedTexture */
+    m_textureDecoder->start();
+}
+
+int BaseApplicationContext::ModelContext::uploadDecodedTextures()
+{
+#ifndef VPVL2_LINK_INTEL_TBB
+    /* no worker threads, decodes one image per call to keep each frame short */
+    m_textureDecoder->decodeNextImage();
+#endif
+    Array<DecodedImage *> images;
+    m_textureDecoder->takeDecodedImages(images);
+    const int nimages = images.count();
+    for (int i = 0; i < nimages; i++) {
+        DecodedImage *image = images[i];
+        m_textureDecoder->remove(image);
+        uploadDecodedImage(image, image->flags);
+    }
+    return int(m_textureDecoder->images.size());
+}
+
+ITexture *BaseApplicationContext::ModelContext::uploadDecodedTexture(const std::string &key, int flags)
+{
+    ITexture *textureRef = 0;
+    if (DecodedImage *image = m_textureDecoder->take(key)) {
+        /* an image not decoded yet falls back to the synchronous path instead of waiting for workers */
+        textureRef = uploadDecodedImage(image, flags);
+    }
+    else if (findTexture(key, textureRef)) {
+        VPVL2_VLOG(2, key << " is already uploaded by uploadDecodedTextures.");
+    }
+    return textureRef;
+}
+
+ITexture *BaseApplicationContext::ModelContext::uploadDecodedImage(DecodedImage *image, int flags)
+{
+    ITexture *textureRef = 0;
+    /* falls back to the synchronous path if decoding failed or flags in the shared key are different */
+    if (image->pixels.count() > 0 && TextureCache::uploadFlags(image->flags) == TextureCache::uploadFlags(flags)) {
+        const std::string &key = image->key;
+        if (findTexture(key, textureRef)) {
+            VPVL2_VLOG(2, key << " is already cached, skipped.");
+        }
+        else if (!(textureRef = findSharedTexture(image->sharedKey, key))) {
+            if (ITexture *texturePtr = m_applicationContextRef->uploadTexture(&image->pixels[0], m_applicationContextRef->defaultTextureFormat(), image->size)) {
+                textureRef = storeSharedTexture(image->sharedKey, key, flags, texturePtr);
+            }
+        }
+    }
+    delete image;
     return textureRef;
 }
 
+void BaseApplicationContext::ModelContext::addDecodeTarget(const IString *name, int flags)
+{
+    if (!name) {
+        return;
+    }
+    /* resolves the key as same as uploadModelTexture and internalUploadTexture */
+    const std::string &newName = toTextureName(name);
+    const String *directoryRef = static_cast<const String *>(m_directoryRef);
+    if (newName.empty() || (!m_archiveRef && !directoryRef)) {
+        return;
+    }
+    const std::string &path = m_archiveRef ? std::string() : directoryRef->toStdString() + "/" + newName;
+    const std::string &key = m_archiveRef ? newName : path;
+    const TextureDecoder::DecodedImageMap &images = m_textureDecoder->images;
+    ITexture *textureRef = 0;
+    if (images.find(key) == images.end() && !findTexture(key, textureRef)
+            && (m_archiveRef || m_applicationContextRef->existsFile(path))) {
+        m_textureDecoder->enqueue(new DecodedImage(key, path, flags));
+    }
+}
+
 bool BaseApplicationContext::initializeOnce(const char *argv0, const char *logdir, int vlog)
 {
     FreeImage_Initialise();
@@ -582,6 +918,8 @@ void BaseApplicationContext::release()
     m_effectRef2Paths.clear();
     m_effectRef2ParameterUIs.clear();
     m_effectCaches.releaseAll();
+    /* delete shared textures no longer used by any render engine while the context is current */
+    TextureCache::purge();
     popAnnotationGroup(this);
 }
 
@@ -619,12 +957,7 @@ ITexture *BaseApplicationContext::uploadEffectTexture(const IString *name, const
 ITexture *BaseApplicationContext::uploadModelTexture(const IString *name, int flags, void *userData)
 {
     ModelContext *context = static_cast<ModelContext *>(userData);
-    std::string newName = static_cast<const String *>(name)->toStdString();
-    std::string::size_type pos(newName.find('\\'));
-    while (pos != std::string::npos) {
-        newName.replace(pos, 1, "/");
-        pos = newName.find('\\', pos + 1);
-    }
+    const std::string &newName = toTextureName(name);
     ITexture *texturePtr = 0;
     if (internal::hasFlagBits(flags, IApplicationContext::kToonTexture)) {
         if (!internal::hasFlagBits(flags, IApplicationContext::kSystemToonTexture)) {
@@ -679,13 +1012,25 @@ ITexture *BaseApplicationContext::uploadSystemToonTexture(const std::string &nam
 ITexture *BaseApplicationContext::internalUploadTexture(const std::string &name, const std::string &path, int flags, ModelContext *context)
 {
     if (!internal::hasFlagBits(flags, IApplicationContext::kSystemToonTexture)) {
+        /* images decoded by ModelContext#decodeTextures are only uploaded here */
+        if (ITexture *texturePtr = context->uploadDecodedTexture(context->archiveRef() ? name : path, flags)) {
+            return texturePtr;
+        }
         if (Archive *archiveRef = context->archiveRef()) {
-            archiveRef->uncompressEntry(name);
+            vsize size = 0;
             VPVL2_LOG(INFO, name);
+            /* stored entries are read directly from the mapped archive */
+            if (const uint8 *ptr = archiveRef->mappedDataRef(name, size)) {
+                return uploadTextureOpaque(ptr, size, name, flags, context);
+            }
+            archiveRef->uncompressEntry(name);
             if (const std::string *bytesRef = archiveRef->dataRef(name)) {
                 const uint8 *ptr = reinterpret_cast<const uint8 *>(bytesRef->data());
-                vsize size = bytesRef->size();
-                return uploadTextureOpaque(ptr, size, name, flags, context);
+                size = bytesRef->size();
+                ITexture *texture = uploadTextureOpaque(ptr, size, name, flags, context);
+                /* the inflated data is no longer needed after the texture is uploaded */
+                archiveRef->releaseEntry(name);
+                return texture;
             }
             VPVL2_LOG(WARNING, "Cannot load a bridge from archive: " << name);
             return handleNullTextureObject();
@@ -728,6 +1073,27 @@ ITexture *BaseApplicationContext::uploadTextureOpaque(const std::string &path, i
     return context->createTextureFromFile(path, flags);
 }
 
+bool BaseApplicationContext::decodeTextureOpaque(const uint8 *data, vsize size, bool flipVertically, Vector3 &textureSize, Array<uint8> &pixels) const
+{
+    /* images are not decoded ahead with FreeImage to decode them in uploadTextureFromMemory */
+#ifndef VPVL2_LINK_FREEIMAGE
+    static const int kNumComponents = 4;
+    int x = 0, y = 0, ncomponents = 0;
+    if (stbi_uc *ptr = stbi_load_from_memory(data, int(size), &x, &y, &ncomponents, kNumComponents)) {
+        const int nbytes = x * y * kNumComponents;
+        if (flipVertically) {
+            flipImageVertically(ptr, x, y, kNumComponents);
+        }
+        pixels.resize(nbytes);
+        internal::copyBytes(&pixels[0], ptr, nbytes);
+        textureSize.setValue(Scalar(x), Scalar(y), 1);
+        stbi_image_free(ptr);
+        return true;
+    }
+#endif
+    return false;
+}
+
 ITexture *BaseApplicationContext::handleNullTextureObject() const
 {
     /* create an null texture object and continues loading model even if texture is not found */
@@ -1039,6 +1405,10 @@ void BaseApplicationContext::addModelFilePath(IModel *model, const std::string &
             m_basename2ModelRefs.insert(path.c_str(), model);
         }
         m_modelRef2Paths.insert(model, path);
+        /* CONTROLOBJECT parameters may refer the model by the base name */
+        if (m_sceneRef) {
+            m_sceneRef->invalidateModelRevision();
+        }
     }
 }
 
@@ -1734,15 +2104,7 @@ ITexture *BaseApplicationContext::uploadTextureFromMemory(const uint8 *data, vsi
     if (stbi_uc *ptr = stbi_load_from_memory(data, int(size), &x, &y, &ncomponents, rc)) {
         textureSize.setValue(Scalar(x), Scalar(y), 1);
         if (flipVertically) {
-            for (int j = 0, height = y >> 1; j < height; ++j) {
-                stbi_uc *p1 = ptr + j * x * rc;
-                stbi_uc *p2 = ptr + (y - 1 - j) * x * rc;
-                for (int i = 0, width = x * rc; i < width; ++i) {
-                    stbi_uc t = p1[i];
-                    p1[i] = p2[i];
-                    p2[i] = t;
-                }
-            }
+            flipImageVertically(ptr, x, y, rc);
         }
         texturePtr = uploadTexture(ptr, defaultTextureFormat(), textureSize);
         stbi_image_free(ptr);
@@ -0,0 +1,300 @@
+/**
+
+ Copyright (c) 2010-2014  hkrn
+
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or
+ without modification, are permitted provided that the following
+ conditions are met:
+
+ - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following
+   disclaimer in the documentation and/or other materials provided
+   with the distribution.
+ - Neither the name of the MMDAI project team nor the names of
+   its contributors may be used to endorse or promote products
+   derived from this software without specific prior written
+   permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <vpvl2/vpvl2.h>
+#include <vpvl2/extensions/EffectCache.h>
+#include <vpvl2/internal/util.h>
+#include <vpvl2/internal/Mutex.h>
+
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+
+using namespace vpvl2::VPVL2_VERSION_NS;
+
+static const uint8 kSignature[] = { 'V', 'P', 'V', 'L', '2', 'F', 'X', 'C' };
+static const uint32 kVersion = 1;
+
+struct EntryHeader {
+    uint8 signature[sizeof(kSignature)];
+    uint32 version;
+    uint32 type;
+    uint32 format;
+    uint32 keySize;
+    uint64 payloadSize;
+    uint64 checksum;
+};
+
+struct FNV1a {
+    FNV1a()
+        : value(14695981039346656037ULL)
+    {
+    }
+    void append(const uint8 *data, vsize size) {
+        for (vsize i = 0; i < size; i++) {
+            value ^= data[i];
+            value *= 1099511628211ULL;
+        }
+    }
+    void append(const std::string &s) {
+        append(reinterpret_cast<const uint8 *>(s.c_str()), s.size());
+        /* separates concatenated strings to be different keys */
+        const uint8 terminator = 0;
+        append(&terminator, sizeof(terminator));
+    }
+    uint64 value;
+};
+
+struct Storage {
+    Storage() {
+        internal::zerofill(&statistics, sizeof(statistics));
+    }
+    ~Storage() {
+    }
+
+    std::string makePath(const std::string &key, extensions::EffectCache::EntryType type) const {
+        std::string path(directory);
+        path.append("/");
+        path.append(key);
+        path.append(type == extensions::EffectCache::kProgramBinary ? ".bin" : ".glsl");
+        return path;
+    }
+    void countMiss(extensions::EffectCache::EntryType type) {
+        if (type == extensions::EffectCache::kProgramBinary) {
+            statistics.numProgramBinaryMisses++;
+        }
+        else {
+            statistics.numSourceMisses++;
+        }
+    }
+    void countHit(extensions::EffectCache::EntryType type) {
+        if (type == extensions::EffectCache::kProgramBinary) {
+            statistics.numProgramBinaryHits++;
+        }
+        else {
+            statistics.numSourceHits++;
+        }
+    }
+
+    internal::Mutex mutex;
+    extensions::EffectCache::Statistics statistics;
+    std::string directory;
+};
+
+static Storage g_storage;
+
+static bool readEntry(FILE *fp, const std::string &key, uint32 type, uint32 &format, Array<uint8> &bytes)
+{
+    EntryHeader header;
+    if (fread(&header, sizeof(header), 1, fp) != 1) {
+        return false;
+    }
+    if (memcmp(header.signature, kSignature, sizeof(kSignature)) != 0 || header.version != kVersion ||
+            header.type != type || header.keySize != key.size() || header.payloadSize > 0x7fffffff) {
+        return false;
+    }
+    Array<char> storedKey;
+    storedKey.resize(header.keySize + 1);
+    if (header.keySize > 0 && fread(&storedKey[0], header.keySize, 1, fp) != 1) {
+        return false;
+    }
+    storedKey[header.keySize] = 0;
+    if (key.compare(&storedKey[0]) != 0) {
+        return false;
+    }
+    const vsize size = vsize(header.payloadSize);
+    bytes.resize(int(size));
+    if (size > 0 && fread(&bytes[0], size, 1, fp) != 1) {
+        return false;
+    }
+    FNV1a checksum;
+    if (size > 0) {
+        checksum.append(&bytes[0], size);
+    }
+    if (checksum.value != header.checksum) {
+        return false;
+    }
+    format = header.format;
+    return true;
+}
+
+} /* namespace anonymous */
+
+namespace vpvl2
+{
+namespace VPVL2_VERSION_NS
+{
+namespace extensions
+{
+
+std::string EffectCache::makeKey(const std::string &backend,
+                                 const std::string &source,
+                                 const StringMap &includeBuffers,
+                                 const StringList &defines)
+{
+    /* 64bit FNV-1a of all inputs, the source size is appended like TextureCache::makeKey */
+    FNV1a hash;
+    hash.append(backend);
+    hash.append(source);
+    for (StringMap::const_iterator it = includeBuffers.begin(), end = includeBuffers.end(); it != end; it++) {
+        hash.append(it->first);
+        hash.append(it->second);
+    }
+    for (StringList::const_iterator it = defines.begin(), end = defines.end(); it != end; it++) {
+        hash.append(*it);
+    }
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%016llx-%llu", static_cast<unsigned long long>(hash.value),
+             static_cast<unsigned long long>(source.size()));
+    return std::string(buffer);
+}
+
+bool EffectCache::find(const std::string &key, EntryType type, uint32 &format, Array<uint8> &bytes)
+{
+    internal::ScopedLock lock(g_storage.mutex);
+    if (g_storage.directory.empty()) {
+        return false;
+    }
+    const std::string &path = g_storage.makePath(key, type);
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (!fp) {
+        g_storage.countMiss(type);
+        return false;
+    }
+    bool found = readEntry(fp, key, type, format, bytes);
+    fclose(fp);
+    if (!found) {
+        /* written by an other version or truncated, compile again and overwrite it */
+        VPVL2_LOG(WARNING, "Rejected an invalid effect cache entry: " << path);
+        remove(path.c_str());
+        bytes.clear();
+        g_storage.statistics.numRejects++;
+        g_storage.countMiss(type);
+        return false;
+    }
+    g_storage.countHit(type);
+    return true;
+}
+
+bool EffectCache::store(const std::string &key, EntryType type, uint32 format, const uint8 *data, vsize size)
+{
+    internal::ScopedLock lock(g_storage.mutex);
+    if (g_storage.directory.empty() || (!data && size > 0)) {
+        return false;
+    }
+    EntryHeader header;
+    internal::zerofill(&header, sizeof(header));
+    memcpy(header.signature, kSignature, sizeof(kSignature));
+    header.version = kVersion;
+    header.type = type;
+    header.format = format;
+    header.keySize = uint32(key.size());
+    header.payloadSize = size;
+    FNV1a checksum;
+    checksum.append(data, size);
+    header.checksum = checksum.value;
+    /* write to the temporary file and rename it not to leave a partially written entry */
+    const std::string &path = g_storage.makePath(key, type), temporaryPath(path + ".tmp");
+    FILE *fp = fopen(temporaryPath.c_str(), "wb");
+    if (!fp) {
+        VPVL2_VLOG(1, "Cannot write an effect cache entry: " << temporaryPath);
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+            (key.empty() || fwrite(key.c_str(), key.size(), 1, fp) == 1) &&
+            (size == 0 || fwrite(data, size, 1, fp) == 1);
+    written = fclose(fp) == 0 && written;
+    if (written) {
+        remove(path.c_str());
+        written = rename(temporaryPath.c_str(), path.c_str()) == 0;
+    }
+    if (!written) {
+        VPVL2_VLOG(1, "Cannot write an effect cache entry: " << path);
+        remove(temporaryPath.c_str());
+        return false;
+    }
+    g_storage.statistics.numStores++;
+    VPVL2_VLOG(2, "Stored an effect cache entry: path=" << path << " size=" << size);
+    return true;
+}
+
+void EffectCache::reject(const std::string &key, EntryType type)
+{
+    internal::ScopedLock lock(g_storage.mutex);
+    if (!g_storage.directory.empty()) {
+        const std::string &path = g_storage.makePath(key, type);
+        VPVL2_VLOG(1, "Rejected an effect cache entry: " << path);
+        remove(path.c_str());
+        g_storage.statistics.numRejects++;
+    }
+}
+
+void EffectCache::getStatistics(Statistics &value)
+{
+    internal::ScopedLock lock(g_storage.mutex);
+    value = g_storage.statistics;
+}
+
+void EffectCache::resetStatistics()
+{
+    internal::ScopedLock lock(g_storage.mutex);
+    internal::zerofill(&g_storage.statistics, sizeof(g_storage.statistics));
+}
+
+std::string EffectCache::directory()
+{
+    internal::ScopedLock lock(g_storage.mutex);
+    return g_storage.directory;
+}
+
+void EffectCache::setDirectory(const std::string &value)
+{
+    internal::ScopedLock lock(g_storage.mutex);
+    g_storage.directory = value;
+}
+
+bool EffectCache::isEnabled()
+{
+    internal::ScopedLock lock(g_storage.mutex);
+    return !g_storage.directory.empty();
+}
+
+} /* namespace extensions */
+} /* namespace VPVL2_VERSION_NS */
+} /* namespace vpvl2 */
@@ -39,7 +39,7 @@
 #include <vpvl2/internal/util.h>
 #include <vpvl2/extensions/fx/EffectFX5.h>
 
-#include <vpvl2/extensions/gl/ShaderProgram.h>
+#include <vpvl2/gl/ShaderProgram.h>
 
 #ifdef __clang__
 #pragma clang diagnostic push
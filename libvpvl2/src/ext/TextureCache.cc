@@ -0,0 +1,313 @@
+/**
+
+ Copyright (c) 2010-2014  hkrn
+
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or
+ without modification, are permitted provided that the following
+ conditions are met:
+
+ - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following
+   disclaimer in the documentation and/or other materials provided
+   with the distribution.
+ - Neither the name of the MMDAI project team nor the names of
+   its contributors may be used to endorse or promote products
+   derived from this software without specific prior written
+   permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <vpvl2/vpvl2.h>
+#include <vpvl2/IApplicationContext.h>
+#include <vpvl2/ITexture.h>
+#include <vpvl2/extensions/TextureCache.h>
+#include <vpvl2/internal/util.h>
+#include <vpvl2/internal/Mutex.h>
+
+/* STL */
+#include <map>
+#include <stdio.h>
+
+namespace
+{
+
+using namespace vpvl2::VPVL2_VERSION_NS;
+
+struct Entry {
+    Entry(const std::string &k, ITexture *t)
+        : key(k),
+          texturePtr(t),
+          previous(0),
+          next(0),
+          bytes(0),
+          numReferences(0)
+    {
+        const Vector3 &size = t->size();
+        bytes = vsize(size.x()) * vsize(size.y()) * 4;
+        /* mipmaps are generated on upload */
+        bytes += bytes / 3;
+    }
+    ~Entry() {
+        internal::deleteObject(texturePtr);
+        previous = next = 0;
+        bytes = 0;
+        numReferences = 0;
+    }
+    const std::string key;
+    ITexture *texturePtr;
+    Entry *previous;
+    Entry *next;
+    vsize bytes;
+    int numReferences;
+};
+
+struct Storage {
+    static const vsize kDefaultMemoryBudget = 256 * 1024 * 1024;
+
+    Storage()
+        : leastRecentlyUsed(0),
+          mostRecentlyUsed(0),
+          budgetBytes(kDefaultMemoryBudget)
+    {
+        internal::zerofill(&statistics, sizeof(statistics));
+    }
+    ~Storage() {
+        /* textures alive at exit are intentionally left since no OpenGL context would be current */
+        entries.clear();
+    }
+
+    /* entries not referenced are linked from the least recently used one to evict */
+    void link(Entry *entry) {
+        entry->previous = mostRecentlyUsed;
+        entry->next = 0;
+        if (mostRecentlyUsed) {
+            mostRecentlyUsed->next = entry;
+        }
+        else {
+            leastRecentlyUsed = entry;
+        }
+        mostRecentlyUsed = entry;
+        statistics.unreferencedBytes += entry->bytes;
+    }
+    void unlink(Entry *entry) {
+        if (entry->previous) {
+            entry->previous->next = entry->next;
+        }
+        else {
+            leastRecentlyUsed = entry->next;
+        }
+        if (entry->next) {
+            entry->next->previous = entry->previous;
+        }
+        else {
+            mostRecentlyUsed = entry->previous;
+        }
+        entry->previous = entry->next = 0;
+        statistics.unreferencedBytes -= entry->bytes;
+    }
+    void retain(Entry *entry) {
+        if (entry->numReferences++ == 0) {
+            unlink(entry);
+        }
+        statistics.numReferences++;
+    }
+    void release(Entry *entry) {
+        VPVL2_DCHECK_GT(entry->numReferences, 0);
+        statistics.numReferences--;
+        if (--entry->numReferences == 0) {
+            link(entry);
+            evict(budgetBytes);
+        }
+    }
+    void evict(vsize limit) {
+        while (statistics.usedBytes > limit && leastRecentlyUsed) {
+            Entry *entry = leastRecentlyUsed;
+            unlink(entry);
+            entries.erase(entry->key);
+            statistics.usedBytes -= entry->bytes;
+            statistics.numEntries--;
+            statistics.numEvictions++;
+            VPVL2_VLOG(2, "Evicted a cached texture: key=" << entry->key << " bytes=" << entry->bytes);
+            delete entry;
+        }
+    }
+
+    internal::Mutex mutex;
+    std::map<std::string, Entry *> entries;
+    extensions::TextureCache::Statistics statistics;
+    Entry *leastRecentlyUsed;
+    Entry *mostRecentlyUsed;
+    vsize budgetBytes;
+};
+
+static Storage g_storage;
+
+class TextureReference VPVL2_DECL_FINAL : public ITexture {
+public:
+    TextureReference(Entry *entryRef)
+        : m_entryRef(entryRef),
+          m_textureRef(entryRef->texturePtr)
+    {
+        g_storage.retain(entryRef);
+    }
+    ~TextureReference() {
+        internal::ScopedLock lock(g_storage.mutex);
+        g_storage.release(m_entryRef);
+        m_entryRef = 0;
+        m_textureRef = 0;
+    }
+
+    void create() { m_textureRef->create(); }
+    void bind() { m_textureRef->bind(); }
+    void fillPixels(const void *pixels) { m_textureRef->fillPixels(pixels); }
+    void allocate(const void *pixels) { m_textureRef->allocate(pixels); }
+    void write(const void *pixels) { m_textureRef->write(pixels); }
+    void getParameters(unsigned int key, int *values) const { m_textureRef->getParameters(key, values); }
+    void getParameters(unsigned int key, float *values) const { m_textureRef->getParameters(key, values); }
+    /*
+     * parameters are shared by all references and decided by the upload flags in the key, so they are
+     * set to the texture before it is stored and a reference can't change them for other models
+     */
+    void setParameter(unsigned int key, int /* value */) { rejectParameter(key); }
+    void setParameter(unsigned int key, float /* value */) { rejectParameter(key); }
+    void generateMipmaps() { m_textureRef->generateMipmaps(); }
+    void resize(const Vector3 &size) { m_textureRef->resize(size); }
+    void unbind() { m_textureRef->unbind(); }
+    void release() {
+        /* the shared texture is released by the cache, not by each reference */
+    }
+    Vector3 size() const { return m_textureRef->size(); }
+    intptr_t data() const { return m_textureRef->data(); }
+    intptr_t sampler() const { return m_textureRef->sampler(); }
+    intptr_t format() const { return m_textureRef->format(); }
+
+private:
+    void rejectParameter(unsigned int key) const {
+        VPVL2_VLOG(2, "Rejected changing a parameter of the shared texture: key=" << m_entryRef->key << " parameter=" << key);
+    }
+
+    Entry *m_entryRef;
+    ITexture *m_textureRef;
+
+    VPVL2_DISABLE_COPY_AND_ASSIGN(TextureReference)
+};
+
+} /* namespace anonymous */
+
+namespace vpvl2
+{
+namespace VPVL2_VERSION_NS
+{
+namespace extensions
+{
+
+int TextureCache::uploadFlags(int flags)
+{
+    /* only whether the texture is loaded asynchronously doesn't change the uploaded texture */
+    return flags & ~IApplicationContext::kAsyncLoadingTexture;
+}
+
+std::string TextureCache::makeKey(const uint8 *data, vsize size, int flags, bool flipVertically)
+{
+    /* 64bit FNV-1a of the encoded image, the parameters are appended to be different keys */
+    uint64 hash = 14695981039346656037ULL;
+    for (vsize i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%016llx:%llu:%x:%d", static_cast<unsigned long long>(hash),
+             static_cast<unsigned long long>(size), uploadFlags(flags), flipVertically ? 1 : 0);
+    return std::string(buffer);
+}
+
+ITexture *TextureCache::acquire(const std::string &key)
+{
+    internal::ScopedLock lock(g_storage.mutex);
+    std::map<std::string, Entry *>::const_iterator it = g_storage.entries.find(key);
+    if (it != g_storage.entries.end()) {
+        g_storage.statistics.numHits++;
+        return new TextureReference(it->second);
+    }
+    g_storage.statistics.numMisses++;
+    return 0;
+}
+
+ITexture *TextureCache::store(const std::string &key, ITexture *texturePtr)
+{
+    if (!texturePtr) {
+        return 0;
+    }
+    internal::ScopedLock lock(g_storage.mutex);
+    std::map<std::string, Entry *>::const_iterator it = g_storage.entries.find(key);
+    if (it != g_storage.entries.end()) {
+        /* the same content was uploaded concurrently */
+        internal::deleteObject(texturePtr);
+        return new TextureReference(it->second);
+    }
+    Entry *entry = new Entry(key, texturePtr);
+    g_storage.entries.insert(std::make_pair(key, entry));
+    g_storage.statistics.numEntries++;
+    g_storage.statistics.usedBytes += entry->bytes;
+    /* a new entry is unreferenced until the reference below is created */
+    g_storage.link(entry);
+    ITexture *reference = new TextureReference(entry);
+    g_storage.evict(g_storage.budgetBytes);
+    return reference;
+}
+
+void TextureCache::purge()
+{
+    internal::ScopedLock lock(g_storage.mutex);
+    g_storage.evict(0);
+}
+
+void TextureCache::getStatistics(Statistics &value)
+{
+    internal::ScopedLock lock(g_storage.mutex);
+    value = g_storage.statistics;
+    value.budgetBytes = g_storage.budgetBytes;
+}
+
+void TextureCache::resetStatistics()
+{
+    internal::ScopedLock lock(g_storage.mutex);
+    g_storage.statistics.numHits = 0;
+    g_storage.statistics.numMisses = 0;
+    g_storage.statistics.numEvictions = 0;
+}
+
+vsize TextureCache::memoryBudget()
+{
+    internal::ScopedLock lock(g_storage.mutex);
+    return g_storage.budgetBytes;
+}
+
+void TextureCache::setMemoryBudget(vsize value)
+{
+    internal::ScopedLock lock(g_storage.mutex);
+    g_storage.budgetBytes = value;
+    g_storage.evict(value);
+}
+
+} /* namespace extensions */
+} /* namespace VPVL2_VERSION_NS */
+} /* namespace vpvl2 */
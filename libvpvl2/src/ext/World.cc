@@ -51,6 +51,7 @@
 #include <BulletCollision/CollisionShapes/btStaticPlaneShape.h>
 #include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h>
 #include <BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
+#include <LinearMath/btQuickprof.h>
 #ifdef __clang__
 #pragma clang diagnostic pop
 #endif
@@ -67,8 +68,129 @@ namespace VPVL2_VERSION_NS
 namespace extensions
 {
 
+namespace {
+
+class BoundedDynamicsWorld : public btDiscreteDynamicsWorld {
+public:
+    BoundedDynamicsWorld(btDispatcher *dispatcher,
+                         btBroadphaseInterface *broadphase,
+                         btConstraintSolver *solver,
+                         btCollisionConfiguration *config)
+        : btDiscreteDynamicsWorld(dispatcher, broadphase, solver, config),
+          m_collisionTime(0),
+          m_solverTime(0)
+    {
+    }
+    ~BoundedDynamicsWorld() {
+    }
+
+    /* same as btDiscreteDynamicsWorld::stepSimulation but stops at the time budget (seconds) */
+    int stepSimulationBounded(const Scalar &timeStep,
+                              int maxSubSteps,
+                              const Scalar &fixedTimeStep,
+                              const Scalar &budget,
+                              bool dropRemainder,
+                              int &numExecuted) {
+        int numSubSteps = 0;
+        m_localTime += timeStep;
+        if (m_localTime >= fixedTimeStep) {
+            numSubSteps = int(m_localTime / fixedTimeStep);
+            m_localTime -= numSubSteps * fixedTimeStep;
+        }
+        numExecuted = 0;
+        if (numSubSteps > 0) {
+            const int numClampedSubSteps = btMin(numSubSteps, maxSubSteps);
+            const unsigned long budgetInMicroseconds = budget > 0 ? static_cast<unsigned long>(budget * 1000000) : 0;
+            btClock clock;
+            saveKinematicState(fixedTimeStep * numClampedSubSteps);
+            applyGravity();
+            for (int i = 0; i < numClampedSubSteps; i++) {
+                /* always run at least one substep to advance the simulation */
+                if (i > 0 && budgetInMicroseconds > 0 && clock.getTimeMicroseconds() >= budgetInMicroseconds) {
+                    break;
+                }
+                internalSingleStepSimulation(fixedTimeStep);
+                synchronizeMotionStates();
+                numExecuted++;
+            }
+            if (numExecuted < numSubSteps) {
+                if (dropRemainder) {
+                    m_localTime = 0;
+                }
+                else {
+                    const Scalar &remainder = m_localTime + (numSubSteps - numExecuted) * fixedTimeStep;
+                    m_localTime = btMin(remainder, fixedTimeStep * Scalar(0.999));
+                }
+                synchronizeMotionStates();
+            }
+        }
+        else {
+            synchronizeMotionStates();
+        }
+        clearForces();
+        return numSubSteps;
+    }
+    void performDiscreteCollisionDetection() {
+        btClock clock;
+        btDiscreteDynamicsWorld::performDiscreteCollisionDetection();
+        m_collisionTime += clock.getTimeMicroseconds();
+    }
+    void resetLocalTime() {
+        m_localTime = 0;
+    }
+    void resetTimers() {
+        m_collisionTime = m_solverTime = 0;
+    }
+    Scalar collisionTime() const {
+        return Scalar(m_collisionTime) / 1000000;
+    }
+    Scalar solverTime() const {
+        return Scalar(m_solverTime) / 1000000;
+    }
+
+protected:
+    void solveConstraints(btContactSolverInfo &solverInfo) {
+        btClock clock;
+        btDiscreteDynamicsWorld::solveConstraints(solverInfo);
+        m_solverTime += clock.getTimeMicroseconds();
+    }
+
+private:
+    unsigned long m_collisionTime;
+    unsigned long m_solverTime;
+};
+
+}
+
 struct World::PrivateContext {
     static const int kMaxSubSteps;
+    struct BodyState {
+        const btRigidBody *body;
+        Transform worldTransform;
+        Transform interpolationWorldTransform;
+        Vector3 linearVelocity;
+        Vector3 angularVelocity;
+        Vector3 interpolationLinearVelocity;
+        Vector3 interpolationAngularVelocity;
+    };
+    struct Snapshot {
+        Snapshot(const Scalar &timeIndex)
+            : timeIndex(timeIndex)
+        {
+        }
+        ~Snapshot() {
+        }
+        vsize size() const {
+            return sizeof(*this) + sizeof(BodyState) * states.count();
+        }
+        Array<BodyState> states;
+        const Scalar timeIndex;
+    };
+    struct SnapshotPredication {
+        bool operator()(const Snapshot *left, const Snapshot *right) const {
+            return left->timeIndex < right->timeIndex;
+        }
+    };
     PrivateContext()
         : dispatcher(0),
           broadphase(0),
@@ -78,12 +200,19 @@ struct World::PrivateContext {
           groundBody(0),
           baseFPS(60.0f),
           timeScale(1.0f),
+          stepTimeBudget(0),
+          maxSubSteps(kDefaultMaxSubSteps),
+          steppingPolicy(kExactStepping),
+          snapshotInterval(kDefaultSnapshotInterval),
+          snapshotMemoryBudget(kDefaultSnapshotMemoryBudget),
+          snapshotMemoryUsage(0),
           enableFloor(true)
     {
+        internal::zerofill(&statistics, sizeof(statistics));
         dispatcher = new btCollisionDispatcher(&config);
         broadphase = new btDbvtBroadphase();
         solver = new btSequentialImpulseConstraintSolver();
-        world = new btDiscreteDynamicsWorld(dispatcher, broadphase, solver, &config);
+        world = new BoundedDynamicsWorld(dispatcher, broadphase, solver, &config);
         world->getSolverInfo().m_solverMode &= ~SOLVER_RANDMIZE_ORDER;
         ground = new btStaticPlaneShape(Vector3(0, 1, 0), 0);
         btRigidBody::btRigidBodyConstructionInfo info(0, 0, ground, kZeroV3);
@@ -91,6 +220,7 @@ struct World::PrivateContext {
         world->addRigidBody(groundBody, 0x10, 0);
     }
     ~PrivateContext() {
+        clearSnapshots();
         world->removeRigidBody(groundBody);
         internal::deleteObject(groundBody);
         internal::deleteObject(ground);
@@ -100,21 +230,164 @@ struct World::PrivateContext {
         internal::deleteObject(world);
         baseFPS = 0;
         timeScale = 0;
+        stepTimeBudget = 0;
+        maxSubSteps = 0;
         enableFloor = false;
     }
 
+    /* returns the index of the latest snapshot at or before timeIndex or -1 */
+    int findSnapshotIndex(const Scalar &timeIndex) const {
+        int low = 0, high = snapshots.count() - 1, found = -1;
+        while (low <= high) {
+            int mid = low + (high - low) / 2;
+            if (snapshots[mid]->timeIndex <= timeIndex) {
+                found = mid;
+                low = mid + 1;
+            }
+            else {
+                high = mid - 1;
+            }
+        }
+        return found;
+    }
+    void captureSnapshot(const Scalar &timeIndex) {
+        const int index = findSnapshotIndex(timeIndex);
+        if ((index >= 0 && timeIndex - snapshots[index]->timeIndex < snapshotInterval) ||
+                (index + 1 < snapshots.count() && snapshots[index + 1]->timeIndex - timeIndex < snapshotInterval)) {
+            return;
+        }
+        const btCollisionObjectArray &objects = world->getCollisionObjectArray();
+        const int numObjects = objects.size();
+        Snapshot *snapshot = new Snapshot(timeIndex);
+        snapshot->states.reserve(numObjects);
+        for (int i = 0; i < numObjects; i++) {
+            const btRigidBody *body = btRigidBody::upcast(objects[i]);
+            if (body && !body->isStaticOrKinematicObject()) {
+                BodyState state;
+                state.body = body;
+                state.worldTransform = body->getCenterOfMassTransform();
+                state.interpolationWorldTransform = body->getInterpolationWorldTransform();
+                state.linearVelocity = body->getLinearVelocity();
+                state.angularVelocity = body->getAngularVelocity();
+                state.interpolationLinearVelocity = body->getInterpolationLinearVelocity();
+                state.interpolationAngularVelocity = body->getInterpolationAngularVelocity();
+                snapshot->states.append(state);
+            }
+        }
+        snapshots.append(snapshot);
+        snapshots.sort(SnapshotPredication());
+        snapshotMemoryUsage += snapshot->size();
+        evictSnapshots();
+    }
+    bool restoreSnapshot(const Scalar &timeIndex, Scalar &restoredTimeIndex) {
+        const int index = findSnapshotIndex(timeIndex);
+        if (index < 0) {
+            return false;
+        }
+        const Snapshot *snapshot = snapshots[index];
+        const Array<BodyState> &states = snapshot->states;
+        const int numStates = states.count();
+        /* bodies may be added or removed since the snapshot was taken */
+        if (countDynamicBodies() != numStates) {
+            clearSnapshots();
+            return false;
+        }
+        btCollisionObjectArray &objects = world->getCollisionObjectArray();
+        for (int i = 0; i < numStates; i++) {
+            btRigidBody *body = const_cast<btRigidBody *>(states[i].body);
+            if (objects.findLinearSearch(body) == objects.size()) {
+                clearSnapshots();
+                return false;
+            }
+        }
+        btOverlappingPairCache *cache = world->getPairCache();
+        btDispatcher *dispatcher = world->getDispatcher();
+        for (int i = 0; i < numStates; i++) {
+            const BodyState &state = states[i];
+            btRigidBody *body = const_cast<btRigidBody *>(state.body);
+            if (cache) {
+                cache->cleanProxyFromPairs(body->getBroadphaseHandle(), dispatcher);
+            }
+            body->setCenterOfMassTransform(state.worldTransform);
+            body->setInterpolationWorldTransform(state.interpolationWorldTransform);
+            body->setLinearVelocity(state.linearVelocity);
+            body->setAngularVelocity(state.angularVelocity);
+            body->setInterpolationLinearVelocity(state.interpolationLinearVelocity);
+            body->setInterpolationAngularVelocity(state.interpolationAngularVelocity);
+            body->clearForces();
+            if (btMotionState *motionState = body->getMotionState()) {
+                motionState->setWorldTransform(state.worldTransform);
+            }
+        }
+        world->resetLocalTime();
+        restoredTimeIndex = snapshot->timeIndex;
+        return true;
+    }
+    int countDynamicBodies() const {
+        const btCollisionObjectArray &objects = world->getCollisionObjectArray();
+        const int numObjects = objects.size();
+        int numBodies = 0;
+        for (int i = 0; i < numObjects; i++) {
+            const btRigidBody *body = btRigidBody::upcast(objects[i]);
+            if (body && !body->isStaticOrKinematicObject()) {
+                numBodies++;
+            }
+        }
+        return numBodies;
+    }
+    /* removes the snapshot leaving the smallest gap except the first one until the usage fits the budget */
+    void evictSnapshots() {
+        while (snapshotMemoryUsage > snapshotMemoryBudget && snapshots.count() > 1) {
+            const int numSnapshots = snapshots.count();
+            int target = numSnapshots - 1;
+            if (numSnapshots > 2) {
+                Scalar smallestGap = std::numeric_limits<Scalar>::max();
+                for (int i = 1; i < numSnapshots - 1; i++) {
+                    const Scalar &gap = snapshots[i + 1]->timeIndex - snapshots[i - 1]->timeIndex;
+                    if (gap < smallestGap) {
+                        smallestGap = gap;
+                        target = i;
+                    }
+                }
+            }
+            removeSnapshotAt(target);
+        }
+    }
+    void removeSnapshotAt(int index) {
+        Snapshot *snapshot = snapshots[index];
+        snapshotMemoryUsage -= snapshot->size();
+        snapshots.remove(snapshot);
+        snapshots.sort(SnapshotPredication());
+        internal::deleteObject(snapshot);
+    }
+    void clearSnapshots() {
+        snapshots.releaseAll();
+        snapshotMemoryUsage = 0;
+    }
+
     btDefaultCollisionConfiguration config;
     btCollisionDispatcher *dispatcher;
     btDbvtBroadphase *broadphase;
     btSequentialImpulseConstraintSolver *solver;
-    btDiscreteDynamicsWorld *world;
+    BoundedDynamicsWorld *world;
     btStaticPlaneShape *ground;
     btRigidBody *groundBody;
+    StepStatistics statistics;
     Scalar baseFPS;
     Scalar timeScale;
+    Scalar stepTimeBudget;
+    int maxSubSteps;
+    SteppingPolicy steppingPolicy;
+    Array<Snapshot *> snapshots;
+    Scalar snapshotInterval;
+    vsize snapshotMemoryBudget;
+    vsize snapshotMemoryUsage;
     bool enableFloor;
 };
 
+const int World::kDefaultMaxSubSteps = 8;
+const Scalar World::kDefaultSnapshotInterval = 30;
+const vsize World::kDefaultSnapshotMemoryBudget = 32 * 1024 * 1024;
 const int World::PrivateContext::kMaxSubSteps = std::numeric_limits<int>::max();
 
 World::World()
@@ -136,6 +409,7 @@ void World::addRigidBody(btRigidBody *value)
 void World::removeRigidBody(btRigidBody *value)
 {
     m_context->world->removeRigidBody(value);
+    m_context->clearSnapshots();
 }
 
 void World::deleteAll()
@@ -156,12 +430,33 @@ void World::deleteAll()
             delete object;
         }
     }
+    m_context->clearSnapshots();
 }
 
 void World::stepSimulation(const Scalar &deltaTimeIndex, const Scalar &motionFPS)
 {
     const Scalar &v = (deltaTimeIndex / motionFPS) * (m_context->baseFPS / motionFPS) * m_context->timeScale;
-    m_context->world->stepSimulation(v, PrivateContext::kMaxSubSteps, 1.0f / m_context->baseFPS);
+    const Scalar &fixedTimeStep = 1.0f / m_context->baseFPS;
+    BoundedDynamicsWorld *world = m_context->world;
+    StepStatistics &statistics = m_context->statistics;
+    btClock clock;
+    world->resetTimers();
+    if (m_context->steppingPolicy == kExactStepping) {
+        statistics.numSubSteps = world->stepSimulation(v, PrivateContext::kMaxSubSteps, fixedTimeStep);
+        statistics.numDroppedSubSteps = 0;
+    }
+    else {
+        int numExecuted = 0;
+        bool dropRemainder = m_context->steppingPolicy == kDropStepping;
+        int numSubSteps = world->stepSimulationBounded(v, m_context->maxSubSteps, fixedTimeStep,
+                                                        m_context->stepTimeBudget, dropRemainder, numExecuted);
+        statistics.numSubSteps = numExecuted;
+        statistics.numDroppedSubSteps = numSubSteps - numExecuted;
+    }
+    statistics.numOverlappingPairs = m_context->broadphase->getOverlappingPairCache()->getNumOverlappingPairs();
+    statistics.elapsedTime = Scalar(clock.getTimeMicroseconds()) / 1000000;
+    statistics.collisionTime = world->collisionTime();
+    statistics.solverTime = world->solverTime();
 }
 
 const Vector3 World::gravity() const
@@ -226,6 +521,97 @@ void World::setFloorEnabled(bool value)
     m_context->enableFloor = value;
 }
 
+World::SteppingPolicy World::steppingPolicy() const
+{
+    return m_context->steppingPolicy;
+}
+
+void World::setSteppingPolicy(SteppingPolicy value)
+{
+    m_context->steppingPolicy = value;
+}
+
+int World::maxSubSteps() const
+{
+    return m_context->maxSubSteps;
+}
+
+void World::setMaxSubSteps(int value)
+{
+    m_context->maxSubSteps = btMax(value, 1);
+}
+
+Scalar World::stepTimeBudget() const
+{
+    return m_context->stepTimeBudget;
+}
+
+void World::setStepTimeBudget(const Scalar &value)
+{
+    m_context->stepTimeBudget = btMax(value, Scalar(0));
+}
+
+void World::getStepStatistics(StepStatistics &value) const
+{
+    value = m_context->statistics;
+}
+
+void World::captureSnapshot(const Scalar &timeIndex)
+{
+    m_context->captureSnapshot(timeIndex);
+}
+
+bool World::findSnapshot(const Scalar &timeIndex, Scalar &foundTimeIndex) const
+{
+    const int index = m_context->findSnapshotIndex(timeIndex);
+    if (index >= 0) {
+        foundTimeIndex = m_context->snapshots[index]->timeIndex;
+        return true;
+    }
+    return false;
+}
+
+bool World::restoreSnapshot(const Scalar &timeIndex, Scalar &restoredTimeIndex)
+{
+    return m_context->restoreSnapshot(timeIndex, restoredTimeIndex);
+}
+
+void World::clearSnapshots()
+{
+    m_context->clearSnapshots();
+}
+
+int World::countSnapshots() const
+{
+    return m_context->snapshots.count();
+}
+
+Scalar World::snapshotInterval() const
+{
+    return m_context->snapshotInterval;
+}
+
+void World::setSnapshotInterval(const Scalar &value)
+{
+    m_context->snapshotInterval = btMax(value, Scalar(1));
+}
+
+vsize World::snapshotMemoryBudget() const
+{
+    return m_context->snapshotMemoryBudget;
+}
+
+void World::setSnapshotMemoryBudget(vsize value)
+{
+    m_context->snapshotMemoryBudget = value;
+    m_context->evictSnapshots();
+}
+
+vsize World::snapshotMemoryUsage() const
+{
+    return m_context->snapshotMemoryUsage;
+}
+
 
 } /* namespace extensions */
 } /* namespace VPVL2_VERSION_NS */
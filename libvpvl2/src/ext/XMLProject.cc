@@ -67,6 +67,8 @@
 #include "vpvl2/vmd/Motion.h"
 
 #include <tinyxml2.h>
+#include <cstdio>
+#include <cstring>
 #include <set>
 #include <string>
 #include <sstream>
@@ -76,6 +78,39 @@
 
 using namespace tinyxml2;
 
+namespace
+{
+
+using namespace vpvl2::VPVL2_VERSION_NS;
+
+/* the binary project starts with BinaryHeader and is followed by chunks until EOF */
+static const uint8 kBinarySignature[] = { 'V', 'P', 'V', 'L', '2', 'P', 'R', 'J' };
+
+struct BinaryHeader {
+    uint8 signature[sizeof(kBinarySignature)];
+    float32 version;
+    uint32 flags;
+};
+
+struct BinaryChunkHeader {
+    uint32 type;
+    uint32 size;
+};
+
+enum BinaryChunkType {
+    kSettingsChunk = 0x47544553, /* SETG */
+    kModelChunk    = 0x4c444f4d, /* MODL */
+    kAssetChunk    = 0x54455341, /* ASET */
+    kMotionChunk   = 0x4e544f4d  /* MOTN */
+};
+
+static inline vsize alignChunkSize(vsize size)
+{
+    return (size + 3) & ~vsize(3);
+}
+
+}
+
 namespace vpvl2
 {
 namespace VPVL2_VERSION_NS
@@ -839,6 +874,8 @@ struct XMLProject::PrivateContext {
                 pushState(kAssets);
             }
             else if (equalsToElement(element, "vpvm:motions")) {
+                /* motions refer their parent models */
+                flushPendingModels();
                 pushState(kMotions);
             }
         }
@@ -1562,50 +1599,78 @@ struct XMLProject::PrivateContext {
         }
     }
 
-    void addAsset() {
-        if (!uuid.empty() && uuid != XMLProject::kNullUUID && assetRefs.find(uuid) == assetRefs.end()) {
-            IModel *assetPtr = 0;
+    void loadModel(const XMLProject::UUID &value, IModel::Type type, ModelSettings &settings, ModelMap &models) {
+        if (!value.empty() && value != XMLProject::kNullUUID && models.find(value) == models.end()) {
+            IModel *modelPtr = 0;
             IRenderEngine *enginePtr = 0;
             int priority = 0;
-            if (delegateRef->loadModel(uuid, localAssetSettings[uuid], IModel::kAssetModel, assetPtr, enginePtr, priority)) {
-                assetRefs.insert(std::make_pair(uuid, assetPtr));
-                sceneRef->addModel(assetPtr, enginePtr, priority);
+            if (delegateRef->loadModel(value, settings[value], type, modelPtr, enginePtr, priority)) {
+                models.insert(std::make_pair(value, modelPtr));
+                sceneRef->addModel(modelPtr, enginePtr, priority);
             }
         }
+    }
+    void commitMotion(const XMLProject::UUID &value, const XMLProject::UUID &parentModelUUID, IMotion *motion) {
+        MotionMap::iterator it = motionRefs.find(value);
+        if (it != motionRefs.end()) {
+            sceneRef->removeMotion(it->second);
+            internal::deleteObject(it->second);
+            motionRefs.erase(it);
+        }
+        if (!parentModelUUID.empty()) {
+            ModelMap::const_iterator it2 = modelRefs.find(parentModelUUID);
+            if (it2 != modelRefs.end()) {
+                motion->setParentModelRef(it2->second);
+            }
+        }
+        motionRefs.insert(std::make_pair(value, motion));
+        motion->createFirstKeyframesUnlessFound();
+        sceneRef->addMotion(motion);
+    }
+    void enqueueModel(const XMLProject::UUID &value, IModel::Type type) {
+        if (!value.empty() && value != XMLProject::kNullUUID) {
+            pendingModels.push_back(std::make_pair(value, type));
+        }
+    }
+    void flushPendingModels() {
+        if (pendingModels.empty()) {
+            return;
+        }
+        /* let the delegate parse all models at once, then register them in the project order */
+        XMLProject::ModelRequestList requests;
+        std::set<XMLProject::UUID> requested;
+        for (PendingModelList::const_iterator it = pendingModels.begin(); it != pendingModels.end(); it++) {
+            const XMLProject::UUID &value = it->first;
+            if (!findModel(value) && requested.insert(value).second) {
+                const bool isAsset = it->second == IModel::kAssetModel;
+                requests.push_back(XMLProject::ModelRequest(value, (isAsset ? localAssetSettings : localModelSettings)[value], it->second));
+            }
+        }
+        delegateRef->prefetchModels(requests);
+        for (PendingModelList::const_iterator it = pendingModels.begin(); it != pendingModels.end(); it++) {
+            if (it->second == IModel::kAssetModel) {
+                loadModel(it->first, it->second, localAssetSettings, assetRefs);
+            }
+            else {
+                loadModel(it->first, it->second, localModelSettings, modelRefs);
+            }
+        }
+        pendingModels.clear();
+    }
+    void addAsset() {
+        enqueueModel(uuid, IModel::kAssetModel);
         popState(kAssets);
         uuid.clear();
     }
     void addModel() {
-        if (!uuid.empty() && uuid != XMLProject::kNullUUID && modelRefs.find(uuid) == modelRefs.end()) {
-            IModel *modelPtr = 0;
-            IRenderEngine *enginePtr = 0;
-            int priority = 0;
-            if (delegateRef->loadModel(uuid, localModelSettings[uuid], IModel::kPMDModel, modelPtr, enginePtr, priority)) {
-                modelRefs.insert(std::make_pair(uuid, modelPtr));
-                sceneRef->addModel(modelPtr, enginePtr, priority);
-            }
-        }
+        enqueueModel(uuid, IModel::kPMDModel);
         popState(kModels);
         uuid.clear();
     }
     void addMotion() {
         if (!uuid.empty()) {
             if (uuid != XMLProject::kNullUUID && currentMotion) {
-                MotionMap::iterator it = motionRefs.find(uuid);
-                if (it != motionRefs.end()) {
-                    sceneRef->removeMotion(it->second);
-                    internal::deleteObject(it->second);
-                    motionRefs.erase(it);
-                }
-                if (!parentModel.empty()) {
-                    ModelMap::const_iterator it2 = modelRefs.find(parentModel);
-                    if (it2 != modelRefs.end()) {
-                        currentMotion->setParentModelRef(it2->second);
-                    }
-                }
-                motionRefs.insert(std::make_pair(uuid, currentMotion));
-                currentMotion->createFirstKeyframesUnlessFound();
-                sceneRef->addMotion(currentMotion);
+                commitMotion(uuid, parentModel, currentMotion);
             }
             else {
                 internal::deleteObject(currentMotion);
@@ -1617,7 +1682,7 @@ struct XMLProject::PrivateContext {
         popState(kMotions);
     }
 
-    bool save(XMLPrinter &printer) {
+    void saveSceneStates() {
         const ICamera *camera = sceneRef->cameraRef();
         globalSettings["state.camera.angle"] = XMLProject::toStringFromVector3(camera->angle());
         globalSettings["state.camera.distance"] = XMLProject::toStringFromFloat32(camera->distance());
@@ -1626,12 +1691,269 @@ struct XMLProject::PrivateContext {
         const ILight *light = sceneRef->lightRef();
         globalSettings["state.light.color"] = XMLProject::toStringFromVector3(light->color());
         globalSettings["state.light.direction"] = XMLProject::toStringFromVector3(light->direction());
+    }
+    bool save(XMLPrinter &printer) {
+        saveSceneStates();
         bool ret = writeXml(printer);
         if (ret) {
             dirty = false;
         }
         return ret;
     }
+    bool save(FILE *fp) {
+        saveSceneStates();
+        bool ret = writeBinary(fp);
+        if (ret) {
+            dirty = false;
+        }
+        return ret;
+    }
+
+    static void appendBytes(const void *data, vsize size, std::vector<uint8> &bytes) {
+        const uint8 *ptr = static_cast<const uint8 *>(data);
+        bytes.insert(bytes.end(), ptr, ptr + size);
+    }
+    static void appendText(const std::string &value, std::vector<uint8> &bytes) {
+        int32 size = int32(value.size());
+        appendBytes(&size, sizeof(size), bytes);
+        appendBytes(value.data(), value.size(), bytes);
+    }
+    static void appendStringMap(const StringMap &map, std::vector<uint8> &bytes) {
+        int32 count = 0;
+        for (StringMap::const_iterator it = map.begin(); it != map.end(); it++) {
+            if (!it->first.empty() && !it->second.empty()) {
+                count++;
+            }
+        }
+        appendBytes(&count, sizeof(count), bytes);
+        for (StringMap::const_iterator it = map.begin(); it != map.end(); it++) {
+            if (!it->first.empty() && !it->second.empty()) {
+                appendText(it->first, bytes);
+                appendText(it->second, bytes);
+            }
+        }
+    }
+    static bool writeChunk(uint32 type, const std::vector<uint8> &bytes, FILE *fp) {
+        static const uint8 kPadding[4] = { 0, 0, 0, 0 };
+        BinaryChunkHeader header;
+        header.type = type;
+        header.size = uint32(bytes.size());
+        const vsize padding = alignChunkSize(bytes.size()) - bytes.size();
+        return fwrite(&header, sizeof(header), 1, fp) == 1 &&
+                (bytes.empty() || fwrite(&bytes[0], bytes.size(), 1, fp) == 1) &&
+                (padding == 0 || fwrite(kPadding, padding, 1, fp) == 1);
+    }
+    bool writeModelChunks(uint32 type, const ModelMap &models, const ModelSettings &settings, FILE *fp) const {
+        std::vector<uint8> bytes;
+        StringMap newModelSettings;
+        for (ModelMap::const_iterator it = models.begin(); it != models.end(); it++) {
+            const XMLProject::UUID &modelUUID = it->first;
+            newModelSettings.clear();
+            ModelSettings::const_iterator it2 = settings.find(modelUUID);
+            if (it2 != settings.end()) {
+                getNewModelSettings(it->second, it2->second, newModelSettings);
+            }
+            bytes.clear();
+            appendText(modelUUID, bytes);
+            appendStringMap(newModelSettings, bytes);
+            if (!writeChunk(type, bytes, fp)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    bool writeBinary(FILE *fp) const {
+        BinaryHeader header;
+        internal::zerofill(&header, sizeof(header));
+        memcpy(header.signature, kBinarySignature, sizeof(header.signature));
+        header.version = XMLProject::formatVersion();
+        if (fwrite(&header, sizeof(header), 1, fp) != 1) {
+            return false;
+        }
+        std::vector<uint8> bytes;
+        appendStringMap(globalSettings, bytes);
+        if (!writeChunk(kSettingsChunk, bytes, fp)) {
+            return false;
+        }
+        /* models and assets must precede motions to resolve parent model of each motion */
+        if (!writeModelChunks(kModelChunk, modelRefs, localModelSettings, fp) ||
+                !writeModelChunks(kAssetChunk, assetRefs, localAssetSettings, fp)) {
+            return false;
+        }
+        for (MotionMap::const_iterator it = motionRefs.begin(); it != motionRefs.end(); it++) {
+            const IMotion *motion = it->second;
+            const IMotion::FormatType motionType = motion ? motion->type() : IMotion::kUnknownFormat;
+            if (motionType != IMotion::kVMDFormat && motionType != IMotion::kMVDFormat) {
+                continue;
+            }
+            const XMLProject::UUID &parentModelUUID = findModelUUID(motion->parentModelRef());
+            std::vector<uint8> payload;
+            saveMotion(motion, payload);
+            IMotion *convertedMotion = 0;
+            if (motionType == IMotion::kVMDFormat && !isVMDKeyframeNamesPreserved(motion, payload)) {
+                /* VMD truncates names to 15 bytes of Shift-JIS so the motion is stored as MVD instead */
+                convertedMotion = factoryRef->convertMotion(const_cast<IMotion *>(motion), IMotion::kMVDFormat);
+                if (!convertedMotion) {
+                    return false;
+                }
+                saveMotion(convertedMotion, payload);
+            }
+            const int32 type = convertedMotion ? convertedMotion->type() : motionType;
+            internal::deleteObject(convertedMotion);
+            bytes.clear();
+            appendText(it->first, bytes);
+            appendText(parentModelUUID, bytes);
+            appendBytes(&type, sizeof(type), bytes);
+            const int32 size = int32(payload.size());
+            appendBytes(&size, sizeof(size), bytes);
+            /* store the motion as its native VMD/MVD encoding */
+            bytes.insert(bytes.end(), payload.begin(), payload.end());
+            if (!writeChunk(kMotionChunk, bytes, fp)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    static void saveMotion(const IMotion *motion, std::vector<uint8> &bytes) {
+        bytes.resize(motion->estimateSize());
+        if (!bytes.empty()) {
+            motion->save(&bytes[0]);
+        }
+    }
+    void getKeyframeNames(const IMotion *motion, std::set<std::string> &names) const {
+        const int nBoneKeyframes = motion->countKeyframes(IKeyframe::kBoneKeyframe);
+        for (int i = 0; i < nBoneKeyframes; i++) {
+            names.insert(delegateRef->toStdFromString(motion->findBoneKeyframeRefAt(i)->name()));
+        }
+        const int nMorphKeyframes = motion->countKeyframes(IKeyframe::kMorphKeyframe);
+        for (int i = 0; i < nMorphKeyframes; i++) {
+            names.insert(delegateRef->toStdFromString(motion->findMorphKeyframeRefAt(i)->name()));
+        }
+    }
+    bool isVMDKeyframeNamesPreserved(const IMotion *motion, const std::vector<uint8> &payload) const {
+        /* reads the saved VMD back as names may also contain characters not representable in Shift-JIS */
+        IMotion *savedMotion = factoryRef->newMotion(IMotion::kVMDFormat, 0);
+        bool preserved = false;
+        if (savedMotion && (payload.empty() || savedMotion->load(&payload[0], payload.size()))) {
+            std::set<std::string> names, savedNames;
+            getKeyframeNames(motion, names);
+            getKeyframeNames(savedMotion, savedNames);
+            preserved = names == savedNames;
+        }
+        internal::deleteObject(savedMotion);
+        return preserved;
+    }
+
+    static bool readText(uint8 *&ptr, vsize &rest, std::string &value) {
+        uint8 *text = 0;
+        int32 size = 0;
+        if (!internal::getText(ptr, rest, text, size)) {
+            return false;
+        }
+        value.assign(reinterpret_cast<const char *>(text), size);
+        return true;
+    }
+    static bool readStringMap(uint8 *&ptr, vsize &rest, StringMap &map) {
+        int32 count = 0;
+        std::string key, value;
+        if (!internal::getTyped(ptr, rest, count) || count < 0) {
+            return false;
+        }
+        for (int32 i = 0; i < count; i++) {
+            if (!readText(ptr, rest, key) || !readText(ptr, rest, value)) {
+                return false;
+            }
+            map[key] = value;
+        }
+        return true;
+    }
+    bool readModelChunk(uint8 *&ptr, vsize &rest, IModel::Type type, ModelSettings &settings) {
+        XMLProject::UUID modelUUID;
+        if (!readText(ptr, rest, modelUUID) || !readStringMap(ptr, rest, settings[modelUUID])) {
+            return false;
+        }
+        enqueueModel(modelUUID, type);
+        return true;
+    }
+    bool readMotionChunk(uint8 *&ptr, vsize &rest) {
+        XMLProject::UUID motionUUID, parentModelUUID;
+        uint8 *payload = 0;
+        int32 type = 0, payloadSize = 0;
+        if (!readText(ptr, rest, motionUUID) || !readText(ptr, rest, parentModelUUID) ||
+                !internal::getTyped(ptr, rest, type) || !internal::getText(ptr, rest, payload, payloadSize)) {
+            return false;
+        }
+        if (motionUUID.empty() || motionUUID == XMLProject::kNullUUID ||
+                (type != IMotion::kVMDFormat && type != IMotion::kMVDFormat)) {
+            /* skip the motion same as XML */
+            return true;
+        }
+        IModel *modelRef = findModel(parentModelUUID);
+        IMotion *motion = factoryRef->newMotion(static_cast<IMotion::FormatType>(type), modelRef);
+        if (motion && motion->load(payload, payloadSize)) {
+            if (modelRef) {
+                motion->setParentModelRef(modelRef);
+            }
+            commitMotion(motionUUID, parentModelUUID, motion);
+            return true;
+        }
+        VPVL2_LOG(WARNING, "Cannot load motion chunk: uuid=" << motionUUID);
+        internal::deleteObject(motion);
+        return false;
+    }
+    bool readBinary(const uint8 *data, vsize size) {
+        uint8 *ptr = const_cast<uint8 *>(data);
+        vsize rest = size;
+        BinaryHeader header;
+        if (!XMLProject::isBinaryFormat(data, size) || !internal::getTyped(ptr, rest, header)) {
+            return false;
+        }
+        char buffer[kElementContentBufferSize];
+        internal::snprintf(buffer, sizeof(buffer), "%.1f", header.version);
+        version.assign(buffer);
+        BinaryChunkHeader chunk;
+        while (rest > 0) {
+            if (!internal::getTyped(ptr, rest, chunk) || chunk.size > rest) {
+                return false;
+            }
+            uint8 *chunkPtr = ptr;
+            vsize chunkRest = chunk.size;
+            bool ok = true;
+            switch (chunk.type) {
+            case kSettingsChunk:
+                ok = readStringMap(chunkPtr, chunkRest, globalSettings);
+                break;
+            case kModelChunk:
+                ok = readModelChunk(chunkPtr, chunkRest, IModel::kPMDModel, localModelSettings);
+                break;
+            case kAssetChunk:
+                ok = readModelChunk(chunkPtr, chunkRest, IModel::kAssetModel, localAssetSettings);
+                break;
+            case kMotionChunk:
+                flushPendingModels();
+                ok = readMotionChunk(chunkPtr, chunkRest);
+                break;
+            default:
+                /* unknown chunks are skipped for forward compatibility */
+                break;
+            }
+            if (!ok) {
+                VPVL2_LOG(WARNING, "Malformed chunk found: type=" << chunk.type << " size=" << chunk.size);
+                return false;
+            }
+            internal::drainBytes(std::min(alignChunkSize(chunk.size), rest), ptr, rest);
+        }
+        flushPendingModels();
+        return true;
+    }
+    bool loadBinary(const uint8 *data, vsize size) {
+        bool ret = validate(readBinary(data, size));
+        if (ret) {
+            sort();
+            restoreStates();
+        }
+        return ret;
+    }
     bool validate(bool result) {
         return result && depth == 0 && checkDuplicateUUID();
     }
@@ -1804,12 +2126,14 @@ struct XMLProject::PrivateContext {
         PrivateContext *contextRef;
     };
 
+    typedef std::vector<std::pair<XMLProject::UUID, IModel::Type> > PendingModelList;
     XMLProject::IDelegate *delegateRef;
     Scene *sceneRef;
     Factory *factoryRef;
     ModelMap assetRefs;
     ModelMap modelRefs;
     MotionMap motionRefs;
+    PendingModelList pendingModels;
     StringMap globalSettings;
     ModelSettings localAssetSettings;
     ModelSettings localModelSettings;
@@ -1832,6 +2156,11 @@ const std::string XMLProject::kSettingURIKey = "uri";
 const std::string XMLProject::kSettingArchiveURIKey = "uri.archive";
 const std::string XMLProject::kSettingOrderKey = "order";
 
+bool XMLProject::isBinaryFormat(const uint8 *data, vsize size)
+{
+    return data && size >= sizeof(BinaryHeader) && internal::memcmp(data, kBinarySignature, sizeof(kBinarySignature)) == 0;
+}
+
 float32 XMLProject::formatVersion()
 {
     return 2.1f;
@@ -1924,11 +2253,34 @@ XMLProject::~XMLProject()
 
 bool XMLProject::load(const char *path)
 {
+    if (FILE *fp = fopen(path, "rb")) {
+        uint8 signature[sizeof(BinaryHeader)];
+        const vsize nread = fread(signature, 1, sizeof(signature), fp);
+        if (isBinaryFormat(signature, nread)) {
+            std::vector<uint8> bytes;
+            fseek(fp, 0, SEEK_END);
+            const long size = ftell(fp);
+            fseek(fp, 0, SEEK_SET);
+            bool ret = false;
+            if (size > 0) {
+                bytes.resize(size);
+                ret = fread(&bytes[0], bytes.size(), 1, fp) == 1 && m_context->loadBinary(&bytes[0], bytes.size());
+            }
+            fclose(fp);
+            if (!ret) {
+                VPVL2_LOG(WARNING, "Cannot load binary project from file " << path);
+            }
+            return ret;
+        }
+        fclose(fp);
+    }
     tinyxml2::XMLDocument document;
     bool ret = false;
     if (document.LoadFile(path) == XML_NO_ERROR) {
         PrivateContext::Reader reader(m_context);
-        ret = m_context->validate(document.Accept(&reader));
+        const bool accepted = document.Accept(&reader);
+        m_context->flushPendingModels();
+        ret = m_context->validate(accepted);
         if (ret) {
             m_context->sort();
             m_context->restoreStates();
@@ -1942,11 +2294,21 @@ bool XMLProject::load(const char *path)
 
 bool XMLProject::load(const uint8 *data, vsize size)
 {
+    if (isBinaryFormat(data, size)) {
+        /* chunks are parsed in place so the data can be a memory mapped file */
+        bool ret = m_context->loadBinary(data, size);
+        if (!ret) {
+            VPVL2_LOG(WARNING, "Cannot load binary project from memory");
+        }
+        return ret;
+    }
     tinyxml2::XMLDocument document;
     bool ret = false;
     if (document.Parse(reinterpret_cast<const char *>(data), size) == XML_NO_ERROR) {
         PrivateContext::Reader reader(m_context);
-        ret = m_context->validate(document.Accept(&reader));
+        const bool accepted = document.Accept(&reader);
+        m_context->flushPendingModels();
+        ret = m_context->validate(accepted);
         if (ret) {
             m_context->sort();
             m_context->restoreStates();
@@ -1960,11 +2322,30 @@ bool XMLProject::load(const uint8 *data, vsize size)
 
 bool XMLProject::save(const char *path)
 {
-    if (FILE *fp = fopen(path, "w")) {
-        XMLPrinter printer(fp);
-        bool ret = m_context->save(printer);
-        fclose(fp);
-        return ret;
+    return save(path, kXMLFormat);
+}
+
+bool XMLProject::save(const char *path, FormatType format)
+{
+    switch (format) {
+    case kXMLFormat:
+        if (FILE *fp = fopen(path, "w")) {
+            XMLPrinter printer(fp);
+            bool ret = m_context->save(printer);
+            fclose(fp);
+            return ret;
+        }
+        break;
+    case kBinaryFormat:
+        if (FILE *fp = fopen(path, "wb")) {
+            bool ret = m_context->save(fp);
+            ret = fclose(fp) == 0 && ret;
+            return ret;
+        }
+        break;
+    case kMaxFormatType:
+    default:
+        break;
     }
     return false;
 }
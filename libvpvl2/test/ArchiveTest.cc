@@ -148,3 +148,42 @@ TEST(ArchiveTest, UncompressWithSetBasePath)
     ASSERT_TRUE(dataRef2);
     ASSERT_EQ(dataRef2, dataRef);
 }
+
+TEST(ArchiveTest, MapStoredEntry)
+{
+    Encoding encoding(0);
+    Archive archive(&encoding);
+    Archive::EntryNames entries;
+    UncompressArchive(archive, entries);
+    vsize size = 0;
+    const uint8 *ptr = archive.mappedDataRef("FOO.TXT", size);
+    ASSERT_TRUE(ptr);
+    ASSERT_EQ(std::string("foo\n"), std::string(reinterpret_cast<const char *>(ptr), size));
+    /* mapping should not uncompress the entry */
+    ASSERT_FALSE(archive.dataRef("foo.txt"));
+    ASSERT_FALSE(archive.mappedDataRef("not_found.txt", size));
+    ASSERT_EQ(vsize(0), size);
+}
+
+TEST(ArchiveTest, ReadAndReleaseEntry)
+{
+    Encoding encoding(0);
+    Archive archive(&encoding);
+    Archive::EntryNames entries;
+    UncompressArchive(archive, entries);
+    std::string bytes;
+    ASSERT_TRUE(archive.readEntry("path/to/entry.txt", bytes));
+    ASSERT_STREQ("entry.txt\n", bytes.c_str());
+    /* reading into caller buffer should not be cached */
+    ASSERT_FALSE(archive.dataRef("path/to/entry.txt"));
+    ASSERT_FALSE(archive.readEntry("not_found.txt", bytes));
+    ASSERT_TRUE(archive.uncompressEntry("bar.txt"));
+    ASSERT_TRUE(archive.dataRef("bar.txt"));
+    archive.releaseEntry("bar.txt");
+    ASSERT_FALSE(archive.dataRef("bar.txt"));
+    /* released entry can be uncompressed again */
+    ASSERT_TRUE(archive.uncompressEntry("bar.txt"));
+    ASSERT_STREQ("bar\n", archive.dataRef("bar.txt")->c_str());
+    archive.releaseAllEntries();
+    ASSERT_TRUE(archive.entryNames().empty());
+}
@@ -0,0 +1,109 @@
+#include "Common.h"
+
+#include "vpvl2/vpvl2.h"
+#include "vpvl2/extensions/EffectCache.h"
+
+using namespace ::testing;
+using namespace vpvl2;
+using namespace vpvl2::extensions;
+
+namespace {
+
+class EffectCacheTest : public Test {
+protected:
+    void SetUp() {
+        ASSERT_TRUE(m_directory.isValid());
+        EffectCache::setDirectory(m_directory.path().toStdString());
+        EffectCache::resetStatistics();
+    }
+    void TearDown() {
+        EffectCache::setDirectory(std::string());
+    }
+    QTemporaryDir m_directory;
+};
+
+}
+
+TEST_F(EffectCacheTest, MakeKey)
+{
+    StringMap includes;
+    StringList defines;
+    const std::string &key = EffectCache::makeKey("fx5:120", "source", includes, defines);
+    ASSERT_EQ(key, EffectCache::makeKey("fx5:120", "source", includes, defines));
+    ASSERT_NE(key, EffectCache::makeKey("fx5:150", "source", includes, defines));
+    ASSERT_NE(key, EffectCache::makeKey("fx5:120", "source2", includes, defines));
+    /* concatenation of the inputs must not be the same key */
+    ASSERT_NE(key, EffectCache::makeKey("fx5:12", "0source", includes, defines));
+    includes["common.fxsub"] = "float4 color;";
+    const std::string &keyWithInclude = EffectCache::makeKey("fx5:120", "source", includes, defines);
+    ASSERT_NE(key, keyWithInclude);
+    includes["common.fxsub"] = "float3 color;";
+    ASSERT_NE(keyWithInclude, EffectCache::makeKey("fx5:120", "source", includes, defines));
+    includes.clear();
+    defines.push_back("-DVPVM");
+    ASSERT_NE(key, EffectCache::makeKey("fx5:120", "source", includes, defines));
+}
+
+TEST_F(EffectCacheTest, StoreAndFind)
+{
+    const std::string &key = EffectCache::makeKey("fx5:120", "source", StringMap(), StringList());
+    const char source[] = "void main() {}";
+    uint32 format = 0;
+    Array<uint8> bytes;
+    ASSERT_FALSE(EffectCache::find(key, EffectCache::kTranslatedSource, format, bytes));
+    ASSERT_TRUE(EffectCache::store(key, EffectCache::kTranslatedSource, 0x8B31, reinterpret_cast<const uint8 *>(source), sizeof(source)));
+    ASSERT_TRUE(EffectCache::find(key, EffectCache::kTranslatedSource, format, bytes));
+    ASSERT_EQ(uint32(0x8B31), format);
+    ASSERT_EQ(int(sizeof(source)), bytes.count());
+    ASSERT_STREQ(source, reinterpret_cast<const char *>(&bytes[0]));
+    /* entry types are stored separately */
+    ASSERT_FALSE(EffectCache::find(key, EffectCache::kProgramBinary, format, bytes));
+    EffectCache::Statistics statistics;
+    EffectCache::getStatistics(statistics);
+    ASSERT_EQ(1, statistics.numSourceHits);
+    ASSERT_EQ(1, statistics.numSourceMisses);
+    ASSERT_EQ(0, statistics.numProgramBinaryHits);
+    ASSERT_EQ(1, statistics.numProgramBinaryMisses);
+    ASSERT_EQ(1, statistics.numStores);
+    ASSERT_EQ(0, statistics.numRejects);
+}
+
+TEST_F(EffectCacheTest, RejectInvalidEntry)
+{
+    const std::string &key = EffectCache::makeKey("gl2:33:150:1", "source", StringMap(), StringList());
+    const uint8 binary[] = { 1, 2, 3, 4 };
+    uint32 format = 0;
+    Array<uint8> bytes;
+    ASSERT_TRUE(EffectCache::store(key, EffectCache::kProgramBinary, 42, binary, sizeof(binary)));
+    /* corrupts the payload to fail the checksum */
+    QFile file(m_directory.filePath(QString::fromStdString(key + ".bin")));
+    ASSERT_TRUE(file.open(QFile::ReadWrite));
+    ASSERT_TRUE(file.seek(file.size() - 1));
+    ASSERT_EQ(1, file.write("\xff", 1));
+    file.close();
+    ASSERT_FALSE(EffectCache::find(key, EffectCache::kProgramBinary, format, bytes));
+    ASSERT_FALSE(file.exists());
+    /* the entry refused by the driver is removed too */
+    ASSERT_TRUE(EffectCache::store(key, EffectCache::kProgramBinary, 42, binary, sizeof(binary)));
+    EffectCache::reject(key, EffectCache::kProgramBinary);
+    ASSERT_FALSE(EffectCache::find(key, EffectCache::kProgramBinary, format, bytes));
+    EffectCache::Statistics statistics;
+    EffectCache::getStatistics(statistics);
+    ASSERT_EQ(2, statistics.numRejects);
+    ASSERT_EQ(2, statistics.numProgramBinaryMisses);
+}
+
+TEST_F(EffectCacheTest, Disabled)
+{
+    EffectCache::setDirectory(std::string());
+    ASSERT_FALSE(EffectCache::isEnabled());
+    const uint8 binary[] = { 1, 2, 3, 4 };
+    uint32 format = 0;
+    Array<uint8> bytes;
+    ASSERT_FALSE(EffectCache::store("key", EffectCache::kProgramBinary, 42, binary, sizeof(binary)));
+    ASSERT_FALSE(EffectCache::find("key", EffectCache::kProgramBinary, format, bytes));
+    EffectCache::Statistics statistics;
+    EffectCache::getStatistics(statistics);
+    ASSERT_EQ(0, statistics.numStores);
+    ASSERT_EQ(0, statistics.numProgramBinaryMisses);
+}
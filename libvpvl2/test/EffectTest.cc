@@ -368,6 +368,47 @@ TEST_F(EffectTest, LoadControlObjectWithModel)
     // AssertParameterFloat(effectPtr, "model_morph", kScaleFactor);
 }
 
+TEST_F(EffectTest, RebindControlObjectWithModelStructureChanged)
+{
+    MockIApplicationContext applicationContext;
+    MockIModel model, *modelPtr = &model;
+    MockIBone bone, renamedBone;
+    MockIBone *bonePtr = &bone;
+    int structureRevision = 0;
+    Scene scene(true);
+    CGeffect effectPtr;
+    std::unique_ptr<cg::Effect> ptr(createEffect(":effects/controlobjects.cgfx", scene, applicationContext, effectPtr));
+    EXPECT_CALL(applicationContext, findProcedureAddress(_)).Times(AnyNumber()).WillRepeatedly(Return(static_cast<void *>(0)));
+    MockEffectEngine engine(&scene, ptr.data(), &applicationContext);
+    Transform boneTransform, renamedBoneTransform;
+    boneTransform.setIdentity();
+    boneTransform.setOrigin(kPosition);
+    renamedBoneTransform.setIdentity();
+    renamedBoneTransform.setOrigin(kPosition * 2);
+    EXPECT_CALL(bone, worldTransform()).Times(AnyNumber()).WillRepeatedly(Return(boneTransform));
+    EXPECT_CALL(renamedBone, worldTransform()).Times(AnyNumber()).WillRepeatedly(Return(renamedBoneTransform));
+    EXPECT_CALL(model, isVisible()).Times(AnyNumber()).WillRepeatedly(Return(true));
+    EXPECT_CALL(model, worldTranslation()).Times(AnyNumber()).WillRepeatedly(Return(kPosition));
+    EXPECT_CALL(model, scaleFactor()).Times(AnyNumber()).WillRepeatedly(Return(kScaleFactor));
+    EXPECT_CALL(model, type()).Times(AnyNumber()).WillRepeatedly(Return(IModel::kPMDModel));
+    EXPECT_CALL(model, structureRevision()).Times(AnyNumber()).WillRepeatedly(ReturnPointee(&structureRevision));
+    EXPECT_CALL(model, findBoneRef(_)).Times(AnyNumber()).WillRepeatedly(ReturnPointee(&bonePtr));
+    EXPECT_CALL(model, findMorphRef(_)).Times(AnyNumber()).WillRepeatedly(Return(static_cast<IMorph *>(0)));
+    EXPECT_CALL(applicationContext, getMatrix(_, modelPtr, _)).Times(AnyNumber()).WillRepeatedly(Invoke(MatrixSetIdentity));
+    EXPECT_CALL(applicationContext, findModel(_)).Times(AnyNumber()).WillRepeatedly(Return(static_cast<IModel *>(&model)));
+    EXPECT_CALL(applicationContext, toUnicode(_)).Times(AnyNumber()).WillRepeatedly(ReturnNew<String>("asset"));
+    engine.controlObject.update(&model);
+    AssertParameterVector(ptr.data(), "bone_float3", kPosition);
+    /* the resolved bone is kept while the structure of the model is not changed */
+    bonePtr = &renamedBone;
+    engine.controlObject.update(&model);
+    AssertParameterVector(ptr.data(), "bone_float3", kPosition);
+    /* removing or renaming a bone bumps the revision and the bone is resolved again */
+    structureRevision++;
+    engine.controlObject.update(&model);
+    AssertParameterVector(ptr.data(), "bone_float3", kPosition * 2);
+}
+
 TEST_F(EffectTest, LoadTimes)
 {
     MockIApplicationContext applicationContext;
@@ -3,6 +3,7 @@
 #include "vpvl2/extensions/icu4c/String.h"
 #include "vpvl2/internal/MotionHelper.h"
 #include "vpvl2/internal/util.h"
+#include "vpvl2/vmd/MorphKeyframe.h"
 #include <limits>
 
 using namespace ::testing;
@@ -248,3 +249,106 @@ TEST(InternalTest, ToggleFlag)
     vpvl2::internal::toggleFlag(0x0400, false, flag);
     ASSERT_EQ(0x0000, int(flag));
 }
+
+namespace {
+
+static void FindKeyframeIndicesLinear(const IKeyframe::TimeIndex &seekIndex,
+                                      int lastIndex,
+                                      int &fromIndex,
+                                      int &toIndex,
+                                      const Array<vmd::MorphKeyframe *> &keyframes)
+{
+    const int nframes = keyframes.count();
+    const IKeyframe::TimeIndex &currentKeyframe = btMin(seekIndex, keyframes[nframes - 1]->timeIndex());
+    const int first = currentKeyframe >= keyframes[lastIndex]->timeIndex() ? lastIndex : 0;
+    const int last = currentKeyframe >= keyframes[lastIndex]->timeIndex() ? nframes : lastIndex + 1;
+    toIndex = 0;
+    for (int i = first; i < last; i++) {
+        if (currentKeyframe <= keyframes[i]->timeIndex()) {
+            toIndex = i;
+            break;
+        }
+    }
+    fromIndex = toIndex <= 1 ? 0 : toIndex - 1;
+}
+
+static void CreateKeyframes(Encoding *encoding, int nkeyframes, Array<vmd::MorphKeyframe *> &keyframes)
+{
+    for (int i = 0; i < nkeyframes; i++) {
+        vmd::MorphKeyframe *keyframe = new vmd::MorphKeyframe(encoding);
+        /* place keyframes irregularly with several duplicated time indices */
+        keyframe->setTimeIndex(IKeyframe::TimeIndex(i * 3 - (i % 5 == 0 ? 1 : 0) - (i % 7 == 0 ? 2 : 0)));
+        keyframes.append(keyframe);
+    }
+}
+
+static void SeekKeyframes(const Array<IKeyframe::TimeIndex> &timeIndices, const Array<vmd::MorphKeyframe *> &keyframes)
+{
+    const int ntimeIndices = timeIndices.count();
+    int lastIndex = 0, fromIndex, toIndex;
+    IKeyframe::TimeIndex currentTimeIndex;
+    for (int i = 0; i < ntimeIndices; i++) {
+        MotionHelper::findKeyframeIndices(timeIndices[i], currentTimeIndex, lastIndex, fromIndex, toIndex, keyframes);
+    }
+}
+
+}
+
+TEST(InternalTest, FindKeyframeIndicesSameAsLinearSearch)
+{
+    Encoding encoding(0);
+    Array<vmd::MorphKeyframe *> keyframes;
+    CreateKeyframes(&encoding, 1000, keyframes);
+    const IKeyframe::TimeIndex &duration = keyframes[keyframes.count() - 1]->timeIndex();
+    Array<IKeyframe::TimeIndex> timeIndices;
+    /* forward, backward and random seeks */
+    for (int i = 0; i <= duration + 10; i++) {
+        timeIndices.append(i);
+    }
+    for (int i = int(duration); i >= 0; i--) {
+        timeIndices.append(i);
+    }
+    qsrand(42);
+    for (int i = 0; i < 10000; i++) {
+        timeIndices.append(IKeyframe::TimeIndex(qrand() % int(duration + 10)) + 0.5);
+    }
+    const int ntimeIndices = timeIndices.count();
+    int lastIndex = 0, fromIndex, toIndex, expectedFromIndex, expectedToIndex;
+    IKeyframe::TimeIndex currentTimeIndex;
+    for (int i = 0; i < ntimeIndices; i++) {
+        FindKeyframeIndicesLinear(timeIndices[i], lastIndex, expectedFromIndex, expectedToIndex, keyframes);
+        MotionHelper::findKeyframeIndices(timeIndices[i], currentTimeIndex, lastIndex, fromIndex, toIndex, keyframes);
+        ASSERT_EQ(expectedFromIndex, fromIndex) << "seek=" << timeIndices[i];
+        ASSERT_EQ(expectedToIndex, toIndex) << "seek=" << timeIndices[i];
+        ASSERT_EQ(fromIndex, lastIndex);
+    }
+    keyframes.releaseAll();
+}
+
+/* microbenchmark of keyframe lookup, run with --gtest_also_run_disabled_tests */
+TEST(InternalTest, DISABLED_FindKeyframeIndicesBenchmark)
+{
+    Encoding encoding(0);
+    Array<vmd::MorphKeyframe *> keyframes;
+    /* about 10 minutes of keyframes at 30fps */
+    CreateKeyframes(&encoding, 18000, keyframes);
+    const int duration = int(keyframes[keyframes.count() - 1]->timeIndex());
+    Array<IKeyframe::TimeIndex> forward, reverse, random;
+    for (int i = 0; i <= duration; i++) {
+        forward.append(i);
+        reverse.append(duration - i);
+    }
+    qsrand(42);
+    for (int i = 0; i <= duration; i++) {
+        random.append(qrand() % duration);
+    }
+    const Array<IKeyframe::TimeIndex> *patterns[] = { &forward, &reverse, &random };
+    const char *names[] = { "forward", "reverse", "random" };
+    for (int i = 0; i < 3; i++) {
+        QElapsedTimer timer;
+        timer.start();
+        SeekKeyframes(*patterns[i], keyframes);
+        qDebug("%s: %d seeks in %lld ns", names[i], patterns[i]->count(), timer.nsecsElapsed());
+    }
+    keyframes.releaseAll();
+}
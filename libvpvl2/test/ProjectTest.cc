@@ -88,6 +88,32 @@ private:
     Factory m_factory;
 };
 
+class PrefetchDelegate : public Delegate
+{
+public:
+    PrefetchDelegate()
+        : m_numPrefetchedAtFirstLoad(-1)
+    {
+    }
+
+    void prefetchModels(const XMLProject::ModelRequestList &requests) {
+        for (XMLProject::ModelRequestList::const_iterator it = requests.begin(); it != requests.end(); it++) {
+            m_prefetched.push_back(it->uuid);
+        }
+    }
+    bool loadModel(const XMLProject::UUID &uuid, const StringMap &settings, IModel::Type type, IModel *&model, IRenderEngine *&engine, int &priority) {
+        if (m_loaded.empty()) {
+            m_numPrefetchedAtFirstLoad = int(m_prefetched.size());
+        }
+        m_loaded.push_back(uuid);
+        return Delegate::loadModel(uuid, settings, type, model, engine, priority);
+    }
+
+    XMLProject::UUIDList m_prefetched;
+    XMLProject::UUIDList m_loaded;
+    int m_numPrefetchedAtFirstLoad;
+};
+
 
 static void TestGlobalSettings(const XMLProject &project)
 {
@@ -405,6 +431,21 @@ TEST(ProjectTest, Load)
     TestMorphMotion(motion3);
 }
 
+TEST(ProjectTest, PrefetchModels)
+{
+    PrefetchDelegate delegate;
+    Encoding encoding(0);
+    Factory factory(&encoding);
+    XMLProject project(&delegate, &factory, true);
+    ASSERT_TRUE(project.load("../../docs/project.xml"));
+    /* all models are requested at once before loading them in the project order */
+    ASSERT_EQ(vsize(4), delegate.m_prefetched.size());
+    ASSERT_EQ(4, delegate.m_numPrefetchedAtFirstLoad);
+    ASSERT_TRUE(delegate.m_prefetched == delegate.m_loaded);
+    ASSERT_EQ(vsize(4), project.modelUUIDs().size());
+    ASSERT_EQ(project.findModel(kModel1UUID), project.findMotion(kMotion1UUID)->parentModelRef());
+}
+
 TEST(ProjectTest, Save)
 {
     Delegate delegate;
@@ -457,6 +498,110 @@ TEST(ProjectTest, Save)
     TestMorphMotion(motion3);
 }
 
+static void CompareMotionKeyframes(const IMotion *expected, const IMotion *actual)
+{
+    const int nBoneKeyframes = expected->countKeyframes(IKeyframe::kBoneKeyframe);
+    ASSERT_EQ(nBoneKeyframes, actual->countKeyframes(IKeyframe::kBoneKeyframe));
+    for (int i = 0; i < nBoneKeyframes; i++) {
+        const IBoneKeyframe *keyframe = expected->findBoneKeyframeRefAt(i);
+        const IBoneKeyframe *keyframe2 = actual->findBoneKeyframeRef(keyframe->timeIndex(), keyframe->name(), keyframe->layerIndex());
+        ASSERT_TRUE(keyframe2);
+        ASSERT_TRUE(CompareVector(keyframe->localTranslation(), keyframe2->localTranslation()));
+        ASSERT_TRUE(CompareVector(keyframe->localOrientation(), keyframe2->localOrientation()));
+    }
+    const int nMorphKeyframes = expected->countKeyframes(IKeyframe::kMorphKeyframe);
+    ASSERT_EQ(nMorphKeyframes, actual->countKeyframes(IKeyframe::kMorphKeyframe));
+    for (int i = 0; i < nMorphKeyframes; i++) {
+        const IMorphKeyframe *keyframe = expected->findMorphKeyframeRefAt(i);
+        const IMorphKeyframe *keyframe2 = actual->findMorphKeyframeRef(keyframe->timeIndex(), keyframe->name(), keyframe->layerIndex());
+        ASSERT_TRUE(keyframe2);
+        ASSERT_FLOAT_EQ(keyframe->weight(), keyframe2->weight());
+    }
+}
+
+TEST(ProjectTest, SaveAndLoadBinary)
+{
+    Delegate delegate;
+    Encoding encoding(0);
+    Factory factory(&encoding);
+    XMLProject project(&delegate, &factory, true);
+    ASSERT_TRUE(project.load("../../docs/project.xml"));
+    /* names longer than 15 bytes can't be stored in VMD without truncation */
+    const String longBoneName("ThisIsAVeryLongBoneName"), longMorphName("ThisIsAVeryLongMorphName");
+    IMotion *sourceMotion = project.findMotion(kMotion1UUID);
+    std::unique_ptr<IBoneKeyframe> boneKeyframe(factory.createBoneKeyframe(sourceMotion));
+    boneKeyframe->setDefaultInterpolationParameter();
+    boneKeyframe->setTimeIndex(3);
+    boneKeyframe->setName(&longBoneName);
+    boneKeyframe->setLocalTranslation(Vector3(4, 5, 6));
+    boneKeyframe->setLocalOrientation(Quaternion(0, 0, 0, 1));
+    sourceMotion->addKeyframe(boneKeyframe.release());
+    std::unique_ptr<IMorphKeyframe> morphKeyframe(factory.createMorphKeyframe(sourceMotion));
+    morphKeyframe->setTimeIndex(3);
+    morphKeyframe->setName(&longMorphName);
+    morphKeyframe->setWeight(0.5);
+    sourceMotion->addKeyframe(morphKeyframe.release());
+    sourceMotion->update(IKeyframe::kBoneKeyframe);
+    sourceMotion->update(IKeyframe::kMorphKeyframe);
+    QTemporaryFile file;
+    file.open();
+    file.setAutoRemove(true);
+    project.setDirty(true);
+    ASSERT_TRUE(project.save(file.fileName().toUtf8(), XMLProject::kBinaryFormat));
+    ASSERT_FALSE(project.isDirty());
+    const QByteArray &bytes = file.readAll();
+    ASSERT_TRUE(XMLProject::isBinaryFormat(reinterpret_cast<const uint8 *>(bytes.constData()), bytes.size()));
+    XMLProject project2(&delegate, &factory, true);
+    ASSERT_TRUE(project2.load(reinterpret_cast<const uint8 *>(bytes.constData()), bytes.size()));
+    QString s;
+    s.sprintf("%.1f", XMLProject::formatVersion());
+    ASSERT_STREQ(qPrintable(s), project2.version().c_str());
+    ASSERT_EQ(vsize(4), project2.modelUUIDs().size());
+    ASSERT_EQ(vsize(3), project2.motionUUIDs().size());
+    TestGlobalSettings(project2);
+    TestLocalSettings(project2);
+    IMotion *motion = project2.findMotion(kMotion1UUID);
+    /* stored as MVD to keep the long names */
+    ASSERT_EQ(IMotion::kMVDFormat, motion->type());
+    ASSERT_EQ(project2.findModel(kModel1UUID), motion->parentModelRef());
+    CompareMotionKeyframes(sourceMotion, motion);
+    ASSERT_TRUE(motion->findBoneKeyframeRef(3, &longBoneName, 0));
+    ASSERT_TRUE(motion->findMorphKeyframeRef(3, &longMorphName, 0));
+    IMotion *motion2 = project2.findMotion(kMotion2UUID);
+    ASSERT_EQ(IMotion::kMVDFormat, motion2->type());
+    ASSERT_EQ(project2.findModel(kModel2UUID), motion2->parentModelRef());
+    CompareMotionKeyframes(project.findMotion(kMotion2UUID), motion2);
+    IMotion *motion3 = project2.findMotion(kMotion3UUID);
+    ASSERT_EQ(IMotion::kVMDFormat, motion3->type());
+    ASSERT_EQ(project2.findModel(kAsset2UUID), motion3->parentModelRef());
+    CompareMotionKeyframes(project.findMotion(kMotion3UUID), motion3);
+    /* converting back to XML keeps the project loadable */
+    QTemporaryFile file2;
+    file2.open();
+    file2.setAutoRemove(true);
+    ASSERT_TRUE(project2.save(file2.fileName().toUtf8(), XMLProject::kXMLFormat));
+    XMLProject project3(&delegate, &factory, true);
+    ASSERT_TRUE(project3.load(file2.fileName().toUtf8()));
+    ASSERT_EQ(vsize(4), project3.modelUUIDs().size());
+    ASSERT_EQ(vsize(3), project3.motionUUIDs().size());
+    TestGlobalSettings(project3);
+    TestLocalSettings(project3);
+    CompareMotionKeyframes(sourceMotion, project3.findMotion(kMotion1UUID));
+    CompareMotionKeyframes(project.findMotion(kMotion2UUID), project3.findMotion(kMotion2UUID));
+    CompareMotionKeyframes(project.findMotion(kMotion3UUID), project3.findMotion(kMotion3UUID));
+}
+
+TEST(ProjectTest, LoadMalformedBinary)
+{
+    Delegate delegate;
+    Encoding encoding(0);
+    Factory factory(&encoding);
+    XMLProject project(&delegate, &factory, true);
+    const uint8 truncated[] = { 'V', 'P', 'V', 'L', '2', 'P', 'R', 'J', 0, 0 };
+    ASSERT_FALSE(XMLProject::isBinaryFormat(truncated, sizeof(truncated)));
+    ASSERT_FALSE(project.load(truncated, sizeof(truncated)));
+}
+
 TEST(ProjectTest, HandleAssets)
 {
     const QString &uuid = QUuid::createUuid().toString();
@@ -1,5 +1,7 @@
 #include "Common.h"
 
+#include <btBulletDynamicsCommon.h>
+
 #include "vpvl2/vpvl2.h"
 #include "vpvl2/IApplicationContext.h"
 #include "vpvl2/extensions/icu4c/Encoding.h"
@@ -105,6 +107,31 @@ TEST(SceneTest, FindModel)
     ASSERT_EQ(model.release(), scene.findModel(&s2));
 }
 
+TEST(SceneTest, FindRenamedModel)
+{
+    Encoding encoding(0);
+    pmx::Model model(&encoding);
+    MockIRenderEngine engine;
+    String name(UnicodeString::fromUTF8("foo")), newName(UnicodeString::fromUTF8("bar"));
+    model.setName(&name, IEncoding::kDefaultLanguage);
+    Scene scene(false);
+    scene.addModel(&model, &engine, 0);
+    const int revision = scene.modelRevision();
+    /* renaming is applied at update and changes the model revision */
+    model.setName(&newName, IEncoding::kDefaultLanguage);
+    scene.update(0);
+    ASSERT_EQ(&model, scene.findModel(&newName));
+    ASSERT_EQ(0, scene.findModel(&name));
+    const int renamedRevision = scene.modelRevision();
+    ASSERT_NE(revision, renamedRevision);
+    scene.update(0);
+    ASSERT_EQ(renamedRevision, scene.modelRevision());
+    /* the application context tells the scene that a model is found by another name */
+    scene.invalidateModelRevision();
+    ASSERT_NE(renamedRevision, scene.modelRevision());
+    scene.removeModel(&model);
+}
+
 TEST(SceneTest, FindRenderEngine)
 {
     Scene scene(true);
@@ -135,13 +162,17 @@ TEST(SceneTest, RemoveModel)
     std::unique_ptr<MockIRenderEngine> engine(new MockIRenderEngine());
     /* removing an null model should do nothing */
     scene.removeModel(0);
+    const int revision = scene.modelRevision();
     scene.addModel(model.get(), engine.get(), 0);
+    const int addedRevision = scene.modelRevision();
+    ASSERT_NE(revision, addedRevision);
     /* model should be deleted and set it null */
     scene.removeModel(model.get());
     scene.getModelRefs(models);
     scene.getRenderEngineRefs(engines);
     ASSERT_EQ(0, models.count());
     ASSERT_EQ(0, engines.count());
+    ASSERT_NE(addedRevision, scene.modelRevision());
 }
 
 TEST(SceneTest, DeleteModel)
@@ -261,6 +292,190 @@ TEST(SceneTest, Update)
     }
 }
 
+TEST(SceneTest, UpdateModelsByParentDependency)
+{
+    std::unique_ptr<MockIModel> childModel(new MockIModel()), parentModel(new MockIModel()), otherModel(new MockIModel());
+    std::unique_ptr<MockIRenderEngine> childEngine(new MockIRenderEngine()),
+            parentEngine(new MockIRenderEngine()), otherEngine(new MockIRenderEngine());
+    String s1(UnicodeString::fromUTF8("child")), s2(UnicodeString::fromUTF8("parent")), s3(UnicodeString::fromUTF8("other"));
+    MockIModel *models[] = { childModel.get(), parentModel.get(), otherModel.get() };
+    MockIRenderEngine *engines[] = { childEngine.get(), parentEngine.get(), otherEngine.get() };
+    const String *names[] = { &s1, &s2, &s3 };
+    for (int i = 0; i < 3; i++) {
+        MockIModel *model = models[i];
+        EXPECT_CALL(*engines[i], release()).WillOnce(Return());
+        EXPECT_CALL(*model, type()).WillRepeatedly(Return(IModel::kMaxModelType));
+        EXPECT_CALL(*model, joinWorld(0)).Times(1);
+        EXPECT_CALL(*model, name(IEncoding::kDefaultLanguage)).WillRepeatedly(Return(names[i]));
+        EXPECT_CALL(*model, parentBoneRef()).WillRepeatedly(Return(static_cast<IBone *>(0)));
+    }
+    EXPECT_CALL(*childModel, parentModelRef()).WillRepeatedly(Return(parentModel.get()));
+    EXPECT_CALL(*parentModel, parentModelRef()).WillRepeatedly(Return(static_cast<IModel *>(0)));
+    EXPECT_CALL(*otherModel, parentModelRef()).WillRepeatedly(Return(static_cast<IModel *>(0)));
+    Sequence sequence;
+    EXPECT_CALL(*parentModel, performUpdate()).Times(1).InSequence(sequence);
+    EXPECT_CALL(*childModel, performUpdate()).Times(1).InSequence(sequence);
+    EXPECT_CALL(*otherModel, performUpdate()).Times(1);
+    Scene scene(true);
+    ASSERT_FALSE(scene.isParallelUpdateEnabled());
+    scene.setParallelUpdateEnable(true);
+    /* child model is added before parent model but updated after parent model */
+    scene.addModel(childModel.release(), childEngine.release(), 0);
+    scene.addModel(otherModel.release(), otherEngine.release(), 0);
+    scene.addModel(parentModel.release(), parentEngine.release(), 0);
+    scene.update(Scene::kUpdateModels);
+}
+
+TEST(SceneTest, SplitRenderEngineUpdates)
+{
+    std::unique_ptr<MockIModel> models[3];
+    std::unique_ptr<MockIRenderEngine> engines[3];
+    String s(UnicodeString::fromUTF8("This is a test model."));
+    for (int i = 0; i < 3; i++) {
+        models[i].reset(new MockIModel());
+        engines[i].reset(new MockIRenderEngine());
+        EXPECT_CALL(*engines[i], release()).WillOnce(Return());
+        EXPECT_CALL(*models[i], type()).WillRepeatedly(Return(IModel::kMaxModelType));
+        EXPECT_CALL(*models[i], joinWorld(0)).Times(1);
+        EXPECT_CALL(*models[i], name(IEncoding::kDefaultLanguage)).WillRepeatedly(Return(&s));
+    }
+    /* CPU skinning of the first two engines is run between beginUpdate and endUpdate */
+    for (int i = 0; i < 2; i++) {
+        Sequence sequence;
+        EXPECT_CALL(*engines[i], beginUpdate()).InSequence(sequence).WillOnce(Return(true));
+        EXPECT_CALL(*engines[i], performUpdate()).Times(1).InSequence(sequence);
+        EXPECT_CALL(*engines[i], endUpdate()).Times(1).InSequence(sequence);
+        EXPECT_CALL(*engines[i], update()).Times(0);
+    }
+    /* the engine can't split the update */
+    EXPECT_CALL(*engines[2], beginUpdate()).WillOnce(Return(false));
+    EXPECT_CALL(*engines[2], performUpdate()).Times(0);
+    EXPECT_CALL(*engines[2], endUpdate()).Times(0);
+    EXPECT_CALL(*engines[2], update()).Times(1);
+    Scene scene(true);
+    ASSERT_FALSE(scene.isParallelUpdateEnabled());
+    scene.setParallelUpdateEnable(true);
+    for (int i = 0; i < 3; i++) {
+        scene.addModel(models[i].release(), engines[i].release(), 0);
+    }
+    scene.update(Scene::kUpdateRenderEngines);
+}
+
+TEST(SceneTest, UpdateRenderEnginesSerially)
+{
+    std::unique_ptr<MockIModel> model(new MockIModel());
+    std::unique_ptr<MockIRenderEngine> engine(new MockIRenderEngine());
+    String s(UnicodeString::fromUTF8("This is a test model."));
+    EXPECT_CALL(*engine, release()).WillOnce(Return());
+    EXPECT_CALL(*model, type()).WillRepeatedly(Return(IModel::kMaxModelType));
+    EXPECT_CALL(*model, joinWorld(0)).Times(1);
+    EXPECT_CALL(*model, name(IEncoding::kDefaultLanguage)).WillRepeatedly(Return(&s));
+    EXPECT_CALL(*engine, beginUpdate()).Times(0);
+    EXPECT_CALL(*engine, update()).Times(1);
+    /* the parallel update is disabled by default */
+    Scene scene(true);
+    scene.addModel(model.release(), engine.release(), 0);
+    scene.update(Scene::kUpdateRenderEngines);
+}
+
+TEST(SceneTest, SkipUnchangedModels)
+{
+    std::unique_ptr<MockIModel> model(new MockIModel());
+    std::unique_ptr<MockIRenderEngine> engine(new MockIRenderEngine());
+    String s(UnicodeString::fromUTF8("This is a test model."));
+    Vector3 translation(kZeroV3);
+    MockIModel *modelRef = model.get();
+    EXPECT_CALL(*engine, release()).WillOnce(Return());
+    EXPECT_CALL(*engine, parentModelRef()).WillRepeatedly(Return(modelRef));
+    EXPECT_CALL(*model, type()).WillRepeatedly(Return(IModel::kMaxModelType));
+    EXPECT_CALL(*model, joinWorld(0)).Times(1);
+    EXPECT_CALL(*model, name(IEncoding::kDefaultLanguage)).WillRepeatedly(Return(&s));
+    EXPECT_CALL(*model, parentModelRef()).WillRepeatedly(Return(static_cast<IModel *>(0)));
+    EXPECT_CALL(*model, parentBoneRef()).WillRepeatedly(Return(static_cast<IBone *>(0)));
+    EXPECT_CALL(*model, worldTranslation()).WillRepeatedly(ReturnPointee(&translation));
+    EXPECT_CALL(*model, worldOrientation()).WillRepeatedly(Return(Quaternion::getIdentity()));
+    EXPECT_CALL(*model, edgeColor()).WillRepeatedly(Return(kZeroC));
+    EXPECT_CALL(*model, opacity()).WillRepeatedly(Return(1));
+    EXPECT_CALL(*model, scaleFactor()).WillRepeatedly(Return(1));
+    EXPECT_CALL(*model, edgeWidth()).WillRepeatedly(Return(1));
+    EXPECT_CALL(*model, isVisible()).WillRepeatedly(Return(true));
+    EXPECT_CALL(*model, isPhysicsEnabled()).WillRepeatedly(Return(false));
+    /* first, after moving the model and by kResetMotionState */
+    EXPECT_CALL(*model, performUpdate()).Times(3);
+    EXPECT_CALL(*engine, update()).Times(3);
+    EXPECT_CALL(*engine, updateSceneParameters()).Times(2);
+    Scene scene(true);
+    Scene::UpdateStatistics statistics;
+    ASSERT_FALSE(scene.isSkipUnchangedModelsEnabled());
+    scene.setSkipUnchangedModelsEnable(true);
+    scene.addModel(model.release(), engine.release(), 0);
+    scene.update(Scene::kUpdateAll);
+    scene.update(Scene::kUpdateAll);
+    scene.getUpdateStatistics(statistics);
+    ASSERT_EQ(0, statistics.numUpdatedModels);
+    ASSERT_EQ(1, statistics.numSkippedModels);
+    translation.setValue(1, 2, 3);
+    scene.update(Scene::kUpdateAll);
+    scene.update(Scene::kUpdateAll);
+    scene.update(Scene::kUpdateAll | Scene::kResetMotionState);
+    scene.getUpdateStatistics(statistics);
+    ASSERT_EQ(1, statistics.numUpdatedModels);
+    ASSERT_EQ(0, statistics.numSkippedModels);
+    ASSERT_EQ(uint64(3), statistics.totalUpdatedModels);
+    ASSERT_EQ(uint64(2), statistics.totalSkippedModels);
+}
+
+TEST(SceneTest, SkipUnchangedModelsWithEffect)
+{
+    {
+        /* skipped engines are still notified so that effects keep advancing TIME and ELAPSEDTIME */
+        std::unique_ptr<MockIModel> model(new MockIModel());
+        std::unique_ptr<MockIRenderEngine> engine(new MockIRenderEngine());
+        String s(UnicodeString::fromUTF8("This is a test model."));
+        MockIModel *modelRef = model.get();
+        EXPECT_CALL(*engine, release()).WillOnce(Return());
+        EXPECT_CALL(*engine, parentModelRef()).WillRepeatedly(Return(modelRef));
+        EXPECT_CALL(*model, type()).WillRepeatedly(Return(IModel::kMaxModelType));
+        EXPECT_CALL(*model, joinWorld(0)).Times(1);
+        EXPECT_CALL(*model, name(IEncoding::kDefaultLanguage)).WillRepeatedly(Return(&s));
+        EXPECT_CALL(*model, parentModelRef()).WillRepeatedly(Return(static_cast<IModel *>(0)));
+        EXPECT_CALL(*model, parentBoneRef()).WillRepeatedly(Return(static_cast<IBone *>(0)));
+        EXPECT_CALL(*model, worldTranslation()).WillRepeatedly(Return(kZeroV3));
+        EXPECT_CALL(*model, worldOrientation()).WillRepeatedly(Return(Quaternion::getIdentity()));
+        EXPECT_CALL(*model, edgeColor()).WillRepeatedly(Return(kZeroC));
+        EXPECT_CALL(*model, opacity()).WillRepeatedly(Return(1));
+        EXPECT_CALL(*model, scaleFactor()).WillRepeatedly(Return(1));
+        EXPECT_CALL(*model, edgeWidth()).WillRepeatedly(Return(1));
+        EXPECT_CALL(*model, isVisible()).WillRepeatedly(Return(true));
+        EXPECT_CALL(*model, isPhysicsEnabled()).WillRepeatedly(Return(false));
+        EXPECT_CALL(*model, performUpdate()).Times(1);
+        EXPECT_CALL(*engine, update()).Times(1);
+        EXPECT_CALL(*engine, updateSceneParameters()).Times(3);
+        Scene scene(true);
+        scene.setSkipUnchangedModelsEnable(true);
+        scene.addModel(model.release(), engine.release(), 0);
+        for (int i = 0; i < 4; i++) {
+            scene.update(Scene::kUpdateAll);
+        }
+        Scene::UpdateStatistics statistics;
+        scene.getUpdateStatistics(statistics);
+        ASSERT_EQ(uint64(1), statistics.totalUpdatedModels);
+        ASSERT_EQ(uint64(3), statistics.totalSkippedModels);
+    }
+    {
+        /* the fx engine without loaded effect should not be crashed */
+        Scene scene(true);
+        Encoding encoding(0);
+        MockIApplicationContext applicationContext;
+        EXPECT_CALL(applicationContext, sharedFunctionResolverInstance()).Times(AnyNumber()).WillRepeatedly(Return(&g_resolver));
+        pmx::Model model(&encoding);
+        std::unique_ptr<IRenderEngine> engine(scene.createRenderEngine(&applicationContext, &model, Scene::kEffectCapable));
+        ASSERT_TRUE(dynamic_cast<fx::PMXRenderEngine *>(engine.get()));
+        engine->updateSceneParameters();
+        engine->release();
+    }
+}
+
 TEST(SceneTest, SeekMotions)
 {
     Scene scene(true);
@@ -718,6 +933,77 @@ TEST_P(SceneModelMotionTest, CreateWithoutOwnMemory)
     ASSERT_EQ(motionType, motion->type());
 }
 
+TEST(SceneTest, WorldSteppingPolicy)
+{
+    extensions::World world;
+    extensions::World::StepStatistics statistics;
+    ASSERT_EQ(extensions::World::kExactStepping, world.steppingPolicy());
+    ASSERT_EQ(extensions::World::kDefaultMaxSubSteps, world.maxSubSteps());
+    /* 30 frames at 30fps with 60fps base should be 120 substeps on exact stepping */
+    world.stepSimulation(30, 30);
+    world.getStepStatistics(statistics);
+    ASSERT_GE(statistics.numSubSteps, 119);
+    ASSERT_EQ(0, statistics.numDroppedSubSteps);
+    /* bounded stepping should stop at max substeps */
+    world.setSteppingPolicy(extensions::World::kDropStepping);
+    world.setMaxSubSteps(4);
+    world.stepSimulation(30, 30);
+    world.getStepStatistics(statistics);
+    ASSERT_EQ(4, statistics.numSubSteps);
+    ASSERT_GE(statistics.numDroppedSubSteps, 115);
+    world.setSteppingPolicy(extensions::World::kInterpolateStepping);
+    world.stepSimulation(1, 30);
+    world.getStepStatistics(statistics);
+    ASSERT_GE(statistics.numSubSteps, 3);
+    ASSERT_LE(statistics.numSubSteps, 4);
+    /* invalid value should be clamped */
+    world.setMaxSubSteps(0);
+    ASSERT_EQ(1, world.maxSubSteps());
+    world.setStepTimeBudget(-1);
+    ASSERT_EQ(0, world.stepTimeBudget());
+}
+
+TEST(SceneTest, WorldSnapshot)
+{
+    extensions::World world;
+    btSphereShape *shape = new btSphereShape(1);
+    btRigidBody::btRigidBodyConstructionInfo info(1, new btDefaultMotionState(Transform(Matrix3x3::getIdentity(), Vector3(0, 50, 0))), shape);
+    btRigidBody *body = new btRigidBody(info);
+    world.addRigidBody(body);
+    world.setSnapshotInterval(10);
+    world.captureSnapshot(0);
+    world.stepSimulation(20, 30);
+    world.captureSnapshot(20);
+    const Transform expected = body->getCenterOfMassTransform();
+    const Vector3 expectedVelocity = body->getLinearVelocity();
+    /* too close to the previous snapshot */
+    world.captureSnapshot(25);
+    ASSERT_EQ(2, world.countSnapshots());
+    world.stepSimulation(40, 30);
+    ASSERT_NE(expected.getOrigin().y(), body->getCenterOfMassTransform().getOrigin().y());
+    Scalar restoredTimeIndex = 0;
+    ASSERT_TRUE(world.restoreSnapshot(30, restoredTimeIndex));
+    ASSERT_FLOAT_EQ(20, restoredTimeIndex);
+    ASSERT_FLOAT_EQ(expected.getOrigin().y(), body->getCenterOfMassTransform().getOrigin().y());
+    ASSERT_FLOAT_EQ(expectedVelocity.y(), body->getLinearVelocity().y());
+    /* the budget should keep the first snapshot */
+    world.setSnapshotMemoryBudget(world.snapshotMemoryUsage() / 2 + 1);
+    ASSERT_EQ(1, world.countSnapshots());
+    ASSERT_TRUE(world.restoreSnapshot(30, restoredTimeIndex));
+    ASSERT_FLOAT_EQ(0, restoredTimeIndex);
+    /* the first snapshot is kept even if it exceeds the budget */
+    world.setSnapshotMemoryBudget(0);
+    ASSERT_EQ(1, world.countSnapshots());
+    Scalar foundTimeIndex = -1;
+    ASSERT_TRUE(world.findSnapshot(30, foundTimeIndex));
+    ASSERT_FLOAT_EQ(0, foundTimeIndex);
+    /* removing a body should invalidate all snapshots */
+    world.deleteAll();
+    ASSERT_EQ(0, world.countSnapshots());
+    ASSERT_EQ(0, world.snapshotMemoryUsage());
+    ASSERT_FALSE(world.restoreSnapshot(30, restoredTimeIndex));
+}
+
 INSTANTIATE_TEST_CASE_P(SceneInstance, SceneModelTest, Values(IModel::kAssetModel, IModel::kPMDModel, IModel::kPMXModel));
 INSTANTIATE_TEST_CASE_P(SceneInstance, SceneRenderEngineTest, Combine(Values(IModel::kAssetModel, IModel::kPMDModel, IModel::kPMXModel),
                                                                       Values(0, Scene::kEffectCapable)));
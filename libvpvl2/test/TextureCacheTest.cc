@@ -0,0 +1,116 @@
+#include "Common.h"
+
+#include "vpvl2/vpvl2.h"
+#include "vpvl2/IApplicationContext.h"
+#include "vpvl2/ITexture.h"
+#include "vpvl2/extensions/TextureCache.h"
+#include "mock/Texture.h"
+
+using namespace ::testing;
+using namespace vpvl2;
+using namespace vpvl2::extensions;
+
+namespace {
+
+MockITexture *CreateTexture(intptr_t name)
+{
+    MockITexture *texture = new MockITexture();
+    EXPECT_CALL(*texture, size()).WillRepeatedly(Return(Vector3(16, 16, 1)));
+    EXPECT_CALL(*texture, data()).WillRepeatedly(Return(name));
+    return texture;
+}
+
+class TextureCacheTest : public Test {
+protected:
+    void SetUp() {
+        TextureCache::purge();
+        TextureCache::resetStatistics();
+        m_budget = TextureCache::memoryBudget();
+    }
+    void TearDown() {
+        TextureCache::setMemoryBudget(m_budget);
+        TextureCache::purge();
+    }
+    vsize m_budget;
+};
+
+}
+
+TEST_F(TextureCacheTest, MakeKey)
+{
+    const uint8 data1[] = "texture1", data2[] = "texture2";
+    ASSERT_EQ(TextureCache::makeKey(data1, sizeof(data1), 0, false), TextureCache::makeKey(data1, sizeof(data1), 0, false));
+    ASSERT_NE(TextureCache::makeKey(data1, sizeof(data1), 0, false), TextureCache::makeKey(data2, sizeof(data2), 0, false));
+    /* the same content uploaded differently must not be shared */
+    ASSERT_NE(TextureCache::makeKey(data1, sizeof(data1), 0, false), TextureCache::makeKey(data1, sizeof(data1), 0, true));
+    ASSERT_NE(TextureCache::makeKey(data1, sizeof(data1), 0, false),
+              TextureCache::makeKey(data1, sizeof(data1), IApplicationContext::kToonTexture, false));
+    ASSERT_NE(TextureCache::makeKey(data1, sizeof(data1), IApplicationContext::kTexture2D, false),
+              TextureCache::makeKey(data1, sizeof(data1), IApplicationContext::kTexture2D | IApplicationContext::kGenerateTextureMipmap, false));
+    /* loading asynchronously uploads the same texture */
+    ASSERT_EQ(TextureCache::makeKey(data1, sizeof(data1), IApplicationContext::kTexture2D, false),
+              TextureCache::makeKey(data1, sizeof(data1), IApplicationContext::kTexture2D | IApplicationContext::kAsyncLoadingTexture, false));
+}
+
+TEST_F(TextureCacheTest, ShareTexture)
+{
+    ASSERT_EQ(static_cast<ITexture *>(0), TextureCache::acquire("key"));
+    std::unique_ptr<ITexture> reference1(TextureCache::store("key", CreateTexture(42)));
+    std::unique_ptr<ITexture> reference2(TextureCache::acquire("key"));
+    ASSERT_TRUE(reference1.get());
+    ASSERT_TRUE(reference2.get());
+    ASSERT_NE(reference1.get(), reference2.get());
+    ASSERT_EQ(42, reference2->data());
+    TextureCache::Statistics statistics;
+    TextureCache::getStatistics(statistics);
+    ASSERT_EQ(1, statistics.numEntries);
+    ASSERT_EQ(2, statistics.numReferences);
+    ASSERT_EQ(1, statistics.numHits);
+    ASSERT_EQ(1, statistics.numMisses);
+    ASSERT_EQ(vsize(0), statistics.unreferencedBytes);
+    /* deleting references keeps the texture until purged */
+    reference1.reset();
+    reference2.reset();
+    TextureCache::getStatistics(statistics);
+    ASSERT_EQ(1, statistics.numEntries);
+    ASSERT_EQ(0, statistics.numReferences);
+    ASSERT_EQ(statistics.usedBytes, statistics.unreferencedBytes);
+    TextureCache::purge();
+    TextureCache::getStatistics(statistics);
+    ASSERT_EQ(0, statistics.numEntries);
+    ASSERT_EQ(vsize(0), statistics.usedBytes);
+}
+
+TEST_F(TextureCacheTest, RejectParameterOfSharedTexture)
+{
+    MockITexture *texture = CreateTexture(42);
+    EXPECT_CALL(*texture, setParameter(_, An<int>())).Times(0);
+    EXPECT_CALL(*texture, setParameter(_, An<float>())).Times(0);
+    std::unique_ptr<ITexture> reference(TextureCache::store("key", texture));
+    /* GL_TEXTURE_MIN_FILTER to GL_NEAREST and GL_TEXTURE_MAX_ANISOTROPY_EXT */
+    reference->setParameter(0x2801, 0x2600);
+    reference->setParameter(0x84FE, 16.0f);
+}
+
+TEST_F(TextureCacheTest, EvictLeastRecentlyUsedTexture)
+{
+    std::unique_ptr<ITexture> reference(TextureCache::store("key1", CreateTexture(1)));
+    TextureCache::Statistics statistics;
+    TextureCache::getStatistics(statistics);
+    /* allows two textures to be cached */
+    TextureCache::setMemoryBudget(statistics.usedBytes * 2);
+    reference.reset(TextureCache::store("key2", CreateTexture(2)));
+    reference.reset(TextureCache::store("key3", CreateTexture(3)));
+    reference.reset();
+    TextureCache::getStatistics(statistics);
+    ASSERT_EQ(2, statistics.numEntries);
+    ASSERT_EQ(1, statistics.numEvictions);
+    ASSERT_EQ(static_cast<ITexture *>(0), TextureCache::acquire("key1"));
+    reference.reset(TextureCache::acquire("key2"));
+    ASSERT_EQ(2, reference->data());
+    /* referenced textures are never evicted */
+    TextureCache::setMemoryBudget(0);
+    TextureCache::getStatistics(statistics);
+    ASSERT_EQ(1, statistics.numEntries);
+    ASSERT_EQ(2, statistics.numEvictions);
+}
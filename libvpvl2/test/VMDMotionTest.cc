@@ -2,6 +2,8 @@
 
 #include "vpvl2/vpvl2.h"
 #include "vpvl2/extensions/icu4c/Encoding.h"
+#include "vpvl2/internal/InterpolationTableCache.h"
+#include "vpvl2/internal/MotionHelper.h"
 #include "vpvl2/pmx/Model.h"
 #include "vpvl2/vmd/BoneAnimation.h"
 #include "vpvl2/vmd/BoneKeyframe.h"
@@ -540,6 +542,99 @@ TEST(VMDMotionTest, CameraInterpolation)
     CompareCameraInterpolationMatrix(p, frame);
 }
 
+TEST(VMDMotionTest, ShareInterpolationTables)
+{
+    typedef internal::InterpolationTableCache Cache;
+    Encoding encoding(0);
+    Cache::Statistics before, after;
+    Cache::getStatistics(before);
+    {
+        vmd::BoneKeyframe frame1(&encoding), frame2(&encoding);
+        const QuadWord p(8, 9, 10, 11), q(12, 13, 14, 15);
+        frame1.setInterpolationParameter(vmd::BoneKeyframe::kBonePositionX, p);
+        frame2.setInterpolationParameter(vmd::BoneKeyframe::kBonePositionX, p);
+        frame2.setInterpolationParameter(vmd::BoneKeyframe::kBonePositionY, q);
+        // same curve and size share one table
+        ASSERT_TRUE(frame1.interpolationTable()[vmd::BoneKeyframe::kBonePositionX]);
+        ASSERT_EQ(frame1.interpolationTable()[vmd::BoneKeyframe::kBonePositionX],
+                  frame2.interpolationTable()[vmd::BoneKeyframe::kBonePositionX]);
+        ASSERT_NE(frame2.interpolationTable()[vmd::BoneKeyframe::kBonePositionX],
+                  frame2.interpolationTable()[vmd::BoneKeyframe::kBonePositionY]);
+        // linear curve has no table
+        ASSERT_FALSE(frame1.interpolationTable()[vmd::BoneKeyframe::kBoneRotation]);
+        Cache::getStatistics(after);
+        ASSERT_EQ(before.numTables + 2, after.numTables);
+        ASSERT_EQ(before.numReferences + 3, after.numReferences);
+        ASSERT_LT(after.sharedBytes, after.unsharedBytes);
+        // different table size is not shared
+        vmd::CameraKeyframe frame3;
+        frame3.setInterpolationParameter(vmd::CameraKeyframe::kCameraLookAtX, p);
+        ASSERT_TRUE(frame3.interpolationTable()[vmd::CameraKeyframe::kCameraLookAtX]);
+        ASSERT_NE(frame1.interpolationTable()[vmd::BoneKeyframe::kBonePositionX],
+                  frame3.interpolationTable()[vmd::CameraKeyframe::kCameraLookAtX]);
+    }
+    Cache::getStatistics(after);
+    ASSERT_EQ(before.numTables, after.numTables);
+    ASSERT_EQ(before.numReferences, after.numReferences);
+    ASSERT_EQ(before.sharedBytes, after.sharedBytes);
+}
+
+TEST(VMDMotionTest, AnalyticInterpolationSameAsTable)
+{
+    typedef internal::InterpolationTableCache Cache;
+    Encoding encoding(0);
+    const QuadWord p(20, 0, 107, 127);
+    vmd::BoneKeyframe tableFrame(&encoding), analyticFrame(&encoding);
+    tableFrame.setInterpolationParameter(vmd::BoneKeyframe::kBoneRotation, p);
+    Cache::setEvaluationMode(Cache::kAnalyticEvaluation);
+    analyticFrame.setInterpolationParameter(vmd::BoneKeyframe::kBoneRotation, p);
+    Cache::setEvaluationMode(Cache::kTableEvaluation);
+    const IKeyframe::SmoothPrecision *table = tableFrame.interpolationTable()[vmd::BoneKeyframe::kBoneRotation];
+    ASSERT_TRUE(table);
+    ASSERT_FALSE(analyticFrame.interpolationTable()[vmd::BoneKeyframe::kBoneRotation]);
+    for (int i = 0; i < 100; i++) {
+        const IKeyframe::SmoothPrecision &w = i / IKeyframe::SmoothPrecision(100);
+        const IKeyframe::SmoothPrecision &expected = Cache::lookup(table, p, vmd::BoneKeyframe::kTableSize, w);
+        const IKeyframe::SmoothPrecision &actual = Cache::lookup(0, p, vmd::BoneKeyframe::kTableSize, w);
+        ASSERT_NEAR(expected, actual, 0.01) << "weight=" << w;
+    }
+}
+
+/* prints memory usage of interpolation tables of a real motion in both evaluation modes */
+/* only reports memory usage with motion.vmd, run with --gtest_also_run_disabled_tests */
+TEST(VMDMotionTest, DISABLED_InterpolationTableMemoryReport)
+{
+    typedef internal::InterpolationTableCache Cache;
+    QFile file("motion.vmd");
+    if (file.open(QFile::ReadOnly)) {
+        QByteArray bytes = file.readAll();
+        const uint8 *data = reinterpret_cast<const uint8 *>(bytes.constData());
+        vsize size = bytes.size();
+        Encoding encoding(0);
+        Model model(&encoding);
+        const Cache::EvaluationMode modes[] = { Cache::kTableEvaluation, Cache::kAnalyticEvaluation };
+        const char *names[] = { "table", "analytic" };
+        for (int i = 0; i < Cache::kMaxEvaluationMode; i++) {
+            Cache::Statistics before, after;
+            Cache::setEvaluationMode(modes[i]);
+            Cache::getStatistics(before);
+            vmd::Motion motion(&model, &encoding);
+            ASSERT_TRUE(motion.load(data, size));
+            Cache::getStatistics(after);
+            Cache::setEvaluationMode(Cache::kTableEvaluation);
+            const vsize sharedBytes = after.sharedBytes - before.sharedBytes;
+            const vsize unsharedBytes = after.unsharedBytes - before.unsharedBytes;
+            ASSERT_LE(sharedBytes, unsharedBytes);
+            if (modes[i] == Cache::kAnalyticEvaluation) {
+                ASSERT_EQ(vsize(0), unsharedBytes);
+            }
+            qDebug("%s: %d tables for %d curves, %lu bytes shared, %lu bytes if owned by each keyframe",
+                   names[i], after.numTables - before.numTables, after.numReferences - before.numReferences,
+                   static_cast<unsigned long>(sharedBytes), static_cast<unsigned long>(unsharedBytes));
+        }
+    }
+}
+
 TEST(VMDMotionTest, AddAndRemoveBoneKeyframes)
 {
     Encoding encoding(0);
@@ -775,6 +870,314 @@ TEST(VMDMotionTest, AddAndRemoveNullKeyframe)
     motion.deleteKeyframe(nullKeyframe);
 }
 
+TEST(VMDMotionTest, AddBoneKeyframesIncrementally)
+{
+    Encoding encoding(0);
+    String name("bone");
+    MockIModel model;
+    MockIBone bone;
+    EXPECT_CALL(model, findBoneRef(_)).Times(AnyNumber()).WillRepeatedly(Return(&bone));
+    vmd::Motion motion(&model, &encoding);
+    /* keyframes are indexed on add without calling update */
+    static const IKeyframe::TimeIndex kTimeIndices[] = { 30, 10, 20 };
+    IBoneKeyframe *keyframes[3];
+    for (int i = 0; i < 3; i++) {
+        IBoneKeyframe *keyframe = keyframes[i] = new vmd::BoneKeyframe(&encoding);
+        keyframe->setTimeIndex(kTimeIndices[i]);
+        keyframe->setName(&name);
+        motion.addKeyframe(keyframe);
+        ASSERT_EQ(keyframe, motion.findBoneKeyframeRef(kTimeIndices[i], &name, 0));
+    }
+    ASSERT_EQ(3, motion.countKeyframes(IKeyframe::kBoneKeyframe));
+    ASSERT_EQ(keyframes[1], motion.findBoneKeyframeRefAt(0));
+    ASSERT_EQ(keyframes[2], motion.findBoneKeyframeRefAt(1));
+    ASSERT_EQ(keyframes[0], motion.findBoneKeyframeRefAt(2));
+    ASSERT_FLOAT_EQ(30, motion.durationTimeIndex());
+    Array<IKeyframe *> found;
+    motion.getKeyframeRefs(20, 0, IKeyframe::kBoneKeyframe, found);
+    ASSERT_EQ(1, found.count());
+    ASSERT_EQ(keyframes[2], found[0]);
+    /* removing the last keyframe shrinks duration */
+    IKeyframe *keyframeToDelete = keyframes[0];
+    motion.deleteKeyframe(keyframeToDelete);
+    ASSERT_EQ(2, motion.countKeyframes(IKeyframe::kBoneKeyframe));
+    ASSERT_EQ(static_cast<IBoneKeyframe *>(0), motion.findBoneKeyframeRef(30, &name, 0));
+    ASSERT_FLOAT_EQ(20, motion.durationTimeIndex());
+}
+
+TEST(VMDMotionTest, RemoveBoneKeyframesAfterSeeking)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    String name("bone");
+    IBone *bone = model.createBone();
+    bone->setName(&name, IEncoding::kDefaultLanguage);
+    model.addBone(bone);
+    vmd::Motion motion(&model, &encoding);
+    static const IKeyframe::TimeIndex kTimeIndices[] = { 0, 10, 20, 30 };
+    static const float kValues[] = { 0, 10, 100, 30 };
+    IKeyframe *keyframes[4];
+    for (int i = 0; i < 4; i++) {
+        IBoneKeyframe *keyframe = new vmd::BoneKeyframe(&encoding);
+        keyframe->setDefaultInterpolationParameter();
+        keyframe->setTimeIndex(kTimeIndices[i]);
+        keyframe->setLocalTranslation(Vector3(kValues[i], 0, 0));
+        keyframe->setName(&name);
+        motion.addKeyframe(keyframe);
+        keyframes[i] = keyframe;
+    }
+    motion.seek(25);
+    ASSERT_NEAR(65, bone->localTranslation().x(), 0.01);
+    /* the seek hint of the track must follow removed keyframes before it */
+    motion.deleteKeyframe(keyframes[1]);
+    motion.seek(25);
+    ASSERT_NEAR(65, bone->localTranslation().x(), 0.01);
+    motion.deleteKeyframe(keyframes[2]);
+    motion.seek(25);
+    ASSERT_NEAR(25, bone->localTranslation().x(), 0.01);
+    ASSERT_EQ(2, motion.countKeyframes(IKeyframe::kBoneKeyframe));
+    ASSERT_FLOAT_EQ(30, motion.durationTimeIndex());
+}
+
+TEST(VMDMotionTest, BatchEditBoneKeyframes)
+{
+    Encoding encoding(0);
+    String name("bone");
+    MockIModel model;
+    MockIBone bone;
+    EXPECT_CALL(model, findBoneRef(_)).Times(AnyNumber()).WillRepeatedly(Return(&bone));
+    vmd::Motion motion(&model, &encoding);
+    static const int kNumKeyframes = 64;
+    motion.beginBatchEdit();
+    for (int i = kNumKeyframes - 1; i >= 0; i--) {
+        IBoneKeyframe *keyframe = new vmd::BoneKeyframe(&encoding);
+        keyframe->setTimeIndex(i);
+        keyframe->setName(&name);
+        motion.addKeyframe(keyframe);
+    }
+    /* per-bone index is available even while editing in batch */
+    for (int i = 0; i < kNumKeyframes; i++) {
+        IBoneKeyframe *keyframe = motion.findBoneKeyframeRef(i, &name, 0);
+        ASSERT_TRUE(keyframe);
+        ASSERT_FLOAT_EQ(i, keyframe->timeIndex());
+    }
+    IKeyframe *keyframeToDelete = motion.findBoneKeyframeRef(kNumKeyframes / 2, &name, 0);
+    motion.deleteKeyframe(keyframeToDelete);
+    ASSERT_FALSE(motion.findBoneKeyframeRef(kNumKeyframes / 2, &name, 0));
+    motion.endBatchEdit();
+    ASSERT_EQ(kNumKeyframes - 1, motion.countKeyframes(IKeyframe::kBoneKeyframe));
+    for (int i = 0, j = 0; i < kNumKeyframes; i++) {
+        if (i != kNumKeyframes / 2) {
+            ASSERT_FLOAT_EQ(i, motion.findBoneKeyframeRefAt(j++)->timeIndex());
+            ASSERT_FLOAT_EQ(i, motion.findBoneKeyframeRef(i, &name, 0)->timeIndex());
+        }
+    }
+    ASSERT_FLOAT_EQ(kNumKeyframes - 1, motion.durationTimeIndex());
+}
+
+TEST(VMDMotionTest, BatchEditCameraKeyframes)
+{
+    Encoding encoding(0);
+    vmd::Motion motion(0, &encoding);
+    static const int kNumKeyframes = 16;
+    motion.beginBatchEdit();
+    for (int i = kNumKeyframes; i > 0; i--) {
+        ICameraKeyframe *keyframe = new vmd::CameraKeyframe();
+        keyframe->setTimeIndex(i);
+        motion.addKeyframe(keyframe);
+    }
+    /* keyframes are not sorted yet but must be found */
+    for (int i = 1; i <= kNumKeyframes; i++) {
+        ICameraKeyframe *keyframe = motion.findCameraKeyframeRef(i, 0);
+        ASSERT_TRUE(keyframe);
+        ASSERT_FLOAT_EQ(i, keyframe->timeIndex());
+    }
+    motion.endBatchEdit();
+    for (int i = 0; i < kNumKeyframes; i++) {
+        ASSERT_FLOAT_EQ(i + 1, motion.findCameraKeyframeRefAt(i)->timeIndex());
+    }
+    ASSERT_FLOAT_EQ(kNumKeyframes, motion.durationTimeIndex());
+}
+
+TEST(VMDMotionTest, CreateFirstBoneKeyframesInBatch)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    String name0("bone0"), name1("bone1");
+    IBone *bone0 = model.createBone(), *bone1 = model.createBone();
+    bone0->setName(&name0, IEncoding::kDefaultLanguage);
+    model.addBone(bone0);
+    bone1->setName(&name1, IEncoding::kDefaultLanguage);
+    model.addBone(bone1);
+    vmd::Motion motion(&model, &encoding);
+    IBoneKeyframe *keyframe = new vmd::BoneKeyframe(&encoding);
+    keyframe->setTimeIndex(10);
+    keyframe->setName(&name1);
+    motion.addKeyframe(keyframe);
+    motion.createFirstKeyframesUnlessFound();
+    ASSERT_EQ(3, motion.countKeyframes(IKeyframe::kBoneKeyframe));
+    ASSERT_TRUE(motion.findBoneKeyframeRef(0, &name0, 0));
+    ASSERT_TRUE(motion.findBoneKeyframeRef(0, &name1, 0));
+    ASSERT_FLOAT_EQ(0, motion.findBoneKeyframeRefAt(0)->timeIndex());
+    ASSERT_FLOAT_EQ(0, motion.findBoneKeyframeRefAt(1)->timeIndex());
+    ASSERT_EQ(keyframe, motion.findBoneKeyframeRefAt(2));
+    ASSERT_FLOAT_EQ(10, motion.durationTimeIndex());
+    /* should not add keyframes already exist */
+    motion.createFirstKeyframesUnlessFound();
+    ASSERT_EQ(3, motion.countKeyframes(IKeyframe::kBoneKeyframe));
+}
+
+namespace {
+
+/* replays the keyframes MotionProxy#assignModel adds to a motion for bones and morphs without tracks */
+static void AddPoseKeyframes(const IModel &model, IEncoding *encoding, const QSet<const IString *> &trackNames, vmd::Motion &motion)
+{
+    Array<IBone *> bones;
+    model.getBoneRefs(bones);
+    const int nbones = bones.count();
+    for (int i = 0; i < nbones; i++) {
+        const IBone *bone = bones[i];
+        const IString *name = bone->name(IEncoding::kDefaultLanguage);
+        if (!trackNames.contains(name)) {
+            IBoneKeyframe *keyframe = new vmd::BoneKeyframe(encoding);
+            keyframe->setDefaultInterpolationParameter();
+            keyframe->setTimeIndex(0);
+            keyframe->setLocalOrientation(bone->localOrientation());
+            keyframe->setLocalTranslation(bone->localTranslation());
+            keyframe->setName(name);
+            motion.addKeyframe(keyframe);
+        }
+    }
+    Array<IMorph *> morphs;
+    model.getMorphRefs(morphs);
+    const int nmorphs = morphs.count();
+    for (int i = 0; i < nmorphs; i++) {
+        const IMorph *morph = morphs[i];
+        IMorphKeyframe *keyframe = new vmd::MorphKeyframe(encoding);
+        keyframe->setTimeIndex(0);
+        keyframe->setWeight(morph->weight());
+        keyframe->setName(morph->name(IEncoding::kDefaultLanguage));
+        motion.addKeyframe(keyframe);
+    }
+}
+
+/* replays AddPoseKeyframes as createFirstKeyframeUnlessFound did before the batch edit: append and sort all keyframes each time */
+static void AddPoseKeyframesWithFullSort(const IModel &model, IEncoding *encoding, const QSet<const IString *> &trackNames,
+                                         PointerArray<IKeyframe> &boneKeyframes, PointerArray<IKeyframe> &morphKeyframes)
+{
+    const internal::MotionHelper::KeyframeTimeIndexPredication predication;
+    Array<IBone *> bones;
+    model.getBoneRefs(bones);
+    const int nbones = bones.count();
+    for (int i = 0; i < nbones; i++) {
+        const IBone *bone = bones[i];
+        const IString *name = bone->name(IEncoding::kDefaultLanguage);
+        if (!trackNames.contains(name)) {
+            IBoneKeyframe *keyframe = boneKeyframes.append(new vmd::BoneKeyframe(encoding));
+            keyframe->setDefaultInterpolationParameter();
+            keyframe->setTimeIndex(0);
+            keyframe->setLocalOrientation(bone->localOrientation());
+            keyframe->setLocalTranslation(bone->localTranslation());
+            keyframe->setName(name);
+            boneKeyframes.sort(predication);
+        }
+    }
+    Array<IMorph *> morphs;
+    model.getMorphRefs(morphs);
+    const int nmorphs = morphs.count();
+    for (int i = 0; i < nmorphs; i++) {
+        const IMorph *morph = morphs[i];
+        IMorphKeyframe *keyframe = morphKeyframes.append(new vmd::MorphKeyframe(encoding));
+        keyframe->setTimeIndex(0);
+        keyframe->setWeight(morph->weight());
+        keyframe->setName(morph->name(IEncoding::kDefaultLanguage));
+        morphKeyframes.sort(predication);
+    }
+}
+
+static void AddAnimatedBoneKeyframes(const IModel &model, IEncoding *encoding, int nkeyframes, QSet<const IString *> &trackNames, vmd::Motion &motion)
+{
+    Array<IBone *> bones;
+    model.getBoneRefs(bones);
+    const int nbones = bones.count();
+    /* only a half of bones is animated and none of them has the first keyframe */
+    motion.beginBatchEdit();
+    for (int i = 0; i < nbones; i += 2) {
+        const IString *name = bones[i]->name(IEncoding::kDefaultLanguage);
+        trackNames.insert(name);
+        for (int j = 1; j <= nkeyframes; j++) {
+            IBoneKeyframe *keyframe = new vmd::BoneKeyframe(encoding);
+            keyframe->setTimeIndex(j);
+            keyframe->setName(name);
+            motion.addKeyframe(keyframe);
+        }
+    }
+    motion.endBatchEdit();
+}
+
+}
+
+/*
+ * compares binding a model to a motion with the full sort on each insert (before the batch edit),
+ * the sorted insert and the batch edit, run with --gtest_also_run_disabled_tests
+ */
+TEST(VMDMotionTest, DISABLED_BindModelBenchmark)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    static const int kNumBones = 700, kNumMorphs = 100, kNumKeyframes = 300;
+    PointerArray<IString> names, morphNames;
+    for (int i = 0; i < kNumBones; i++) {
+        IString *name = names.append(new String(UnicodeString::fromUTF8(QByteArray::number(i).prepend("bone").constData())));
+        IBone *bone = model.createBone();
+        bone->setName(name, IEncoding::kDefaultLanguage);
+        model.addBone(bone);
+    }
+    for (int i = 0; i < kNumMorphs; i++) {
+        IString *name = morphNames.append(new String(UnicodeString::fromUTF8(QByteArray::number(i).prepend("morph").constData())));
+        IMorph *morph = model.createMorph();
+        morph->setName(name, IEncoding::kDefaultLanguage);
+        model.addMorph(morph);
+    }
+    vmd::Motion perKeyframeMotion(&model, &encoding), batchedMotion(&model, &encoding);
+    QSet<const IString *> trackNames;
+    AddAnimatedBoneKeyframes(model, &encoding, kNumKeyframes, trackNames, perKeyframeMotion);
+    AddAnimatedBoneKeyframes(model, &encoding, kNumKeyframes, trackNames, batchedMotion);
+    PointerArray<IKeyframe> fullSortBoneKeyframes, fullSortMorphKeyframes;
+    Array<IKeyframe *> animatedKeyframes;
+    perKeyframeMotion.getAllKeyframeRefs(animatedKeyframes, IKeyframe::kBoneKeyframe);
+    const int nanimatedKeyframes = animatedKeyframes.count();
+    for (int i = 0; i < nanimatedKeyframes; i++) {
+        fullSortBoneKeyframes.append(static_cast<const IBoneKeyframe *>(animatedKeyframes[i])->clone());
+    }
+    QElapsedTimer timer;
+    timer.start();
+    AddPoseKeyframesWithFullSort(model, &encoding, trackNames, fullSortBoneKeyframes, fullSortMorphKeyframes);
+    qDebug("full sort on each insert: %d keyframes in %lld ns",
+           fullSortBoneKeyframes.count() + fullSortMorphKeyframes.count(), timer.nsecsElapsed());
+    /* previous MotionProxy#assignModel inserts each keyframe to the sorted position */
+    timer.restart();
+    AddPoseKeyframes(model, &encoding, trackNames, perKeyframeMotion);
+    qDebug("per keyframe: %d keyframes in %lld ns",
+           perKeyframeMotion.countKeyframes(IKeyframe::kBoneKeyframe) + perKeyframeMotion.countKeyframes(IKeyframe::kMorphKeyframe),
+           timer.nsecsElapsed());
+    timer.restart();
+    batchedMotion.beginBatchEdit();
+    AddPoseKeyframes(model, &encoding, trackNames, batchedMotion);
+    batchedMotion.endBatchEdit();
+    qDebug("batched: %d keyframes in %lld ns",
+           batchedMotion.countKeyframes(IKeyframe::kBoneKeyframe) + batchedMotion.countKeyframes(IKeyframe::kMorphKeyframe),
+           timer.nsecsElapsed());
+    ASSERT_EQ(perKeyframeMotion.countKeyframes(IKeyframe::kBoneKeyframe), batchedMotion.countKeyframes(IKeyframe::kBoneKeyframe));
+    ASSERT_EQ(perKeyframeMotion.countKeyframes(IKeyframe::kMorphKeyframe), batchedMotion.countKeyframes(IKeyframe::kMorphKeyframe));
+    ASSERT_EQ(fullSortBoneKeyframes.count(), batchedMotion.countKeyframes(IKeyframe::kBoneKeyframe));
+    ASSERT_EQ(fullSortMorphKeyframes.count(), batchedMotion.countKeyframes(IKeyframe::kMorphKeyframe));
+    fullSortBoneKeyframes.releaseAll();
+    fullSortMorphKeyframes.releaseAll();
+    names.releaseAll();
+    morphNames.releaseAll();
+}
+
 class VMDMotionAllKeyframesTest : public TestWithParam<IKeyframe::Type> {};
 
 TEST_P(VMDMotionAllKeyframesTest, SetAndGetAllKeyframes)
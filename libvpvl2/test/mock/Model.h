@@ -181,6 +181,8 @@ class MockIModel : public IModel {
       void(IRigidBody *value));
   MOCK_METHOD1(removeVertex,
       void(IVertex *value));
+  MOCK_CONST_METHOD0(structureRevision,
+      int());
   MOCK_CONST_METHOD0(progressReporterRef,
       IProgressReporter*());
   MOCK_METHOD1(setProgressReporterRef,
@@ -19,6 +19,14 @@ class MockIRenderEngine : public IRenderEngine {
       void(IEffect::Pass *overridePass));
   MOCK_METHOD0(update,
       void());
+  MOCK_METHOD0(beginUpdate,
+      bool());
+  MOCK_METHOD0(performUpdate,
+      void());
+  MOCK_METHOD0(endUpdate,
+      void());
+  MOCK_METHOD0(updateSceneParameters,
+      void());
   MOCK_METHOD1(setUpdateOptions,
       void(int options));
   MOCK_CONST_METHOD0(hasPreProcess,
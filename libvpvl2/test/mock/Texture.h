@@ -0,0 +1,43 @@
+namespace vpvl2 {
+namespace VPVL2_VERSION_NS {
+
+class MockITexture : public ITexture {
+ public:
+  MOCK_METHOD0(create,
+      void());
+  MOCK_METHOD0(bind,
+      void());
+  MOCK_METHOD1(fillPixels,
+      void(const void *pixels));
+  MOCK_METHOD1(allocate,
+      void(const void *pixels));
+  MOCK_METHOD1(write,
+      void(const void *pixels));
+  MOCK_CONST_METHOD2(getParameters,
+      void(unsigned int key, int *values));
+  MOCK_CONST_METHOD2(getParameters,
+      void(unsigned int key, float *values));
+  MOCK_METHOD2(setParameter,
+      void(unsigned int key, int value));
+  MOCK_METHOD2(setParameter,
+      void(unsigned int key, float value));
+  MOCK_METHOD0(generateMipmaps,
+      void());
+  MOCK_METHOD1(resize,
+      void(const Vector3 &size));
+  MOCK_METHOD0(unbind,
+      void());
+  MOCK_METHOD0(release,
+      void());
+  MOCK_CONST_METHOD0(size,
+      Vector3());
+  MOCK_CONST_METHOD0(data,
+      intptr_t());
+  MOCK_CONST_METHOD0(sampler,
+      intptr_t());
+  MOCK_CONST_METHOD0(format,
+      intptr_t());
+};
+
+}  // namespace VPVL2_VERSION_NS
+}  // namespace vpvl2
@@ -11,6 +11,8 @@
 #include "vpvl2/pmx/Morph.h"
 #include "vpvl2/pmx/RigidBody.h"
 #include "vpvl2/pmx/Vertex.h"
+#include "vpvl2/internal/MaterialDrawList.h"
+#include "vpvl2/internal/ParallelProcessors.h"
 
 #include "../mock/Bone.h"
 #include "../mock/Joint.h"
@@ -18,6 +20,7 @@
 #include "../mock/Material.h"
 #include "../mock/Morph.h"
 #include "../mock/RigidBody.h"
+#include "../mock/Texture.h"
 #include "../mock/Vertex.h"
 
 using namespace std::tr1;
@@ -580,3 +580,71 @@ TEST(PMXModelTest, RemoveMaterialReferences)
     ASSERT_EQ(Factory::sharedNullMaterialRef(), vertex.materialRef());
     ASSERT_EQ(0, materialMorph.materials->count());
 }
+
+TEST(PMXMaterialTest, DrawListMergesAdjacentMaterials)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    Material m0(&model), m1(&model), m2(&model), m3(&model);
+    Array<IMaterial *> materials;
+    IMaterial::IndexRange range;
+    range.count = 3;
+    materials.append(&m0);
+    materials.append(&m1);
+    materials.append(&m2);
+    materials.append(&m3);
+    for (int i = 0; i < materials.count(); i++) {
+        Material *material = static_cast<Material *>(materials[i]);
+        material->setIndexRange(range);
+        material->setDiffuse(Color(0.1, 0.2, 0.3, 1.0));
+        material->setEdgeColor(Color(0, 0, 0, 1));
+    }
+    m2.setDiffuse(Color(0.4, 0.5, 0.6, 1.0));
+    m3.setDiffuse(Color(0.4, 0.5, 0.6, 1.0));
+    m0.setFlags(IMaterial::kEnableEdge | IMaterial::kCastingShadow);
+    m1.setFlags(IMaterial::kEnableEdge);
+    m2.setFlags(IMaterial::kEnableEdge | IMaterial::kCastingShadow);
+    m3.setFlags(IMaterial::kDisableCulling | IMaterial::kCastingShadow);
+    internal::MaterialDrawList drawList;
+    ASSERT_TRUE(drawList.build(materials));
+    ASSERT_EQ(4, drawList.countStates());
+    /* m0 and m1 are merged, m3 differs from m2 by culling */
+    ASSERT_EQ(3, drawList.countCommands(internal::MaterialDrawList::kModelPass));
+    const internal::MaterialDrawList::Command &c0 = drawList.commandAt(internal::MaterialDrawList::kModelPass, 0);
+    ASSERT_EQ(0, c0.materialIndex);
+    ASSERT_EQ(2, c0.numMaterials);
+    ASSERT_EQ(vsize(0), c0.offset);
+    ASSERT_EQ(6, c0.count);
+    const internal::MaterialDrawList::Command &c2 = drawList.commandAt(internal::MaterialDrawList::kModelPass, 2);
+    ASSERT_EQ(3, c2.materialIndex);
+    ASSERT_EQ(vsize(9), c2.offset);
+    ASSERT_EQ(3, c2.count);
+    /* edge pass only depends on the edge color and size */
+    ASSERT_EQ(1, drawList.countCommands(internal::MaterialDrawList::kEdgePass));
+    ASSERT_EQ(3, drawList.commandAt(internal::MaterialDrawList::kEdgePass, 0).numMaterials);
+    ASSERT_EQ(9, drawList.commandAt(internal::MaterialDrawList::kEdgePass, 0).count);
+    /* m1 is not casting shadow so m0 cannot be merged with m2 */
+    ASSERT_EQ(2, drawList.countCommands(internal::MaterialDrawList::kShadowPass));
+    ASSERT_EQ(vsize(6), drawList.commandAt(internal::MaterialDrawList::kShadowPass, 1).offset);
+    ASSERT_EQ(6, drawList.commandAt(internal::MaterialDrawList::kShadowPass, 1).count);
+    ASSERT_EQ(0, drawList.countCommands(internal::MaterialDrawList::kZPlotPass));
+    /* nothing is changed */
+    ASSERT_FALSE(drawList.build(materials));
+    /* textures are part of the state */
+    MockITexture texture;
+    drawList.setTextureRefs(1, &texture, 0, 0);
+    ASSERT_TRUE(drawList.build(materials));
+    ASSERT_EQ(4, drawList.countCommands(internal::MaterialDrawList::kModelPass));
+    ASSERT_EQ(&texture, drawList.stateAt(1).mainTextureRef);
+    drawList.setTextureRefs(1, 0, 0, 0);
+    m1.setDiffuse(Color(0.4, 0.5, 0.6, 1.0));
+    ASSERT_TRUE(drawList.build(materials));
+    ASSERT_EQ(3, drawList.countCommands(internal::MaterialDrawList::kModelPass));
+    ASSERT_EQ(2, drawList.commandAt(internal::MaterialDrawList::kModelPass, 1).numMaterials);
+    /* vertex shader skinning needs a command per material */
+    drawList.setMergeEnabled(false);
+    ASSERT_TRUE(drawList.build(materials));
+    ASSERT_EQ(4, drawList.countCommands(internal::MaterialDrawList::kModelPass));
+    ASSERT_EQ(3, drawList.countCommands(internal::MaterialDrawList::kEdgePass));
+    ASSERT_EQ(3, drawList.countCommands(internal::MaterialDrawList::kShadowPass));
+}
@@ -91,6 +91,459 @@ TEST(PMXModelTest, ParseRealPMX)
     }
 }
 
+TEST(PMXModelTest, ParallelLoadSameAsSerialLoad)
+{
+    QFile file("miku.pmx");
+    if (file.open(QFile::ReadOnly)) {
+        const QByteArray &bytes = file.readAll();
+        Encoding::Dictionary dict;
+        Encoding encoding(&dict);
+        pmx::Model expected(&encoding), actual(&encoding);
+        expected.setParallelLoadEnable(false);
+        ASSERT_TRUE(expected.load(reinterpret_cast<const uint8 *>(bytes.constData()), bytes.size()));
+        ASSERT_TRUE(actual.isParallelLoadEnabled());
+        ASSERT_TRUE(actual.load(reinterpret_cast<const uint8 *>(bytes.constData()), bytes.size()));
+        const Array<Vertex *> &expectedVertices = expected.vertices(), &actualVertices = actual.vertices();
+        ASSERT_EQ(expectedVertices.count(), actualVertices.count());
+        for (int i = 0, nvertices = expectedVertices.count(); i < nvertices; i++) {
+            const Vertex *e = expectedVertices[i], *a = actualVertices[i];
+            ASSERT_TRUE(CompareVector(e->origin(), a->origin()));
+            ASSERT_EQ(e->type(), a->type());
+            ASSERT_EQ(e->materialRef() ? e->materialRef()->index() : -1, a->materialRef() ? a->materialRef()->index() : -1);
+        }
+        const Array<int> &expectedIndices = expected.indices(), &actualIndices = actual.indices();
+        ASSERT_EQ(expectedIndices.count(), actualIndices.count());
+        for (int i = 0, nindices = expectedIndices.count(); i < nindices; i++) {
+            ASSERT_EQ(expectedIndices[i], actualIndices[i]);
+        }
+        const Array<Morph *> &expectedMorphs = expected.morphs(), &actualMorphs = actual.morphs();
+        ASSERT_EQ(expectedMorphs.count(), actualMorphs.count());
+        for (int i = 0, nmorphs = expectedMorphs.count(); i < nmorphs; i++) {
+            const IString *name = expectedMorphs[i]->name(IEncoding::kJapanese);
+            ASSERT_TRUE(name->equals(actualMorphs[i]->name(IEncoding::kJapanese)));
+            ASSERT_EQ(expected.findMorphRef(name)->index(), actual.findMorphRef(name)->index());
+        }
+        const Array<Material *> &expectedMaterials = expected.materials(), &actualMaterials = actual.materials();
+        ASSERT_EQ(expectedMaterials.count(), actualMaterials.count());
+        for (int i = 0, nmaterials = expectedMaterials.count(); i < nmaterials; i++) {
+            const IMaterial::IndexRange &e = expectedMaterials[i]->indexRange(), &a = actualMaterials[i]->indexRange();
+            ASSERT_EQ(e.start, a.start);
+            ASSERT_EQ(e.end, a.end);
+            ASSERT_EQ(e.count, a.count);
+        }
+        ASSERT_EQ(expected.bones().count(), actual.bones().count());
+        ASSERT_EQ(expected.labels().count(), actual.labels().count());
+        ASSERT_EQ(expected.rigidBodies().count(), actual.rigidBodies().count());
+        ASSERT_EQ(expected.joints().count(), actual.joints().count());
+    }
+    else {
+        // skip
+    }
+}
+
+class RecordingProgressReporter : public IProgressReporter {
+public:
+    void reportProgress(float value) { m_values.append(value); }
+    const QList<float> &values() const { return m_values; }
+private:
+    QList<float> m_values;
+};
+
+TEST(PMXModelTest, ReportLoadProgressOfAllSteps)
+{
+    QFile file("miku.pmx");
+    if (file.open(QFile::ReadOnly)) {
+        const QByteArray &bytes = file.readAll();
+        Encoding::Dictionary dict;
+        Encoding encoding(&dict);
+        for (int i = 0; i < 2; i++) {
+            /* sections are parsed concurrently only if the parallel load is enabled */
+            pmx::Model model(&encoding);
+            RecordingProgressReporter reporter;
+            model.setParallelLoadEnable(i == 0);
+            model.setProgressReporterRef(&reporter);
+            ASSERT_TRUE(model.load(reinterpret_cast<const uint8 *>(bytes.constData()), bytes.size()));
+            const QList<float> &values = reporter.values();
+            ASSERT_EQ(15, values.size());
+            for (int j = 0; j < 15; j++) {
+                ASSERT_FLOAT_EQ((j + 1) / 15.0f, values[j]);
+            }
+        }
+    }
+    else {
+        // skip
+    }
+}
+
+class ByteArrayMappedData : public Model::MappedData {
+public:
+    ByteArrayMappedData(const QByteArray &bytes) : m_bytes(bytes) {}
+    const uint8 *address() const { return reinterpret_cast<const uint8 *>(m_bytes.constData()); }
+    vsize size() const { return vsize(m_bytes.size()); }
+private:
+    const QByteArray m_bytes;
+};
+
+TEST(PMXModelTest, MappedLoadSameAsLoad)
+{
+    QFile file("miku.pmx");
+    if (file.open(QFile::ReadOnly)) {
+        const QByteArray &bytes = file.readAll();
+        Encoding::Dictionary dict;
+        Encoding encoding(&dict);
+        pmx::Model expected(&encoding), actual(&encoding);
+        ASSERT_TRUE(expected.load(reinterpret_cast<const uint8 *>(bytes.constData()), bytes.size()));
+        ASSERT_TRUE(actual.loadMapped(new ByteArrayMappedData(bytes)));
+        const int nindices = expected.count(IModel::kIndex);
+        ASSERT_EQ(nindices, actual.count(IModel::kIndex));
+        const Array<int> &expectedIndices = expected.indices();
+        for (int i = 0; i < nindices; i++) {
+            ASSERT_EQ(expectedIndices[i], actual.indexAt(i));
+        }
+        Array<int> actualIndices;
+        actual.getIndices(actualIndices);
+        ASSERT_EQ(nindices, actualIndices.count());
+        for (int i = 0; i < nindices; i++) {
+            ASSERT_EQ(expectedIndices[i], actualIndices[i]);
+        }
+        const Array<Material *> &expectedMaterials = expected.materials(), &actualMaterials = actual.materials();
+        ASSERT_EQ(expectedMaterials.count(), actualMaterials.count());
+        for (int i = 0, nmaterials = expectedMaterials.count(); i < nmaterials; i++) {
+            const IMaterial::IndexRange &e = expectedMaterials[i]->indexRange(), &a = actualMaterials[i]->indexRange();
+            ASSERT_EQ(e.start, a.start);
+            ASSERT_EQ(e.end, a.end);
+            ASSERT_EQ(e.count, a.count);
+        }
+        /* decodes indices from the mapping and keeps them after that */
+        const Array<int> &decodedIndices = actual.indices();
+        ASSERT_EQ(nindices, decodedIndices.count());
+        for (int i = 0; i < nindices; i++) {
+            ASSERT_EQ(expectedIndices[i], decodedIndices[i]);
+        }
+        ASSERT_EQ(nindices, actual.count(IModel::kIndex));
+    }
+    else {
+        // skip
+    }
+}
+
+TEST(PMXModelTest, MappedLoadTakesOwnershipOnFailure)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    ASSERT_FALSE(model.loadMapped(new ByteArrayMappedData(QByteArray("PMX ", 4))));
+    ASSERT_FALSE(model.loadMapped(0));
+}
+
+static void SetupSkinningModel(Model &model, int nvertices)
+{
+    Array<Bone *> bones;
+    for (int i = 0; i < Vertex::kMaxBones; i++) {
+        Bone *bone = new Bone(&model);
+        Transform transform;
+        transform.setOrigin(Vector3(0.1 * i, 0.2 * i, 0.3 * i));
+        transform.setRotation(Quaternion(Vector3(0, 1, 0), 0.25 * i));
+        bone->setLocalTransform(transform);
+        model.addBone(bone);
+        bones.append(bone);
+    }
+    Material *material = new Material(&model);
+    material->setEdgeSize(0.5);
+    model.addMaterial(material);
+    static const Vertex::Type kTypes[] = { Vertex::kBdef1, Vertex::kBdef2, Vertex::kBdef4, Vertex::kSdef, Vertex::kQdef };
+    static const int kNumTypes = sizeof(kTypes) / sizeof(kTypes[0]);
+    for (int i = 0; i < nvertices; i++) {
+        Vertex *vertex = new Vertex(&model);
+        SetVertex(*vertex, kTypes[i % kNumTypes], bones);
+        vertex->setOrigin(Vector3(0.01 * i, 0.02 * i, 0.03 * i));
+        vertex->setOriginUV(1, Vector4(0.1 * i, 0.2 * i, 0.3 * i, 0.4 * i));
+        vertex->setMaterialRef(material);
+        model.addVertex(vertex);
+    }
+}
+
+TEST(PMXModelTest, PackedVertexStoreSameAsReferenceSkinning)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    SetupSkinningModel(model, 40);
+    QScopedPointer<IModel::IndexBuffer> indexBuffer;
+    QScopedPointer<IModel::DynamicVertexBuffer> dynamicBuffer;
+    IModel::IndexBuffer *indexBufferPtr = 0;
+    IModel::DynamicVertexBuffer *dynamicBufferPtr = 0;
+    model.getIndexBuffer(indexBufferPtr);
+    indexBuffer.reset(indexBufferPtr);
+    model.getDynamicVertexBuffer(dynamicBufferPtr, indexBufferPtr);
+    dynamicBuffer.reset(dynamicBufferPtr);
+    ASSERT_TRUE(dynamicBuffer.data());
+    const Vector3 cameraPosition(0, 10, -50);
+    Array<uint8> expected, actual;
+    expected.resize(int(dynamicBuffer->size()));
+    actual.resize(int(dynamicBuffer->size()));
+    model.setPackedVertexStoreEnable(false);
+    ASSERT_EQ(static_cast<internal::PackedVertexStore *>(0), model.packedVertexStoreRef());
+    dynamicBuffer->performTransform(&expected[0], cameraPosition);
+    model.setPackedVertexStoreEnable(true);
+    ASSERT_TRUE(model.packedVertexStoreRef());
+    dynamicBuffer->performTransform(&actual[0], cameraPosition);
+    const vsize stride = dynamicBuffer->strideSize();
+    const vsize offsets[] = {
+        dynamicBuffer->strideOffset(IModel::Buffer::kVertexStride),
+        dynamicBuffer->strideOffset(IModel::Buffer::kNormalStride),
+        dynamicBuffer->strideOffset(IModel::Buffer::kEdgeVertexStride)
+    };
+    const int nvertices = model.vertices().count();
+    for (int i = 0; i < nvertices; i++) {
+        for (int j = 0; j < 3; j++) {
+            const vsize offset = stride * i + offsets[j];
+            const Vector3 &e = *reinterpret_cast<const Vector3 *>(&expected[int(offset)]);
+            const Vector3 &a = *reinterpret_cast<const Vector3 *>(&actual[int(offset)]);
+            ASSERT_TRUE(CompareVector(e, a));
+        }
+    }
+}
+
+TEST(PMXModelTest, FusedSkinningSameAsReferenceSkinning)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    SetupSkinningModel(model, 4000);
+    QScopedPointer<IModel::IndexBuffer> indexBuffer;
+    QScopedPointer<IModel::DynamicVertexBuffer> dynamicBuffer;
+    IModel::IndexBuffer *indexBufferPtr = 0;
+    IModel::DynamicVertexBuffer *dynamicBufferPtr = 0;
+    model.getIndexBuffer(indexBufferPtr);
+    indexBuffer.reset(indexBufferPtr);
+    model.getDynamicVertexBuffer(dynamicBufferPtr, indexBufferPtr);
+    dynamicBuffer.reset(dynamicBufferPtr);
+    ASSERT_TRUE(dynamicBuffer.data());
+    const Vector3 cameraPosition(0, 10, -50);
+    Array<uint8> expected, actual;
+    expected.resize(int(dynamicBuffer->size()));
+    actual.resize(int(dynamicBuffer->size()));
+    model.setPackedVertexStoreEnable(false);
+    dynamicBuffer->performTransform(&expected[0], cameraPosition);
+    const Array<Vertex *> &vertices = model.vertices();
+    Vector3 aabbMin, aabbMax;
+    internal::ParallelSkinningAabbVertexProcessor<Vertex> processor(&vertices, dynamicBuffer.data(), model.edgeScaleFactor(cameraPosition), &actual[0]);
+    processor.execute(true, aabbMin, aabbMax);
+    const vsize stride = dynamicBuffer->strideSize();
+    const vsize offsets[] = {
+        dynamicBuffer->strideOffset(IModel::Buffer::kVertexStride),
+        dynamicBuffer->strideOffset(IModel::Buffer::kNormalStride),
+        dynamicBuffer->strideOffset(IModel::Buffer::kEdgeVertexStride),
+        dynamicBuffer->strideOffset(IModel::Buffer::kUVA2Stride)
+    };
+    Vector3 expectedMin(SIMD_INFINITY, SIMD_INFINITY, SIMD_INFINITY), expectedMax(-SIMD_INFINITY, -SIMD_INFINITY, -SIMD_INFINITY);
+    const int nvertices = vertices.count();
+    for (int i = 0; i < nvertices; i++) {
+        for (int j = 0; j < 3; j++) {
+            const vsize offset = stride * i + offsets[j];
+            const Vector3 &e = *reinterpret_cast<const Vector3 *>(&expected[int(offset)]);
+            const Vector3 &a = *reinterpret_cast<const Vector3 *>(&actual[int(offset)]);
+            ASSERT_TRUE(CompareVector(e, a));
+        }
+        const vsize offset = stride * i + offsets[3];
+        const Vector4 &e = *reinterpret_cast<const Vector4 *>(&expected[int(offset)]);
+        const Vector4 &a = *reinterpret_cast<const Vector4 *>(&actual[int(offset)]);
+        ASSERT_TRUE(CompareVector(e, a));
+        const Vector3 &position = *reinterpret_cast<const Vector3 *>(&expected[int(stride * i + offsets[0])]);
+        expectedMin.setMin(position);
+        expectedMax.setMax(position);
+    }
+    ASSERT_TRUE(CompareVector(expectedMin, aabbMin));
+    ASSERT_TRUE(CompareVector(expectedMax, aabbMax));
+    /* serial path must produce the same bounding box */
+    processor.execute(false, aabbMin, aabbMax);
+    ASSERT_TRUE(CompareVector(expectedMin, aabbMin));
+    ASSERT_TRUE(CompareVector(expectedMax, aabbMax));
+}
+
+TEST(PMXModelTest, FusedSkinningStreamLayoutWithoutUVA)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    SetupSkinningModel(model, 100);
+    QScopedPointer<IModel::IndexBuffer> indexBuffer;
+    QScopedPointer<IModel::DynamicVertexBuffer> dynamicBuffer;
+    IModel::IndexBuffer *indexBufferPtr = 0;
+    IModel::DynamicVertexBuffer *dynamicBufferPtr = 0;
+    model.getIndexBuffer(indexBufferPtr);
+    indexBuffer.reset(indexBufferPtr);
+    model.getDynamicVertexBuffer(dynamicBufferPtr, indexBufferPtr);
+    dynamicBuffer.reset(dynamicBufferPtr);
+    const Vector3 cameraPosition(0, 10, -50);
+    Array<uint8> expected;
+    expected.resize(int(dynamicBuffer->size()));
+    model.setPackedVertexStoreEnable(false);
+    dynamicBuffer->performTransform(&expected[0], cameraPosition);
+    /* position, normal and edge only as the per-frame stream */
+    typedef internal::ParallelSkinningAabbVertexProcessor<Vertex> Processor;
+    const Array<Vertex *> &vertices = model.vertices();
+    const int nvertices = vertices.count();
+    Array<Vector3> actual;
+    actual.resize(nvertices * 3);
+    const Processor::Layout layout(sizeof(Vector3) * 3, 0, sizeof(Vector3), sizeof(Vector3) * 2);
+    Processor processor(&vertices, layout, model.edgeScaleFactor(cameraPosition), &actual[0]);
+    Vector3 aabbMin, aabbMax;
+    processor.execute(false, aabbMin, aabbMax);
+    const vsize stride = dynamicBuffer->strideSize();
+    const vsize offsets[] = {
+        dynamicBuffer->strideOffset(IModel::Buffer::kVertexStride),
+        dynamicBuffer->strideOffset(IModel::Buffer::kNormalStride),
+        dynamicBuffer->strideOffset(IModel::Buffer::kEdgeVertexStride)
+    };
+    for (int i = 0; i < nvertices; i++) {
+        for (int j = 0; j < 3; j++) {
+            const Vector3 &e = *reinterpret_cast<const Vector3 *>(&expected[int(stride * i + offsets[j])]);
+            ASSERT_TRUE(CompareVector(e, actual[i * 3 + j]));
+        }
+    }
+}
+
+TEST(PMXModelTest, PackedFusedSkinningSameAsReferenceSkinning)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    SetupSkinningModel(model, 4000);
+    QScopedPointer<IModel::IndexBuffer> indexBuffer;
+    QScopedPointer<IModel::DynamicVertexBuffer> dynamicBuffer;
+    IModel::IndexBuffer *indexBufferPtr = 0;
+    IModel::DynamicVertexBuffer *dynamicBufferPtr = 0;
+    model.getIndexBuffer(indexBufferPtr);
+    indexBuffer.reset(indexBufferPtr);
+    model.getDynamicVertexBuffer(dynamicBufferPtr, indexBufferPtr);
+    dynamicBuffer.reset(dynamicBufferPtr);
+    const Vector3 cameraPosition(0, 10, -50);
+    Array<uint8> expected;
+    expected.resize(int(dynamicBuffer->size()));
+    model.setPackedVertexStoreEnable(false);
+    dynamicBuffer->performTransform(&expected[0], cameraPosition);
+    model.setPackedVertexStoreEnable(true);
+    internal::PackedVertexStore *storeRef = model.packedVertexStoreRef();
+    ASSERT_TRUE(storeRef);
+    storeRef->update(model.vertices(), model.bones(), model.materials());
+    typedef internal::PackedVertexStore::SkinningUnit Unit;
+    const int nvertices = model.vertices().count();
+    Array<Unit> actual;
+    actual.resize(nvertices);
+    internal::ParallelPackedSkinningAabbVertexProcessor<Unit> processor(storeRef, model.edgeScaleFactor(cameraPosition), &actual[0]);
+    Vector3 aabbMin, aabbMax;
+    processor.execute(true, aabbMin, aabbMax);
+    const vsize stride = dynamicBuffer->strideSize();
+    const vsize positionOffset = dynamicBuffer->strideOffset(IModel::Buffer::kVertexStride),
+            normalOffset = dynamicBuffer->strideOffset(IModel::Buffer::kNormalStride),
+            edgeOffset = dynamicBuffer->strideOffset(IModel::Buffer::kEdgeVertexStride);
+    Vector3 expectedMin(SIMD_INFINITY, SIMD_INFINITY, SIMD_INFINITY), expectedMax(-SIMD_INFINITY, -SIMD_INFINITY, -SIMD_INFINITY);
+    for (int i = 0; i < nvertices; i++) {
+        const Vector3 &position = *reinterpret_cast<const Vector3 *>(&expected[int(stride * i + positionOffset)]);
+        ASSERT_TRUE(CompareVector(position, actual[i].position));
+        ASSERT_TRUE(CompareVector(*reinterpret_cast<const Vector3 *>(&expected[int(stride * i + normalOffset)]), actual[i].normal));
+        ASSERT_TRUE(CompareVector(*reinterpret_cast<const Vector3 *>(&expected[int(stride * i + edgeOffset)]), actual[i].edge));
+        expectedMin.setMin(position);
+        expectedMax.setMax(position);
+    }
+    ASSERT_TRUE(CompareVector(expectedMin, aabbMin));
+    ASSERT_TRUE(CompareVector(expectedMax, aabbMax));
+    processor.execute(false, aabbMin, aabbMax);
+    ASSERT_TRUE(CompareVector(expectedMin, aabbMin));
+    ASSERT_TRUE(CompareVector(expectedMax, aabbMax));
+}
+
+/* same layout as the dynamic vertex buffer so both paths write the same bytes */
+struct DynamicUnit {
+    Vector3 position;
+    Vector3 normal;
+    Vector3 edge;
+    Vector4 uva1;
+    Vector4 uva2;
+    Vector4 uva3;
+    Vector4 uva4;
+};
+
+TEST(PMXModelTest, DISABLED_FusedSkinningBenchmark)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    static const int kNumVertices = 200000, kNumIterations = 30;
+    SetupSkinningModel(model, kNumVertices);
+    QScopedPointer<IModel::IndexBuffer> indexBuffer;
+    QScopedPointer<IModel::DynamicVertexBuffer> dynamicBuffer;
+    IModel::IndexBuffer *indexBufferPtr = 0;
+    IModel::DynamicVertexBuffer *dynamicBufferPtr = 0;
+    model.getIndexBuffer(indexBufferPtr);
+    indexBuffer.reset(indexBufferPtr);
+    model.getDynamicVertexBuffer(dynamicBufferPtr, indexBufferPtr);
+    dynamicBuffer.reset(dynamicBufferPtr);
+    dynamicBuffer->setParallelUpdateEnable(true);
+    const Vector3 cameraPosition(0, 10, -50);
+    Array<uint8> bytes;
+    bytes.resize(int(dynamicBuffer->size()));
+    const vsize stride = dynamicBuffer->strideSize();
+    Vector3 aabbMin, aabbMax;
+    /* default path: packed skinning kernels followed by a separate bounding box pass */
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < kNumIterations; i++) {
+        dynamicBuffer->performTransform(&bytes[0], cameraPosition);
+        aabbMin.setValue(SIMD_INFINITY, SIMD_INFINITY, SIMD_INFINITY);
+        aabbMax.setValue(-SIMD_INFINITY, -SIMD_INFINITY, -SIMD_INFINITY);
+        for (int j = 0; j < kNumVertices; j++) {
+            const Vector3 &position = *reinterpret_cast<const Vector3 *>(&bytes[int(stride * j)]);
+            aabbMin.setMin(position);
+            aabbMax.setMax(position);
+        }
+    }
+    qDebug("two passes: %d vertices in %lld ns", kNumVertices, timer.nsecsElapsed() / kNumIterations);
+    ASSERT_EQ(stride, sizeof(DynamicUnit));
+    internal::PackedVertexStore *storeRef = model.packedVertexStoreRef();
+    ASSERT_TRUE(storeRef);
+    const IVertex::EdgeSizePrecision &edgeScaleFactor = model.edgeScaleFactor(cameraPosition);
+    timer.restart();
+    for (int i = 0; i < kNumIterations; i++) {
+        storeRef->update(model.vertices(), model.bones(), model.materials());
+        internal::ParallelPackedSkinningAabbVertexProcessor<DynamicUnit> processor(storeRef, edgeScaleFactor, &bytes[0]);
+        processor.execute(true, aabbMin, aabbMax);
+    }
+    qDebug("fused pass: %d vertices in %lld ns", kNumVertices, timer.nsecsElapsed() / kNumIterations);
+}
+
+/*
+ * compares loading model.pmx from a heap copy and from a mapping, run with --gtest_also_run_disabled_tests.
+ * the mapped path doesn't copy the file and doesn't decode indices until they are requested as an array.
+ */
+TEST(PMXModelTest, DISABLED_LoadFromMappedFileBenchmark)
+{
+    QFile file("model.pmx");
+    if (!file.open(QFile::ReadOnly)) {
+        return;
+    }
+    Encoding encoding(0);
+    const qint64 fileSize = file.size();
+    {
+        QElapsedTimer timer;
+        timer.start();
+        uchar *address = file.map(0, fileSize);
+        ASSERT_TRUE(address);
+        {
+            /* the model refers the mapping until it's destroyed */
+            Model model(&encoding);
+            ASSERT_TRUE(model.loadMapped(new ByteArrayMappedData(QByteArray::fromRawData(reinterpret_cast<const char *>(address), int(fileSize)))));
+            qDebug("mapped: %lld bytes, %d vertices in %lld ns", fileSize, model.vertices().count(), timer.nsecsElapsed());
+        }
+        file.unmap(address);
+    }
+    {
+        QElapsedTimer timer;
+        timer.start();
+        file.seek(0);
+        const QByteArray &bytes = file.readAll();
+        Model model(&encoding);
+        ASSERT_TRUE(model.load(reinterpret_cast<const uint8 *>(bytes.constData()), vsize(bytes.size())));
+        qDebug("copied: %lld bytes, %d vertices in %lld ns", fileSize, model.vertices().count(), timer.nsecsElapsed());
+    }
+}
+
 INSTANTIATE_TEST_CASE_P(PMXModelInstance, PMXFragmentTest, Values(1, 2, 4));
 INSTANTIATE_TEST_CASE_P(PMXModelInstance, PMXFragmentWithUVTest, Combine(Values(1, 2, 4),
                                                                          Values(pmx::Morph::kTexCoordMorph,
@@ -1,4 +1,5 @@
 #include "Common.h"
+#include "vpvl2/internal/DynamicVertexUpdateTracker.h"
 
 TEST_P(PMXFragmentTest, ReadWriteBoneMorph)
 {
@@ -365,6 +366,163 @@ TEST(PMXModelTest, RemoveMorphReferences)
     ASSERT_EQ(static_cast<IMorph *>(0), flipMorph.morph);
 }
 
+TEST(PMXModelTest, UpdateOnlyVerticesTouchedByMorph)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    static const int kNumVertices = 8;
+    for (int i = 0; i < kNumVertices; i++) {
+        model.addVertex(new Vertex(&model));
+    }
+    Morph *morph = new Morph(&model);
+    morph->setType(IMorph::kVertexMorph);
+    const int indices[] = { 2, 5 };
+    for (int i = 0; i < 2; i++) {
+        Morph::Vertex *vertexMorph = new Morph::Vertex();
+        vertexMorph->vertex = model.findVertexRefAt(indices[i]);
+        vertexMorph->index = indices[i];
+        vertexMorph->position.setValue(1, 2, 3);
+        morph->addVertexMorph(vertexMorph);
+    }
+    model.addMorph(morph);
+    /* all vertices are reset at the first update */
+    model.performUpdate();
+    ASSERT_EQ(kNumVertices, model.numMorphTouchedVertices());
+    model.performUpdate();
+    ASSERT_EQ(0, model.numMorphTouchedVertices());
+    morph->setWeight(0.5);
+    model.performUpdate();
+    ASSERT_EQ(2, model.numMorphTouchedVertices());
+    ASSERT_EQ(indices[0], model.morphTouchedVertexIndices()[0]);
+    ASSERT_EQ(indices[1], model.morphTouchedVertexIndices()[1]);
+    ASSERT_TRUE(CompareVector(Vector3(0.5, 1, 1.5), model.vertices()[indices[0]]->delta()));
+    /* non-zero weight morph is accumulated again without doubling deltas */
+    model.performUpdate();
+    ASSERT_EQ(2, model.numMorphTouchedVertices());
+    ASSERT_TRUE(CompareVector(Vector3(0.5, 1, 1.5), model.vertices()[indices[1]]->delta()));
+    ASSERT_TRUE(CompareVector(kZeroV3, model.vertices()[0]->delta()));
+    /* vertices touched at the previous frame are reset */
+    morph->setWeight(0);
+    model.performUpdate();
+    ASSERT_EQ(2, model.numMorphTouchedVertices());
+    ASSERT_TRUE(CompareVector(kZeroV3, model.vertices()[indices[0]]->delta()));
+    model.performUpdate();
+    ASSERT_EQ(0, model.numMorphTouchedVertices());
+    /* editing vertices reports all vertices again */
+    model.vertices()[0]->setOrigin(Vector3(1, 1, 1));
+    model.performUpdate();
+    ASSERT_EQ(kNumVertices, model.numMorphTouchedVertices());
+}
+
+TEST(PMXModelTest, ResetUVMorphInGroupMorph)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    model.addVertex(new Vertex(&model));
+    Vertex *vertex = model.vertices()[0];
+    /* children are added before the parents to be visited first by the model */
+    Morph *uvMorph = new Morph(&model);
+    uvMorph->setType(IMorph::kUVA1Morph);
+    Morph::UV *uv = new Morph::UV();
+    uv->vertex = vertex;
+    uv->index = 0;
+    uv->offset = 1;
+    uv->position.setValue(1, 2, 3, 4);
+    uvMorph->addUVMorph(uv);
+    model.addMorph(uvMorph);
+    Morph *childGroupMorph = new Morph(&model);
+    childGroupMorph->setType(IMorph::kGroupMorph);
+    Morph::Group *uvGroup = new Morph::Group();
+    uvGroup->morph = uvMorph;
+    uvGroup->fixedWeight = 1;
+    childGroupMorph->addGroupMorph(uvGroup);
+    model.addMorph(childGroupMorph);
+    Morph *groupMorph = new Morph(&model);
+    groupMorph->setType(IMorph::kGroupMorph);
+    Morph::Group *childGroup = new Morph::Group();
+    childGroup->morph = childGroupMorph;
+    childGroup->fixedWeight = 0.5;
+    groupMorph->addGroupMorph(childGroup);
+    model.addMorph(groupMorph);
+    ASSERT_TRUE(uvMorph->hasParent());
+    ASSERT_TRUE(childGroupMorph->hasParent());
+    model.performUpdate();
+    groupMorph->setWeight(1);
+    model.performUpdate();
+    ASSERT_TRUE(CompareVector(Vector4(0.5, 1, 1.5, 2), vertex->uv(0)));
+    /* merged only once through the group morph at every frame */
+    model.performUpdate();
+    ASSERT_TRUE(CompareVector(Vector4(0.5, 1, 1.5, 2), vertex->uv(0)));
+    groupMorph->setWeight(0);
+    model.performUpdate();
+    ASSERT_TRUE(CompareVector(kZeroV4, vertex->uv(0)));
+    ASSERT_EQ(1, model.numMorphTouchedVertices());
+    /* children of the removed group morph are updated by the model */
+    model.removeMorph(groupMorph);
+    ASSERT_FALSE(childGroupMorph->hasParent());
+    delete groupMorph;
+}
+
+TEST(PMXModelTest, TrackUploadRangesOfMorphedVertices)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    static const int kNumVertices = 100;
+    for (int i = 0; i < kNumVertices; i++) {
+        model.addVertex(new Vertex(&model));
+    }
+    Morph *morph = new Morph(&model);
+    morph->setType(IMorph::kVertexMorph);
+    const int indices[] = { 80, 10, 12 };
+    for (int i = 0; i < 3; i++) {
+        Morph::Vertex *vertexMorph = new Morph::Vertex();
+        vertexMorph->vertex = model.findVertexRefAt(indices[i]);
+        vertexMorph->index = indices[i];
+        vertexMorph->position.setValue(1, 2, 3);
+        morph->addVertexMorph(vertexMorph);
+    }
+    model.addMorph(morph);
+    QScopedPointer<IModel::IndexBuffer> indexBuffer;
+    QScopedPointer<IModel::DynamicVertexBuffer> dynamicBuffer;
+    IModel::IndexBuffer *indexBufferPtr = 0;
+    IModel::DynamicVertexBuffer *dynamicBufferPtr = 0;
+    model.getIndexBuffer(indexBufferPtr);
+    indexBuffer.reset(indexBufferPtr);
+    model.getDynamicVertexBuffer(dynamicBufferPtr, indexBufferPtr);
+    dynamicBuffer.reset(dynamicBufferPtr);
+    const vsize stride = dynamicBuffer->strideSize();
+    internal::DynamicVertexUpdateTracker tracker(2);
+    /* both of double buffers are filled at first */
+    model.performUpdate();
+    ASSERT_FALSE(tracker.collect(dynamicBuffer.data(), kNumVertices));
+    model.performUpdate();
+    ASSERT_FALSE(tracker.collect(dynamicBuffer.data(), kNumVertices));
+    model.performUpdate();
+    ASSERT_TRUE(tracker.collect(dynamicBuffer.data(), kNumVertices));
+    ASSERT_EQ(0, tracker.ranges(stride).count());
+    /* near vertices are merged into one range */
+    morph->setWeight(0.5);
+    model.performUpdate();
+    ASSERT_TRUE(tracker.collect(dynamicBuffer.data(), kNumVertices));
+    ASSERT_EQ(3, tracker.currentVertexIndices().count());
+    const Array<internal::DynamicVertexUpdateTracker::Range> &ranges = tracker.ranges(stride);
+    ASSERT_EQ(2, ranges.count());
+    ASSERT_EQ(10 * stride, ranges[0].offset);
+    ASSERT_EQ(3 * stride, ranges[0].size);
+    ASSERT_EQ(80 * stride, ranges[1].offset);
+    ASSERT_EQ(stride, ranges[1].size);
+    /* the other buffer still needs vertices changed at the previous frame */
+    model.performUpdate();
+    ASSERT_TRUE(tracker.collect(dynamicBuffer.data(), kNumVertices));
+    ASSERT_EQ(2, tracker.ranges(stride).count());
+    /* skipped updates fill all buffers again */
+    model.performUpdate();
+    model.performUpdate();
+    ASSERT_FALSE(tracker.collect(dynamicBuffer.data(), kNumVertices));
+    ASSERT_FALSE(tracker.collect(dynamicBuffer.data(), kNumVertices));
+    ASSERT_TRUE(tracker.collect(dynamicBuffer.data(), kNumVertices));
+}
+
 TEST_P(PMXLanguageTest, RenameMorph)
 {
     Encoding encoding(0);
@@ -18,6 +18,13 @@
 #include "glsl_optimizer.h"
 #endif
 
+#ifdef ENABLE_EFFECT_CACHE
+#include <vpvl2/vpvl2.h>
+#include <vpvl2/IApplicationContext.h>
+#include <vpvl2/extensions/EffectCache.h>
+#include <vpvl2/nvfx/EffectContext.h>
+#endif
+
 #if defined(__APPLE__)
 #include <OpenGL/CGLCurrent.h>
 #else
@@ -29,6 +36,7 @@ using namespace nvFX;
 namespace {
 
 static const GLenum GL_NUM_EXTENSIONS = 0x821D;
+static const GLenum kGL_SHADING_LANGUAGE_VERSION = 0x8B8C;
 
 static void HandleGLFWError(int /* error */, const char *message)
 {
@@ -96,6 +104,20 @@ static void WritePassShaders(IPass *pass)
     glslopt_cleanup(context);
 }
 
+#ifdef ENABLE_EFFECT_CACHE
+static int GetShaderVersion()
+{
+    /* same as vpvl2::gl::makeVersion used by the renderer (e.g. "1.50" is 150) */
+    if (const GLubyte *s = ::glGetString(kGL_SHADING_LANGUAGE_VERSION)) {
+        int major = s[0] - '0', minor = s[2] - '0';
+        if (major >= 0 && major <= 9 && minor >= 0 && minor <= 9) {
+            return major * 100 + minor * 10;
+        }
+    }
+    return 0;
+}
+#endif
+
 static bool ParseEffect(const char *filename, bool isCoreProfileEnabled)
 {
     IContainer *container = 0;
@@ -155,6 +177,13 @@ static bool ParseEffect(const char *filename, bool isCoreProfileEnabled)
             snprintf(appendingHeader, sizeof(appendingHeader), kFormat, 120, kAppendingShaderHeader);
         }
         int i = 0;
+#ifdef ENABLE_EFFECT_CACHE
+        if (vpvl2::extensions::EffectCache::isEnabled()) {
+            /* must be the same header as the renderer to make the same program cache keys */
+            vpvl2::nvfx::EffectContext::appendShaderHeader(container, GetShaderVersion(), isCoreProfileEnabled);
+        }
+        else
+#endif
         while (IShader *shader = container->findShader(i++)) {
             TargetType type = shader->getType();
             const char *name = shader->getName();
@@ -259,10 +288,27 @@ int main(int argc, char *argv[])
     nvFX::initialize();
     for (int i = 1; i < argc; i++) {
         const char *filename = argv[i];
+#ifdef ENABLE_EFFECT_CACHE
+        /* "-c dir" stores program binaries linked by the following effects to the effect cache in dir */
+        if (std::string(filename) == "-c" && i + 1 < argc) {
+            vpvl2::extensions::EffectCache::setDirectory(argv[++i]);
+            continue;
+        }
+#endif
         if (!ParseEffect(filename, isCoreProfileEnabled)) {
             std::cerr << "Cannot parse this file: " << filename << std::endl;
         }
     }
+#ifdef ENABLE_EFFECT_CACHE
+    if (vpvl2::extensions::EffectCache::isEnabled()) {
+        vpvl2::extensions::EffectCache::Statistics statistics;
+        vpvl2::extensions::EffectCache::getStatistics(statistics);
+        std::cerr << "EffectCache: stores=" << statistics.numStores
+                  << " binaryHits=" << statistics.numProgramBinaryHits
+                  << " binaryMisses=" << statistics.numProgramBinaryMisses
+                  << " rejects=" << statistics.numRejects << std::endl;
+    }
+#endif
     glfwDestroyWindow(window);
     nvFX::cleanup();
 
@@ -402,7 +402,10 @@ int main(int argc, char *argv[])
                 if (finfo.suffix() == "pmx") { // || finfo.suffix() == "pmd") {
                     QFile file(finfo.absoluteFilePath());
                     if (file.open(QFile::ReadOnly)) {
-                        const QByteArray bytes = file.readAll();
+                        /* map the model file to avoid copying it into a temporary buffer */
+                        const int size = int(file.size());
+                        const uchar *address = file.map(0, size);
+                        const QByteArray bytes = address ? QByteArray::fromRawData(reinterpret_cast<const char *>(address), size) : file.readAll();
                         const uint8 *ptr = reinterpret_cast<const uint8 *>(bytes.constData());
                         bool ok = false;
                         IModel *model = factory.createModel(ptr, bytes.size(), ok);